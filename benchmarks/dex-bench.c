@@ -0,0 +1,1008 @@
+/* dex-bench.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include <libdex.h>
+
+#include "dex-aio-backend-private.h"
+#include "dex-posix-aio-backend-private.h"
+#include "dex-semaphore-private.h"
+#ifdef HAVE_LIBURING
+# include "dex-uring-aio-backend-private.h"
+#endif
+
+/* NOTE:
+ *
+ * Each benchmark runs inside a fiber on the main scheduler so that it may
+ * use dex_await(). Iteration counts are tuned to take a fraction of a second
+ * on a modern machine and may be adjusted with --scale. Use --json to get
+ * machine readable output suitable for comparing against a saved baseline.
+ */
+
+typedef struct _Result
+{
+  char    *name;
+  guint64  n_ops;
+  gint64   elapsed_usec;
+  GString *extra;
+} Result;
+
+typedef gboolean (*BenchFunc) (GError **error);
+
+typedef struct _Bench
+{
+  const char *name;
+  const char *description;
+  BenchFunc   func;
+} Bench;
+
+static GArray *results;
+static double scale = 1.;
+static char *filter;
+static gboolean json;
+static gboolean list;
+static int exit_code = EXIT_SUCCESS;
+
+static guint
+scaled (guint n)
+{
+  return MAX (1, (guint)(n * scale));
+}
+
+static Result *
+report (const char *name,
+        guint64     n_ops,
+        gint64      elapsed_usec)
+{
+  Result result = {
+    .name = g_strdup (name),
+    .n_ops = n_ops,
+    .elapsed_usec = MAX (1, elapsed_usec),
+    .extra = g_string_new (NULL),
+  };
+
+  g_array_append_val (results, result);
+
+  if (!json)
+    {
+      double ns_per_op = result.elapsed_usec * 1000. / MAX (1, n_ops);
+      double ops_per_sec = n_ops / (result.elapsed_usec / (double)G_USEC_PER_SEC);
+
+      g_print ("%-36s %12"G_GUINT64_FORMAT" %12.1lf %14.0lf\n",
+               name, n_ops, ns_per_op, ops_per_sec);
+    }
+
+  return &g_array_index (results, Result, results->len - 1);
+}
+
+static void
+report_extra (Result     *result,
+              const char *key,
+              const char *format,
+              ...) G_GNUC_PRINTF (3, 4);
+
+static void
+report_extra (Result     *result,
+              const char *key,
+              const char *format,
+              ...)
+{
+  g_autofree char *value = NULL;
+  va_list args;
+
+  va_start (args, format);
+  value = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  g_string_append_printf (result->extra, ", \"%s\": %s", key, value);
+
+  if (!json)
+    g_print ("%-36s   %s = %s\n", "", key, value);
+}
+
+static void
+clear_result (gpointer data)
+{
+  Result *result = data;
+
+  g_clear_pointer (&result->name, g_free);
+  g_string_free (result->extra, TRUE);
+}
+
+/* future-then: cost of each link in a dex_future_then() chain */
+
+static DexFuture *
+then_cb (DexFuture *completed,
+         gpointer   user_data)
+{
+  return NULL;
+}
+
+static gboolean
+bench_future_then (GError **error)
+{
+  static const guint depths[] = { 1, 10, 100, 1000 };
+
+  for (guint d = 0; d < G_N_ELEMENTS (depths); d++)
+    {
+      guint depth = depths[d];
+      guint iterations = scaled (100000 / depth);
+      g_autofree char *name = g_strdup_printf ("future-then/depth-%u", depth);
+      gint64 begin = g_get_monotonic_time ();
+
+      for (guint i = 0; i < iterations; i++)
+        {
+          DexPromise *promise = dex_promise_new ();
+          DexFuture *future = dex_ref (promise);
+
+          for (guint j = 0; j < depth; j++)
+            future = dex_future_then (future, then_cb, NULL, NULL);
+
+          dex_promise_resolve_boolean (promise, TRUE);
+          dex_unref (promise);
+
+          if (!dex_await (future, error))
+            return FALSE;
+        }
+
+      report (name, (guint64)iterations * depth, g_get_monotonic_time () - begin);
+    }
+
+  return TRUE;
+}
+
+/* fiber-spawn: spawn and join fibers in batches */
+
+static DexFuture *
+noop_fiber (gpointer user_data)
+{
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static gboolean
+spawn_batches (DexScheduler  *scheduler,
+               const char    *name,
+               GError       **error)
+{
+  DexFuture *batch[100];
+  guint iterations = scaled (1000);
+  gint64 begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    {
+      DexFuture *all;
+
+      for (guint j = 0; j < G_N_ELEMENTS (batch); j++)
+        batch[j] = dex_scheduler_spawn (scheduler, 0, noop_fiber, NULL, NULL);
+
+      all = dex_future_allv (batch, G_N_ELEMENTS (batch));
+
+      for (guint j = 0; j < G_N_ELEMENTS (batch); j++)
+        dex_unref (batch[j]);
+
+      if (!dex_await (all, error))
+        return FALSE;
+    }
+
+  report (name, (guint64)iterations * G_N_ELEMENTS (batch), g_get_monotonic_time () - begin);
+
+  return TRUE;
+}
+
+static gboolean
+bench_fiber_spawn (GError **error)
+{
+  return spawn_batches (NULL, "fiber-spawn/same-thread", error) &&
+         spawn_batches (dex_thread_pool_scheduler_get_default (), "fiber-spawn/thread-pool", error);
+}
+
+/* fiber-switch: two fibers ping-pong a value over a pair of channels */
+
+typedef struct _PingPong
+{
+  DexChannel *ping;
+  DexChannel *pong;
+  guint       iterations;
+} PingPong;
+
+static DexFuture *
+pong_fiber (gpointer user_data)
+{
+  PingPong *state = user_data;
+  GError *error = NULL;
+
+  for (guint i = 0; i < state->iterations; i++)
+    {
+      gpointer value;
+
+      if (!(value = dex_channel_receive_value (state->ping, &error)) ||
+          !dex_channel_send_value (state->pong, value, &error))
+        return dex_future_new_for_error (error);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static gboolean
+bench_fiber_switch (GError **error)
+{
+  PingPong state;
+  DexSchedulerStats before;
+  DexSchedulerStats after;
+  DexFuture *pong;
+  Result *result;
+  gint64 begin;
+
+  state.ping = dex_channel_new_for_values (1, NULL);
+  state.pong = dex_channel_new_for_values (1, NULL);
+  state.iterations = scaled (100000);
+
+  dex_scheduler_get_global_stats (&before);
+  begin = g_get_monotonic_time ();
+
+  pong = dex_scheduler_spawn (NULL, 0, pong_fiber, &state, NULL);
+
+  for (guint i = 0; i < state.iterations; i++)
+    {
+      if (!dex_channel_send_value (state.ping, GINT_TO_POINTER (1), error) ||
+          !dex_channel_receive_value (state.pong, error))
+        {
+          dex_channel_close_send (state.ping);
+          dex_await (pong, NULL);
+          goto failure;
+        }
+    }
+
+  if (!dex_await (pong, error))
+    goto failure;
+
+  result = report ("fiber-switch/ping-pong", state.iterations, g_get_monotonic_time () - begin);
+
+  dex_scheduler_get_global_stats (&after);
+  report_extra (result, "fiber_switches", "%"G_GUINT64_FORMAT,
+                after.n_fiber_switches - before.n_fiber_switches);
+
+  dex_unref (state.ping);
+  dex_unref (state.pong);
+
+  return TRUE;
+
+failure:
+  dex_unref (state.ping);
+  dex_unref (state.pong);
+
+  return FALSE;
+}
+
+/* await: dex_await() on a completed future vs one resolved later */
+
+static void
+resolve_promise_cb (gpointer user_data)
+{
+  DexPromise *promise = user_data;
+
+  dex_promise_resolve_boolean (promise, TRUE);
+  dex_unref (promise);
+}
+
+static gboolean
+bench_await (GError **error)
+{
+  DexScheduler *scheduler = dex_scheduler_get_thread_default ();
+  guint iterations = scaled (1000000);
+  gint64 begin;
+
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    {
+      if (!dex_await (dex_future_new_for_boolean (TRUE), error))
+        return FALSE;
+    }
+
+  report ("await/completed", iterations, g_get_monotonic_time () - begin);
+
+  iterations = scaled (100000);
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    {
+      DexPromise *promise = dex_promise_new ();
+
+      dex_scheduler_push (scheduler, resolve_promise_cb, dex_ref (promise));
+
+      if (!dex_await (DEX_FUTURE (promise), error))
+        return FALSE;
+    }
+
+  report ("await/pending", iterations, g_get_monotonic_time () - begin);
+
+  return TRUE;
+}
+
+/* channel: producer and consumer fibers sharing a bounded channel */
+
+typedef struct _Transfer
+{
+  DexChannel *channel;
+  guint       iterations;
+} Transfer;
+
+static DexFuture *
+producer_fiber (gpointer user_data)
+{
+  Transfer *state = user_data;
+  GError *error = NULL;
+
+  for (guint i = 0; i < state->iterations; i++)
+    {
+      if (!dex_await (dex_channel_send (state->channel, dex_future_new_for_int (i)), &error))
+        return dex_future_new_for_error (error);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+consumer_fiber (gpointer user_data)
+{
+  Transfer *state = user_data;
+  GError *error = NULL;
+
+  for (guint i = 0; i < state->iterations; i++)
+    {
+      if (dex_await_int (dex_channel_receive (state->channel), &error) != (int)i)
+        {
+          if (error == NULL)
+            error = g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED, "Item %u received out of order", i);
+          return dex_future_new_for_error (error);
+        }
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static gboolean
+bench_channel (GError **error)
+{
+  static const guint capacities[] = { 1, 64 };
+
+  for (guint c = 0; c < G_N_ELEMENTS (capacities); c++)
+    {
+      g_autofree char *name = g_strdup_printf ("channel/capacity-%u", capacities[c]);
+      Transfer state;
+      gboolean ret;
+      gint64 begin;
+
+      state.channel = dex_channel_new (capacities[c]);
+      state.iterations = scaled (100000);
+
+      begin = g_get_monotonic_time ();
+      ret = dex_await (dex_future_all (dex_scheduler_spawn (NULL, 0, producer_fiber, &state, NULL),
+                                       dex_scheduler_spawn (NULL, 0, consumer_fiber, &state, NULL),
+                                       NULL),
+                       error);
+      dex_unref (state.channel);
+
+      if (!ret)
+        return FALSE;
+
+      report (name, state.iterations, g_get_monotonic_time () - begin);
+    }
+
+  return TRUE;
+}
+
+/* global-queue: external threads pushing into the thread pool */
+
+#define N_PUSH_THREADS 4
+
+typedef struct _Flood
+{
+  DexScheduler *scheduler;
+  DexPromise   *done;
+  guint         per_thread;
+  int           remaining;
+} Flood;
+
+static void
+flood_item_cb (gpointer user_data)
+{
+  Flood *state = user_data;
+
+  if (g_atomic_int_dec_and_test (&state->remaining))
+    dex_promise_resolve_boolean (state->done, TRUE);
+}
+
+static gpointer
+flood_thread (gpointer user_data)
+{
+  Flood *state = user_data;
+
+  for (guint i = 0; i < state->per_thread; i++)
+    dex_scheduler_push (state->scheduler, flood_item_cb, state);
+
+  return NULL;
+}
+
+static gboolean
+bench_global_queue (GError **error)
+{
+  GThread *threads[N_PUSH_THREADS];
+  Flood state;
+  gboolean ret;
+  gint64 begin;
+
+  state.scheduler = dex_thread_pool_scheduler_get_default ();
+  state.done = dex_promise_new ();
+  state.per_thread = scaled (100000);
+  state.remaining = state.per_thread * N_PUSH_THREADS;
+
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < N_PUSH_THREADS; i++)
+    threads[i] = g_thread_new ("[dex-bench-push]", flood_thread, &state);
+
+  ret = dex_await (dex_ref (state.done), error);
+
+  if (ret)
+    report ("global-queue/push-from-threads",
+            (guint64)state.per_thread * N_PUSH_THREADS,
+            g_get_monotonic_time () - begin);
+
+  for (guint i = 0; i < N_PUSH_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  dex_unref (state.done);
+
+  return ret;
+}
+
+/* work-stealing: seed a single worker and see how evenly the work spreads */
+
+typedef struct _Spread
+{
+  GMutex      mutex;
+  GPtrArray  *counters;
+  DexPromise *done;
+  guint       generation;
+  guint       n_items;
+  int         remaining;
+} Spread;
+
+typedef struct _SpreadCounter
+{
+  guint   generation;
+  guint64 count;
+} SpreadCounter;
+
+static GPrivate spread_counter;
+static guint spread_generation;
+static volatile guint spread_sink;
+
+static void
+spread_item_cb (gpointer user_data)
+{
+  Spread *state = user_data;
+  SpreadCounter *counter = g_private_get (&spread_counter);
+
+  /* Counters are owned by @state and only ever written from their thread.
+   * The decrement of @remaining orders them before the promise resolves.
+   */
+  if (counter == NULL || counter->generation != state->generation)
+    {
+      counter = g_new0 (SpreadCounter, 1);
+      counter->generation = state->generation;
+      g_private_set (&spread_counter, counter);
+
+      g_mutex_lock (&state->mutex);
+      g_ptr_array_add (state->counters, counter);
+      g_mutex_unlock (&state->mutex);
+    }
+
+  /* Give each item enough weight that stealing is worthwhile */
+  for (guint i = 0; i < 2000; i++)
+    spread_sink++;
+
+  counter->count++;
+
+  if (g_atomic_int_dec_and_test (&state->remaining))
+    dex_promise_resolve_boolean (state->done, TRUE);
+}
+
+static void
+spread_seed_cb (gpointer user_data)
+{
+  Spread *state = user_data;
+  DexScheduler *worker = dex_scheduler_get_thread_default ();
+
+  /* Pushing from within a worker lands on its local queue */
+  for (guint i = 0; i < state->n_items; i++)
+    dex_scheduler_push (worker, spread_item_cb, state);
+}
+
+static gboolean
+bench_work_stealing (GError **error)
+{
+  DexSchedulerStats before;
+  DexSchedulerStats after;
+  g_autoptr(GString) counts = g_string_new ("[");
+  Spread state;
+  Result *result;
+  double sum = 0;
+  double sum_sq = 0;
+  guint n_threads;
+  gint64 begin;
+
+  g_mutex_init (&state.mutex);
+  state.counters = g_ptr_array_new_with_free_func (g_free);
+  state.done = dex_promise_new ();
+  state.generation = ++spread_generation;
+  state.n_items = scaled (200000);
+  state.remaining = state.n_items;
+
+  dex_scheduler_get_global_stats (&before);
+  begin = g_get_monotonic_time ();
+
+  dex_scheduler_push (dex_thread_pool_scheduler_get_default (), spread_seed_cb, &state);
+
+  /* Nothing rejects @done so there is no error to propagate */
+  dex_await (dex_ref (state.done), NULL);
+
+  result = report ("work-stealing/single-seed", state.n_items, g_get_monotonic_time () - begin);
+  dex_scheduler_get_global_stats (&after);
+
+  /* Workers that never ran an item still count against fairness, so use
+   * the default pool size (see dex_thread_pool_scheduler_init()) as the
+   * lower bound on the number of participants.
+   */
+  n_threads = MAX (state.counters->len, MAX (1, MIN (32, g_get_num_processors ()) / 2));
+
+  for (guint i = 0; i < state.counters->len; i++)
+    {
+      const SpreadCounter *counter = g_ptr_array_index (state.counters, i);
+
+      g_string_append_printf (counts, "%s%"G_GUINT64_FORMAT, i ? ", " : "", counter->count);
+      sum += counter->count;
+      sum_sq += (double)counter->count * counter->count;
+    }
+
+  g_string_append_c (counts, ']');
+
+  report_extra (result, "threads", "%u", n_threads);
+  report_extra (result, "per_thread", "%s", counts->str);
+  report_extra (result, "jain_index", "%.4lf", sum_sq > 0 ? (sum * sum) / (n_threads * sum_sq) : 0.);
+  report_extra (result, "steal_attempts", "%"G_GUINT64_FORMAT,
+                after.n_steal_attempts - before.n_steal_attempts);
+  report_extra (result, "steal_successes", "%"G_GUINT64_FORMAT,
+                after.n_steal_successes - before.n_steal_successes);
+
+  g_ptr_array_unref (state.counters);
+  g_mutex_clear (&state.mutex);
+  dex_unref (state.done);
+
+  return TRUE;
+}
+
+/* semaphore: uncontended post/wait and a ping-pong between two fibers */
+
+typedef struct _Baton
+{
+  DexSemaphore *ping;
+  DexSemaphore *pong;
+  guint         iterations;
+} Baton;
+
+static DexFuture *
+baton_fiber (gpointer user_data)
+{
+  Baton *state = user_data;
+  GError *error = NULL;
+
+  for (guint i = 0; i < state->iterations; i++)
+    {
+      if (!dex_await (dex_semaphore_wait (state->ping), &error))
+        return dex_future_new_for_error (error);
+
+      dex_semaphore_post (state->pong);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static gboolean
+bench_semaphore (GError **error)
+{
+  DexSemaphore *semaphore = dex_semaphore_new ();
+  guint iterations = scaled (1000000);
+  DexFuture *fiber;
+  gboolean ret = TRUE;
+  Baton state;
+  gint64 begin;
+
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    {
+      dex_semaphore_post (semaphore);
+
+      if (!dex_await (dex_semaphore_wait (semaphore), error))
+        {
+          dex_unref (semaphore);
+          return FALSE;
+        }
+    }
+
+  report ("semaphore/uncontended", iterations, g_get_monotonic_time () - begin);
+  dex_unref (semaphore);
+
+  state.ping = dex_semaphore_new ();
+  state.pong = dex_semaphore_new ();
+  state.iterations = scaled (100000);
+
+  begin = g_get_monotonic_time ();
+  fiber = dex_scheduler_spawn (NULL, 0, baton_fiber, &state, NULL);
+
+  for (guint i = 0; i < state.iterations; i++)
+    {
+      dex_semaphore_post (state.ping);
+
+      if (!(ret = dex_await (dex_semaphore_wait (state.pong), error)))
+        {
+          dex_semaphore_close (state.ping);
+          dex_await (fiber, NULL);
+          break;
+        }
+    }
+
+  if (ret && (ret = dex_await (fiber, error)))
+    report ("semaphore/ping-pong", state.iterations, g_get_monotonic_time () - begin);
+
+  dex_unref (state.ping);
+  dex_unref (state.pong);
+
+  return ret;
+}
+
+/* aio-read: sequential reads of a page-cached file through each backend */
+
+#define AIO_CHUNK_SIZE (64*1024)
+#define AIO_MAX_DEPTH  16
+
+static gboolean
+aio_read_file (DexAioBackend  *backend,
+               const char     *backend_name,
+               int             fd,
+               gsize           file_size,
+               guint8         *buffers,
+               GError        **error)
+{
+  static const guint depths[] = { 1, AIO_MAX_DEPTH };
+  DexAioContext *aio_context;
+  gboolean ret = TRUE;
+
+  if (!(aio_context = dex_aio_backend_create_context (backend)))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Failed to create %s aio context", backend_name);
+      return FALSE;
+    }
+
+  g_source_attach ((GSource *)aio_context,
+                   dex_scheduler_get_main_context (dex_scheduler_get_thread_default ()));
+
+  for (guint d = 0; ret && d < G_N_ELEMENTS (depths); d++)
+    {
+      g_autofree char *name = g_strdup_printf ("aio-read/%s/depth-%u", backend_name, depths[d]);
+      guint64 n_reads = 0;
+      gsize n_read = 0;
+      Result *result;
+      gint64 begin;
+      gint64 elapsed;
+
+      begin = g_get_monotonic_time ();
+
+      for (goffset offset = 0; offset < (goffset)file_size; offset += (goffset)depths[d] * AIO_CHUNK_SIZE)
+        {
+          DexFuture *reads[AIO_MAX_DEPTH];
+          DexFuture *all;
+          guint n = 0;
+
+          for (; n < depths[d] && (gsize)offset + n * AIO_CHUNK_SIZE < file_size; n++)
+            reads[n] = dex_aio_backend_read (backend, aio_context, fd,
+                                             buffers + n * AIO_CHUNK_SIZE,
+                                             AIO_CHUNK_SIZE,
+                                             offset + n * AIO_CHUNK_SIZE);
+
+          all = dex_future_allv (reads, n);
+
+          if (!(ret = dex_await (all, error)))
+            {
+              for (guint i = 0; i < n; i++)
+                dex_unref (reads[i]);
+              break;
+            }
+
+          for (guint i = 0; i < n; i++)
+            {
+              n_read += dex_await_int64 (reads[i], NULL);
+              n_reads++;
+            }
+        }
+
+      if (!ret)
+        break;
+
+      elapsed = g_get_monotonic_time () - begin;
+      result = report (name, n_reads, elapsed);
+      report_extra (result, "bytes_per_sec", "%.0lf",
+                    n_read / (MAX (1, elapsed) / (double)G_USEC_PER_SEC));
+    }
+
+  g_source_destroy ((GSource *)aio_context);
+  g_source_unref ((GSource *)aio_context);
+
+  return ret;
+}
+
+static gboolean
+bench_aio_read (GError **error)
+{
+  g_autofree guint8 *buffers = NULL;
+  g_autofree char *path = NULL;
+  DexAioBackend *backend;
+  gsize file_size;
+  gboolean ret = FALSE;
+  int fd;
+
+  file_size = (gsize)scaled (64) * 1024 * 1024;
+  buffers = g_malloc (AIO_MAX_DEPTH * AIO_CHUNK_SIZE);
+  memset (buffers, 'X', AIO_MAX_DEPTH * AIO_CHUNK_SIZE);
+
+  if (-1 == (fd = g_file_open_tmp ("dex-bench-XXXXXX", &path, error)))
+    return FALSE;
+
+  g_unlink (path);
+
+  for (gsize written = 0; written < file_size; )
+    {
+      gssize len = write (fd, buffers, MIN (file_size - written, AIO_MAX_DEPTH * AIO_CHUNK_SIZE));
+
+      if (len < 0 && errno == EINTR)
+        continue;
+
+      if (len <= 0)
+        {
+          int errsv = errno;
+          g_set_error_literal (error,
+                               G_IO_ERROR,
+                               g_io_error_from_errno (errsv),
+                               g_strerror (errsv));
+          goto cleanup;
+        }
+
+      written += len;
+    }
+
+#ifdef HAVE_LIBURING
+  if ((backend = dex_uring_aio_backend_new ()))
+    {
+      ret = aio_read_file (backend, "uring", fd, file_size, buffers, error);
+      dex_unref (backend);
+
+      if (!ret)
+        goto cleanup;
+    }
+  else if (!json)
+    {
+      g_print ("%-36s %12s\n", "aio-read/uring", "unavailable");
+    }
+#endif
+
+  backend = dex_posix_aio_backend_new ();
+  ret = aio_read_file (backend, "posix", fd, file_size, buffers, error);
+  dex_unref (backend);
+
+cleanup:
+  close (fd);
+
+  return ret;
+}
+
+/* timeout: creating timeouts and cancelling them by dropping the last ref */
+
+static gboolean
+bench_timeout (GError **error)
+{
+  guint iterations = scaled (100000);
+  DexFuture **timeouts = g_new (DexFuture *, iterations);
+  gint64 begin;
+
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    timeouts[i] = dex_timeout_new_seconds (3600);
+
+  report ("timeout/create", iterations, g_get_monotonic_time () - begin);
+
+  begin = g_get_monotonic_time ();
+
+  for (guint i = 0; i < iterations; i++)
+    dex_unref (timeouts[i]);
+
+  report ("timeout/cancel", iterations, g_get_monotonic_time () - begin);
+
+  g_free (timeouts);
+
+  return TRUE;
+}
+
+static const Bench benchmarks[] = {
+  { "future-then", "Cost per link of dex_future_then() chains", bench_future_then },
+  { "fiber-spawn", "Spawning and joining fibers", bench_fiber_spawn },
+  { "fiber-switch", "Fiber context switches over a channel ping-pong", bench_fiber_switch },
+  { "await", "dex_await() on completed and pending futures", bench_await },
+  { "channel", "DexChannel send/receive throughput", bench_channel },
+  { "global-queue", "Thread pool pushes from external threads", bench_global_queue },
+  { "work-stealing", "Distribution of work seeded on a single worker", bench_work_stealing },
+  { "semaphore", "DexSemaphore post/wait", bench_semaphore },
+  { "aio-read", "dex_aio_read() throughput per backend", bench_aio_read },
+  { "timeout", "DexTimeout creation and cancellation", bench_timeout },
+};
+
+static void
+print_json (void)
+{
+  g_autoptr(GString) str = g_string_new (NULL);
+
+  g_string_append_printf (str,
+                          "{\n"
+                          "  \"version\": \"%s\",\n"
+                          "  \"scale\": %lf,\n"
+                          "  \"results\": [\n",
+                          DEX_VERSION_S, scale);
+
+  for (guint i = 0; i < results->len; i++)
+    {
+      const Result *result = &g_array_index (results, Result, i);
+      double ns_per_op = result->elapsed_usec * 1000. / MAX (1, result->n_ops);
+      double ops_per_sec = result->n_ops / (result->elapsed_usec / (double)G_USEC_PER_SEC);
+
+      g_string_append_printf (str,
+                              "    {\"name\": \"%s\", \"iterations\": %"G_GUINT64_FORMAT", "
+                              "\"elapsed_ns\": %"G_GINT64_FORMAT", \"ns_per_op\": %.2lf, "
+                              "\"ops_per_sec\": %.0lf%s}%s\n",
+                              result->name,
+                              result->n_ops,
+                              result->elapsed_usec * 1000,
+                              ns_per_op,
+                              ops_per_sec,
+                              result->extra->str,
+                              i + 1 < results->len ? "," : "");
+    }
+
+  g_string_append (str, "  ]\n}\n");
+
+  g_print ("%s", str->str);
+}
+
+static DexFuture *
+bench_fiber (gpointer user_data)
+{
+  GError *error = NULL;
+
+  if (!json)
+    g_print ("%-36s %12s %12s %14s\n", "benchmark", "iterations", "ns/op", "ops/sec");
+
+  for (guint i = 0; i < G_N_ELEMENTS (benchmarks); i++)
+    {
+      if (filter != NULL && !g_pattern_match_simple (filter, benchmarks[i].name))
+        continue;
+
+      if (!benchmarks[i].func (&error))
+        {
+          g_prefix_error (&error, "%s: ", benchmarks[i].name);
+          return dex_future_new_for_error (error);
+        }
+    }
+
+  if (json)
+    print_json ();
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+quit_cb (DexFuture *completed,
+         gpointer   user_data)
+{
+  GMainLoop *main_loop = user_data;
+  g_autoptr(GError) error = NULL;
+
+  if (!dex_future_get_value (completed, &error))
+    {
+      g_printerr ("dex-bench: %s\n", error->message);
+      exit_code = EXIT_FAILURE;
+    }
+
+  g_main_loop_quit (main_loop);
+
+  return NULL;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GMainLoop) main_loop = NULL;
+  g_autoptr(DexFuture) future = NULL;
+  g_autoptr(GError) error = NULL;
+  GOptionEntry entries[] = {
+    { "json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print results as JSON", NULL },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter, "Only run benchmarks matching a glob", "PATTERN" },
+    { "scale", 's', 0, G_OPTION_ARG_DOUBLE, &scale, "Multiply iteration counts (default 1.0)", "FACTOR" },
+    { "list", 'l', 0, G_OPTION_ARG_NONE, &list, "List available benchmarks", NULL },
+    { NULL }
+  };
+
+  dex_init ();
+
+  context = g_option_context_new ("- Run libdex microbenchmarks");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (list)
+    {
+      for (guint i = 0; i < G_N_ELEMENTS (benchmarks); i++)
+        g_print ("%-16s %s\n", benchmarks[i].name, benchmarks[i].description);
+      return EXIT_SUCCESS;
+    }
+
+  if (scale <= 0)
+    scale = 1.;
+
+  results = g_array_new (FALSE, FALSE, sizeof (Result));
+  g_array_set_clear_func (results, clear_result);
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+
+  future = dex_scheduler_spawn (NULL, 0, bench_fiber, NULL, NULL);
+  future = dex_future_finally (future, quit_cb, g_main_loop_ref (main_loop), (GDestroyNotify)g_main_loop_unref);
+
+  g_main_loop_run (main_loop);
+
+  g_array_unref (results);
+  g_free (filter);
+
+  return exit_code;
+}
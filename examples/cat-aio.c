@@ -19,6 +19,8 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  */
 
+#include "config.h"
+
 #include <unistd.h>
 
 #include "cat-util.h"
@@ -31,6 +33,9 @@
  *
  * `gio cat` is likely faster than this doing synchronous IO on the calling
  * thread because it doesn't have to coordinate across thread pools.
+ *
+ * Use `--direct` to read with O_DIRECT, bypassing the page cache. That is
+ * useful to benchmark the storage device rather than memory bandwidth.
  */
 
 static DexFuture *
@@ -55,12 +60,20 @@ cat_read_fiber (gpointer user_data)
       next = cat_pop_buffer (cat);
 
       /* Suspend while reading into the buffer */
-      next->length = dex_await_int64 (dex_aio_read (NULL,
-                                                    cat->read_fd,
-                                                    next->data,
-                                                    next->capacity,
-                                                    -1),
-                                      NULL);
+      if (cat->direct)
+        next->length = dex_await_int64 (dex_aio_read_direct (NULL,
+                                                             cat->read_fd,
+                                                             next->data,
+                                                             next->capacity,
+                                                             -1),
+                                        NULL);
+      else
+        next->length = dex_await_int64 (dex_aio_read (NULL,
+                                                      cat->read_fd,
+                                                      next->data,
+                                                      next->capacity,
+                                                      -1),
+                                        NULL);
 
       /* If we got length <= 0, we failed or finished */
       if (next->length <= 0)
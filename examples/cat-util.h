@@ -44,6 +44,7 @@ typedef struct _Buffer Buffer;
 struct _Cat
 {
   gsize buffer_size;
+  gsize alignment;
   int read_fd;
   int write_fd;
   gssize to_read;
@@ -52,6 +53,7 @@ struct _Cat
   GMainLoop *main_loop;
   GError *error;
   Buffer *current;
+  gboolean direct;
 };
 
 struct _Buffer
@@ -70,7 +72,7 @@ buffer_new (Cat *cat)
 
   buffer->cat = cat;
   buffer->link.data = buffer;
-  buffer->data = g_aligned_alloc (1, cat->buffer_size, 4096);
+  buffer->data = g_aligned_alloc (1, cat->buffer_size, cat->alignment);
   buffer->capacity = cat->buffer_size;
   buffer->length = 0;
 
@@ -104,6 +106,7 @@ cat_init (Cat      *cat,
   GOptionContext *context;
   char *output = NULL;
   gboolean ret = FALSE;
+  gboolean direct = FALSE;
   int buffer_size = (1024*256 - 2*sizeof(gpointer)); /* 256k minus malloc overhead */
   int queue_size = 32;
 #ifdef HAVE_POSIX_FADVISE
@@ -114,12 +117,14 @@ cat_init (Cat      *cat,
     { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "Cat contents into OUTPUT", "OUTPUT" },
     { "buffer-size", 'b', 0, G_OPTION_ARG_INT, &buffer_size, "Read/Write buffer size", "BYTES" },
     { "queue-size", 'q', 0, G_OPTION_ARG_INT, &queue_size, "Amount of reads that can advance ahead of writes (default 32)", "COUNT" },
+    { "direct", 'D', 0, G_OPTION_ARG_NONE, &direct, "Read FILE with O_DIRECT, bypassing the page cache", NULL },
     { 0 }
   };
 
   memset (cat, 0, sizeof *cat);
 
   cat->buffer_size = buffer_size;
+  cat->alignment = 4096;
   cat->read_fd = -1;
   cat->write_fd = -1;
   cat->channel = dex_channel_new (queue_size);
@@ -150,14 +155,38 @@ cat_init (Cat      *cat,
     }
   else if (*argc == 2)
     {
-      if (-1 == (cat->read_fd = open ((*argv)[1], O_RDONLY)))
+      if (-1 == (cat->read_fd = open ((*argv)[1], O_RDONLY | (direct ? O_DIRECT : 0))))
         goto cleanup;
     }
+  else if (direct)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_INVAL,
+                           "Direct I/O requires a FILE");
+      goto cleanup;
+    }
   else
     {
       cat->read_fd = STDIN_FILENO;
     }
 
+  if (direct)
+    {
+      gsize memory_alignment;
+      gsize offset_alignment;
+
+      if (!dex_aio_query_direct_alignment (cat->read_fd, &memory_alignment, &offset_alignment, error))
+        goto cleanup;
+
+      /* Reads must use aligned buffers and be a multiple of the
+       * offset alignment in length.
+       */
+      cat->direct = TRUE;
+      cat->alignment = MAX (cat->alignment, MAX (memory_alignment, offset_alignment));
+      cat->buffer_size = (cat->buffer_size + cat->alignment - 1) & ~(cat->alignment - 1);
+    }
+
 #ifdef HAVE_POSIX_FADVISE
   len = lseek (cat->read_fd, 0, SEEK_END);
 
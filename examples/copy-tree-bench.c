@@ -0,0 +1,219 @@
+/* copy-tree-bench.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <libdex.h>
+
+/* NOTE:
+ *
+ * This compares `cp -r` against dex_file_copy_tree(). Unless a source
+ * directory is given, a tree of small and medium sized files is generated
+ * in the temporary directory first.
+ *
+ * Both copies read from the page cache after the first run, so run with
+ * --source on a cold cache (`echo 3 > /proc/sys/vm/drop_caches`) to
+ * measure the disk rather than the copy machinery. On filesystems with
+ * reflink support (Btrfs, XFS) the library copy will clone extents where
+ * `cp` from older coreutils copies data.
+ */
+
+static char *source;
+static int n_dirs = 64;
+static int n_files = 64;
+static int max_files;
+static int max_mb;
+
+static GMainLoop *main_loop;
+
+static void
+generate_tree (const char *path)
+{
+  g_autofree guint8 *buffer = g_malloc (1024*1024);
+  GError *error = NULL;
+
+  memset (buffer, 'X', 1024*1024);
+
+  for (int d = 0; d < n_dirs; d++)
+    {
+      g_autofree char *name = g_strdup_printf ("dir-%04d", d);
+      g_autofree char *dir = g_build_filename (path, name, NULL);
+
+      if (g_mkdir_with_parents (dir, 0750) != 0)
+        g_error ("Failed to create %s", dir);
+
+      for (int f = 0; f < n_files; f++)
+        {
+          g_autofree char *file_name = g_strdup_printf ("file-%04d", f);
+          g_autofree char *file = g_build_filename (dir, file_name, NULL);
+
+          /* Mostly small files, with the occasional large one */
+          gsize size = (f % 16 == 0) ? 1024*1024 : 4096 * (1 + (f % 8));
+
+          if (!g_file_set_contents (file, (const char *)buffer, size, &error))
+            g_error ("%s", error->message);
+        }
+    }
+}
+
+static void
+remove_tree (const char *path)
+{
+  const char *argv[] = { "rm", "-rf", path, NULL };
+
+  g_spawn_sync (NULL, (char **)argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, NULL, NULL, NULL);
+}
+
+static double
+run_cp (const char *from,
+        const char *to)
+{
+  const char *argv[] = { "cp", "-r", from, to, NULL };
+  gint64 begin = g_get_monotonic_time ();
+  GError *error = NULL;
+  int wait_status;
+
+  if (!g_spawn_sync (NULL, (char **)argv, NULL, G_SPAWN_SEARCH_PATH,
+                     NULL, NULL, NULL, NULL, &wait_status, &error) ||
+      !g_spawn_check_exit_status (wait_status, &error))
+    g_error ("cp: %s", error->message);
+
+  return (g_get_monotonic_time () - begin) / (double)G_USEC_PER_SEC;
+}
+
+static DexFuture *
+bench_fiber (gpointer user_data)
+{
+  g_autofree char *tmpdir = g_build_filename (g_get_tmp_dir (), "copy-tree-bench-XXXXXX", NULL);
+  g_autofree char *generated = NULL;
+  g_autofree char *cp_dest = NULL;
+  g_autofree char *dex_dest = NULL;
+  g_autoptr(GFile) from = NULL;
+  g_autoptr(GFile) to = NULL;
+  const char *src;
+  GError *error = NULL;
+  double cp_duration;
+  double dex_duration;
+  guint64 n_bytes;
+  gint64 begin;
+
+  if (g_mkdtemp (tmpdir) == NULL)
+    return dex_future_new_reject (G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to create %s", tmpdir);
+
+  if (source != NULL)
+    {
+      src = source;
+    }
+  else
+    {
+      generated = g_build_filename (tmpdir, "source", NULL);
+      generate_tree (generated);
+      src = generated;
+    }
+
+  cp_dest = g_build_filename (tmpdir, "cp", NULL);
+  dex_dest = g_build_filename (tmpdir, "dex", NULL);
+
+  cp_duration = run_cp (src, cp_dest);
+
+  from = g_file_new_for_path (src);
+  to = g_file_new_for_path (dex_dest);
+
+  begin = g_get_monotonic_time ();
+  n_bytes = dex_await_uint64 (dex_file_copy_tree (from, to, max_files, (guint64)max_mb * 1024 * 1024,
+                                                  NULL, NULL, NULL),
+                              &error);
+  dex_duration = (g_get_monotonic_time () - begin) / (double)G_USEC_PER_SEC;
+
+  remove_tree (tmpdir);
+
+  if (error != NULL)
+    return dex_future_new_for_error (error);
+
+  {
+    g_autofree char *size_str = g_format_size (n_bytes);
+    g_autofree char *cp_rate = g_format_size (n_bytes / cp_duration);
+    g_autofree char *dex_rate = g_format_size (n_bytes / dex_duration);
+
+    g_print ("Copied %s\n", size_str);
+    g_print ("%20s %10s %14s\n", "", "seconds", "throughput");
+    g_print ("%20s %10.3lf %12s/s\n", "cp -r", cp_duration, cp_rate);
+    g_print ("%20s %10.3lf %12s/s\n", "dex_file_copy_tree", dex_duration, dex_rate);
+    g_print ("%20s %9.2lfx\n", "speedup", cp_duration / dex_duration);
+  }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+quit_cb (DexFuture *completed,
+         gpointer   user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  if (!dex_future_get_value (completed, &error))
+    g_printerr ("copy-tree-bench: %s\n", error->message);
+
+  g_main_loop_quit (main_loop);
+
+  return NULL;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(DexFuture) future = NULL;
+  g_autoptr(GError) error = NULL;
+  GOptionEntry entries[] = {
+    { "source", 's', 0, G_OPTION_ARG_FILENAME, &source, "Copy an existing directory instead of a generated tree", "DIR" },
+    { "dirs", 'd', 0, G_OPTION_ARG_INT, &n_dirs, "Directories to generate (default 64)", "N" },
+    { "files", 'f', 0, G_OPTION_ARG_INT, &n_files, "Files to generate per directory (default 64)", "N" },
+    { "max-files", 0, 0, G_OPTION_ARG_INT, &max_files, "Maximum files in flight", "N" },
+    { "max-mb", 0, 0, G_OPTION_ARG_INT, &max_mb, "Maximum megabytes in flight", "MB" },
+    { NULL }
+  };
+
+  dex_init ();
+
+  context = g_option_context_new ("- Compare cp -r and dex_file_copy_tree()");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+
+  future = dex_scheduler_spawn (NULL, 0, bench_fiber, NULL, NULL);
+  future = dex_future_finally (future, quit_cb, NULL, NULL);
+
+  g_main_loop_run (main_loop);
+
+  g_main_loop_unref (main_loop);
+  g_free (source);
+
+  return EXIT_SUCCESS;
+}
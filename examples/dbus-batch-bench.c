@@ -0,0 +1,298 @@
+/* dbus-batch-bench.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+
+#include <libdex.h>
+
+/* NOTE:
+ *
+ * This compares issuing many dex_dbus_connection_call() requests against
+ * a single dex_dbus_connection_call_batch() over a peer-to-peer
+ * GDBusConnection on a socketpair, so no message bus is required. The
+ * peer runs in its own thread and main context.
+ */
+
+#define OBJECT_PATH    "/org/gnome/Dex/Bench"
+#define INTERFACE_NAME "org.gnome.Dex.Bench"
+
+static const char introspection_xml[] =
+  "<node>"
+  "  <interface name='" INTERFACE_NAME "'>"
+  "    <method name='Ping'>"
+  "      <arg type='u' name='value' direction='in'/>"
+  "      <arg type='u' name='value' direction='out'/>"
+  "    </method>"
+  "  </interface>"
+  "</node>";
+
+static int n_calls = 10000;
+static int n_rounds = 5;
+
+static void
+peer_method_call (GDBusConnection       *connection,
+                  const char            *sender,
+                  const char            *object_path,
+                  const char            *interface_name,
+                  const char            *method_name,
+                  GVariant              *parameters,
+                  GDBusMethodInvocation *invocation,
+                  gpointer               user_data)
+{
+  guint32 value;
+
+  g_variant_get (parameters, "(u)", &value);
+  g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", value));
+}
+
+static const GDBusInterfaceVTable peer_vtable = { peer_method_call };
+
+static void
+peer_closed_cb (GDBusConnection *connection,
+                gboolean         remote_peer_vanished,
+                GError          *error,
+                GMainLoop       *main_loop)
+{
+  g_main_loop_quit (main_loop);
+}
+
+static gpointer
+peer_thread (gpointer data)
+{
+  g_autoptr(GIOStream) stream = data;
+  g_autoptr(GMainContext) main_context = g_main_context_new ();
+  g_autoptr(GMainLoop) main_loop = g_main_loop_new (main_context, FALSE);
+  g_autoptr(GDBusConnection) connection = NULL;
+  g_autoptr(GDBusNodeInfo) node_info = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree char *guid = g_dbus_generate_guid ();
+
+  g_main_context_push_thread_default (main_context);
+
+  if (!(connection = g_dbus_connection_new_sync (stream,
+                                                 guid,
+                                                 (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER |
+                                                  G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING),
+                                                 NULL, NULL, &error)))
+    g_error ("%s", error->message);
+
+  node_info = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+
+  if (!g_dbus_connection_register_object (connection,
+                                          OBJECT_PATH,
+                                          node_info->interfaces[0],
+                                          &peer_vtable,
+                                          NULL, NULL, &error))
+    g_error ("%s", error->message);
+
+  g_signal_connect (connection, "closed", G_CALLBACK (peer_closed_cb), main_loop);
+  g_dbus_connection_start_message_processing (connection);
+
+  g_main_loop_run (main_loop);
+
+  g_main_context_pop_thread_default (main_context);
+
+  return NULL;
+}
+
+static GIOStream *
+stream_new_for_fd (int fd)
+{
+  g_autoptr(GSocket) socket = NULL;
+  g_autoptr(GError) error = NULL;
+
+  if (!(socket = g_socket_new_from_fd (fd, &error)))
+    g_error ("%s", error->message);
+
+  return G_IO_STREAM (g_socket_connection_factory_create_connection (socket));
+}
+
+static gboolean
+run_calls (GDBusConnection  *connection,
+           GError          **error)
+{
+  g_autoptr(GPtrArray) futures = g_ptr_array_new_with_free_func (dex_unref);
+
+  for (guint i = 0; i < (guint)n_calls; i++)
+    g_ptr_array_add (futures,
+                     dex_dbus_connection_call (connection,
+                                               NULL,
+                                               OBJECT_PATH,
+                                               INTERFACE_NAME,
+                                               "Ping",
+                                               g_variant_new ("(u)", i),
+                                               G_VARIANT_TYPE ("(u)"),
+                                               G_DBUS_CALL_FLAGS_NONE,
+                                               -1));
+
+  return dex_await (dex_future_allv ((DexFuture **)futures->pdata, futures->len), error);
+}
+
+static gboolean
+run_batch (GDBusConnection  *connection,
+           GError          **error)
+{
+  g_autoptr(GPtrArray) messages = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr(GPtrArray) replies = NULL;
+
+  for (guint i = 0; i < (guint)n_calls; i++)
+    {
+      GDBusMessage *message = g_dbus_message_new_method_call (NULL, OBJECT_PATH, INTERFACE_NAME, "Ping");
+
+      g_dbus_message_set_body (message, g_variant_new ("(u)", i));
+      g_ptr_array_add (messages, message);
+    }
+
+  if (!(replies = dex_await_boxed (dex_dbus_connection_call_batch (connection,
+                                                                   (GDBusMessage **)messages->pdata,
+                                                                   messages->len,
+                                                                   -1),
+                                   error)))
+    return FALSE;
+
+  for (guint i = 0; i < replies->len; i++)
+    {
+      if (g_dbus_message_to_gerror (g_ptr_array_index (replies, i), error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static DexFuture *
+bench_fiber (gpointer user_data)
+{
+  GDBusConnection *connection = user_data;
+  GError *error = NULL;
+
+  g_print ("%6s %16s %16s %8s\n", "round", "call", "call-batch", "ratio");
+
+  for (guint round = 0; round < (guint)n_rounds; round++)
+    {
+      double rate[2];
+
+      for (guint i = 0; i < G_N_ELEMENTS (rate); i++)
+        {
+          gint64 begin = g_get_monotonic_time ();
+          gboolean ret;
+
+          if (i == 0)
+            ret = run_calls (connection, &error);
+          else
+            ret = run_batch (connection, &error);
+
+          if (!ret)
+            return dex_future_new_for_error (error);
+
+          rate[i] = n_calls / ((g_get_monotonic_time () - begin) / (double)G_USEC_PER_SEC);
+        }
+
+      g_print ("%6u %12.0lf/sec %12.0lf/sec %7.2lfx\n",
+               round, rate[0], rate[1], rate[1] / rate[0]);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+quit_cb (DexFuture *completed,
+         gpointer   user_data)
+{
+  GMainLoop *main_loop = user_data;
+  g_autoptr(GError) error = NULL;
+
+  if (!dex_future_get_value (completed, &error))
+    g_printerr ("dbus-batch-bench: %s\n", error->message);
+
+  g_main_loop_quit (main_loop);
+
+  return NULL;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GMainLoop) main_loop = NULL;
+  g_autoptr(GDBusConnection) connection = NULL;
+  g_autoptr(GIOStream) stream = NULL;
+  g_autoptr(DexFuture) future = NULL;
+  g_autoptr(GError) error = NULL;
+  GThread *thread;
+  GOptionEntry entries[] = {
+    { "calls", 'n', 0, G_OPTION_ARG_INT, &n_calls, "Method calls per round (default 10000)", "N" },
+    { "rounds", 'r', 0, G_OPTION_ARG_INT, &n_rounds, "Number of rounds (default 5)", "N" },
+    { NULL }
+  };
+  int fds[2];
+
+  dex_init ();
+
+  context = g_option_context_new ("- Compare individual and batched D-Bus calls");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (n_calls <= 0)
+    n_calls = 10000;
+
+  if (n_rounds <= 0)
+    n_rounds = 5;
+
+  if (socketpair (AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, fds) != 0)
+    {
+      int errsv = errno;
+      g_printerr ("socketpair: %s\n", g_strerror (errsv));
+      return EXIT_FAILURE;
+    }
+
+  thread = g_thread_new ("dbus-peer", peer_thread, stream_new_for_fd (fds[1]));
+
+  stream = stream_new_for_fd (fds[0]);
+
+  if (!(connection = g_dbus_connection_new_sync (stream,
+                                                 NULL,
+                                                 G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                                 NULL, NULL, &error)))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+
+  future = dex_scheduler_spawn (NULL, 0, bench_fiber, connection, NULL);
+  future = dex_future_finally (future, quit_cb, g_main_loop_ref (main_loop), (GDestroyNotify)g_main_loop_unref);
+
+  g_main_loop_run (main_loop);
+
+  g_dbus_connection_close_sync (connection, NULL, NULL);
+  g_thread_join (thread);
+
+  return EXIT_SUCCESS;
+}
@@ -20,8 +20,44 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <libdex.h>
 
+/* NOTE:
+ *
+ * By default each connection sends its next request as soon as the previous
+ * one completes (closed-loop). With --rate, requests are instead due on a
+ * fixed schedule (open-loop) and latency is measured from when a request was
+ * due rather than when it was sent. Otherwise a stalled server would slow
+ * the client down and hide the stall from the results, which is commonly
+ * known as coordinated omission.
+ *
+ * Latencies are recorded in microseconds into a log-linear histogram in the
+ * style of HdrHistogram, which keeps about two significant digits of
+ * precision across the whole range with a fixed amount of memory.
+ */
+
+/* Closed-loop workers have no schedule to pace them, so they wait this
+ * long after a failed request instead of retrying in a tight loop.
+ */
+#define FAILURE_BACKOFF_MSEC 10
+
+#define HISTOGRAM_SUB_BUCKET_BITS 7
+#define HISTOGRAM_SUB_BUCKETS     (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_BUCKETS    (HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_MAX_SHIFT       32
+#define HISTOGRAM_N_BUCKETS       (HISTOGRAM_SUB_BUCKETS + HISTOGRAM_MAX_SHIFT * HISTOGRAM_HALF_BUCKETS)
+
+typedef struct _Histogram
+{
+  guint64 counts[HISTOGRAM_N_BUCKETS];
+  guint64 total;
+  guint64 sum;
+  guint64 min;
+  guint64 max;
+} Histogram;
+
 typedef struct _Worker
 {
   gint64 conn_attempts;
@@ -30,6 +66,10 @@ typedef struct _Worker
   gint64 conn_closed;
   gint64 bytes_sent;
   gint64 bytes_received;
+  gint64 requests;
+  gint64 req_failures;
+  gint64 start_time;
+  Histogram latency;
 } Worker;
 
 static DexScheduler *thread_pool;
@@ -41,45 +81,203 @@ static Worker *workers;
 static guint n_workers;
 static gboolean in_shutdown;
 static GTimer *timer;
+static gint64 interval;
+static gboolean keep_alive;
+static gboolean json;
+
+static guint
+histogram_index (guint64 value)
+{
+  guint shift = 0;
+
+  if (value < HISTOGRAM_SUB_BUCKETS)
+    return value;
+
+  /* Scale @value down until it fits in the upper half of the sub-buckets */
+  while ((value >> shift) >= HISTOGRAM_SUB_BUCKETS)
+    shift++;
+
+  if (shift > HISTOGRAM_MAX_SHIFT)
+    return HISTOGRAM_N_BUCKETS - 1;
+
+  return HISTOGRAM_SUB_BUCKETS
+       + (shift - 1) * HISTOGRAM_HALF_BUCKETS
+       + ((value >> shift) - HISTOGRAM_HALF_BUCKETS);
+}
+
+static guint64
+histogram_bucket_value (guint index)
+{
+  guint64 sub_bucket;
+  guint shift;
+
+  if (index < HISTOGRAM_SUB_BUCKETS)
+    return index;
+
+  index -= HISTOGRAM_SUB_BUCKETS;
+  shift = index / HISTOGRAM_HALF_BUCKETS + 1;
+  sub_bucket = index % HISTOGRAM_HALF_BUCKETS + HISTOGRAM_HALF_BUCKETS;
+
+  /* The highest value that lands in this bucket */
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+static void
+histogram_record (Histogram *histogram,
+                  guint64    value)
+{
+  histogram->counts[histogram_index (value)]++;
+
+  if (histogram->total == 0 || value < histogram->min)
+    histogram->min = value;
+
+  if (value > histogram->max)
+    histogram->max = value;
+
+  histogram->total++;
+  histogram->sum += value;
+}
+
+static void
+histogram_merge (Histogram       *dest,
+                 const Histogram *src)
+{
+  if (src->total == 0)
+    return;
+
+  for (guint i = 0; i < HISTOGRAM_N_BUCKETS; i++)
+    dest->counts[i] += src->counts[i];
+
+  if (dest->total == 0 || src->min < dest->min)
+    dest->min = src->min;
+
+  if (src->max > dest->max)
+    dest->max = src->max;
+
+  dest->total += src->total;
+  dest->sum += src->sum;
+}
+
+static guint64
+histogram_percentile (const Histogram *histogram,
+                      double           percentile)
+{
+  double exact = histogram->total * percentile / 100.;
+  guint64 target = (guint64)exact;
+  guint64 seen = 0;
+
+  if (histogram->total == 0)
+    return 0;
+
+  if (target < exact || target == 0)
+    target++;
+
+  for (guint i = 0; i < HISTOGRAM_N_BUCKETS; i++)
+    {
+      seen += histogram->counts[i];
+
+      if (seen >= target)
+        return MIN (histogram_bucket_value (i), histogram->max);
+    }
+
+  return histogram->max;
+}
 
 static DexFuture *
 worker_fiber (gpointer user_data)
 {
   g_autoptr(GSocketClient) client = NULL;
+  g_autoptr(GSocketConnection) connection = NULL;
   Worker *worker = user_data;
   g_autofree char *inbuf = g_malloc (buflen);
+  gint64 next_request = worker->start_time;
 
   client = g_socket_client_new ();
 
   while (!g_atomic_int_get (&in_shutdown))
     {
-      g_autoptr(GSocketConnection) connection = NULL;
       GOutputStream *output;
       GInputStream *input;
+      gint64 begin;
+      gsize n_written = 0;
+      gsize n_read = 0;
       gssize len;
 
-      worker->conn_attempts++;
+      if (interval > 0)
+        {
+          /* Requests that fall behind schedule are sent immediately but
+           * still measured from when they were due.
+           */
+          if (next_request > g_get_monotonic_time ())
+            dex_await (dex_timeout_new_deadline (next_request), NULL);
+
+          if (g_atomic_int_get (&in_shutdown))
+            break;
 
-      if (!(connection = dex_await_object (dex_socket_client_connect (client, socket_address), NULL)))
+          begin = next_request;
+          next_request += interval;
+        }
+      else
         {
-          worker->conn_failures++;
-          break;
+          begin = g_get_monotonic_time ();
         }
 
-      worker->conn_success++;
+      if (connection == NULL)
+        {
+          worker->conn_attempts++;
+
+          if (!(connection = dex_await_object (dex_socket_client_connect (client, socket_address), NULL)))
+            {
+              worker->conn_failures++;
+              goto failure;
+            }
+
+          worker->conn_success++;
+        }
 
       output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
       input = g_io_stream_get_input_stream (G_IO_STREAM (connection));
 
-      if ((len = dex_await_int64 (dex_output_stream_write (output, buf, buflen, G_PRIORITY_DEFAULT), NULL)) <= 0)
-        break;
-      worker->bytes_sent += len;
+      while (n_written < buflen)
+        {
+          if ((len = dex_await_int64 (dex_output_stream_write (output, buf + n_written, buflen - n_written, G_PRIORITY_DEFAULT), NULL)) <= 0)
+            goto failure;
+          n_written += len;
+          worker->bytes_sent += len;
+        }
+
+      /* The echo may arrive in pieces, so wait for all of it */
+      while (n_read < buflen)
+        {
+          if ((len = dex_await_int64 (dex_input_stream_read (input, inbuf + n_read, buflen - n_read, G_PRIORITY_DEFAULT), NULL)) <= 0)
+            goto failure;
+          n_read += len;
+          worker->bytes_received += len;
+        }
+
+      histogram_record (&worker->latency, g_get_monotonic_time () - begin);
+      worker->requests++;
+
+      if (!keep_alive)
+        {
+          dex_await (dex_io_stream_close (G_IO_STREAM (connection), G_PRIORITY_DEFAULT), NULL);
+          g_clear_object (&connection);
+          worker->conn_closed++;
+        }
 
-      if ((len = dex_await_int64 (dex_input_stream_read (input, inbuf, buflen, G_PRIORITY_DEFAULT), NULL)) <= 0)
-        break;
-      worker->bytes_received += len;
+      continue;
 
-      dex_await (dex_io_stream_close (G_IO_STREAM (connection), G_PRIORITY_DEFAULT), NULL);
+    failure:
+      /* Failed requests still take their place in the schedule and are
+       * measured, otherwise a failing server would look faster. The next
+       * request reconnects.
+       */
+      histogram_record (&worker->latency, g_get_monotonic_time () - begin);
+      worker->req_failures++;
+      g_clear_object (&connection);
+
+      if (interval == 0)
+        dex_await (dex_timeout_new_msec (FAILURE_BACKOFF_MSEC), NULL);
     }
 
   return NULL;
@@ -105,42 +303,163 @@ quit_cb (DexFuture *completed,
   return NULL;
 }
 
+static Worker *
+collect_totals (void)
+{
+  Worker *total = g_new0 (Worker, 1);
+
+  for (guint i = 0; i < n_workers; i++)
+    {
+      total->conn_attempts += workers[i].conn_attempts;
+      total->conn_failures += workers[i].conn_failures;
+      total->conn_success += workers[i].conn_success;
+      total->conn_closed += workers[i].conn_closed;
+      total->bytes_sent += workers[i].bytes_sent;
+      total->bytes_received += workers[i].bytes_received;
+      total->requests += workers[i].requests;
+      total->req_failures += workers[i].req_failures;
+      histogram_merge (&total->latency, &workers[i].latency);
+    }
+
+  return total;
+}
+
 static gboolean
 print_live_status (gpointer data)
 {
-  Worker total = {0};
+  g_autofree Worker *total = collect_totals ();
   double duration = g_timer_elapsed (timer, NULL);
   g_autofree char *sent_per_sec = NULL;
   g_autofree char *recv_per_sec = NULL;
 
-  for (guint i = 0; i < n_workers; i++)
-    {
-      total.conn_attempts += workers[i].conn_attempts;
-      total.conn_failures += workers[i].conn_failures;
-      total.conn_success += workers[i].conn_success;
-      total.conn_closed += workers[i].conn_closed;
-      total.bytes_sent += workers[i].bytes_sent;
-      total.bytes_received += workers[i].bytes_received;
-    }
-
-  sent_per_sec = g_format_size (total.bytes_sent/duration);
-  recv_per_sec = g_format_size (total.bytes_received/duration);
+  sent_per_sec = g_format_size (total->bytes_sent/duration);
+  recv_per_sec = g_format_size (total->bytes_received/duration);
 
   g_printerr ("\n");
   g_printerr ("  req: succ=%"G_GINT64_FORMAT" (per-sec %0.2lf) fail=%"G_GINT64_FORMAT" (per-sec=%0.2lf)\n",
-              total.conn_success, total.conn_success/duration,
-              total.conn_failures, total.conn_failures/duration);
+              total->requests, total->requests/duration,
+              total->req_failures, total->req_failures/duration);
   g_printerr ("bytes: sent=%"G_GINT64_FORMAT" (per-sec %s) recv=%"G_GINT64_FORMAT" (per-sec %s)\n",
-              total.bytes_sent, sent_per_sec,
-              total.bytes_received, recv_per_sec);
+              total->bytes_sent, sent_per_sec,
+              total->bytes_received, recv_per_sec);
+  g_printerr ("  lat: p50=%"G_GUINT64_FORMAT"us p99=%"G_GUINT64_FORMAT"us p999=%"G_GUINT64_FORMAT"us max=%"G_GUINT64_FORMAT"us\n",
+              histogram_percentile (&total->latency, 50),
+              histogram_percentile (&total->latency, 99),
+              histogram_percentile (&total->latency, 99.9),
+              total->latency.max);
 
   return G_SOURCE_CONTINUE;
 }
 
 static void
-print_results (void)
+append_json_string (GString    *str,
+                    const char *value)
+{
+  g_string_append_c (str, '"');
+
+  for (const char *c = value; *c; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        g_string_append_printf (str, "\\%c", *c);
+      else if ((guchar)*c < 0x20)
+        g_string_append_printf (str, "\\u%04x", (guchar)*c);
+      else
+        g_string_append_c (str, *c);
+    }
+
+  g_string_append_c (str, '"');
+}
+
+static void
+print_json (const char *address,
+            int         length,
+            int         rate)
+{
+  g_autofree Worker *total = collect_totals ();
+  g_autoptr(GString) str = g_string_new (NULL);
+  const Histogram *latency = &total->latency;
+  double duration = g_timer_elapsed (timer, NULL);
+  gboolean first = TRUE;
+
+  g_string_append (str, "{\n  \"address\": ");
+  append_json_string (str, address);
+  g_string_append_printf (str,
+                          ",\n"
+                          "  \"mode\": \"%s\",\n"
+                          "  \"connections\": %u,\n"
+                          "  \"length\": %d,\n"
+                          "  \"rate\": %d,\n"
+                          "  \"keep_alive\": %s,\n"
+                          "  \"duration\": %.3lf,\n",
+                          interval > 0 ? "open-loop" : "closed-loop",
+                          n_workers,
+                          length,
+                          rate,
+                          keep_alive ? "true" : "false",
+                          duration);
+  g_string_append_printf (str,
+                          "  \"requests\": %"G_GINT64_FORMAT",\n"
+                          "  \"requests_per_sec\": %.2lf,\n"
+                          "  \"request_failures\": %"G_GINT64_FORMAT",\n"
+                          "  \"connection_attempts\": %"G_GINT64_FORMAT",\n"
+                          "  \"connection_failures\": %"G_GINT64_FORMAT",\n"
+                          "  \"bytes_sent\": %"G_GINT64_FORMAT",\n"
+                          "  \"bytes_received\": %"G_GINT64_FORMAT",\n",
+                          total->requests,
+                          total->requests / duration,
+                          total->req_failures,
+                          total->conn_attempts,
+                          total->conn_failures,
+                          total->bytes_sent,
+                          total->bytes_received);
+  g_string_append_printf (str,
+                          "  \"latency_usec\": {\n"
+                          "    \"min\": %"G_GUINT64_FORMAT",\n"
+                          "    \"mean\": %.2lf,\n"
+                          "    \"p50\": %"G_GUINT64_FORMAT",\n"
+                          "    \"p90\": %"G_GUINT64_FORMAT",\n"
+                          "    \"p99\": %"G_GUINT64_FORMAT",\n"
+                          "    \"p999\": %"G_GUINT64_FORMAT",\n"
+                          "    \"p9999\": %"G_GUINT64_FORMAT",\n"
+                          "    \"max\": %"G_GUINT64_FORMAT"\n"
+                          "  },\n"
+                          "  \"histogram\": [",
+                          latency->min,
+                          latency->total ? latency->sum / (double)latency->total : 0.,
+                          histogram_percentile (latency, 50),
+                          histogram_percentile (latency, 90),
+                          histogram_percentile (latency, 99),
+                          histogram_percentile (latency, 99.9),
+                          histogram_percentile (latency, 99.99),
+                          latency->max);
+
+  /* Pairs of the highest value in each bucket and its count */
+  for (guint i = 0; i < HISTOGRAM_N_BUCKETS; i++)
+    {
+      if (latency->counts[i] == 0)
+        continue;
+
+      g_string_append_printf (str, "%s[%"G_GUINT64_FORMAT", %"G_GUINT64_FORMAT"]",
+                              first ? "" : ", ",
+                              histogram_bucket_value (i),
+                              latency->counts[i]);
+      first = FALSE;
+    }
+
+  g_string_append (str, "]\n}\n");
+
+  g_print ("%s", str->str);
+}
+
+static void
+print_results (const char *address,
+               int         length,
+               int         rate)
 {
   print_live_status (NULL);
+
+  if (json)
+    print_json (address, length, rate);
 }
 
 int
@@ -156,6 +475,8 @@ main (int   argc,
   int length = 0;
   int duration = 0;
   int number = 0;
+  int rate = 0;
+  gint64 start_time;
 
   GOptionEntry entries[] = {
     { "address", 'a', 0, G_OPTION_ARG_STRING, &address, "Target echo server adderss.", "0.0.0.0:8080" },
@@ -163,6 +484,9 @@ main (int   argc,
     { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Test duration in seconds.", "SECONDS" },
     { "number", 'c', 0, G_OPTION_ARG_INT, &number, "Number of concurrent connections.", "CONNECTIONS" },
     { "message", 'm', 0, G_OPTION_ARG_STRING, &message, "A custom message to send.", "MSG" },
+    { "rate", 'r', 0, G_OPTION_ARG_INT, &rate, "Total requests per second across all connections (open-loop).", "REQUESTS" },
+    { "keep-alive", 'k', 0, G_OPTION_ARG_NONE, &keep_alive, "Reuse connections rather than connecting per request.", NULL },
+    { "json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print final results as JSON to stdout.", NULL },
     { NULL }
   };
 
@@ -216,6 +540,13 @@ main (int   argc,
   g_printerr ("Benchmarking: %s\n", address);
   g_printerr ("%u clients, running %u bytes, %u sec.\n", number, length, duration);
 
+  /* Each connection gets an equal share of the requested rate */
+  if (rate > 0)
+    {
+      interval = MAX (1, (gint64)number * G_USEC_PER_SEC / rate);
+      g_printerr ("Open-loop at %d requests/sec (every %"G_GINT64_FORMAT" usec per client).\n", rate, interval);
+    }
+
   /* Space for the workers to track information */
   n_workers = number;
   workers = g_new0 (Worker, n_workers);
@@ -226,12 +557,18 @@ main (int   argc,
   main_loop = g_main_loop_new (NULL, FALSE);
   thread_pool = dex_thread_pool_scheduler_new ();
   timer = g_timer_new ();
+  start_time = g_get_monotonic_time ();
 
-  /* Hold a reference to the fibers so we can join them */
+  /* Hold a reference to the fibers so we can join them. Stagger the first
+   * request of each client so open-loop requests are spread evenly.
+   */
   fibers = g_ptr_array_new_with_free_func (dex_unref);
   for (int i = 0; i < number; i++)
-    g_ptr_array_add (fibers,
-                     dex_scheduler_spawn (thread_pool, 0, worker_fiber, &workers[i], NULL));
+    {
+      workers[i].start_time = start_time + interval * i / number;
+      g_ptr_array_add (fibers,
+                       dex_scheduler_spawn (thread_pool, 0, worker_fiber, &workers[i], NULL));
+    }
 
   /* After @duration seconds, reject */
   future = dex_timeout_new_seconds (duration);
@@ -247,7 +584,7 @@ main (int   argc,
 
   g_main_loop_run (main_loop);
 
-  print_results ();
+  print_results (address, length, rate);
 
   /* Cleanup state */
   g_object_unref (socket_address);
@@ -0,0 +1,332 @@
+/* send-zc-bench.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <libdex.h>
+
+/* NOTE:
+ *
+ * This compares dex_aio_send() against dex_aio_send_zc() over a TCP
+ * connection on the loopback device. Keep in mind that the kernel will
+ * copy anyway when delivering zero-copy sends to loopback, so the numbers
+ * here mostly reflect the overhead of the notification round-trip. Point
+ * --address at a remote sink (such as `nc -l 9000 > /dev/null`) to measure
+ * the benefit on real hardware.
+ */
+
+#define MIN_PAYLOAD_SIZE (64*1024)
+#define MAX_PAYLOAD_SIZE (4*1024*1024)
+
+typedef struct _Run
+{
+  int       send_fd;
+  int       recv_fd;
+  gsize     payload_size;
+  gsize     to_transfer;
+  gboolean  zerocopy;
+} Run;
+
+static guint8 *payload;
+static int total_mb = 512;
+static char *address;
+
+static DexFuture *
+sender_fiber (gpointer user_data)
+{
+  Run *run = user_data;
+  gsize remaining = run->to_transfer;
+  GError *error = NULL;
+
+  while (remaining > 0)
+    {
+      gsize to_send = MIN (remaining, run->payload_size);
+      gsize sent = 0;
+
+      /* Short sends are possible, so complete the whole payload before
+       * moving on to the next.
+       */
+      while (sent < to_send)
+        {
+          DexFuture *future;
+          gssize len;
+
+          if (run->zerocopy)
+            future = dex_aio_send_zc (NULL, run->send_fd, payload + sent, to_send - sent, MSG_NOSIGNAL);
+          else
+            future = dex_aio_send (NULL, run->send_fd, payload + sent, to_send - sent, MSG_NOSIGNAL);
+
+          if ((len = dex_await_int64 (future, &error)) <= 0)
+            goto failure;
+
+          sent += len;
+        }
+
+      remaining -= to_send;
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+
+failure:
+  if (error == NULL)
+    error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CLOSED, "Connection closed");
+
+  return dex_future_new_for_error (error);
+}
+
+static DexFuture *
+receiver_fiber (gpointer user_data)
+{
+  Run *run = user_data;
+  g_autofree guint8 *buffer = g_malloc (MAX_PAYLOAD_SIZE);
+  gsize remaining = run->to_transfer;
+  GError *error = NULL;
+
+  /* There is no receiver when benchmarking against a remote sink */
+  if (run->recv_fd < 0)
+    return dex_future_new_for_boolean (TRUE);
+
+  while (remaining > 0)
+    {
+      gssize len;
+
+      len = dex_await_int64 (dex_aio_read (NULL, run->recv_fd, buffer, MIN (remaining, MAX_PAYLOAD_SIZE), -1), &error);
+
+      if (len <= 0)
+        {
+          if (error == NULL)
+            error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CLOSED, "Connection closed");
+          return dex_future_new_for_error (error);
+        }
+
+      remaining -= len;
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static gboolean
+connect_loopback (int     *send_fd,
+                  int     *recv_fd,
+                  GError **error)
+{
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl (INADDR_LOOPBACK) };
+  socklen_t addrlen = sizeof addr;
+  int listen_fd = -1;
+  int one = 1;
+  int errsv;
+
+  *send_fd = -1;
+  *recv_fd = -1;
+
+  if (-1 == (listen_fd = socket (AF_INET, SOCK_STREAM|SOCK_CLOEXEC, 0)) ||
+      bind (listen_fd, (struct sockaddr *)&addr, sizeof addr) != 0 ||
+      listen (listen_fd, 1) != 0 ||
+      getsockname (listen_fd, (struct sockaddr *)&addr, &addrlen) != 0 ||
+      -1 == (*send_fd = socket (AF_INET, SOCK_STREAM|SOCK_CLOEXEC, 0)) ||
+      connect (*send_fd, (struct sockaddr *)&addr, addrlen) != 0 ||
+      -1 == (*recv_fd = accept (listen_fd, NULL, NULL)))
+    goto failure;
+
+  setsockopt (*send_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+  close (listen_fd);
+
+  return TRUE;
+
+failure:
+  errsv = errno;
+
+  if (listen_fd != -1)
+    close (listen_fd);
+
+  if (*send_fd != -1)
+    close (*send_fd);
+
+  if (*recv_fd != -1)
+    close (*recv_fd);
+
+  g_set_error_literal (error,
+                       G_IO_ERROR,
+                       g_io_error_from_errno (errsv),
+                       g_strerror (errsv));
+
+  return FALSE;
+}
+
+static gboolean
+connect_remote (int     *send_fd,
+                GError **error)
+{
+  g_autoptr(GSocketConnectable) connectable = NULL;
+  g_autoptr(GSocketClient) client = NULL;
+  g_autoptr(GSocketConnection) connection = NULL;
+  GSocket *socket;
+
+  if (!(connectable = g_network_address_parse (address, 9000, error)))
+    return FALSE;
+
+  client = g_socket_client_new ();
+
+  if (!(connection = g_socket_client_connect (client, connectable, NULL, error)))
+    return FALSE;
+
+  socket = g_socket_connection_get_socket (connection);
+  *send_fd = dup (g_socket_get_fd (socket));
+
+  return TRUE;
+}
+
+static DexFuture *
+bench_fiber (gpointer user_data)
+{
+  GError *error = NULL;
+  int send_fd = -1;
+  int recv_fd = -1;
+
+  if (address != NULL)
+    {
+      if (!connect_remote (&send_fd, &error))
+        return dex_future_new_for_error (error);
+    }
+  else
+    {
+      if (!connect_loopback (&send_fd, &recv_fd, &error))
+        return dex_future_new_for_error (error);
+    }
+
+  g_print ("%10s %14s %14s %8s\n", "payload", "send", "send-zc", "ratio");
+
+  for (gsize payload_size = MIN_PAYLOAD_SIZE;
+       payload_size <= MAX_PAYLOAD_SIZE;
+       payload_size *= 2)
+    {
+      g_autofree char *payload_str = g_format_size_full (payload_size, G_FORMAT_SIZE_IEC_UNITS);
+      double rate[2];
+
+      for (guint i = 0; i < G_N_ELEMENTS (rate); i++)
+        {
+          Run run = {
+            .send_fd = send_fd,
+            .recv_fd = recv_fd,
+            .payload_size = payload_size,
+            .to_transfer = (gsize)total_mb * 1024 * 1024,
+            .zerocopy = i == 1,
+          };
+          gint64 begin = g_get_monotonic_time ();
+          double duration;
+
+          if (!dex_await (dex_future_all (dex_scheduler_spawn (NULL, 0, sender_fiber, &run, NULL),
+                                          dex_scheduler_spawn (NULL, 0, receiver_fiber, &run, NULL),
+                                          NULL),
+                          &error))
+            goto failure;
+
+          duration = (g_get_monotonic_time () - begin) / (double)G_USEC_PER_SEC;
+          rate[i] = run.to_transfer / duration;
+        }
+
+      {
+        g_autofree char *send_str = g_format_size (rate[0]);
+        g_autofree char *send_zc_str = g_format_size (rate[1]);
+
+        g_print ("%10s %12s/s %12s/s %7.2lfx\n",
+                 payload_str, send_str, send_zc_str, rate[1] / rate[0]);
+      }
+    }
+
+  close (send_fd);
+  if (recv_fd != -1)
+    close (recv_fd);
+
+  return dex_future_new_for_boolean (TRUE);
+
+failure:
+  close (send_fd);
+  if (recv_fd != -1)
+    close (recv_fd);
+
+  return dex_future_new_for_error (error);
+}
+
+static DexFuture *
+quit_cb (DexFuture *completed,
+         gpointer   user_data)
+{
+  GMainLoop *main_loop = user_data;
+  g_autoptr(GError) error = NULL;
+
+  if (!dex_future_get_value (completed, &error))
+    g_printerr ("send-zc-bench: %s\n", error->message);
+
+  g_main_loop_quit (main_loop);
+
+  return NULL;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GMainLoop) main_loop = NULL;
+  g_autoptr(DexFuture) future = NULL;
+  g_autoptr(GError) error = NULL;
+  GOptionEntry entries[] = {
+    { "address", 'a', 0, G_OPTION_ARG_STRING, &address, "Send to a remote sink instead of loopback", "HOST:PORT" },
+    { "total", 't', 0, G_OPTION_ARG_INT, &total_mb, "Megabytes to transfer per payload size (default 512)", "MB" },
+    { NULL }
+  };
+
+  dex_init ();
+
+  context = g_option_context_new ("- Compare send() and zero-copy send() throughput");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (total_mb <= 0)
+    total_mb = 512;
+
+  payload = g_malloc (MAX_PAYLOAD_SIZE);
+  memset (payload, 'X', MAX_PAYLOAD_SIZE);
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+
+  future = dex_scheduler_spawn (NULL, 0, bench_fiber, NULL, NULL);
+  future = dex_future_finally (future, quit_cb, g_main_loop_ref (main_loop), (GDestroyNotify)g_main_loop_unref);
+
+  g_main_loop_run (main_loop);
+
+  g_free (payload);
+  g_free (address);
+
+  return EXIT_SUCCESS;
+}
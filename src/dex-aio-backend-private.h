@@ -20,8 +20,11 @@
 
 #pragma once
 
+#include <gio/gio.h>
+
 #include "dex-object-private.h"
 #include "dex-future.h"
+#include "dex-stats-private.h"
 
 G_BEGIN_DECLS
 
@@ -57,12 +60,58 @@ struct _DexAioBackendClass
                                     gconstpointer  buffer,
                                     gsize          count,
                                     goffset        offset);
+  DexFuture     *(*read_direct)    (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    gpointer       buffer,
+                                    gsize          count,
+                                    goffset        offset);
+  DexFuture     *(*write_direct)   (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    gconstpointer  buffer,
+                                    gsize          count,
+                                    goffset        offset);
+  DexFuture     *(*writev)         (DexAioBackend       *aio_backend,
+                                    DexAioContext       *aio_context,
+                                    int                  fd,
+                                    const GOutputVector *vectors,
+                                    gsize                n_vectors,
+                                    goffset              offset);
+  DexFuture     *(*send)           (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    gconstpointer  buffer,
+                                    gsize          count,
+                                    int            flags);
+  DexFuture     *(*send_zc)        (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    gconstpointer  buffer,
+                                    gsize          count,
+                                    int            flags);
+  DexFuture     *(*poll)           (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    GIOCondition   condition);
+  DexFuture     *(*fadvise)        (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    goffset        offset,
+                                    goffset        length,
+                                    int            advice);
+  DexFuture     *(*madvise)        (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    gpointer       address,
+                                    gsize          length,
+                                    int            advice);
 };
 
 struct _DexAioContext
 {
   GSource        parent_source;
   DexAioBackend *aio_backend;
+  DexStats       stats;
   /*< private >*/
 };
 
@@ -81,5 +130,50 @@ DexFuture     *dex_aio_backend_write          (DexAioBackend *aio_backend,
                                                gconstpointer  buffer,
                                                gsize          count,
                                                goffset        offset);
+DexFuture     *dex_aio_backend_read_direct    (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               gpointer       buffer,
+                                               gsize          count,
+                                               goffset        offset);
+DexFuture     *dex_aio_backend_write_direct   (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               gconstpointer  buffer,
+                                               gsize          count,
+                                               goffset        offset);
+DexFuture     *dex_aio_backend_writev         (DexAioBackend       *aio_backend,
+                                               DexAioContext       *aio_context,
+                                               int                  fd,
+                                               const GOutputVector *vectors,
+                                               gsize                n_vectors,
+                                               goffset              offset);
+DexFuture     *dex_aio_backend_send           (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               gconstpointer  buffer,
+                                               gsize          count,
+                                               int            flags);
+DexFuture     *dex_aio_backend_send_zc        (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               gconstpointer  buffer,
+                                               gsize          count,
+                                               int            flags);
+DexFuture     *dex_aio_backend_poll           (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               GIOCondition   condition);
+DexFuture     *dex_aio_backend_fadvise        (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               int            fd,
+                                               goffset        offset,
+                                               goffset        length,
+                                               int            advice);
+DexFuture     *dex_aio_backend_madvise        (DexAioBackend *aio_backend,
+                                               DexAioContext *aio_context,
+                                               gpointer       address,
+                                               gsize          length,
+                                               int            advice);
 
 G_END_DECLS
@@ -43,9 +43,14 @@ dex_aio_backend_init (DexAioBackend *aio_backend)
 DexAioContext *
 dex_aio_backend_create_context (DexAioBackend *aio_backend)
 {
+  DexAioContext *aio_context;
+
   g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
 
-  return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->create_context (aio_backend);
+  if ((aio_context = DEX_AIO_BACKEND_GET_CLASS (aio_backend)->create_context (aio_backend)))
+    dex_stats_register (&aio_context->stats, NULL);
+
+  return aio_context;
 }
 
 DexFuture *
@@ -59,6 +64,8 @@ dex_aio_backend_read (DexAioBackend *aio_backend,
   g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
   g_return_val_if_fail (aio_context != NULL, NULL);
 
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
   return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->read (aio_backend, aio_context, fd, buffer, count, offset);
 }
 
@@ -73,9 +80,168 @@ dex_aio_backend_write (DexAioBackend *aio_backend,
   g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
   g_return_val_if_fail (aio_context != NULL, NULL);
 
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
   return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->write (aio_backend, aio_context, fd, buffer, count, offset);
 }
 
+DexFuture *
+dex_aio_backend_read_direct (DexAioBackend *aio_backend,
+                             DexAioContext *aio_context,
+                             int            fd,
+                             gpointer       buffer,
+                             gsize          count,
+                             goffset        offset)
+{
+  DexAioBackendClass *aio_backend_class;
+
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  aio_backend_class = DEX_AIO_BACKEND_GET_CLASS (aio_backend);
+
+  if (aio_backend_class->read_direct == NULL)
+    return aio_backend_class->read (aio_backend, aio_context, fd, buffer, count, offset);
+
+  return aio_backend_class->read_direct (aio_backend, aio_context, fd, buffer, count, offset);
+}
+
+DexFuture *
+dex_aio_backend_write_direct (DexAioBackend *aio_backend,
+                              DexAioContext *aio_context,
+                              int            fd,
+                              gconstpointer  buffer,
+                              gsize          count,
+                              goffset        offset)
+{
+  DexAioBackendClass *aio_backend_class;
+
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  aio_backend_class = DEX_AIO_BACKEND_GET_CLASS (aio_backend);
+
+  if (aio_backend_class->write_direct == NULL)
+    return aio_backend_class->write (aio_backend, aio_context, fd, buffer, count, offset);
+
+  return aio_backend_class->write_direct (aio_backend, aio_context, fd, buffer, count, offset);
+}
+
+DexFuture *
+dex_aio_backend_writev (DexAioBackend       *aio_backend,
+                        DexAioContext       *aio_context,
+                        int                  fd,
+                        const GOutputVector *vectors,
+                        gsize                n_vectors,
+                        goffset              offset)
+{
+  DexAioBackendClass *aio_backend_class;
+
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+  g_return_val_if_fail (vectors != NULL, NULL);
+  g_return_val_if_fail (n_vectors > 0, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  aio_backend_class = DEX_AIO_BACKEND_GET_CLASS (aio_backend);
+
+  /* A short write of the first vector is still a valid writev() result */
+  if (aio_backend_class->writev == NULL)
+    return aio_backend_class->write (aio_backend, aio_context, fd, vectors[0].buffer, vectors[0].size, offset);
+
+  return aio_backend_class->writev (aio_backend, aio_context, fd, vectors, n_vectors, offset);
+}
+
+DexFuture *
+dex_aio_backend_send (DexAioBackend *aio_backend,
+                      DexAioContext *aio_context,
+                      int            fd,
+                      gconstpointer  buffer,
+                      gsize          count,
+                      int            flags)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->send (aio_backend, aio_context, fd, buffer, count, flags);
+}
+
+DexFuture *
+dex_aio_backend_send_zc (DexAioBackend *aio_backend,
+                         DexAioContext *aio_context,
+                         int            fd,
+                         gconstpointer  buffer,
+                         gsize          count,
+                         int            flags)
+{
+  DexAioBackendClass *aio_backend_class;
+
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  aio_backend_class = DEX_AIO_BACKEND_GET_CLASS (aio_backend);
+
+  /* Backends without a zero-copy path just copy like send() would */
+  if (aio_backend_class->send_zc == NULL)
+    return aio_backend_class->send (aio_backend, aio_context, fd, buffer, count, flags);
+
+  return aio_backend_class->send_zc (aio_backend, aio_context, fd, buffer, count, flags);
+}
+
+DexFuture *
+dex_aio_backend_poll (DexAioBackend *aio_backend,
+                      DexAioContext *aio_context,
+                      int            fd,
+                      GIOCondition   condition)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->poll (aio_backend, aio_context, fd, condition);
+}
+
+DexFuture *
+dex_aio_backend_fadvise (DexAioBackend *aio_backend,
+                         DexAioContext *aio_context,
+                         int            fd,
+                         goffset        offset,
+                         goffset        length,
+                         int            advice)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->fadvise (aio_backend, aio_context, fd, offset, length, advice);
+}
+
+DexFuture *
+dex_aio_backend_madvise (DexAioBackend *aio_backend,
+                         DexAioContext *aio_context,
+                         gpointer       address,
+                         gsize          length,
+                         int            advice)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BACKEND (aio_backend), NULL);
+  g_return_val_if_fail (aio_context != NULL, NULL);
+
+  dex_stats_counter_add (&aio_context->stats.aio_submitted, 1);
+
+  return DEX_AIO_BACKEND_GET_CLASS (aio_backend)->madvise (aio_backend, aio_context, address, length, advice);
+}
+
 DexAioBackend *
 dex_aio_backend_get_default (void)
 {
@@ -0,0 +1,33 @@
+/*
+ * dex-aio-buffer-pool-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-aio-buffer-pool.h"
+#include "dex-future.h"
+
+G_BEGIN_DECLS
+
+GBytes    *dex_aio_buffer_pool_acquire_for_size (gsize      size);
+DexFuture *dex_aio_buffer_pool_wrap_read        (DexFuture *future,
+                                                 GBytes    *buffer);
+
+G_END_DECLS
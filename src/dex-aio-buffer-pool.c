@@ -0,0 +1,591 @@
+/*
+ * dex-aio-buffer-pool.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-aio.h"
+#include "dex-aio-buffer-pool-private.h"
+#include "dex-compat-private.h"
+#include "dex-future-private.h"
+#include "dex-object-private.h"
+
+/**
+ * DexAioBufferPool:
+ *
+ * #DexAioBufferPool provides fixed-size buffers with a specific memory
+ * alignment such as is required for `O_DIRECT` I/O.
+ *
+ * Buffers are leased to the caller as a #GBytes. When the last reference
+ * to the #GBytes is released, the buffer is returned to the pool so that
+ * it may be reused without another allocation.
+ *
+ * A set of process-wide pools with power-of-two buffer sizes is available
+ * from dex_aio_buffer_pool_get_shared(). Those pools additionally keep a
+ * small per-thread cache of released buffers so that a thread which
+ * repeatedly reads into and releases buffers (such as a streaming
+ * connection) does not contend on the pool lock.
+ *
+ * Since: 0.8
+ */
+
+/* The number of released buffers we keep around for reuse. Anything
+ * more than this is freed so that the pool does not permanently hold
+ * on to a peak of memory.
+ */
+#define MAX_CACHED_BUFFERS 32
+
+/* Shared pools cover 4 KiB through 1 MiB in power-of-two steps */
+#define SHARED_MIN_SHIFT       12
+#define SHARED_MAX_SHIFT       20
+#define N_SHARED_POOLS         (SHARED_MAX_SHIFT - SHARED_MIN_SHIFT + 1)
+#define SHARED_ALIGNMENT       4096
+#define MAX_THREAD_CACHED      8
+
+typedef struct _DexAioBufferLease
+{
+  GList             link;
+  DexAioBufferPool *buffer_pool;
+  gpointer          data;
+} DexAioBufferLease;
+
+struct _DexAioBufferPool
+{
+  DexObject parent_instance;
+  gsize     buffer_size;
+  gsize     alignment;
+  GQueue    cached;
+  guint     shared : 1;
+  guint     size_class : 5;
+};
+
+typedef struct _DexAioBufferThreadCache
+{
+  GQueue cached[N_SHARED_POOLS];
+} DexAioBufferThreadCache;
+
+static void dex_aio_buffer_thread_cache_free (gpointer data);
+
+static DexAioBufferPool *shared_pools[N_SHARED_POOLS];
+static GPrivate thread_cache_key = G_PRIVATE_INIT (dex_aio_buffer_thread_cache_free);
+
+typedef struct _DexAioBufferPoolClass
+{
+  DexObjectClass parent_class;
+} DexAioBufferPoolClass;
+
+DEX_DEFINE_FINAL_TYPE (DexAioBufferPool, dex_aio_buffer_pool, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_AIO_BUFFER_POOL
+#define DEX_TYPE_AIO_BUFFER_POOL dex_aio_buffer_pool_type
+
+static void
+dex_aio_buffer_lease_free (DexAioBufferLease *lease)
+{
+  g_assert (lease != NULL);
+  g_assert (lease->buffer_pool == NULL);
+  g_assert (lease->link.prev == NULL);
+  g_assert (lease->link.next == NULL);
+
+  g_aligned_free (lease->data);
+  g_free (lease);
+}
+
+static void
+dex_aio_buffer_thread_cache_free (gpointer data)
+{
+  DexAioBufferThreadCache *thread_cache = data;
+
+  for (guint i = 0; i < N_SHARED_POOLS; i++)
+    {
+      while (thread_cache->cached[i].length > 0)
+        dex_aio_buffer_lease_free (g_queue_pop_head_link (&thread_cache->cached[i])->data);
+    }
+
+  g_free (thread_cache);
+}
+
+static GQueue *
+dex_aio_buffer_thread_cache_get (DexAioBufferPool *buffer_pool)
+{
+  DexAioBufferThreadCache *thread_cache;
+
+  if (!buffer_pool->shared)
+    return NULL;
+
+  if G_UNLIKELY (!(thread_cache = g_private_get (&thread_cache_key)))
+    {
+      thread_cache = g_new0 (DexAioBufferThreadCache, 1);
+      g_private_set (&thread_cache_key, thread_cache);
+    }
+
+  return &thread_cache->cached[buffer_pool->size_class];
+}
+
+static void
+dex_aio_buffer_lease_release (gpointer data)
+{
+  DexAioBufferLease *lease = data;
+  DexAioBufferPool *buffer_pool = g_steal_pointer (&lease->buffer_pool);
+  GQueue *thread_cached;
+
+  g_assert (DEX_IS_AIO_BUFFER_POOL (buffer_pool));
+
+  /* Shared pools live for the duration of the process so the buffer
+   * may be kept by this thread without holding a reference.
+   */
+  if ((thread_cached = dex_aio_buffer_thread_cache_get (buffer_pool)) &&
+      thread_cached->length < MAX_THREAD_CACHED)
+    {
+      g_queue_push_head_link (thread_cached, &lease->link);
+      dex_unref (buffer_pool);
+      return;
+    }
+
+  dex_object_lock (buffer_pool);
+  if (buffer_pool->cached.length < MAX_CACHED_BUFFERS)
+    {
+      g_queue_push_head_link (&buffer_pool->cached, &lease->link);
+      lease = NULL;
+    }
+  dex_object_unlock (buffer_pool);
+
+  if (lease != NULL)
+    dex_aio_buffer_lease_free (lease);
+
+  dex_unref (buffer_pool);
+}
+
+static void
+dex_aio_buffer_pool_finalize (DexObject *object)
+{
+  DexAioBufferPool *buffer_pool = DEX_AIO_BUFFER_POOL (object);
+
+  while (buffer_pool->cached.length > 0)
+    dex_aio_buffer_lease_free (g_queue_pop_head_link (&buffer_pool->cached)->data);
+
+  DEX_OBJECT_CLASS (dex_aio_buffer_pool_parent_class)->finalize (object);
+}
+
+static void
+dex_aio_buffer_pool_class_init (DexAioBufferPoolClass *buffer_pool_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (buffer_pool_class);
+
+  object_class->finalize = dex_aio_buffer_pool_finalize;
+}
+
+static void
+dex_aio_buffer_pool_init (DexAioBufferPool *buffer_pool)
+{
+}
+
+/**
+ * dex_aio_buffer_pool_new:
+ * @buffer_size: the size of each buffer in bytes
+ * @alignment: the memory alignment of each buffer, which must be a
+ *   power of two
+ *
+ * Creates a new #DexAioBufferPool.
+ *
+ * @buffer_size is rounded up to a multiple of @alignment.
+ *
+ * Returns: (transfer full): a new #DexAioBufferPool
+ *
+ * Since: 0.8
+ */
+DexAioBufferPool *
+dex_aio_buffer_pool_new (gsize buffer_size,
+                         gsize alignment)
+{
+  DexAioBufferPool *buffer_pool;
+
+  g_return_val_if_fail (buffer_size > 0, NULL);
+  g_return_val_if_fail (alignment > 0, NULL);
+  g_return_val_if_fail ((alignment & (alignment - 1)) == 0, NULL);
+
+  /* Required by posix_memalign() and friends */
+  alignment = MAX (alignment, sizeof (gpointer));
+
+  buffer_pool = (DexAioBufferPool *)dex_object_create_instance (DEX_TYPE_AIO_BUFFER_POOL);
+  buffer_pool->alignment = alignment;
+  buffer_pool->buffer_size = (buffer_size + alignment - 1) & ~(alignment - 1);
+
+  return buffer_pool;
+}
+
+/**
+ * dex_aio_buffer_pool_new_for_fd:
+ * @fd: a file descriptor opened with `O_DIRECT`
+ * @buffer_size: the size of each buffer in bytes
+ * @error: a location for a #GError or %NULL
+ *
+ * Creates a new #DexAioBufferPool suitable for direct I/O on @fd.
+ *
+ * The alignment is discovered using dex_aio_query_direct_alignment() and
+ * @buffer_size is rounded so that whole buffers may be used as the length
+ * of a request.
+ *
+ * Returns: (transfer full): a new #DexAioBufferPool or %NULL and @error
+ *   is set.
+ *
+ * Since: 0.8
+ */
+DexAioBufferPool *
+dex_aio_buffer_pool_new_for_fd (int      fd,
+                                gsize    buffer_size,
+                                GError **error)
+{
+  gsize memory_alignment;
+  gsize offset_alignment;
+
+  g_return_val_if_fail (fd > -1, NULL);
+  g_return_val_if_fail (buffer_size > 0, NULL);
+
+  if (!dex_aio_query_direct_alignment (fd, &memory_alignment, &offset_alignment, error))
+    return NULL;
+
+  return dex_aio_buffer_pool_new (buffer_size, MAX (memory_alignment, offset_alignment));
+}
+
+/**
+ * dex_aio_buffer_pool_get_buffer_size:
+ * @buffer_pool: a #DexAioBufferPool
+ *
+ * Gets the size of buffers acquired from the pool.
+ *
+ * Returns: the buffer size in bytes
+ *
+ * Since: 0.8
+ */
+gsize
+dex_aio_buffer_pool_get_buffer_size (DexAioBufferPool *buffer_pool)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BUFFER_POOL (buffer_pool), 0);
+
+  return buffer_pool->buffer_size;
+}
+
+/**
+ * dex_aio_buffer_pool_get_alignment:
+ * @buffer_pool: a #DexAioBufferPool
+ *
+ * Gets the memory alignment of buffers acquired from the pool.
+ *
+ * Returns: the alignment in bytes
+ *
+ * Since: 0.8
+ */
+gsize
+dex_aio_buffer_pool_get_alignment (DexAioBufferPool *buffer_pool)
+{
+  g_return_val_if_fail (DEX_IS_AIO_BUFFER_POOL (buffer_pool), 0);
+
+  return buffer_pool->alignment;
+}
+
+/**
+ * dex_aio_buffer_pool_acquire:
+ * @buffer_pool: a #DexAioBufferPool
+ *
+ * Leases a buffer from the pool.
+ *
+ * The lease holder may write to the contents of the #GBytes (such as
+ * with dex_aio_read_direct()) until it is shared with another consumer.
+ * Use g_bytes_new_from_bytes() to create a view of the valid region after
+ * a short read.
+ *
+ * The buffer is returned to @buffer_pool once the #GBytes and any views
+ * of it have been released. The contents of a leased buffer are not
+ * cleared.
+ *
+ * Returns: (transfer full): a #GBytes of dex_aio_buffer_pool_get_buffer_size()
+ *   bytes
+ *
+ * Since: 0.8
+ */
+GBytes *
+dex_aio_buffer_pool_acquire (DexAioBufferPool *buffer_pool)
+{
+  DexAioBufferLease *lease = NULL;
+  GQueue *thread_cached;
+  GList *link;
+
+  g_return_val_if_fail (DEX_IS_AIO_BUFFER_POOL (buffer_pool), NULL);
+
+  if ((thread_cached = dex_aio_buffer_thread_cache_get (buffer_pool)) &&
+      (link = g_queue_pop_head_link (thread_cached)))
+    lease = link->data;
+
+  if (lease == NULL)
+    {
+      dex_object_lock (buffer_pool);
+      if ((link = g_queue_pop_head_link (&buffer_pool->cached)))
+        lease = link->data;
+      dex_object_unlock (buffer_pool);
+    }
+
+  if (lease == NULL)
+    {
+      lease = g_new0 (DexAioBufferLease, 1);
+      lease->link.data = lease;
+      lease->data = g_aligned_alloc (1, buffer_pool->buffer_size, buffer_pool->alignment);
+    }
+
+  lease->buffer_pool = dex_ref (buffer_pool);
+
+  return g_bytes_new_with_free_func (lease->data,
+                                     buffer_pool->buffer_size,
+                                     dex_aio_buffer_lease_release,
+                                     lease);
+}
+
+/**
+ * dex_aio_buffer_pool_get_shared:
+ * @min_buffer_size: the minimum buffer size in bytes
+ *
+ * Gets the process-wide pool with the smallest buffer size that is at
+ * least @min_buffer_size.
+ *
+ * Shared pools have buffer sizes from 4 KiB to 1 MiB in powers of two and
+ * are aligned to 4 KiB. Released buffers are cached per-thread before
+ * being returned to the pool.
+ *
+ * Returns: (transfer none) (nullable): a #DexAioBufferPool or %NULL if
+ *   @min_buffer_size is larger than 1 MiB
+ *
+ * Since: 0.8
+ */
+DexAioBufferPool *
+dex_aio_buffer_pool_get_shared (gsize min_buffer_size)
+{
+  static gsize initialized;
+  guint size_class = 0;
+
+  if (min_buffer_size > (1 << SHARED_MAX_SHIFT))
+    return NULL;
+
+  if (g_once_init_enter (&initialized))
+    {
+      for (guint i = 0; i < N_SHARED_POOLS; i++)
+        {
+          shared_pools[i] = dex_aio_buffer_pool_new ((gsize)1 << (SHARED_MIN_SHIFT + i), SHARED_ALIGNMENT);
+          shared_pools[i]->shared = TRUE;
+          shared_pools[i]->size_class = i;
+        }
+
+      g_once_init_leave (&initialized, TRUE);
+    }
+
+  while (((gsize)1 << (SHARED_MIN_SHIFT + size_class)) < min_buffer_size)
+    size_class++;
+
+  return shared_pools[size_class];
+}
+
+GBytes *
+dex_aio_buffer_pool_acquire_for_size (gsize size)
+{
+  DexAioBufferPool *buffer_pool;
+
+  if ((buffer_pool = dex_aio_buffer_pool_get_shared (size)))
+    return dex_aio_buffer_pool_acquire (buffer_pool);
+
+  /* Too large to be worth caching */
+  return g_bytes_new_take (g_malloc (size), size);
+}
+
+/* Resolves to the filled portion of a pooled buffer once the read into
+ * it completes. The buffer is owned here rather than by a #DexBlock so
+ * that, if we are discarded or released early, it can be handed over to
+ * the read and only returned to the pool once the read completes.
+ */
+#define DEX_TYPE_AIO_POOLED_READ    dex_aio_pooled_read_type
+#define DEX_AIO_POOLED_READ(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_AIO_POOLED_READ, DexAioPooledRead))
+#define DEX_IS_AIO_POOLED_READ(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_AIO_POOLED_READ))
+
+typedef struct _DexAioPooledRead
+{
+  DexFuture  parent_instance;
+  DexFuture *read;
+  GBytes    *buffer;
+} DexAioPooledRead;
+
+typedef struct _DexAioPooledReadClass
+{
+  DexFutureClass parent_class;
+} DexAioPooledReadClass;
+
+DEX_DEFINE_FINAL_TYPE (DexAioPooledRead, dex_aio_pooled_read, DEX_TYPE_FUTURE)
+
+static DexFuture *
+dex_aio_pooled_read_release_cb (DexFuture *completed,
+                                gpointer   user_data)
+{
+  /* Nothing to do, the buffer is released with @user_data */
+  return NULL;
+}
+
+/* Nobody is interested in the result anymore but @read may still be
+ * writing into @buffer. This is the uncommon path so the extra block
+ * is not a concern.
+ */
+static void
+dex_aio_pooled_read_release_when_done (DexFuture *read,
+                                       GBytes    *buffer)
+{
+  dex_future_disown (dex_future_finally (read,
+                                         dex_aio_pooled_read_release_cb,
+                                         buffer,
+                                         (GDestroyNotify)g_bytes_unref));
+}
+
+static gboolean
+dex_aio_pooled_read_propagate (DexFuture *future,
+                               DexFuture *completed)
+{
+  DexAioPooledRead *pooled_read = DEX_AIO_POOLED_READ (future);
+  GError *error = NULL;
+  const GValue *value;
+  GBytes *buffer;
+  DexFuture *read;
+
+  g_assert (DEX_IS_AIO_POOLED_READ (pooled_read));
+  g_assert (DEX_IS_FUTURE (completed));
+
+  dex_object_lock (pooled_read);
+  read = g_steal_pointer (&pooled_read->read);
+  buffer = g_steal_pointer (&pooled_read->buffer);
+  dex_object_unlock (pooled_read);
+
+  /* Lost a race with being discarded */
+  if (buffer == NULL)
+    return TRUE;
+
+  if ((value = dex_future_get_value (completed, &error)))
+    {
+      GValue bytes_value = G_VALUE_INIT;
+      gsize len = g_value_get_int64 (value);
+
+      g_value_init (&bytes_value, G_TYPE_BYTES);
+
+      if (len == g_bytes_get_size (buffer))
+        g_value_set_boxed (&bytes_value, buffer);
+      else
+        g_value_take_boxed (&bytes_value, g_bytes_new_from_bytes (buffer, 0, len));
+
+      dex_future_complete (future, &bytes_value, NULL);
+      g_value_unset (&bytes_value);
+    }
+  else
+    {
+      dex_future_complete (future, NULL, g_steal_pointer (&error));
+    }
+
+  g_bytes_unref (buffer);
+  dex_clear (&read);
+
+  return TRUE;
+}
+
+static void
+dex_aio_pooled_read_discard (DexFuture *future)
+{
+  DexAioPooledRead *pooled_read = DEX_AIO_POOLED_READ (future);
+  GBytes *buffer;
+  DexFuture *read;
+
+  g_assert (DEX_IS_AIO_POOLED_READ (pooled_read));
+
+  dex_object_lock (pooled_read);
+  read = g_steal_pointer (&pooled_read->read);
+  buffer = g_steal_pointer (&pooled_read->buffer);
+  dex_object_unlock (pooled_read);
+
+  if (read == NULL)
+    return;
+
+  /* Cancel first, the lease we chain afterwards must not count as
+   * awaiting the read or it would never be cancelled.
+   */
+  dex_future_discard (read, future);
+  dex_aio_pooled_read_release_when_done (read, buffer);
+}
+
+static void
+dex_aio_pooled_read_finalize (DexObject *object)
+{
+  DexAioPooledRead *pooled_read = DEX_AIO_POOLED_READ (object);
+
+  /* Released without being awaited or discarded */
+  if (pooled_read->read != NULL)
+    dex_aio_pooled_read_release_when_done (g_steal_pointer (&pooled_read->read),
+                                           g_steal_pointer (&pooled_read->buffer));
+
+  DEX_OBJECT_CLASS (dex_aio_pooled_read_parent_class)->finalize (object);
+}
+
+static void
+dex_aio_pooled_read_class_init (DexAioPooledReadClass *pooled_read_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (pooled_read_class);
+  DexFutureClass *future_class = DEX_FUTURE_CLASS (pooled_read_class);
+
+  object_class->finalize = dex_aio_pooled_read_finalize;
+
+  future_class->propagate = dex_aio_pooled_read_propagate;
+  future_class->discard = dex_aio_pooled_read_discard;
+}
+
+static void
+dex_aio_pooled_read_init (DexAioPooledRead *pooled_read)
+{
+}
+
+/*
+ * dex_aio_buffer_pool_wrap_read:
+ * @future: (transfer full): a future resolving to the number of bytes
+ *   read into @buffer
+ * @buffer: (transfer full): the buffer being read into
+ *
+ * Creates a future resolving to a #GBytes for the portion of @buffer
+ * that was filled by @future.
+ *
+ * Discarding the returned future discards @future, cancelling the read,
+ * but @buffer is kept alive until @future completes so that it cannot
+ * be recycled while the read may still be writing into it.
+ */
+DexFuture *
+dex_aio_buffer_pool_wrap_read (DexFuture *future,
+                               GBytes    *buffer)
+{
+  DexAioPooledRead *pooled_read;
+
+  g_assert (DEX_IS_FUTURE (future));
+  g_assert (buffer != NULL);
+
+  pooled_read = (DexAioPooledRead *)dex_object_create_instance (DEX_TYPE_AIO_POOLED_READ);
+  pooled_read->read = future;
+  pooled_read->buffer = buffer;
+
+  dex_future_chain (future, DEX_FUTURE (pooled_read));
+
+  return DEX_FUTURE (pooled_read);
+}
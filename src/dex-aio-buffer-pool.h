@@ -0,0 +1,57 @@
+/*
+ * dex-aio-buffer-pool.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-object.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_AIO_BUFFER_POOL    (dex_aio_buffer_pool_get_type())
+#define DEX_AIO_BUFFER_POOL(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_AIO_BUFFER_POOL, DexAioBufferPool))
+#define DEX_IS_AIO_BUFFER_POOL(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_AIO_BUFFER_POOL))
+
+typedef struct _DexAioBufferPool DexAioBufferPool;
+
+DEX_AVAILABLE_IN_ALL
+GType             dex_aio_buffer_pool_get_type        (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexAioBufferPool *dex_aio_buffer_pool_new             (gsize              buffer_size,
+                                                       gsize              alignment)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexAioBufferPool *dex_aio_buffer_pool_new_for_fd      (int                fd,
+                                                       gsize              buffer_size,
+                                                       GError           **error)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexAioBufferPool *dex_aio_buffer_pool_get_shared      (gsize              min_buffer_size);
+DEX_AVAILABLE_IN_ALL
+gsize             dex_aio_buffer_pool_get_buffer_size (DexAioBufferPool  *buffer_pool);
+DEX_AVAILABLE_IN_ALL
+gsize             dex_aio_buffer_pool_get_alignment   (DexAioBufferPool  *buffer_pool);
+DEX_AVAILABLE_IN_ALL
+GBytes           *dex_aio_buffer_pool_acquire         (DexAioBufferPool  *buffer_pool)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexAioBufferPool, dex_unref)
+
+G_END_DECLS
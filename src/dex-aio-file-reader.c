@@ -0,0 +1,434 @@
+/*
+ * dex-aio-file-reader.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "dex-aio-buffer-pool.h"
+#include "dex-aio-file-reader.h"
+#include "dex-object-private.h"
+#include "dex-scheduler.h"
+
+/**
+ * DexAioFileReader:
+ *
+ * #DexAioFileReader reads a file sequentially while keeping multiple
+ * reads in flight so that the storage device sees a deeper queue than
+ * a simple read-then-await loop would provide.
+ *
+ * Chunks are delivered in file order, either by awaiting
+ * dex_aio_file_reader_next() or by receiving from the channel created
+ * with dex_aio_file_reader_create_channel().
+ *
+ * Chunk buffers come from a #DexAioBufferPool and are recycled once the
+ * consumer releases the #GBytes. The reader never has more than the
+ * requested number of reads outstanding, which bounds memory use to
+ * that many chunks plus whatever the consumer is holding on to.
+ *
+ * The file descriptor must support positioned reads, such as a regular
+ * file or block device. If it was opened with `O_DIRECT`, reads are
+ * submitted with dex_aio_read_direct() using suitably aligned buffers.
+ *
+ * Since: 0.8
+ */
+
+#define DEFAULT_CHUNK_SIZE  (1024*256)
+#define DEFAULT_N_IN_FLIGHT 8
+
+typedef struct _DexAioFileRead
+{
+  GList             link;
+  DexAioFileReader *file_reader;
+  GBytes           *buffer;
+  DexFuture        *future;
+} DexAioFileRead;
+
+typedef struct _DexAioFileReaderPump
+{
+  DexAioFileReader *file_reader;
+  DexChannel       *channel;
+} DexAioFileReaderPump;
+
+struct _DexAioFileReader
+{
+  DexObject         parent_instance;
+
+  /* The context to submit reads to, or %NULL for the current */
+  DexAioContext    *aio_context;
+
+  /* Chunk buffers, recycled as consumers release them */
+  DexAioBufferPool *buffer_pool;
+
+  /* Reads that have been submitted but not yet handed to a consumer,
+   * in the order they must be delivered.
+   */
+  GQueue            in_flight;
+
+  /* Offset for the next read and the end of the file if known */
+  goffset           offset;
+  goffset           end;
+
+  gsize             chunk_size;
+  guint             n_in_flight;
+  int               fd;
+
+  guint             direct : 1;
+  guint             eof : 1;
+};
+
+typedef struct _DexAioFileReaderClass
+{
+  DexObjectClass parent_class;
+} DexAioFileReaderClass;
+
+DEX_DEFINE_FINAL_TYPE (DexAioFileReader, dex_aio_file_reader, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_AIO_FILE_READER
+#define DEX_TYPE_AIO_FILE_READER dex_aio_file_reader_type
+
+static void
+dex_aio_file_read_free (gpointer data)
+{
+  DexAioFileRead *read = data;
+
+  g_assert (read->link.prev == NULL);
+  g_assert (read->link.next == NULL);
+
+  dex_clear (&read->future);
+  dex_clear (&read->file_reader);
+  g_clear_pointer (&read->buffer, g_bytes_unref);
+  g_free (read);
+}
+
+static DexFuture *
+dex_aio_file_read_release (DexFuture *completed,
+                           gpointer   user_data)
+{
+  /* Nothing to do, the buffer is released with @user_data */
+  return NULL;
+}
+
+static void
+dex_aio_file_reader_finalize (DexObject *object)
+{
+  DexAioFileReader *file_reader = DEX_AIO_FILE_READER (object);
+
+  /* The kernel may still be writing into the buffers of reads which were
+   * never handed to a consumer, so keep them alive until they complete.
+   */
+  while (file_reader->in_flight.length > 0)
+    {
+      DexAioFileRead *read = g_queue_pop_head_link (&file_reader->in_flight)->data;
+      DexFuture *future = g_steal_pointer (&read->future);
+
+      dex_future_disown (dex_future_finally (future,
+                                             dex_aio_file_read_release,
+                                             read,
+                                             dex_aio_file_read_free));
+    }
+
+  if (file_reader->aio_context != NULL)
+    g_source_unref ((GSource *)g_steal_pointer (&file_reader->aio_context));
+
+  dex_clear (&file_reader->buffer_pool);
+
+  DEX_OBJECT_CLASS (dex_aio_file_reader_parent_class)->finalize (object);
+}
+
+static void
+dex_aio_file_reader_class_init (DexAioFileReaderClass *file_reader_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (file_reader_class);
+
+  object_class->finalize = dex_aio_file_reader_finalize;
+}
+
+static void
+dex_aio_file_reader_init (DexAioFileReader *file_reader)
+{
+  file_reader->fd = -1;
+  file_reader->end = G_MAXINT64;
+}
+
+/**
+ * dex_aio_file_reader_new:
+ * @aio_context: (nullable): a #DexAioContext or %NULL for the current
+ * @fd: a file descriptor to read from, which must remain open for the
+ *   lifetime of the reader
+ * @chunk_size: the size of each read, or 0 for the default
+ * @n_in_flight: the number of reads to keep in flight, or 0 for the default
+ *
+ * Creates a new #DexAioFileReader which reads @fd from the beginning.
+ *
+ * Returns: (transfer full): a new #DexAioFileReader
+ *
+ * Since: 0.8
+ */
+DexAioFileReader *
+dex_aio_file_reader_new (DexAioContext *aio_context,
+                         int            fd,
+                         gsize          chunk_size,
+                         guint          n_in_flight)
+{
+  DexAioFileReader *file_reader;
+  gsize alignment = 4096;
+  struct stat stbuf;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  if (chunk_size == 0)
+    chunk_size = DEFAULT_CHUNK_SIZE;
+
+  if (n_in_flight == 0)
+    n_in_flight = DEFAULT_N_IN_FLIGHT;
+
+  file_reader = (DexAioFileReader *)dex_object_create_instance (DEX_TYPE_AIO_FILE_READER);
+  file_reader->fd = fd;
+  file_reader->n_in_flight = n_in_flight;
+
+  if (aio_context != NULL)
+    file_reader->aio_context = (DexAioContext *)g_source_ref ((GSource *)aio_context);
+
+#ifdef O_DIRECT
+  if (fcntl (fd, F_GETFL) & O_DIRECT)
+    {
+      gsize memory_alignment;
+      gsize offset_alignment;
+
+      if (dex_aio_query_direct_alignment (fd, &memory_alignment, &offset_alignment, NULL))
+        alignment = MAX (alignment, MAX (memory_alignment, offset_alignment));
+
+      file_reader->direct = TRUE;
+    }
+#endif
+
+  /* Avoid reading past the end of regular files so that we do not
+   * waste reads (and buffers) discovering the end of the file.
+   */
+  if (fstat (fd, &stbuf) == 0 && S_ISREG (stbuf.st_mode))
+    file_reader->end = stbuf.st_size;
+
+  file_reader->buffer_pool = dex_aio_buffer_pool_new (chunk_size, alignment);
+  file_reader->chunk_size = dex_aio_buffer_pool_get_buffer_size (file_reader->buffer_pool);
+
+  return file_reader;
+}
+
+static void
+dex_aio_file_reader_fill_locked (DexAioFileReader *file_reader)
+{
+  while (!file_reader->eof &&
+         file_reader->offset < file_reader->end &&
+         file_reader->in_flight.length < file_reader->n_in_flight)
+    {
+      DexAioFileRead *read;
+      gpointer data;
+
+      read = g_new0 (DexAioFileRead, 1);
+      read->link.data = read;
+      read->buffer = dex_aio_buffer_pool_acquire (file_reader->buffer_pool);
+
+      /* We are the only owner of the lease so it is safe to write to */
+      data = (gpointer)g_bytes_get_data (read->buffer, NULL);
+
+      if (file_reader->direct)
+        read->future = dex_aio_read_direct (file_reader->aio_context,
+                                            file_reader->fd,
+                                            data,
+                                            file_reader->chunk_size,
+                                            file_reader->offset);
+      else
+        read->future = dex_aio_read (file_reader->aio_context,
+                                     file_reader->fd,
+                                     data,
+                                     file_reader->chunk_size,
+                                     file_reader->offset);
+
+      file_reader->offset += file_reader->chunk_size;
+
+      g_queue_push_tail_link (&file_reader->in_flight, &read->link);
+    }
+}
+
+static DexFuture *
+dex_aio_file_reader_read_cb (DexFuture *completed,
+                             gpointer   user_data)
+{
+  DexAioFileRead *read = user_data;
+  DexAioFileReader *file_reader = read->file_reader;
+  const GValue *value;
+  gsize len;
+
+  value = dex_future_get_value (completed, NULL);
+  len = g_value_get_int64 (value);
+
+  /* A short read means we reached the end of the file */
+  if (len < file_reader->chunk_size)
+    {
+      dex_object_lock (file_reader);
+      file_reader->eof = TRUE;
+      dex_object_unlock (file_reader);
+    }
+
+  if (len == file_reader->chunk_size)
+    return dex_future_new_take_boxed (G_TYPE_BYTES, g_steal_pointer (&read->buffer));
+
+  return dex_future_new_take_boxed (G_TYPE_BYTES, g_bytes_new_from_bytes (read->buffer, 0, len));
+}
+
+/**
+ * dex_aio_file_reader_next:
+ * @file_reader: a #DexAioFileReader
+ *
+ * Gets the next chunk of the file.
+ *
+ * Additional reads are submitted as necessary to keep the requested
+ * number of reads in flight.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to a #GBytes
+ *   containing the next chunk of the file, or rejects with error. An
+ *   empty #GBytes indicates the end of the file.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_file_reader_next (DexAioFileReader *file_reader)
+{
+  DexAioFileRead *read = NULL;
+  GList *link;
+
+  g_return_val_if_fail (DEX_IS_AIO_FILE_READER (file_reader), NULL);
+
+  dex_object_lock (file_reader);
+  dex_aio_file_reader_fill_locked (file_reader);
+  if ((link = g_queue_pop_head_link (&file_reader->in_flight)))
+    read = link->data;
+  dex_object_unlock (file_reader);
+
+  if (read == NULL)
+    return dex_future_new_take_boxed (G_TYPE_BYTES, g_bytes_new (NULL, 0));
+
+  read->file_reader = dex_ref (file_reader);
+
+  return dex_future_then (g_steal_pointer (&read->future),
+                          dex_aio_file_reader_read_cb,
+                          read,
+                          dex_aio_file_read_free);
+}
+
+static void
+dex_aio_file_reader_pump_free (gpointer data)
+{
+  DexAioFileReaderPump *pump = data;
+
+  dex_clear (&pump->file_reader);
+  dex_clear (&pump->channel);
+  g_free (pump);
+}
+
+static DexFuture *
+dex_aio_file_reader_pump_fiber (gpointer user_data)
+{
+  DexAioFileReaderPump *pump = user_data;
+  GError *error = NULL;
+
+  for (;;)
+    {
+      GBytes *bytes;
+
+      if (!(bytes = dex_await_boxed (dex_aio_file_reader_next (pump->file_reader), &error)))
+        {
+          /* Deliver the error so the receiver knows why we stopped */
+          dex_future_disown (dex_channel_send (pump->channel,
+                                               dex_future_new_for_error (g_steal_pointer (&error))));
+          break;
+        }
+
+      if (g_bytes_get_size (bytes) == 0)
+        {
+          g_bytes_unref (bytes);
+          break;
+        }
+
+      /* Suspend until the channel has capacity, or fail if the
+       * receiving side has been closed.
+       */
+      if (!dex_await (dex_channel_send (pump->channel,
+                                        dex_future_new_take_boxed (G_TYPE_BYTES, bytes)),
+                      NULL))
+        break;
+    }
+
+  dex_channel_close_send (pump->channel);
+
+  return NULL;
+}
+
+/**
+ * dex_aio_file_reader_create_channel:
+ * @file_reader: a #DexAioFileReader
+ * @capacity: the channel capacity, or 0 for unlimited
+ *
+ * Creates a #DexChannel which will be filled with #GBytes for each chunk
+ * of the file, in order.
+ *
+ * A fiber is spawned on the thread-default scheduler to move chunks from
+ * @file_reader into the channel. The sending side of the channel is
+ * closed upon reaching the end of the file. If a read fails, the error
+ * is delivered as the final item.
+ *
+ * Close the receiving side of the channel to stop reading early.
+ *
+ * @file_reader should not be used directly after calling this function.
+ *
+ * Returns: (transfer full): a #DexChannel
+ *
+ * Since: 0.8
+ */
+DexChannel *
+dex_aio_file_reader_create_channel (DexAioFileReader *file_reader,
+                                    guint             capacity)
+{
+  DexAioFileReaderPump *pump;
+  DexScheduler *scheduler;
+  DexChannel *channel;
+
+  g_return_val_if_fail (DEX_IS_AIO_FILE_READER (file_reader), NULL);
+
+  if (!(scheduler = dex_scheduler_get_thread_default ()))
+    scheduler = dex_scheduler_get_default ();
+
+  channel = dex_channel_new (capacity);
+
+  pump = g_new0 (DexAioFileReaderPump, 1);
+  pump->file_reader = dex_ref (file_reader);
+  pump->channel = dex_ref (channel);
+
+  dex_future_disown (dex_scheduler_spawn (scheduler,
+                                          0,
+                                          dex_aio_file_reader_pump_fiber,
+                                          pump,
+                                          dex_aio_file_reader_pump_free));
+
+  return channel;
+}
@@ -0,0 +1,54 @@
+/*
+ * dex-aio-file-reader.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-aio.h"
+#include "dex-channel.h"
+#include "dex-object.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_AIO_FILE_READER    (dex_aio_file_reader_get_type())
+#define DEX_AIO_FILE_READER(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_AIO_FILE_READER, DexAioFileReader))
+#define DEX_IS_AIO_FILE_READER(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_AIO_FILE_READER))
+
+typedef struct _DexAioFileReader DexAioFileReader;
+
+DEX_AVAILABLE_IN_ALL
+GType             dex_aio_file_reader_get_type       (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexAioFileReader *dex_aio_file_reader_new            (DexAioContext    *aio_context,
+                                                      int               fd,
+                                                      gsize             chunk_size,
+                                                      guint             n_in_flight)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture        *dex_aio_file_reader_next           (DexAioFileReader *file_reader)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexChannel       *dex_aio_file_reader_create_channel (DexAioFileReader *file_reader,
+                                                      guint             capacity)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexAioFileReader, dex_unref)
+
+G_END_DECLS
@@ -0,0 +1,233 @@
+/*
+ * dex-aio-input-stream.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "dex-aio.h"
+#include "dex-aio-private.h"
+#include "dex-aio-input-stream.h"
+#include "dex-async-result.h"
+#include "dex-compat-private.h"
+
+/**
+ * DexAioInputStream:
+ *
+ * #DexAioInputStream is a #GInputStream for reading from a file
+ * descriptor.
+ *
+ * Unlike #GUnixInputStream, asynchronous reads are submitted with
+ * dex_aio_read() to the #DexAioContext of the calling thread rather than
+ * being dispatched to a GIO worker thread. Threads without a scheduler,
+ * such as GIO worker threads, submit to the context of the default
+ * scheduler instead. With the io_uring backend, that means existing GIO
+ * based code (including dex_input_stream_read() and
+ * dex_output_stream_splice()) avoids a thread hop per read.
+ *
+ * Reads use the current file position so @fd may be a regular file,
+ * pipe, or socket.
+ *
+ * Since: 0.8
+ */
+
+struct _DexAioInputStream
+{
+  GInputStream parent_instance;
+  int          fd;
+  guint        close_fd : 1;
+};
+
+G_DEFINE_FINAL_TYPE (DexAioInputStream, dex_aio_input_stream, G_TYPE_INPUT_STREAM)
+
+static gssize
+dex_aio_input_stream_read (GInputStream  *stream,
+                           void          *buffer,
+                           gsize          count,
+                           GCancellable  *cancellable,
+                           GError       **error)
+{
+  DexAioInputStream *self = DEX_AIO_INPUT_STREAM (stream);
+  gssize res;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return -1;
+
+  do
+    res = read (self->fd, buffer, count);
+  while (res < 0 && errno == EINTR);
+
+  if (res < 0)
+    {
+      int errsv = errno;
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           g_io_error_from_errno (errsv),
+                           g_strerror (errsv));
+    }
+
+  return res;
+}
+
+static void
+dex_aio_input_stream_read_async (GInputStream        *stream,
+                                 void                *buffer,
+                                 gsize                count,
+                                 int                  io_priority,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  DexAioInputStream *self = DEX_AIO_INPUT_STREAM (stream);
+  DexAsyncResult *result;
+  GError *error = NULL;
+
+  /* The cancellable is only checked up-front because the kernel may be
+   * writing into @buffer until the read completes.
+   */
+  result = dex_async_result_new (stream, NULL, callback, user_data);
+  dex_async_result_set_static_name (result, G_STRFUNC);
+  dex_async_result_set_priority (result, io_priority);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    dex_async_result_await (result, dex_future_new_for_error (error));
+  else
+    dex_async_result_await (result,
+                            dex_aio_read (dex_aio_context_current_or_default (),
+                                         self->fd, buffer, count, -1));
+
+  g_object_unref (result);
+}
+
+static gssize
+dex_aio_input_stream_read_finish (GInputStream  *stream,
+                                  GAsyncResult  *result,
+                                  GError       **error)
+{
+  return dex_async_result_propagate_int (DEX_ASYNC_RESULT (result), error);
+}
+
+static gboolean
+dex_aio_input_stream_close (GInputStream  *stream,
+                            GCancellable  *cancellable,
+                            GError       **error)
+{
+  DexAioInputStream *self = DEX_AIO_INPUT_STREAM (stream);
+
+  if (self->close_fd && self->fd != -1)
+    {
+      int fd = self->fd;
+
+      self->fd = -1;
+
+      if (close (fd) != 0)
+        {
+          int errsv = errno;
+          g_set_error_literal (error,
+                               G_IO_ERROR,
+                               g_io_error_from_errno (errsv),
+                               g_strerror (errsv));
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+dex_aio_input_stream_class_init (DexAioInputStreamClass *klass)
+{
+  GInputStreamClass *input_stream_class = G_INPUT_STREAM_CLASS (klass);
+
+  input_stream_class->read_fn = dex_aio_input_stream_read;
+  input_stream_class->read_async = dex_aio_input_stream_read_async;
+  input_stream_class->read_finish = dex_aio_input_stream_read_finish;
+  input_stream_class->close_fn = dex_aio_input_stream_close;
+}
+
+static void
+dex_aio_input_stream_init (DexAioInputStream *self)
+{
+  self->fd = -1;
+}
+
+/**
+ * dex_aio_input_stream_new:
+ * @fd: a file descriptor
+ * @close_fd: if @fd should be closed when the stream is closed
+ *
+ * Creates a new #DexAioInputStream for @fd.
+ *
+ * Returns: (transfer full): a new #GInputStream
+ *
+ * Since: 0.8
+ */
+GInputStream *
+dex_aio_input_stream_new (int      fd,
+                          gboolean close_fd)
+{
+  DexAioInputStream *self;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  self = g_object_new (DEX_TYPE_AIO_INPUT_STREAM, NULL);
+  self->fd = fd;
+  self->close_fd = !!close_fd;
+
+  return G_INPUT_STREAM (self);
+}
+
+/**
+ * dex_aio_input_stream_get_fd:
+ * @stream: a #DexAioInputStream
+ *
+ * Gets the file descriptor for the stream.
+ *
+ * Returns: a file descriptor or -1 if it has been closed
+ *
+ * Since: 0.8
+ */
+int
+dex_aio_input_stream_get_fd (DexAioInputStream *stream)
+{
+  g_return_val_if_fail (DEX_IS_AIO_INPUT_STREAM (stream), -1);
+
+  return stream->fd;
+}
+
+/**
+ * dex_aio_input_stream_get_close_fd:
+ * @stream: a #DexAioInputStream
+ *
+ * Gets if the file descriptor will be closed with the stream.
+ *
+ * Returns: %TRUE if the file descriptor is closed with the stream
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_aio_input_stream_get_close_fd (DexAioInputStream *stream)
+{
+  g_return_val_if_fail (DEX_IS_AIO_INPUT_STREAM (stream), FALSE);
+
+  return stream->close_fd;
+}
@@ -0,0 +1,233 @@
+/*
+ * dex-aio-output-stream.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "dex-aio.h"
+#include "dex-aio-private.h"
+#include "dex-aio-output-stream.h"
+#include "dex-async-result.h"
+#include "dex-compat-private.h"
+
+/**
+ * DexAioOutputStream:
+ *
+ * #DexAioOutputStream is a #GOutputStream for writing to a file
+ * descriptor.
+ *
+ * Unlike #GUnixOutputStream, asynchronous writes are submitted with
+ * dex_aio_write() to the #DexAioContext of the calling thread rather than
+ * being dispatched to a GIO worker thread. Threads without a scheduler,
+ * such as GIO worker threads, submit to the context of the default
+ * scheduler instead. With the io_uring backend, that means existing GIO
+ * based code (including dex_output_stream_write() and
+ * dex_output_stream_splice()) avoids a thread hop per write.
+ *
+ * Writes use the current file position so @fd may be a regular file,
+ * pipe, or socket.
+ *
+ * Since: 0.8
+ */
+
+struct _DexAioOutputStream
+{
+  GOutputStream parent_instance;
+  int           fd;
+  guint         close_fd : 1;
+};
+
+G_DEFINE_FINAL_TYPE (DexAioOutputStream, dex_aio_output_stream, G_TYPE_OUTPUT_STREAM)
+
+static gssize
+dex_aio_output_stream_write (GOutputStream  *stream,
+                             const void     *buffer,
+                             gsize           count,
+                             GCancellable   *cancellable,
+                             GError        **error)
+{
+  DexAioOutputStream *self = DEX_AIO_OUTPUT_STREAM (stream);
+  gssize res;
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return -1;
+
+  do
+    res = write (self->fd, buffer, count);
+  while (res < 0 && errno == EINTR);
+
+  if (res < 0)
+    {
+      int errsv = errno;
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           g_io_error_from_errno (errsv),
+                           g_strerror (errsv));
+    }
+
+  return res;
+}
+
+static void
+dex_aio_output_stream_write_async (GOutputStream       *stream,
+                                   const void          *buffer,
+                                   gsize                count,
+                                   int                  io_priority,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  DexAioOutputStream *self = DEX_AIO_OUTPUT_STREAM (stream);
+  DexAsyncResult *result;
+  GError *error = NULL;
+
+  /* The cancellable is only checked up-front because the kernel may be
+   * reading from @buffer until the write completes.
+   */
+  result = dex_async_result_new (stream, NULL, callback, user_data);
+  dex_async_result_set_static_name (result, G_STRFUNC);
+  dex_async_result_set_priority (result, io_priority);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    dex_async_result_await (result, dex_future_new_for_error (error));
+  else
+    dex_async_result_await (result,
+                            dex_aio_write (dex_aio_context_current_or_default (),
+                                          self->fd, buffer, count, -1));
+
+  g_object_unref (result);
+}
+
+static gssize
+dex_aio_output_stream_write_finish (GOutputStream  *stream,
+                                    GAsyncResult   *result,
+                                    GError        **error)
+{
+  return dex_async_result_propagate_int (DEX_ASYNC_RESULT (result), error);
+}
+
+static gboolean
+dex_aio_output_stream_close (GOutputStream  *stream,
+                             GCancellable   *cancellable,
+                             GError        **error)
+{
+  DexAioOutputStream *self = DEX_AIO_OUTPUT_STREAM (stream);
+
+  if (self->close_fd && self->fd != -1)
+    {
+      int fd = self->fd;
+
+      self->fd = -1;
+
+      if (close (fd) != 0)
+        {
+          int errsv = errno;
+          g_set_error_literal (error,
+                               G_IO_ERROR,
+                               g_io_error_from_errno (errsv),
+                               g_strerror (errsv));
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+dex_aio_output_stream_class_init (DexAioOutputStreamClass *klass)
+{
+  GOutputStreamClass *output_stream_class = G_OUTPUT_STREAM_CLASS (klass);
+
+  output_stream_class->write_fn = dex_aio_output_stream_write;
+  output_stream_class->write_async = dex_aio_output_stream_write_async;
+  output_stream_class->write_finish = dex_aio_output_stream_write_finish;
+  output_stream_class->close_fn = dex_aio_output_stream_close;
+}
+
+static void
+dex_aio_output_stream_init (DexAioOutputStream *self)
+{
+  self->fd = -1;
+}
+
+/**
+ * dex_aio_output_stream_new:
+ * @fd: a file descriptor
+ * @close_fd: if @fd should be closed when the stream is closed
+ *
+ * Creates a new #DexAioOutputStream for @fd.
+ *
+ * Returns: (transfer full): a new #GOutputStream
+ *
+ * Since: 0.8
+ */
+GOutputStream *
+dex_aio_output_stream_new (int      fd,
+                           gboolean close_fd)
+{
+  DexAioOutputStream *self;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  self = g_object_new (DEX_TYPE_AIO_OUTPUT_STREAM, NULL);
+  self->fd = fd;
+  self->close_fd = !!close_fd;
+
+  return G_OUTPUT_STREAM (self);
+}
+
+/**
+ * dex_aio_output_stream_get_fd:
+ * @stream: a #DexAioOutputStream
+ *
+ * Gets the file descriptor for the stream.
+ *
+ * Returns: a file descriptor or -1 if it has been closed
+ *
+ * Since: 0.8
+ */
+int
+dex_aio_output_stream_get_fd (DexAioOutputStream *stream)
+{
+  g_return_val_if_fail (DEX_IS_AIO_OUTPUT_STREAM (stream), -1);
+
+  return stream->fd;
+}
+
+/**
+ * dex_aio_output_stream_get_close_fd:
+ * @stream: a #DexAioOutputStream
+ *
+ * Gets if the file descriptor will be closed with the stream.
+ *
+ * Returns: %TRUE if the file descriptor is closed with the stream
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_aio_output_stream_get_close_fd (DexAioOutputStream *stream)
+{
+  g_return_val_if_fail (DEX_IS_AIO_OUTPUT_STREAM (stream), FALSE);
+
+  return stream->close_fd;
+}
@@ -0,0 +1,44 @@
+/*
+ * dex-aio-output-stream.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "dex-version-macros.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_AIO_OUTPUT_STREAM (dex_aio_output_stream_get_type())
+
+DEX_AVAILABLE_IN_ALL
+G_DECLARE_FINAL_TYPE (DexAioOutputStream, dex_aio_output_stream, DEX, AIO_OUTPUT_STREAM, GOutputStream)
+
+DEX_AVAILABLE_IN_ALL
+GOutputStream *dex_aio_output_stream_new          (int                 fd,
+                                                   gboolean            close_fd)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+int            dex_aio_output_stream_get_fd       (DexAioOutputStream *stream);
+DEX_AVAILABLE_IN_ALL
+gboolean       dex_aio_output_stream_get_close_fd (DexAioOutputStream *stream);
+
+G_END_DECLS
@@ -20,11 +20,30 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <gio/gio.h>
+
+#ifdef G_OS_UNIX
+# include <sys/uio.h>
+#endif
+
 #include "dex-aio.h"
 #include "dex-aio-backend-private.h"
+#include "dex-aio-buffer-pool-private.h"
+#include "dex-aio-private.h"
 #include "dex-scheduler-private.h"
 #include "dex-thread-storage-private.h"
 
+#ifdef G_OS_UNIX
+/* Backends pass #GOutputVector straight to writev() like GSocket does */
+G_STATIC_ASSERT (sizeof (GOutputVector) == sizeof (struct iovec));
+G_STATIC_ASSERT (G_STRUCT_OFFSET (GOutputVector, buffer) == G_STRUCT_OFFSET (struct iovec, iov_base));
+G_STATIC_ASSERT (G_STRUCT_OFFSET (GOutputVector, size) == G_STRUCT_OFFSET (struct iovec, iov_len));
+#endif
+
 static DexAioContext *
 dex_aio_context_current (void)
 {
@@ -39,6 +58,22 @@ dex_aio_context_current (void)
   g_return_val_if_reached (NULL);
 }
 
+/* Only for the GIO stream classes, which may be driven from threads
+ * without a scheduler such as GIO worker threads. Those submit to the
+ * default scheduler's context rather than failing. Everything else
+ * requires a thread with a scheduler or an explicit #DexAioContext.
+ */
+DexAioContext *
+dex_aio_context_current_or_default (void)
+{
+  DexThreadStorage *storage = dex_thread_storage_get ();
+
+  if (storage->aio_context == NULL && storage->scheduler == NULL)
+    return dex_scheduler_get_aio_context (dex_scheduler_get_default ());
+
+  return dex_aio_context_current ();
+}
+
 /**
  * dex_aio_read:
  *
@@ -61,6 +96,52 @@ dex_aio_read (DexAioContext *aio_context,
                                fd, buffer, count, offset);
 }
 
+/**
+ * dex_aio_read_bytes:
+ * @aio_context: (nullable): a #DexAioContext or %NULL for the current
+ * @fd: a file descriptor
+ * @count: the maximum number of bytes to read
+ * @offset: the offset to read from, or -1 for the current position
+ *
+ * Reads up to @count bytes into a buffer from the shared
+ * #DexAioBufferPool for that size.
+ *
+ * The buffer is returned to the pool once the resulting #GBytes (and any
+ * views of it) are released, so callers reading in a loop do not allocate
+ * a new buffer for each read. Short reads yield a view of the buffer
+ * which still holds the entire buffer, so copy the data if it is to be
+ * retained for a long time.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to a #GBytes,
+ *   which is empty at the end of the file, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_read_bytes (DexAioContext *aio_context,
+                    int            fd,
+                    gsize          count,
+                    goffset        offset)
+{
+  GBytes *buffer;
+  gpointer data;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  buffer = dex_aio_buffer_pool_acquire_for_size (count);
+
+  /* We are the only owner of the lease so it is safe to write to */
+  data = (gpointer)g_bytes_get_data (buffer, NULL);
+
+  return dex_aio_buffer_pool_wrap_read (dex_aio_backend_read (aio_context->aio_backend,
+                                                              aio_context,
+                                                              fd, data, count, offset),
+                                        buffer);
+}
+
 /**
  * dex_aio_write:
  *
@@ -82,3 +163,345 @@ dex_aio_write (DexAioContext *aio_context,
   return dex_aio_backend_write (aio_context->aio_backend, aio_context,
                                 fd, buffer, count, offset);
 }
+
+/**
+ * dex_aio_read_direct:
+ *
+ * Like dex_aio_read() but for file descriptors opened with `O_DIRECT`.
+ *
+ * @buffer, @count, and @offset must satisfy the alignment requirements
+ * of @fd which may be discovered with dex_aio_query_direct_alignment().
+ *
+ * AIO backends may use this to submit the request to a polled completion
+ * queue (such as `IORING_SETUP_IOPOLL`) rather than interrupt driven
+ * completion. If that is not possible, this behaves like dex_aio_read().
+ *
+ * Returns: (transfer full): a future that will resolve when the
+ *   read completes or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_read_direct (DexAioContext *aio_context,
+                     int            fd,
+                     gpointer       buffer,
+                     gsize          count,
+                     goffset        offset)
+{
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_read_direct (aio_context->aio_backend, aio_context,
+                                      fd, buffer, count, offset);
+}
+
+/**
+ * dex_aio_write_direct:
+ *
+ * Like dex_aio_write() but for file descriptors opened with `O_DIRECT`.
+ *
+ * See dex_aio_read_direct() for the requirements of @buffer, @count,
+ * and @offset.
+ *
+ * Returns: (transfer full): a future that will resolve when the
+ *   write completes or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_write_direct (DexAioContext *aio_context,
+                      int            fd,
+                      gconstpointer  buffer,
+                      gsize          count,
+                      goffset        offset)
+{
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_write_direct (aio_context->aio_backend, aio_context,
+                                       fd, buffer, count, offset);
+}
+
+/**
+ * dex_aio_writev:
+ * @aio_context: (nullable): a #DexAioContext or %NULL
+ * @fd: a file descriptor
+ * @vectors: (array length=n_vectors): the buffers to write
+ * @n_vectors: the number of elements in @vectors
+ * @offset: the offset to write at, or -1 for the current file position
+ *
+ * An asynchronous `pwritev()` wrapper which writes several buffers with
+ * a single request.
+ *
+ * @vectors and the buffers it points to must stay valid until the
+ * returned future completes. Like `writev()`, fewer bytes than requested
+ * may be written.
+ *
+ * Returns: (transfer full): a future that will resolve to the number
+ *   of bytes written or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_writev (DexAioContext       *aio_context,
+                int                  fd,
+                const GOutputVector *vectors,
+                gsize                n_vectors,
+                goffset              offset)
+{
+  g_return_val_if_fail (vectors != NULL, NULL);
+  g_return_val_if_fail (n_vectors > 0, NULL);
+
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_writev (aio_context->aio_backend, aio_context,
+                                 fd, vectors, n_vectors, offset);
+}
+
+/**
+ * dex_aio_send:
+ *
+ * An asynchronous `send()` wrapper.
+ *
+ * Returns: (transfer full): a future that will resolve to the number
+ *   of bytes sent or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_send (DexAioContext *aio_context,
+              int            fd,
+              gconstpointer  buffer,
+              gsize          count,
+              int            flags)
+{
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_send (aio_context->aio_backend, aio_context,
+                               fd, buffer, count, flags);
+}
+
+/**
+ * dex_aio_send_zc:
+ *
+ * An asynchronous zero-copy `send()` wrapper.
+ *
+ * When supported by the AIO backend, the kernel transmits directly from
+ * @buffer rather than copying it into socket buffers first. The future
+ * does not resolve until the kernel has notified that it no longer
+ * references @buffer, so @buffer must be kept alive and unmodified until
+ * then.
+ *
+ * If zero-copy is not available for the backend or the socket type, this
+ * falls back to a regular send.
+ *
+ * Zero-copy generally only pays off for large payloads.
+ *
+ * Returns: (transfer full): a future that will resolve to the number
+ *   of bytes sent or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_send_zc (DexAioContext *aio_context,
+                 int            fd,
+                 gconstpointer  buffer,
+                 gsize          count,
+                 int            flags)
+{
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_send_zc (aio_context->aio_backend, aio_context,
+                                  fd, buffer, count, flags);
+}
+
+/**
+ * dex_aio_fadvise:
+ * @aio_context: (nullable): a #DexAioContext or %NULL
+ * @fd: a file descriptor
+ * @offset: the start of the range
+ * @length: the length of the range, or 0 for the rest of the file
+ * @advice: a `POSIX_FADV_*` constant
+ *
+ * An asynchronous `posix_fadvise()` wrapper.
+ *
+ * This is primarily useful with `POSIX_FADV_WILLNEED` to start reading a
+ * range into the page cache ahead of a large scan without blocking the
+ * calling thread.
+ *
+ * Returns: (transfer full): a future that will resolve when the advice
+ *   has been applied or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_fadvise (DexAioContext *aio_context,
+                 int            fd,
+                 goffset        offset,
+                 goffset        length,
+                 int            advice)
+{
+  g_return_val_if_fail (offset >= 0, NULL);
+  g_return_val_if_fail (length >= 0, NULL);
+
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_fadvise (aio_context->aio_backend, aio_context,
+                                  fd, offset, length, advice);
+}
+
+/**
+ * dex_aio_madvise:
+ * @aio_context: (nullable): a #DexAioContext or %NULL
+ * @address: a page aligned address within a mapping
+ * @length: the length of the range
+ * @advice: a `MADV_*` constant
+ *
+ * An asynchronous `madvise()` wrapper.
+ *
+ * Returns: (transfer full): a future that will resolve when the advice
+ *   has been applied or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_aio_madvise (DexAioContext *aio_context,
+                 gpointer       address,
+                 gsize          length,
+                 int            advice)
+{
+  if (aio_context == NULL)
+    aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_madvise (aio_context->aio_backend, aio_context,
+                                  address, length, advice);
+}
+
+/**
+ * dex_fd_wait:
+ * @fd: a file descriptor
+ * @condition: the #GIOCondition to wait for
+ *
+ * Creates a future that resolves once @fd becomes ready for any of the
+ * conditions in @condition.
+ *
+ * This allows driving nonblocking libraries which expose their file
+ * descriptors (such as database or DNS clients) directly from a fiber
+ * without creating a #GSource for each wait.
+ *
+ * %G_IO_ERR, %G_IO_HUP, and %G_IO_NVAL are always reported even when
+ * they are not part of @condition.
+ *
+ * With the io_uring backend this submits `IORING_OP_POLL_ADD` to the
+ * #DexAioContext of the calling thread. Otherwise @fd is added to the
+ * pollfds of the thread's #GMainContext.
+ *
+ * If the future is discarded before @fd is ready, the wait is cancelled
+ * and the future rejects with %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: (transfer full): a future that resolves to the #GIOCondition
+ *   that was observed (see dex_await_flags()) or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_fd_wait (int          fd,
+             GIOCondition condition)
+{
+  DexAioContext *aio_context;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  aio_context = dex_aio_context_current ();
+
+  return dex_aio_backend_poll (aio_context->aio_backend, aio_context,
+                               fd, condition);
+}
+
+/**
+ * dex_aio_query_direct_alignment:
+ * @fd: a file descriptor
+ * @memory_alignment: (out) (optional): location for the buffer alignment
+ * @offset_alignment: (out) (optional): location for the offset and
+ *   length alignment
+ * @error: a location for a #GError or %NULL
+ *
+ * Discovers the alignment requirements for performing `O_DIRECT` I/O
+ * on @fd.
+ *
+ * On Linux 6.1 and newer this uses `statx()` with `STATX_DIOALIGN`. If
+ * that is unavailable, the preferred I/O block size of @fd is used as it
+ * is a conservative choice for both alignments.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE and @error is set. If
+ *   the file does not support direct I/O, %G_IO_ERROR_NOT_SUPPORTED
+ *   is set.
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_aio_query_direct_alignment (int      fd,
+                                gsize   *memory_alignment,
+                                gsize   *offset_alignment,
+                                GError **error)
+{
+  gsize mem_align = 0;
+  gsize off_align = 0;
+  struct stat stbuf;
+  int errsv;
+
+  g_return_val_if_fail (fd > -1, FALSE);
+
+#ifdef HAVE_STATX_DIOALIGN
+  {
+    struct statx stx;
+
+    if (statx (fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+        (stx.stx_mask & STATX_DIOALIGN) != 0)
+      {
+        /* Zero alignment means direct I/O is not supported on @fd */
+        if (stx.stx_dio_mem_align == 0 || stx.stx_dio_offset_align == 0)
+          {
+            g_set_error_literal (error,
+                                 G_IO_ERROR,
+                                 G_IO_ERROR_NOT_SUPPORTED,
+                                 "Direct I/O is not supported");
+            return FALSE;
+          }
+
+        mem_align = stx.stx_dio_mem_align;
+        off_align = stx.stx_dio_offset_align;
+
+        goto finish;
+      }
+  }
+#endif
+
+  if (fstat (fd, &stbuf) != 0)
+    {
+      errsv = errno;
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           g_io_error_from_errno (errsv),
+                           g_strerror (errsv));
+      return FALSE;
+    }
+
+  mem_align = MAX (stbuf.st_blksize, 512);
+  off_align = MAX (stbuf.st_blksize, 512);
+
+#ifdef HAVE_STATX_DIOALIGN
+finish:
+#endif
+  if (memory_alignment != NULL)
+    *memory_alignment = mem_align;
+
+  if (offset_alignment != NULL)
+    *offset_alignment = off_align;
+
+  return TRUE;
+}
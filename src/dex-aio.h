@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <gio/gio.h>
+
 #include "dex-future.h"
 
 G_BEGIN_DECLS
@@ -27,18 +29,81 @@ G_BEGIN_DECLS
 typedef struct _DexAioContext DexAioContext;
 
 DEX_AVAILABLE_IN_ALL
-DexFuture *dex_aio_read  (DexAioContext *aio_context,
-                          int            fd,
-                          gpointer       buffer,
-                          gsize          count,
-                          goffset        offset)
+DexFuture *dex_aio_read                   (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gpointer        buffer,
+                                           gsize           count,
+                                           goffset         offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_read_bytes             (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gsize           count,
+                                           goffset         offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_write                  (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gconstpointer   buffer,
+                                           gsize           count,
+                                           goffset         offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_read_direct            (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gpointer        buffer,
+                                           gsize           count,
+                                           goffset         offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_write_direct           (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gconstpointer   buffer,
+                                           gsize           count,
+                                           goffset         offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_writev                 (DexAioContext       *aio_context,
+                                           int                  fd,
+                                           const GOutputVector *vectors,
+                                           gsize                n_vectors,
+                                           goffset              offset)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_send                   (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gconstpointer   buffer,
+                                           gsize           count,
+                                           int             flags)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_send_zc                (DexAioContext  *aio_context,
+                                           int             fd,
+                                           gconstpointer   buffer,
+                                           gsize           count,
+                                           int             flags)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
-DexFuture *dex_aio_write (DexAioContext *aio_context,
-                          int            fd,
-                          gconstpointer  buffer,
-                          gsize          count,
-                          goffset        offset)
+DexFuture *dex_aio_fadvise                (DexAioContext  *aio_context,
+                                           int             fd,
+                                           goffset         offset,
+                                           goffset         length,
+                                           int             advice)
   G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_aio_madvise                (DexAioContext  *aio_context,
+                                           gpointer        address,
+                                           gsize           length,
+                                           int             advice)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_fd_wait                    (int             fd,
+                                           GIOCondition    condition)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+gboolean   dex_aio_query_direct_alignment (int             fd,
+                                           gsize          *memory_alignment,
+                                           gsize          *offset_alignment,
+                                           GError        **error);
 
 G_END_DECLS
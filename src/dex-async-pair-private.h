@@ -35,6 +35,7 @@ typedef struct _DexAsyncPair
   GCancellable *cancellable;
   DexAsyncPairInfo *info;
   guint cancel_on_discard : 1;
+  guint recycle_cancellable : 1;
 } DexAsyncPair;
 
 typedef struct _DexAsyncPairClass
@@ -42,4 +43,6 @@ typedef struct _DexAsyncPairClass
   DexFutureClass parent_class;
 } DexAsyncPairClass;
 
+DexAsyncPair *dex_async_pair_create (void);
+
 G_END_DECLS
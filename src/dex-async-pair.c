@@ -31,6 +31,65 @@ DEX_DEFINE_FINAL_TYPE (DexAsyncPair, dex_async_pair, DEX_TYPE_FUTURE)
 #undef DEX_TYPE_ASYNC_PAIR
 #define DEX_TYPE_ASYNC_PAIR dex_async_pair_type
 
+#define CANCELLABLE_CACHE_MAX 16
+
+static GPrivate cancellable_cache_key = G_PRIVATE_INIT ((GDestroyNotify)g_ptr_array_unref);
+static guint cancelled_signal_id;
+
+static GCancellable *
+dex_async_pair_acquire_cancellable (void)
+{
+  GPtrArray *cache = g_private_get (&cancellable_cache_key);
+
+  if (cache != NULL && cache->len > 0)
+    return g_ptr_array_steal_index_fast (cache, cache->len - 1);
+
+  return g_cancellable_new ();
+}
+
+/* A GCancellable is a full GObject with its own mutex, which is a lot to
+ * create and destroy for every read or write. GIO needs it when the
+ * operation starts so it cannot be created lazily. Instead, pairs created
+ * by dex_async_pair_create() for our own GIO wrappers take one from a
+ * per-thread cache and hand it back when finalized.
+ *
+ * Only cancellables which were never given to application code are
+ * recycled, so nothing can have attached qdata, weak references or
+ * handlers we don't know about. GIO may still hold a reference after we
+ * are finalized, such as from a GTask that has not been freed yet, in
+ * which case the cancellable is dropped so it is never shared with the
+ * next operation.
+ */
+static void
+dex_async_pair_release_cancellable (DexAsyncPair *async_pair)
+{
+  GCancellable *cancellable = g_steal_pointer (&async_pair->cancellable);
+  GPtrArray *cache;
+
+  if (cancellable == NULL)
+    return;
+
+  if (!async_pair->recycle_cancellable ||
+      g_atomic_int_get (&G_OBJECT (cancellable)->ref_count) != 1 ||
+      g_cancellable_is_cancelled (cancellable) ||
+      g_signal_has_handler_pending (cancellable, cancelled_signal_id, 0, TRUE))
+    {
+      g_object_unref (cancellable);
+      return;
+    }
+
+  if G_UNLIKELY (!(cache = g_private_get (&cancellable_cache_key)))
+    {
+      cache = g_ptr_array_new_with_free_func (g_object_unref);
+      g_private_set (&cancellable_cache_key, cache);
+    }
+
+  if (cache->len < CANCELLABLE_CACHE_MAX)
+    g_ptr_array_add (cache, cancellable);
+  else
+    g_object_unref (cancellable);
+}
+
 static void
 dex_async_pair_discard (DexFuture *future)
 {
@@ -46,7 +105,7 @@ dex_async_pair_finalize (DexObject *object)
   DexAsyncPair *async_pair = DEX_ASYNC_PAIR (object);
 
   g_clear_object (&async_pair->instance);
-  g_clear_object (&async_pair->cancellable);
+  dex_async_pair_release_cancellable (async_pair);
   g_clear_pointer (&async_pair->info, g_free);
 
   DEX_OBJECT_CLASS (dex_async_pair_parent_class)->finalize (object);
@@ -57,19 +116,39 @@ dex_async_pair_class_init (DexAsyncPairClass *async_pair_class)
 {
   DexObjectClass *object_class = DEX_OBJECT_CLASS (async_pair_class);
   DexFutureClass *future_class = DEX_FUTURE_CLASS (async_pair_class);
+  GTypeClass *cancellable_class;
 
   object_class->finalize = dex_async_pair_finalize;
 
   future_class->discard = dex_async_pair_discard;
+
+  cancellable_class = g_type_class_ref (G_TYPE_CANCELLABLE);
+  cancelled_signal_id = g_signal_lookup ("cancelled", G_TYPE_CANCELLABLE);
+  g_type_class_unref (cancellable_class);
 }
 
 static void
 dex_async_pair_init (DexAsyncPair *async_pair)
 {
-  async_pair->cancellable = g_cancellable_new ();
   async_pair->cancel_on_discard = TRUE;
 }
 
+/* For the GIO wrappers within libdex. The cancellable may be recycled
+ * from a previous operation on this thread and must only be passed to
+ * GIO, never to application code.
+ */
+DexAsyncPair *
+dex_async_pair_create (void)
+{
+  DexAsyncPair *async_pair;
+
+  async_pair = (DexAsyncPair *)dex_object_create_instance (DEX_TYPE_ASYNC_PAIR);
+  async_pair->cancellable = dex_async_pair_acquire_cancellable ();
+  async_pair->recycle_cancellable = TRUE;
+
+  return async_pair;
+}
+
 static void
 dex_async_pair_ready_callback (GObject      *object,
                                GAsyncResult *result,
@@ -202,6 +281,7 @@ dex_async_pair_new (gpointer                instance,
   async_func = info->async;
 
   async_pair = (DexAsyncPair *)dex_object_create_instance (DEX_TYPE_ASYNC_PAIR);
+  async_pair->cancellable = g_cancellable_new ();
   async_pair->info = g_memdup2 (info, sizeof *info);
   g_set_object (&async_pair->instance, instance);
 
@@ -229,6 +309,10 @@ dex_async_pair_get_cancellable (DexAsyncPair *async_pair)
 {
   g_return_val_if_fail (DEX_IS_ASYNC_PAIR (async_pair), NULL);
 
+  dex_object_lock (async_pair);
+  async_pair->recycle_cancellable = FALSE;
+  dex_object_unlock (async_pair);
+
   return async_pair->cancellable;
 }
 
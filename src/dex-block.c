@@ -22,6 +22,8 @@
 #include "config.h"
 
 #include "dex-block-private.h"
+#include "dex-probes-private.h"
+#include "dex-profiler.h"
 #include "dex-thread-storage-private.h"
 
 /**
@@ -86,12 +88,17 @@ typedef struct _PropagateState
 {
   DexBlock *block;
   DexFuture *completed;
+  gint64 queued_at;
 } PropagateState;
 
 static gboolean
 dex_block_propagate_within_scheduler_internal (PropagateState *state)
 {
-  DexFuture *delayed = state->block->callback (state->completed, state->block->callback_data);
+  DexFuture *delayed;
+
+  DEX_PROBE2 (block_dispatch, state->block, DEX_FUTURE (state->block)->name);
+
+  delayed = state->block->callback (state->completed, state->block->callback_data);
 
   /* If we got a future then we need to chain to it so that we get
    * a second propagation callback with the resolved or rejected
@@ -139,6 +146,16 @@ dex_block_propagate_within_scheduler (gpointer data)
   g_assert (DEX_IS_BLOCK (state->block));
   g_assert (DEX_IS_FUTURE (state->completed));
 
+  /* Time spent waiting in the scheduler queue before we could run */
+  if (state->queued_at != 0 && DEX_PROFILER_ACTIVE)
+    {
+      gint64 duration = DEX_PROFILER_CURRENT_TIME - state->queued_at;
+
+      DEX_PROFILER_MARK (duration,
+                         "DexBlock",
+                         DEX_FUTURE (state->block)->name ? DEX_FUTURE (state->block)->name : "enqueue to run");
+    }
+
   if (!dex_block_propagate_within_scheduler_internal (state))
     dex_future_complete (DEX_FUTURE (state->block),
                          state->completed->rejected ? NULL : &state->completed->resolved,
@@ -201,6 +218,9 @@ dex_block_propagate (DexFuture *future,
         }
 
       /* Otherwise we must defer it to the scheduler */
+      if (DEX_PROFILER_ACTIVE)
+        state.queued_at = DEX_PROFILER_CURRENT_TIME;
+
       dex_ref (block);
       dex_ref (completed);
       dex_scheduler_push (block->scheduler,
@@ -0,0 +1,718 @@
+/*
+ * dex-broadcast.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-broadcast.h"
+#include "dex-error.h"
+#include "dex-object-private.h"
+#include "dex-promise.h"
+
+/**
+ * DexBroadcast:
+ *
+ * #DexBroadcast delivers every published item to each of its
+ * subscribers.
+ *
+ * Items are stored once in a fixed-size ring and each
+ * #DexBroadcastSubscriber keeps its own read cursor into it. Publishing
+ * writes a single slot no matter how many subscribers there are, and a
+ * subscriber reading an item that is already available only takes its
+ * own lock. Nothing is allocated unless a publisher or subscriber has
+ * to wait.
+ *
+ * Every subscriber receives the same #DexFuture that was published.
+ * Subscribers only see items published after they subscribed.
+ *
+ * When a subscriber has fallen a full ring behind, the #DexBroadcastPolicy
+ * decides whether publishing waits for it, it skips the oldest items, or
+ * it is disconnected.
+ *
+ * Since: 0.8
+ */
+
+/**
+ * DexBroadcastSubscriber:
+ *
+ * #DexBroadcastSubscriber reads items from a #DexBroadcast in the order
+ * they were published.
+ *
+ * Since: 0.8
+ */
+
+typedef struct _DexBroadcastPending
+{
+  GList       link;
+  DexFuture  *future;
+  DexPromise *promise;
+} DexBroadcastPending;
+
+struct _DexBroadcast
+{
+  DexObject           parent_instance;
+
+  /* The sequence of the next item to publish. Only changed with the
+   * object lock held but read atomically by subscribers.
+   */
+  int                 head;
+
+  guint               mask;
+  DexFuture         **slots;
+  DexBroadcastPolicy  policy;
+
+  /* Number of publishes in @blocked, checked by subscribers after
+   * advancing so they know when to make room.
+   */
+  int                 n_blocked;
+
+  /* The rest is protected by the object lock */
+  GPtrArray          *subscribers;
+  GQueue              waiting;
+  GQueue              blocked;
+  guint               min_cursor;
+  guint               closed : 1;
+};
+
+typedef struct _DexBroadcastClass
+{
+  DexObjectClass parent_class;
+} DexBroadcastClass;
+
+struct _DexBroadcastSubscriber
+{
+  DexObject     parent_instance;
+
+  DexBroadcast *broadcast;
+
+  /* Protected by the broadcast lock, set while waiting for an item */
+  GList         link;
+  DexPromise   *ready;
+
+  /* Sequence of the next item to read. Changed with our lock held but
+   * read atomically by publishers.
+   */
+  int           cursor;
+
+  /* Protected by our lock */
+  guint64       n_dropped;
+  guint         disconnected : 1;
+};
+
+typedef struct _DexBroadcastSubscriberClass
+{
+  DexObjectClass parent_class;
+} DexBroadcastSubscriberClass;
+
+DEX_DEFINE_FINAL_TYPE (DexBroadcast, dex_broadcast, DEX_TYPE_OBJECT)
+DEX_DEFINE_FINAL_TYPE (DexBroadcastSubscriber, dex_broadcast_subscriber, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_BROADCAST
+#define DEX_TYPE_BROADCAST dex_broadcast_type
+
+#undef DEX_TYPE_BROADCAST_SUBSCRIBER
+#define DEX_TYPE_BROADCAST_SUBSCRIBER dex_broadcast_subscriber_type
+
+static inline guint
+dex_broadcast_capacity (DexBroadcast *broadcast)
+{
+  return broadcast->mask + 1;
+}
+
+static void
+dex_broadcast_add_woken (GPtrArray  **woken,
+                         DexPromise  *promise)
+{
+  if (*woken == NULL)
+    *woken = g_ptr_array_new_with_free_func (dex_unref);
+  g_ptr_array_add (*woken, promise);
+}
+
+static void
+dex_broadcast_wake (GPtrArray *woken)
+{
+  if (woken == NULL)
+    return;
+
+  for (guint i = 0; i < woken->len; i++)
+    dex_promise_resolve_boolean (g_ptr_array_index (woken, i), TRUE);
+
+  g_ptr_array_unref (woken);
+}
+
+/* Wakes every subscriber which was waiting for the next item */
+static void
+dex_broadcast_wake_waiting_locked (DexBroadcast  *broadcast,
+                                   GPtrArray    **woken)
+{
+  while (broadcast->waiting.length > 0)
+    {
+      DexBroadcastSubscriber *subscriber = g_queue_pop_head_link (&broadcast->waiting)->data;
+
+      dex_broadcast_add_woken (woken, g_steal_pointer (&subscriber->ready));
+    }
+}
+
+/* Ensures the slot for the next item is no longer needed by any
+ * subscriber, applying the policy to those which lag a full ring behind.
+ * Returns FALSE if the publisher must wait.
+ */
+static gboolean
+dex_broadcast_make_room_locked (DexBroadcast  *broadcast,
+                                GPtrArray    **woken)
+{
+  guint capacity = dex_broadcast_capacity (broadcast);
+  guint seq = broadcast->head;
+  guint min_cursor = seq;
+
+  /* Cursors only move forward so the cached minimum is a lower bound */
+  if (seq - broadcast->min_cursor < capacity)
+    return TRUE;
+
+  for (guint i = 0; i < broadcast->subscribers->len; i++)
+    {
+      DexBroadcastSubscriber *subscriber = g_ptr_array_index (broadcast->subscribers, i);
+      guint cursor = g_atomic_int_get (&subscriber->cursor);
+
+      if ((int)(cursor - min_cursor) < 0)
+        min_cursor = cursor;
+    }
+
+  broadcast->min_cursor = min_cursor;
+
+  if (seq - min_cursor < capacity)
+    return TRUE;
+
+  if (broadcast->policy == DEX_BROADCAST_POLICY_BLOCK)
+    return FALSE;
+
+  for (guint i = broadcast->subscribers->len; i > 0; i--)
+    {
+      DexBroadcastSubscriber *subscriber = g_ptr_array_index (broadcast->subscribers, i - 1);
+      gboolean disconnected = FALSE;
+      guint cursor;
+
+      if (seq - (guint)g_atomic_int_get (&subscriber->cursor) < capacity)
+        continue;
+
+      /* The subscriber reads slots with its lock held, so once the
+       * cursor has moved past the slot it can be overwritten.
+       */
+      dex_object_lock (subscriber);
+      cursor = subscriber->cursor;
+      if (seq - cursor >= capacity)
+        {
+          if (broadcast->policy == DEX_BROADCAST_POLICY_DROP_OLDEST)
+            {
+              subscriber->n_dropped += seq - capacity + 1 - cursor;
+              g_atomic_int_set (&subscriber->cursor, seq - capacity + 1);
+            }
+          else
+            {
+              subscriber->disconnected = TRUE;
+              disconnected = TRUE;
+            }
+        }
+      dex_object_unlock (subscriber);
+
+      if (disconnected)
+        g_ptr_array_remove_index_fast (broadcast->subscribers, i - 1);
+    }
+
+  broadcast->min_cursor = seq - capacity + 1;
+
+  return TRUE;
+}
+
+/* Stores @future in the next slot, returning the item it replaced */
+static DexFuture *
+dex_broadcast_write_locked (DexBroadcast *broadcast,
+                            DexFuture    *future)
+{
+  guint seq = broadcast->head;
+  DexFuture *replaced;
+
+  replaced = broadcast->slots[seq & broadcast->mask];
+  broadcast->slots[seq & broadcast->mask] = future;
+
+  /* Publishes the slot to subscribers */
+  g_atomic_int_set (&broadcast->head, seq + 1);
+
+  return replaced;
+}
+
+static void
+dex_broadcast_flush_blocked (DexBroadcast *broadcast)
+{
+  g_autoptr(GPtrArray) replaced = NULL;
+  GPtrArray *woken = NULL;
+
+  dex_object_lock (broadcast);
+
+  while (broadcast->blocked.length > 0 &&
+         dex_broadcast_make_room_locked (broadcast, &woken))
+    {
+      DexBroadcastPending *pending = g_queue_pop_head_link (&broadcast->blocked)->data;
+      DexFuture *old;
+
+      g_atomic_int_add (&broadcast->n_blocked, -1);
+
+      if ((old = dex_broadcast_write_locked (broadcast, g_steal_pointer (&pending->future))))
+        {
+          if (replaced == NULL)
+            replaced = g_ptr_array_new_with_free_func (dex_unref);
+          g_ptr_array_add (replaced, old);
+        }
+
+      dex_broadcast_add_woken (&woken, g_steal_pointer (&pending->promise));
+      g_free (pending);
+    }
+
+  dex_broadcast_wake_waiting_locked (broadcast, &woken);
+
+  dex_object_unlock (broadcast);
+
+  dex_broadcast_wake (woken);
+}
+
+static void
+dex_broadcast_finalize (DexObject *object)
+{
+  DexBroadcast *broadcast = DEX_BROADCAST (object);
+
+  /* Subscribers hold a reference to the broadcast */
+  g_assert (broadcast->subscribers->len == 0);
+  g_assert (broadcast->waiting.length == 0);
+
+  while (broadcast->blocked.length > 0)
+    {
+      DexBroadcastPending *pending = g_queue_pop_head_link (&broadcast->blocked)->data;
+
+      dex_promise_reject (pending->promise,
+                          g_error_new_literal (DEX_ERROR,
+                                               DEX_ERROR_CHANNEL_CLOSED,
+                                               "Broadcast closed"));
+      dex_clear (&pending->promise);
+      dex_clear (&pending->future);
+      g_free (pending);
+    }
+
+  for (guint i = 0; i <= broadcast->mask; i++)
+    dex_clear (&broadcast->slots[i]);
+
+  g_clear_pointer (&broadcast->slots, g_free);
+  g_clear_pointer (&broadcast->subscribers, g_ptr_array_unref);
+
+  DEX_OBJECT_CLASS (dex_broadcast_parent_class)->finalize (object);
+}
+
+static void
+dex_broadcast_class_init (DexBroadcastClass *broadcast_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (broadcast_class);
+
+  object_class->finalize = dex_broadcast_finalize;
+}
+
+static void
+dex_broadcast_init (DexBroadcast *broadcast)
+{
+  broadcast->subscribers = g_ptr_array_new ();
+}
+
+static void
+dex_broadcast_subscriber_finalize (DexObject *object)
+{
+  DexBroadcastSubscriber *subscriber = DEX_BROADCAST_SUBSCRIBER (object);
+  DexBroadcast *broadcast = subscriber->broadcast;
+
+  dex_object_lock (broadcast);
+  g_ptr_array_remove_fast (broadcast->subscribers, subscriber);
+  if (subscriber->ready != NULL)
+    {
+      g_queue_unlink (&broadcast->waiting, &subscriber->link);
+      dex_clear (&subscriber->ready);
+    }
+  dex_object_unlock (broadcast);
+
+  /* Publishers may be waiting on this subscriber */
+  if (g_atomic_int_get (&broadcast->n_blocked) > 0)
+    dex_broadcast_flush_blocked (broadcast);
+
+  dex_clear (&subscriber->broadcast);
+
+  DEX_OBJECT_CLASS (dex_broadcast_subscriber_parent_class)->finalize (object);
+}
+
+static void
+dex_broadcast_subscriber_class_init (DexBroadcastSubscriberClass *subscriber_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (subscriber_class);
+
+  object_class->finalize = dex_broadcast_subscriber_finalize;
+}
+
+static void
+dex_broadcast_subscriber_init (DexBroadcastSubscriber *subscriber)
+{
+  subscriber->link.data = subscriber;
+}
+
+/**
+ * dex_broadcast_new:
+ * @capacity: the number of items kept for subscribers
+ * @policy: what to do when a subscriber falls @capacity items behind
+ *
+ * Creates a new #DexBroadcast.
+ *
+ * @capacity must be non-zero and is rounded up to the next power of two.
+ *
+ * Returns: (transfer full): a new #DexBroadcast
+ *
+ * Since: 0.8
+ */
+DexBroadcast *
+dex_broadcast_new (guint              capacity,
+                   DexBroadcastPolicy policy)
+{
+  DexBroadcast *broadcast;
+  guint n_slots = 1;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+  g_return_val_if_fail (capacity <= G_MAXINT / 2, NULL);
+  g_return_val_if_fail (policy <= DEX_BROADCAST_POLICY_DISCONNECT, NULL);
+
+  while (n_slots < capacity)
+    n_slots <<= 1;
+
+  broadcast = (DexBroadcast *)dex_object_create_instance (DEX_TYPE_BROADCAST);
+  broadcast->mask = n_slots - 1;
+  broadcast->slots = g_new0 (DexFuture *, n_slots);
+  broadcast->policy = policy;
+
+  return broadcast;
+}
+
+/**
+ * dex_broadcast_publish:
+ * @broadcast: a #DexBroadcast
+ * @future: (transfer full): a #DexFuture
+ *
+ * Publishes @future to every subscriber of @broadcast.
+ *
+ * The returned future resolves to %TRUE once @future has been stored.
+ * With %DEX_BROADCAST_POLICY_BLOCK that may wait for the slowest
+ * subscriber to read older items. If the broadcast is closed, it rejects
+ * with %DEX_ERROR_CHANNEL_CLOSED.
+ *
+ * Returns: (transfer full): a #DexFuture
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_broadcast_publish (DexBroadcast *broadcast,
+                       DexFuture    *future)
+{
+  DexBroadcastPending *pending;
+  GPtrArray *woken = NULL;
+  DexFuture *replaced;
+  DexFuture *ret;
+  gboolean room;
+
+  g_return_val_if_fail (DEX_IS_BROADCAST (broadcast), NULL);
+  g_return_val_if_fail (DEX_IS_FUTURE (future), NULL);
+
+  dex_object_lock (broadcast);
+
+  if (broadcast->closed)
+    {
+      dex_object_unlock (broadcast);
+      dex_unref (future);
+      return dex_future_new_reject (DEX_ERROR,
+                                    DEX_ERROR_CHANNEL_CLOSED,
+                                    "Broadcast closed");
+    }
+
+  room = broadcast->blocked.length == 0 &&
+         dex_broadcast_make_room_locked (broadcast, &woken);
+
+  if (!room)
+    {
+      /* Announce ourselves before checking again so that a subscriber
+       * advancing concurrently either makes room here or sees us.
+       */
+      g_atomic_int_inc (&broadcast->n_blocked);
+
+      room = broadcast->blocked.length == 0 &&
+             dex_broadcast_make_room_locked (broadcast, &woken);
+
+      if (room)
+        g_atomic_int_add (&broadcast->n_blocked, -1);
+    }
+
+  if (!room)
+    {
+      pending = g_new0 (DexBroadcastPending, 1);
+      pending->link.data = pending;
+      pending->future = future;
+      pending->promise = dex_promise_new ();
+      ret = dex_ref (pending->promise);
+      g_queue_push_tail_link (&broadcast->blocked, &pending->link);
+
+      dex_object_unlock (broadcast);
+
+      dex_broadcast_wake (woken);
+
+      return ret;
+    }
+
+  replaced = dex_broadcast_write_locked (broadcast, future);
+  dex_broadcast_wake_waiting_locked (broadcast, &woken);
+
+  dex_object_unlock (broadcast);
+
+  dex_broadcast_wake (woken);
+  dex_clear (&replaced);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+/**
+ * dex_broadcast_close:
+ * @broadcast: a #DexBroadcast
+ *
+ * Closes @broadcast so that no more items may be published.
+ *
+ * Publishes which are waiting are rejected. Subscribers may still read
+ * the items already published, after which they are rejected with
+ * %DEX_ERROR_CHANNEL_CLOSED.
+ *
+ * Since: 0.8
+ */
+void
+dex_broadcast_close (DexBroadcast *broadcast)
+{
+  GQueue blocked = G_QUEUE_INIT;
+  GPtrArray *woken = NULL;
+
+  g_return_if_fail (DEX_IS_BROADCAST (broadcast));
+
+  dex_object_lock (broadcast);
+
+  broadcast->closed = TRUE;
+
+  while (broadcast->blocked.length > 0)
+    g_queue_push_tail_link (&blocked, g_queue_pop_head_link (&broadcast->blocked));
+  g_atomic_int_set (&broadcast->n_blocked, 0);
+
+  dex_broadcast_wake_waiting_locked (broadcast, &woken);
+
+  dex_object_unlock (broadcast);
+
+  dex_broadcast_wake (woken);
+
+  while (blocked.length > 0)
+    {
+      DexBroadcastPending *pending = g_queue_pop_head_link (&blocked)->data;
+
+      dex_promise_reject (pending->promise,
+                          g_error_new_literal (DEX_ERROR,
+                                               DEX_ERROR_CHANNEL_CLOSED,
+                                               "Broadcast closed"));
+      dex_clear (&pending->promise);
+      dex_clear (&pending->future);
+      g_free (pending);
+    }
+}
+
+/**
+ * dex_broadcast_subscribe:
+ * @broadcast: a #DexBroadcast
+ *
+ * Creates a new subscriber which receives items published from now on.
+ *
+ * Dropping the last reference to the subscriber unsubscribes it.
+ *
+ * Returns: (transfer full): a new #DexBroadcastSubscriber
+ *
+ * Since: 0.8
+ */
+DexBroadcastSubscriber *
+dex_broadcast_subscribe (DexBroadcast *broadcast)
+{
+  DexBroadcastSubscriber *subscriber;
+
+  g_return_val_if_fail (DEX_IS_BROADCAST (broadcast), NULL);
+
+  subscriber = (DexBroadcastSubscriber *)dex_object_create_instance (DEX_TYPE_BROADCAST_SUBSCRIBER);
+  subscriber->broadcast = dex_ref (broadcast);
+
+  dex_object_lock (broadcast);
+  subscriber->cursor = broadcast->head;
+  if (broadcast->subscribers->len == 0)
+    broadcast->min_cursor = broadcast->head;
+  g_ptr_array_add (broadcast->subscribers, subscriber);
+  dex_object_unlock (broadcast);
+
+  return subscriber;
+}
+
+/* Takes the next item if it has been published, must be called with
+ * the subscriber locked.
+ */
+static DexFuture *
+dex_broadcast_subscriber_take_locked (DexBroadcastSubscriber *subscriber)
+{
+  DexBroadcast *broadcast = subscriber->broadcast;
+  guint cursor = subscriber->cursor;
+  DexFuture *item;
+
+  if (cursor == (guint)g_atomic_int_get (&broadcast->head))
+    return NULL;
+
+  item = dex_ref (broadcast->slots[cursor & broadcast->mask]);
+  g_atomic_int_set (&subscriber->cursor, cursor + 1);
+
+  return item;
+}
+
+static DexFuture *
+dex_broadcast_subscriber_next_cb (DexFuture *completed,
+                                  gpointer   user_data)
+{
+  return dex_broadcast_subscriber_next (user_data);
+}
+
+/**
+ * dex_broadcast_subscriber_next:
+ * @subscriber: a #DexBroadcastSubscriber
+ *
+ * Gets the next item for @subscriber.
+ *
+ * The returned future resolves or rejects like the published future
+ * once it is available. It rejects with %DEX_ERROR_CHANNEL_CLOSED after
+ * the last item of a closed broadcast, or with
+ * %DEX_ERROR_SUBSCRIBER_DISCONNECTED if the subscriber fell too far
+ * behind with %DEX_BROADCAST_POLICY_DISCONNECT.
+ *
+ * Returns: (transfer full): a #DexFuture
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_broadcast_subscriber_next (DexBroadcastSubscriber *subscriber)
+{
+  DexBroadcast *broadcast;
+  DexFuture *item;
+  DexFuture *ret;
+
+  g_return_val_if_fail (DEX_IS_BROADCAST_SUBSCRIBER (subscriber), NULL);
+
+  broadcast = subscriber->broadcast;
+
+  dex_object_lock (subscriber);
+  if (subscriber->disconnected)
+    goto disconnected;
+  item = dex_broadcast_subscriber_take_locked (subscriber);
+  dex_object_unlock (subscriber);
+
+  if (item != NULL)
+    goto complete;
+
+  /* Wait for the next publish, locking in the same order as publishers */
+  dex_object_lock (broadcast);
+  dex_object_lock (subscriber);
+
+  if (subscriber->disconnected)
+    {
+      dex_object_unlock (broadcast);
+      goto disconnected;
+    }
+
+  if ((item = dex_broadcast_subscriber_take_locked (subscriber)))
+    {
+      dex_object_unlock (subscriber);
+      dex_object_unlock (broadcast);
+      goto complete;
+    }
+
+  if (broadcast->closed)
+    {
+      dex_object_unlock (subscriber);
+      dex_object_unlock (broadcast);
+      return dex_future_new_reject (DEX_ERROR,
+                                    DEX_ERROR_CHANNEL_CLOSED,
+                                    "Broadcast closed");
+    }
+
+  if (subscriber->ready == NULL)
+    {
+      subscriber->ready = dex_promise_new ();
+      g_queue_push_tail_link (&broadcast->waiting, &subscriber->link);
+    }
+
+  ret = dex_future_then (dex_ref (subscriber->ready),
+                         dex_broadcast_subscriber_next_cb,
+                         dex_ref (subscriber),
+                         dex_unref);
+
+  dex_object_unlock (subscriber);
+  dex_object_unlock (broadcast);
+
+  return ret;
+
+complete:
+  if (g_atomic_int_get (&broadcast->n_blocked) > 0)
+    dex_broadcast_flush_blocked (broadcast);
+
+  return item;
+
+disconnected:
+  dex_object_unlock (subscriber);
+
+  return dex_future_new_reject (DEX_ERROR,
+                                DEX_ERROR_SUBSCRIBER_DISCONNECTED,
+                                "Subscriber fell too far behind");
+}
+
+/**
+ * dex_broadcast_subscriber_get_n_dropped:
+ * @subscriber: a #DexBroadcastSubscriber
+ *
+ * Gets the number of items @subscriber skipped because it fell too far
+ * behind with %DEX_BROADCAST_POLICY_DROP_OLDEST.
+ *
+ * Returns: the number of dropped items
+ *
+ * Since: 0.8
+ */
+guint64
+dex_broadcast_subscriber_get_n_dropped (DexBroadcastSubscriber *subscriber)
+{
+  guint64 ret;
+
+  g_return_val_if_fail (DEX_IS_BROADCAST_SUBSCRIBER (subscriber), 0);
+
+  dex_object_lock (subscriber);
+  ret = subscriber->n_dropped;
+  dex_object_unlock (subscriber);
+
+  return ret;
+}
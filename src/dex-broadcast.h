@@ -0,0 +1,65 @@
+/*
+ * dex-broadcast.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-enums.h"
+#include "dex-future.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_BROADCAST               (dex_broadcast_get_type())
+#define DEX_BROADCAST(obj)               (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_BROADCAST, DexBroadcast))
+#define DEX_IS_BROADCAST(obj)            (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_BROADCAST))
+#define DEX_TYPE_BROADCAST_SUBSCRIBER    (dex_broadcast_subscriber_get_type())
+#define DEX_BROADCAST_SUBSCRIBER(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_BROADCAST_SUBSCRIBER, DexBroadcastSubscriber))
+#define DEX_IS_BROADCAST_SUBSCRIBER(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_BROADCAST_SUBSCRIBER))
+
+typedef struct _DexBroadcast           DexBroadcast;
+typedef struct _DexBroadcastSubscriber DexBroadcastSubscriber;
+
+DEX_AVAILABLE_IN_ALL
+GType                   dex_broadcast_get_type                 (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+GType                   dex_broadcast_subscriber_get_type      (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexBroadcast           *dex_broadcast_new                      (guint                   capacity,
+                                                                DexBroadcastPolicy      policy)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture              *dex_broadcast_publish                  (DexBroadcast           *broadcast,
+                                                                DexFuture              *future)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+void                    dex_broadcast_close                    (DexBroadcast           *broadcast);
+DEX_AVAILABLE_IN_ALL
+DexBroadcastSubscriber *dex_broadcast_subscribe                (DexBroadcast           *broadcast)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture              *dex_broadcast_subscriber_next          (DexBroadcastSubscriber *subscriber)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+guint64                 dex_broadcast_subscriber_get_n_dropped (DexBroadcastSubscriber *subscriber);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexBroadcast, dex_unref)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexBroadcastSubscriber, dex_unref)
+
+G_END_DECLS
@@ -0,0 +1,830 @@
+/*
+ * dex-buffered-writer.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "dex-aio.h"
+#include "dex-aio-output-stream.h"
+#include "dex-buffered-writer.h"
+#include "dex-gio.h"
+#include "dex-object-private.h"
+#include "dex-promise.h"
+#include "dex-scheduler.h"
+#include "dex-timeout.h"
+
+/**
+ * DexBufferedWriter:
+ *
+ * #DexBufferedWriter coalesces many small writes into a single vectored
+ * write.
+ *
+ * Protocol implementations tend to produce output in many small pieces.
+ * Writing each of them with dex_output_stream_write() costs a system call,
+ * a #DexAsyncPair and a wakeup per piece. Instead, writes made with
+ * dex_buffered_writer_write() are appended to a batch which is submitted
+ * with dex_aio_writev() (or g_output_stream_writev_all_async() for streams
+ * not backed by a file descriptor) once the batch grows beyond
+ * #DexBufferedWriter:max-buffer-size, the maximum delay has elapsed, or
+ * dex_buffered_writer_flush() is called.
+ *
+ * Only one batch is written at a time. Writes made while a batch is being
+ * written are collected into the next batch, so the number of system calls
+ * adapts to how fast the peer consumes data.
+ *
+ * Every write made to the same batch shares a single future which resolves
+ * once the whole batch has been written. After a write fails, the error is
+ * sticky and all further writes are rejected with it.
+ *
+ * Since: 0.8
+ */
+
+#define DEFAULT_MAX_BUFFER_SIZE (64*1024)
+
+/* GBytes smaller than this are copied rather than getting a vector of their
+ * own, which keeps the vector count low for chatty protocols.
+ */
+#define COPY_THRESHOLD 256
+
+#ifdef IOV_MAX
+# define MAX_VECTORS IOV_MAX
+#else
+# define MAX_VECTORS 1024
+#endif
+
+typedef struct _DexBufferedSegment
+{
+  /* %NULL if the data was copied into the batch buffer */
+  GBytes *bytes;
+  gsize   offset;
+  gsize   length;
+} DexBufferedSegment;
+
+typedef struct _DexBufferedBatch
+{
+  GByteArray *buffer;
+  GArray     *segments;
+  DexPromise *promise;
+  gsize       length;
+} DexBufferedBatch;
+
+struct _DexBufferedWriter
+{
+  DexObject         parent_instance;
+
+  /* The stream to write to if @fd is -1, and to close if set */
+  GOutputStream    *stream;
+
+  /* Writes which have not been submitted yet */
+  DexBufferedBatch *pending;
+
+  /* Promise for the batch currently being written */
+  DexPromise       *in_flight;
+
+  /* Resolved to wake the flushing fiber before the delay elapses */
+  DexPromise       *wakeup;
+
+  /* The first error encountered while writing */
+  GError           *error;
+
+  gsize             max_buffer_size;
+  gint64            max_delay;
+  int               fd;
+
+  guint             close_fd : 1;
+  guint             closed : 1;
+  guint             flushing : 1;
+  guint             flush_requested : 1;
+};
+
+typedef struct _DexBufferedWriterClass
+{
+  DexObjectClass parent_class;
+} DexBufferedWriterClass;
+
+DEX_DEFINE_FINAL_TYPE (DexBufferedWriter, dex_buffered_writer, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_BUFFERED_WRITER
+#define DEX_TYPE_BUFFERED_WRITER dex_buffered_writer_type
+
+static void
+dex_buffered_segment_clear (gpointer data)
+{
+  DexBufferedSegment *segment = data;
+
+  g_clear_pointer (&segment->bytes, g_bytes_unref);
+}
+
+static DexBufferedBatch *
+dex_buffered_batch_new (void)
+{
+  DexBufferedBatch *batch;
+
+  batch = g_new0 (DexBufferedBatch, 1);
+  batch->buffer = g_byte_array_new ();
+  batch->segments = g_array_new (FALSE, FALSE, sizeof (DexBufferedSegment));
+  batch->promise = dex_promise_new ();
+
+  g_array_set_clear_func (batch->segments, dex_buffered_segment_clear);
+
+  return batch;
+}
+
+static void
+dex_buffered_batch_free (DexBufferedBatch *batch)
+{
+  g_clear_pointer (&batch->buffer, g_byte_array_unref);
+  g_clear_pointer (&batch->segments, g_array_unref);
+  dex_clear (&batch->promise);
+  g_free (batch);
+}
+
+static void
+dex_buffered_batch_append (DexBufferedBatch *batch,
+                           gconstpointer     data,
+                           gsize             count,
+                           GBytes           *bytes)
+{
+  DexBufferedSegment segment;
+
+  batch->length += count;
+
+  if (bytes != NULL && count >= COPY_THRESHOLD)
+    {
+      segment.bytes = g_bytes_ref (bytes);
+      segment.offset = 0;
+      segment.length = count;
+      g_array_append_val (batch->segments, segment);
+      return;
+    }
+
+  /* Extend the previous segment when it also refers to the tail of
+   * the batch buffer so consecutive copies share a single vector.
+   */
+  if (batch->segments->len > 0)
+    {
+      DexBufferedSegment *last = &g_array_index (batch->segments,
+                                                 DexBufferedSegment,
+                                                 batch->segments->len - 1);
+
+      if (last->bytes == NULL && last->offset + last->length == batch->buffer->len)
+        {
+          g_byte_array_append (batch->buffer, data, count);
+          last->length += count;
+          return;
+        }
+    }
+
+  segment.bytes = NULL;
+  segment.offset = batch->buffer->len;
+  segment.length = count;
+  g_array_append_val (batch->segments, segment);
+
+  g_byte_array_append (batch->buffer, data, count);
+}
+
+static gboolean
+dex_buffered_writer_write_batch (DexBufferedWriter  *buffered_writer,
+                                 DexBufferedBatch   *batch,
+                                 GError            **error)
+{
+  g_autofree GOutputVector *vectors = NULL;
+  GOutputVector *iter;
+  gsize n_vectors;
+
+  n_vectors = batch->segments->len;
+  iter = vectors = g_new (GOutputVector, n_vectors);
+
+  /* The batch buffer is no longer appended to, so it is now safe to
+   * take pointers into it.
+   */
+  for (guint i = 0; i < n_vectors; i++)
+    {
+      const DexBufferedSegment *segment = &g_array_index (batch->segments, DexBufferedSegment, i);
+      const guint8 *base;
+
+      if (segment->bytes != NULL)
+        base = g_bytes_get_data (segment->bytes, NULL);
+      else
+        base = batch->buffer->data;
+
+      vectors[i].buffer = base + segment->offset;
+      vectors[i].size = segment->length;
+    }
+
+  while (n_vectors > 0)
+    {
+      gsize n = MIN (n_vectors, MAX_VECTORS);
+      GError *local_error = NULL;
+      gint64 len;
+
+      if (buffered_writer->fd != -1)
+        len = dex_await_int64 (dex_aio_writev (NULL, buffered_writer->fd, iter, n, -1),
+                               &local_error);
+      else
+        len = dex_await_int64 (dex_output_stream_writev_all (buffered_writer->stream, iter, n, G_PRIORITY_DEFAULT),
+                               &local_error);
+
+      if (local_error != NULL)
+        {
+          g_propagate_error (error, local_error);
+          return FALSE;
+        }
+
+      if (len <= 0)
+        {
+          g_set_error_literal (error,
+                               G_IO_ERROR,
+                               G_IO_ERROR_BROKEN_PIPE,
+                               "Failed to write buffered data");
+          return FALSE;
+        }
+
+      /* Skip past completed vectors and resubmit the remainder of
+       * a partially written one.
+       */
+      while (n_vectors > 0 && (gsize)len >= iter->size)
+        {
+          len -= iter->size;
+          iter++;
+          n_vectors--;
+        }
+
+      if (len > 0)
+        {
+          iter->buffer = (const guint8 *)iter->buffer + len;
+          iter->size -= len;
+        }
+    }
+
+  return TRUE;
+}
+
+static DexFuture *
+dex_buffered_writer_fiber (gpointer user_data)
+{
+  DexBufferedWriter *buffered_writer = user_data;
+
+  for (;;)
+    {
+      DexBufferedBatch *batch;
+      GError *error = NULL;
+
+      dex_object_lock (buffered_writer);
+
+      if (buffered_writer->pending == NULL)
+        {
+          buffered_writer->flushing = FALSE;
+          dex_object_unlock (buffered_writer);
+          break;
+        }
+
+      /* Give more writes a chance to join the batch unless a flush
+       * was requested or the buffer is already full.
+       */
+      if (!buffered_writer->flush_requested && buffered_writer->max_delay > 0)
+        {
+          DexPromise *wakeup = dex_promise_new ();
+          gint64 max_delay = buffered_writer->max_delay;
+
+          buffered_writer->wakeup = dex_ref (wakeup);
+          dex_object_unlock (buffered_writer);
+
+          dex_await (dex_future_first (dex_timeout_new_usec (max_delay),
+                                       DEX_FUTURE (wakeup),
+                                       NULL),
+                     NULL);
+
+          dex_object_lock (buffered_writer);
+          dex_clear (&buffered_writer->wakeup);
+        }
+
+      batch = g_steal_pointer (&buffered_writer->pending);
+      buffered_writer->flush_requested = FALSE;
+      buffered_writer->in_flight = dex_ref (batch->promise);
+
+      if (buffered_writer->error != NULL)
+        error = g_error_copy (buffered_writer->error);
+
+      dex_object_unlock (buffered_writer);
+
+      if (error == NULL)
+        dex_buffered_writer_write_batch (buffered_writer, batch, &error);
+
+      dex_object_lock (buffered_writer);
+      dex_clear (&buffered_writer->in_flight);
+      if (error != NULL && buffered_writer->error == NULL)
+        buffered_writer->error = g_error_copy (error);
+      dex_object_unlock (buffered_writer);
+
+      if (error != NULL)
+        dex_promise_reject (batch->promise, error);
+      else
+        dex_promise_resolve_boolean (batch->promise, TRUE);
+
+      dex_buffered_batch_free (batch);
+    }
+
+  return NULL;
+}
+
+static void
+dex_buffered_writer_spawn (DexBufferedWriter *buffered_writer)
+{
+  DexScheduler *scheduler;
+
+  if (!(scheduler = dex_scheduler_get_thread_default ()))
+    scheduler = dex_scheduler_get_default ();
+
+  /* The fiber holds a reference so that pending data is written even
+   * if the caller releases the writer right away.
+   */
+  dex_future_disown (dex_scheduler_spawn (scheduler,
+                                          0,
+                                          dex_buffered_writer_fiber,
+                                          dex_ref (buffered_writer),
+                                          dex_unref));
+}
+
+static void
+dex_buffered_writer_finalize (DexObject *object)
+{
+  DexBufferedWriter *buffered_writer = DEX_BUFFERED_WRITER (object);
+
+  g_assert (buffered_writer->pending == NULL);
+  g_assert (buffered_writer->in_flight == NULL);
+  g_assert (buffered_writer->wakeup == NULL);
+
+  if (buffered_writer->close_fd && buffered_writer->fd != -1)
+    close (buffered_writer->fd);
+
+  buffered_writer->fd = -1;
+
+  g_clear_object (&buffered_writer->stream);
+  g_clear_error (&buffered_writer->error);
+
+  DEX_OBJECT_CLASS (dex_buffered_writer_parent_class)->finalize (object);
+}
+
+static void
+dex_buffered_writer_class_init (DexBufferedWriterClass *buffered_writer_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (buffered_writer_class);
+
+  object_class->finalize = dex_buffered_writer_finalize;
+}
+
+static void
+dex_buffered_writer_init (DexBufferedWriter *buffered_writer)
+{
+  buffered_writer->fd = -1;
+  buffered_writer->max_buffer_size = DEFAULT_MAX_BUFFER_SIZE;
+}
+
+/**
+ * dex_buffered_writer_new:
+ * @stream: a #GOutputStream
+ *
+ * Creates a new #DexBufferedWriter which writes to @stream.
+ *
+ * If @stream is a #DexAioOutputStream, batches are written directly to
+ * its file descriptor with dex_aio_writev().
+ *
+ * Returns: (transfer full): a new #DexBufferedWriter
+ *
+ * Since: 0.8
+ */
+DexBufferedWriter *
+dex_buffered_writer_new (GOutputStream *stream)
+{
+  DexBufferedWriter *buffered_writer;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), NULL);
+
+  buffered_writer = (DexBufferedWriter *)dex_object_create_instance (DEX_TYPE_BUFFERED_WRITER);
+  buffered_writer->stream = g_object_ref (stream);
+
+  if (DEX_IS_AIO_OUTPUT_STREAM (stream))
+    buffered_writer->fd = dex_aio_output_stream_get_fd (DEX_AIO_OUTPUT_STREAM (stream));
+
+  return buffered_writer;
+}
+
+/**
+ * dex_buffered_writer_new_for_fd:
+ * @fd: a file descriptor
+ * @close_fd: if @fd should be closed with the writer
+ *
+ * Creates a new #DexBufferedWriter which writes to @fd at the current
+ * file position using dex_aio_writev().
+ *
+ * Returns: (transfer full): a new #DexBufferedWriter
+ *
+ * Since: 0.8
+ */
+DexBufferedWriter *
+dex_buffered_writer_new_for_fd (int      fd,
+                                gboolean close_fd)
+{
+  DexBufferedWriter *buffered_writer;
+
+  g_return_val_if_fail (fd > -1, NULL);
+
+  buffered_writer = (DexBufferedWriter *)dex_object_create_instance (DEX_TYPE_BUFFERED_WRITER);
+  buffered_writer->fd = fd;
+  buffered_writer->close_fd = !!close_fd;
+
+  return buffered_writer;
+}
+
+/**
+ * dex_buffered_writer_get_max_buffer_size:
+ * @buffered_writer: a #DexBufferedWriter
+ *
+ * Gets the number of bytes after which a batch is flushed without
+ * waiting for the maximum delay.
+ *
+ * Returns: the maximum buffer size in bytes
+ *
+ * Since: 0.8
+ */
+gsize
+dex_buffered_writer_get_max_buffer_size (DexBufferedWriter *buffered_writer)
+{
+  gsize ret;
+
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), 0);
+
+  dex_object_lock (buffered_writer);
+  ret = buffered_writer->max_buffer_size;
+  dex_object_unlock (buffered_writer);
+
+  return ret;
+}
+
+/**
+ * dex_buffered_writer_set_max_buffer_size:
+ * @buffered_writer: a #DexBufferedWriter
+ * @max_buffer_size: the size in bytes, or 0 for the default
+ *
+ * Sets the number of bytes after which a batch is flushed without
+ * waiting for the maximum delay. The default is 64 KiB.
+ *
+ * This is a threshold rather than a limit; writes are never rejected
+ * because the batch is full.
+ *
+ * Since: 0.8
+ */
+void
+dex_buffered_writer_set_max_buffer_size (DexBufferedWriter *buffered_writer,
+                                         gsize              max_buffer_size)
+{
+  g_return_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer));
+
+  if (max_buffer_size == 0)
+    max_buffer_size = DEFAULT_MAX_BUFFER_SIZE;
+
+  dex_object_lock (buffered_writer);
+  buffered_writer->max_buffer_size = max_buffer_size;
+  dex_object_unlock (buffered_writer);
+}
+
+/**
+ * dex_buffered_writer_get_max_delay:
+ * @buffered_writer: a #DexBufferedWriter
+ *
+ * Gets the maximum time a write may wait for more writes to join
+ * its batch.
+ *
+ * Returns: the maximum delay in microseconds
+ *
+ * Since: 0.8
+ */
+gint64
+dex_buffered_writer_get_max_delay (DexBufferedWriter *buffered_writer)
+{
+  gint64 ret;
+
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), 0);
+
+  dex_object_lock (buffered_writer);
+  ret = buffered_writer->max_delay;
+  dex_object_unlock (buffered_writer);
+
+  return ret;
+}
+
+/**
+ * dex_buffered_writer_set_max_delay:
+ * @buffered_writer: a #DexBufferedWriter
+ * @max_delay_usec: the delay in microseconds
+ *
+ * Sets the maximum time a write may wait for more writes to join
+ * its batch.
+ *
+ * The default of 0 submits a batch as soon as the scheduler gets to it,
+ * which still coalesces writes made in the same iteration of the
+ * scheduler and writes made while the previous batch was being written.
+ *
+ * Since: 0.8
+ */
+void
+dex_buffered_writer_set_max_delay (DexBufferedWriter *buffered_writer,
+                                   gint64             max_delay_usec)
+{
+  g_return_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer));
+  g_return_if_fail (max_delay_usec >= 0);
+
+  dex_object_lock (buffered_writer);
+  buffered_writer->max_delay = max_delay_usec;
+  dex_object_unlock (buffered_writer);
+}
+
+/* Must be called with the lock held. Returns a promise to resolve once
+ * the lock has been released, if any, and sets @spawn if a new fiber
+ * must be spawned to write the pending batch.
+ */
+static DexPromise *
+dex_buffered_writer_kick_locked (DexBufferedWriter *buffered_writer,
+                                 gboolean          *spawn)
+{
+  *spawn = FALSE;
+
+  if (buffered_writer->pending == NULL)
+    return NULL;
+
+  if (!buffered_writer->flushing)
+    {
+      buffered_writer->flushing = TRUE;
+      *spawn = TRUE;
+      return NULL;
+    }
+
+  if (buffered_writer->flush_requested)
+    return g_steal_pointer (&buffered_writer->wakeup);
+
+  return NULL;
+}
+
+static void
+dex_buffered_writer_kick (DexBufferedWriter *buffered_writer,
+                          DexPromise        *wakeup,
+                          gboolean           spawn)
+{
+  if (wakeup != NULL)
+    {
+      dex_promise_resolve_boolean (wakeup, TRUE);
+      dex_unref (wakeup);
+    }
+
+  if (spawn)
+    dex_buffered_writer_spawn (buffered_writer);
+}
+
+static DexFuture *
+dex_buffered_writer_append (DexBufferedWriter *buffered_writer,
+                            gconstpointer      buffer,
+                            gsize              count,
+                            GBytes            *bytes)
+{
+  DexPromise *wakeup = NULL;
+  gboolean spawn = FALSE;
+  DexFuture *ret;
+
+  dex_object_lock (buffered_writer);
+
+  if (buffered_writer->error != NULL)
+    {
+      ret = dex_future_new_for_error (g_error_copy (buffered_writer->error));
+    }
+  else if (buffered_writer->closed)
+    {
+      ret = dex_future_new_reject (G_IO_ERROR,
+                                   G_IO_ERROR_CLOSED,
+                                   "Writer is closed");
+    }
+  else if (count == 0)
+    {
+      ret = dex_future_new_for_boolean (TRUE);
+    }
+  else
+    {
+      if (buffered_writer->pending == NULL)
+        buffered_writer->pending = dex_buffered_batch_new ();
+
+      dex_buffered_batch_append (buffered_writer->pending, buffer, count, bytes);
+      ret = dex_ref (buffered_writer->pending->promise);
+
+      if (buffered_writer->max_delay == 0 ||
+          buffered_writer->pending->length >= buffered_writer->max_buffer_size)
+        buffered_writer->flush_requested = TRUE;
+
+      wakeup = dex_buffered_writer_kick_locked (buffered_writer, &spawn);
+    }
+
+  dex_object_unlock (buffered_writer);
+
+  dex_buffered_writer_kick (buffered_writer, wakeup, spawn);
+
+  return ret;
+}
+
+/**
+ * dex_buffered_writer_write:
+ * @buffered_writer: a #DexBufferedWriter
+ * @buffer: (array length=count) (element-type guint8): the data to write
+ * @count: the number of bytes in @buffer
+ *
+ * Appends @buffer to the pending batch.
+ *
+ * @buffer is copied so it need not remain valid after this returns.
+ *
+ * The returned future is shared by every write in the same batch, so
+ * awaiting it waits for all of them.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE once the
+ *   batch containing @buffer has been written, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_buffered_writer_write (DexBufferedWriter *buffered_writer,
+                           gconstpointer      buffer,
+                           gsize              count)
+{
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), NULL);
+  g_return_val_if_fail (buffer != NULL || count == 0, NULL);
+
+  return dex_buffered_writer_append (buffered_writer, buffer, count, NULL);
+}
+
+/**
+ * dex_buffered_writer_write_bytes:
+ * @buffered_writer: a #DexBufferedWriter
+ * @bytes: a #GBytes
+ *
+ * Like dex_buffered_writer_write() but avoids copying larger buffers by
+ * holding a reference to @bytes until the batch has been written.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE once the
+ *   batch containing @bytes has been written, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_buffered_writer_write_bytes (DexBufferedWriter *buffered_writer,
+                                 GBytes            *bytes)
+{
+  gconstpointer data;
+  gsize count;
+
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), NULL);
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  data = g_bytes_get_data (bytes, &count);
+
+  return dex_buffered_writer_append (buffered_writer, data, count, bytes);
+}
+
+/**
+ * dex_buffered_writer_flush:
+ * @buffered_writer: a #DexBufferedWriter
+ *
+ * Submits the pending batch without waiting for the maximum delay.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE once all
+ *   previous writes have been written, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_buffered_writer_flush (DexBufferedWriter *buffered_writer)
+{
+  DexPromise *wakeup = NULL;
+  gboolean spawn = FALSE;
+  DexFuture *ret;
+
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), NULL);
+
+  dex_object_lock (buffered_writer);
+
+  if (buffered_writer->error != NULL)
+    {
+      ret = dex_future_new_for_error (g_error_copy (buffered_writer->error));
+    }
+  else if (buffered_writer->pending != NULL)
+    {
+      /* Batches are written in order, so the pending batch completing
+       * implies that the in-flight batch has completed too.
+       */
+      buffered_writer->flush_requested = TRUE;
+      ret = dex_ref (buffered_writer->pending->promise);
+      wakeup = dex_buffered_writer_kick_locked (buffered_writer, &spawn);
+    }
+  else if (buffered_writer->in_flight != NULL)
+    {
+      ret = dex_ref (buffered_writer->in_flight);
+    }
+  else
+    {
+      ret = dex_future_new_for_boolean (TRUE);
+    }
+
+  dex_object_unlock (buffered_writer);
+
+  dex_buffered_writer_kick (buffered_writer, wakeup, spawn);
+
+  return ret;
+}
+
+static DexFuture *
+dex_buffered_writer_close_cb (DexFuture *completed,
+                              gpointer   user_data)
+{
+  DexBufferedWriter *buffered_writer = user_data;
+  g_autoptr(GOutputStream) stream = NULL;
+  GError *error = NULL;
+  int fd = -1;
+
+  dex_object_lock (buffered_writer);
+  stream = g_steal_pointer (&buffered_writer->stream);
+  if (buffered_writer->close_fd)
+    fd = buffered_writer->fd;
+  buffered_writer->fd = -1;
+  dex_object_unlock (buffered_writer);
+
+  dex_future_get_value (completed, &error);
+
+  if (fd != -1 && close (fd) != 0 && error == NULL)
+    {
+      int errsv = errno;
+      error = g_error_new_literal (G_IO_ERROR,
+                                   g_io_error_from_errno (errsv),
+                                   g_strerror (errsv));
+    }
+
+  if (stream != NULL)
+    {
+      DexFuture *future = dex_output_stream_close (stream, G_PRIORITY_DEFAULT);
+
+      if (error == NULL)
+        return future;
+
+      dex_future_disown (future);
+    }
+
+  if (error != NULL)
+    return dex_future_new_for_error (error);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+/**
+ * dex_buffered_writer_close:
+ * @buffered_writer: a #DexBufferedWriter
+ *
+ * Flushes pending writes and then closes the underlying stream or file
+ * descriptor (if it was created with @close_fd set).
+ *
+ * Further writes are rejected with %G_IO_ERROR_CLOSED.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE once the
+ *   writer has been flushed and closed, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_buffered_writer_close (DexBufferedWriter *buffered_writer)
+{
+  g_return_val_if_fail (DEX_IS_BUFFERED_WRITER (buffered_writer), NULL);
+
+  dex_object_lock (buffered_writer);
+  buffered_writer->closed = TRUE;
+  dex_object_unlock (buffered_writer);
+
+  return dex_future_finally (dex_buffered_writer_flush (buffered_writer),
+                             dex_buffered_writer_close_cb,
+                             dex_ref (buffered_writer),
+                             dex_unref);
+}
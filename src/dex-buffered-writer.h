@@ -0,0 +1,74 @@
+/*
+ * dex-buffered-writer.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "dex-future.h"
+#include "dex-object.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_BUFFERED_WRITER    (dex_buffered_writer_get_type())
+#define DEX_BUFFERED_WRITER(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_BUFFERED_WRITER, DexBufferedWriter))
+#define DEX_IS_BUFFERED_WRITER(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_BUFFERED_WRITER))
+
+typedef struct _DexBufferedWriter DexBufferedWriter;
+
+DEX_AVAILABLE_IN_ALL
+GType              dex_buffered_writer_get_type            (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexBufferedWriter *dex_buffered_writer_new                 (GOutputStream     *stream)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexBufferedWriter *dex_buffered_writer_new_for_fd          (int                fd,
+                                                            gboolean           close_fd)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+gsize              dex_buffered_writer_get_max_buffer_size (DexBufferedWriter *buffered_writer);
+DEX_AVAILABLE_IN_ALL
+void               dex_buffered_writer_set_max_buffer_size (DexBufferedWriter *buffered_writer,
+                                                            gsize              max_buffer_size);
+DEX_AVAILABLE_IN_ALL
+gint64             dex_buffered_writer_get_max_delay       (DexBufferedWriter *buffered_writer);
+DEX_AVAILABLE_IN_ALL
+void               dex_buffered_writer_set_max_delay       (DexBufferedWriter *buffered_writer,
+                                                            gint64             max_delay_usec);
+DEX_AVAILABLE_IN_ALL
+DexFuture         *dex_buffered_writer_write               (DexBufferedWriter *buffered_writer,
+                                                            gconstpointer      buffer,
+                                                            gsize              count)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture         *dex_buffered_writer_write_bytes         (DexBufferedWriter *buffered_writer,
+                                                            GBytes            *bytes)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture         *dex_buffered_writer_flush               (DexBufferedWriter *buffered_writer)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture         *dex_buffered_writer_close               (DexBufferedWriter *buffered_writer)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexBufferedWriter, dex_unref)
+
+G_END_DECLS
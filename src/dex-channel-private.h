@@ -0,0 +1,69 @@
+/*
+ * dex-channel-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-channel.h"
+#include "dex-channel-select.h"
+#include "dex-promise.h"
+
+G_BEGIN_DECLS
+
+typedef enum _DexChannelPoll
+{
+  DEX_CHANNEL_POLL_EMPTY,
+  DEX_CHANNEL_POLL_READY,
+  DEX_CHANNEL_POLL_CLOSED,
+} DexChannelPoll;
+
+/* Embedded in a DexChannelSelect for each channel it waits on and
+ * queued on the channel while the select is waiting. Protected by
+ * the channel's object lock.
+ */
+typedef struct _DexChannelSelectNode
+{
+  GList             link;
+  DexChannelSelect *channel_select;
+  guint             index;
+  guint             queued : 1;
+} DexChannelSelectNode;
+
+DexChannelPoll  dex_channel_poll                (DexChannel           *channel,
+                                                 gpointer             *item);
+void            dex_channel_add_select_node     (DexChannel           *channel,
+                                                 DexChannelSelectNode *node);
+void            dex_channel_remove_select_node  (DexChannel           *channel,
+                                                 DexChannelSelectNode *node);
+void            dex_channel_free_item           (DexChannel           *channel,
+                                                 gpointer              item);
+
+/* Called by channels with their lock held to commit a select to a
+ * single source. A claim that was begun must either be finished, which
+ * returns the promise to resolve once the lock is released, or aborted.
+ */
+gboolean        dex_channel_select_begin_claim  (DexChannelSelect     *channel_select);
+DexPromise     *dex_channel_select_finish_claim (DexChannelSelect     *channel_select,
+                                                 DexChannel           *channel,
+                                                 guint                 index,
+                                                 gpointer              item);
+void            dex_channel_select_abort_claim  (DexChannelSelect     *channel_select);
+
+G_END_DECLS
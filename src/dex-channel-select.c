@@ -0,0 +1,531 @@
+/*
+ * dex-channel-select.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-channel-private.h"
+#include "dex-object-private.h"
+
+/**
+ * DexChannelSelect:
+ *
+ * #DexChannelSelect waits on several #DexChannel and #DexFuture at once
+ * and commits to exactly one of them.
+ *
+ * Unlike calling dex_channel_receive() on each channel and awaiting the
+ * results with dex_future_any(), a select takes an item only from the
+ * channel it commits to. Other channels keep their items for the next
+ * round or for other receivers.
+ *
+ * A select is meant to be reused from a fiber loop:
+ *
+ * |[<!-- language="C" -->
+ * for (;;)
+ *   {
+ *     guint index = dex_channel_select_await (select);
+ *     g_autoptr(DexFuture) item = dex_channel_select_steal_item (select);
+ *
+ *     if (index == shutdown_index)
+ *       break;
+ *     ...
+ *   }
+ * ]|
+ *
+ * Sources which are already ready are taken without allocating. Only a
+ * round which has to wait allocates the future it suspends on.
+ *
+ * A closed channel is always ready and provides no item. Unlike
+ * dex_future_first(), futures are never discarded by the select, so a
+ * timeout or cancellable added once keeps running across rounds won by
+ * other sources. Each future is watched once for the lifetime of the
+ * select rather than once per round.
+ *
+ * Since: 0.8
+ */
+
+enum {
+  WINNER_NONE     = -1,
+  WINNER_CLAIMING = -2,
+};
+
+typedef struct _DexChannelSelectSource
+{
+  DexChannel           *channel;
+  DexFuture            *future;
+  /* Completes after @future to wake the select, set up by the first
+   * round which has to wait.
+   */
+  DexFuture            *ready;
+  DexChannelSelectNode  node;
+} DexChannelSelectSource;
+
+struct _DexChannelSelect
+{
+  DexObject   parent_instance;
+
+  /* Sources are allocated individually so that nodes queued on a
+   * channel do not move.
+   */
+  GPtrArray  *sources;
+
+  /* Set for the duration of a round which has to wait, protected by
+   * the object lock for future sources.
+   */
+  DexPromise *wakeup;
+
+  /* The index of the committed source, WINNER_NONE while waiting or
+   * WINNER_CLAIMING while a channel is taking an item for us.
+   */
+  int         winner;
+
+  /* Item from the committed channel, if any */
+  gpointer    item;
+  DexChannel *item_channel;
+
+  /* Where the next round starts polling, for fairness */
+  guint       next;
+};
+
+typedef struct _DexChannelSelectClass
+{
+  DexObjectClass parent_class;
+} DexChannelSelectClass;
+
+DEX_DEFINE_FINAL_TYPE (DexChannelSelect, dex_channel_select, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_CHANNEL_SELECT
+#define DEX_TYPE_CHANNEL_SELECT dex_channel_select_type
+
+static void
+dex_channel_select_source_free (gpointer data)
+{
+  DexChannelSelectSource *source = data;
+
+  g_assert (!source->node.queued);
+
+  dex_clear (&source->channel);
+  dex_clear (&source->future);
+  dex_clear (&source->ready);
+  g_free (source);
+}
+
+static void
+dex_channel_select_clear_item (DexChannelSelect *channel_select)
+{
+  gpointer item = g_steal_pointer (&channel_select->item);
+
+  if (item != NULL)
+    dex_channel_free_item (channel_select->item_channel, item);
+
+  channel_select->item_channel = NULL;
+}
+
+static void
+dex_channel_select_finalize (DexObject *object)
+{
+  DexChannelSelect *channel_select = DEX_CHANNEL_SELECT (object);
+
+  g_assert (channel_select->wakeup == NULL);
+
+  dex_channel_select_clear_item (channel_select);
+
+  g_clear_pointer (&channel_select->sources, g_ptr_array_unref);
+
+  DEX_OBJECT_CLASS (dex_channel_select_parent_class)->finalize (object);
+}
+
+static void
+dex_channel_select_class_init (DexChannelSelectClass *channel_select_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (channel_select_class);
+
+  object_class->finalize = dex_channel_select_finalize;
+}
+
+static void
+dex_channel_select_init (DexChannelSelect *channel_select)
+{
+  channel_select->sources = g_ptr_array_new_with_free_func (dex_channel_select_source_free);
+  channel_select->winner = WINNER_NONE;
+}
+
+/**
+ * dex_channel_select_new:
+ *
+ * Creates a new #DexChannelSelect with no sources.
+ *
+ * Returns: (transfer full): a new #DexChannelSelect
+ *
+ * Since: 0.8
+ */
+DexChannelSelect *
+dex_channel_select_new (void)
+{
+  return (DexChannelSelect *)dex_object_create_instance (DEX_TYPE_CHANNEL_SELECT);
+}
+
+static DexChannelSelectSource *
+dex_channel_select_add_source (DexChannelSelect *channel_select)
+{
+  DexChannelSelectSource *source;
+
+  source = g_new0 (DexChannelSelectSource, 1);
+  source->node.link.data = &source->node;
+  source->node.channel_select = channel_select;
+  source->node.index = channel_select->sources->len;
+
+  g_ptr_array_add (channel_select->sources, source);
+
+  return source;
+}
+
+/**
+ * dex_channel_select_add_channel:
+ * @channel_select: a #DexChannelSelect
+ * @channel: a #DexChannel
+ *
+ * Adds @channel as a source to receive items from.
+ *
+ * This may not be called while a fiber is waiting in
+ * dex_channel_select_await().
+ *
+ * Returns: the index of the source
+ *
+ * Since: 0.8
+ */
+guint
+dex_channel_select_add_channel (DexChannelSelect *channel_select,
+                                DexChannel       *channel)
+{
+  DexChannelSelectSource *source;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL_SELECT (channel_select), 0);
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), 0);
+  g_return_val_if_fail (channel_select->wakeup == NULL, 0);
+
+  source = dex_channel_select_add_source (channel_select);
+  source->channel = dex_ref (channel);
+
+  return source->node.index;
+}
+
+/**
+ * dex_channel_select_add_future:
+ * @channel_select: a #DexChannelSelect
+ * @future: a #DexFuture
+ *
+ * Adds @future as a source which is ready once it resolves or rejects.
+ *
+ * This may not be called while a fiber is waiting in
+ * dex_channel_select_await().
+ *
+ * Returns: the index of the source
+ *
+ * Since: 0.8
+ */
+guint
+dex_channel_select_add_future (DexChannelSelect *channel_select,
+                               DexFuture        *future)
+{
+  DexChannelSelectSource *source;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL_SELECT (channel_select), 0);
+  g_return_val_if_fail (DEX_IS_FUTURE (future), 0);
+  g_return_val_if_fail (channel_select->wakeup == NULL, 0);
+
+  source = dex_channel_select_add_source (channel_select);
+  source->future = dex_ref (future);
+
+  return source->node.index;
+}
+
+static gboolean
+dex_channel_select_claim (DexChannelSelect *channel_select,
+                          int               winner)
+{
+  for (;;)
+    {
+      if (g_atomic_int_compare_and_exchange (&channel_select->winner, WINNER_NONE, winner))
+        return TRUE;
+
+      /* A channel is in the middle of taking an item for us, which
+       * either commits the select or puts it back to WINNER_NONE.
+       */
+      if (g_atomic_int_get (&channel_select->winner) != WINNER_CLAIMING)
+        return FALSE;
+
+      g_thread_yield ();
+    }
+}
+
+gboolean
+dex_channel_select_begin_claim (DexChannelSelect *channel_select)
+{
+  return dex_channel_select_claim (channel_select, WINNER_CLAIMING);
+}
+
+DexPromise *
+dex_channel_select_finish_claim (DexChannelSelect *channel_select,
+                                 DexChannel       *channel,
+                                 guint             index,
+                                 gpointer          item)
+{
+  g_assert (g_atomic_int_get (&channel_select->winner) == WINNER_CLAIMING);
+  g_assert (channel_select->wakeup != NULL);
+  g_assert (channel_select->item == NULL);
+
+  channel_select->item = item;
+  channel_select->item_channel = channel;
+
+  /* Publishes @item to the waiting fiber */
+  g_atomic_int_set (&channel_select->winner, index);
+
+  return dex_ref (channel_select->wakeup);
+}
+
+void
+dex_channel_select_abort_claim (DexChannelSelect *channel_select)
+{
+  g_assert (g_atomic_int_get (&channel_select->winner) == WINNER_CLAIMING);
+
+  g_atomic_int_set (&channel_select->winner, WINNER_NONE);
+}
+
+static void
+dex_channel_select_weak_ref_free (gpointer data)
+{
+  DexWeakRef *wr = data;
+
+  dex_weak_ref_clear (wr);
+  g_free (wr);
+}
+
+static DexFuture *
+dex_channel_select_source_ready_cb (DexFuture *completed,
+                                    gpointer   user_data)
+{
+  DexChannelSelect *channel_select;
+  DexPromise *wakeup = NULL;
+
+  if (!(channel_select = dex_weak_ref_get (user_data)))
+    return NULL;
+
+  dex_object_lock (channel_select);
+  if (channel_select->wakeup != NULL)
+    wakeup = dex_ref (channel_select->wakeup);
+  dex_object_unlock (channel_select);
+
+  /* A round which is not waiting finds the future ready on its own */
+  if (wakeup != NULL)
+    {
+      dex_promise_resolve_boolean (wakeup, TRUE);
+      dex_unref (wakeup);
+    }
+
+  dex_unref (channel_select);
+
+  return NULL;
+}
+
+static void
+dex_channel_select_watch_source (DexChannelSelect       *channel_select,
+                                 DexChannelSelectSource *source)
+{
+  DexWeakRef *wr;
+
+  g_assert (source->future != NULL);
+  g_assert (source->ready == NULL);
+
+  wr = g_new0 (DexWeakRef, 1);
+  dex_weak_ref_init (wr, channel_select);
+
+  /* Rather than awaiting @future each round with dex_future_first(),
+   * which would discard it whenever another source wins, watch it once
+   * and let it resolve whichever wakeup is current.
+   */
+  source->ready = dex_future_finally (dex_ref (source->future),
+                                      dex_channel_select_source_ready_cb,
+                                      wr,
+                                      dex_channel_select_weak_ref_free);
+}
+
+static guint
+dex_channel_select_wait (DexChannelSelect *channel_select)
+{
+  GPtrArray *sources = channel_select->sources;
+  DexPromise *wakeup = dex_promise_new ();
+  gboolean future_ready = FALSE;
+
+  g_atomic_int_set (&channel_select->winner, WINNER_NONE);
+
+  dex_object_lock (channel_select);
+  channel_select->wakeup = wakeup;
+  dex_object_unlock (channel_select);
+
+  /* Channels may commit the select as soon as the node is queued */
+  for (guint i = 0; i < sources->len; i++)
+    {
+      DexChannelSelectSource *source = g_ptr_array_index (sources, i);
+
+      if (g_atomic_int_get (&channel_select->winner) >= 0)
+        break;
+
+      if (source->channel != NULL)
+        {
+          dex_channel_add_select_node (source->channel, &source->node);
+        }
+      else if (source->ready == NULL)
+        {
+          dex_channel_select_watch_source (channel_select, source);
+        }
+      else if (!dex_future_is_pending (source->future))
+        {
+          /* Completed while no wakeup was set */
+          future_ready = TRUE;
+          break;
+        }
+    }
+
+  /* Futures report their own errors through the source */
+  if (!future_ready && g_atomic_int_get (&channel_select->winner) < 0)
+    dex_await (dex_ref (wakeup), NULL);
+
+  /* Unless a channel committed first, a future is ready */
+  if (g_atomic_int_get (&channel_select->winner) < 0)
+    {
+      for (guint i = 0; i < sources->len; i++)
+        {
+          DexChannelSelectSource *source = g_ptr_array_index (sources, i);
+
+          if (source->future != NULL &&
+              !dex_future_is_pending (source->future) &&
+              dex_channel_select_claim (channel_select, i))
+            break;
+        }
+    }
+
+  for (guint i = 0; i < sources->len; i++)
+    {
+      DexChannelSelectSource *source = g_ptr_array_index (sources, i);
+
+      if (source->channel != NULL)
+        dex_channel_remove_select_node (source->channel, &source->node);
+    }
+
+  dex_object_lock (channel_select);
+  channel_select->wakeup = NULL;
+  dex_object_unlock (channel_select);
+
+  dex_unref (wakeup);
+
+  g_assert (g_atomic_int_get (&channel_select->winner) >= 0);
+
+  return g_atomic_int_get (&channel_select->winner);
+}
+
+/**
+ * dex_channel_select_await:
+ * @channel_select: a #DexChannelSelect
+ *
+ * Waits until one of the sources is ready and commits to it.
+ *
+ * For channels, the received item is taken from the channel and may be
+ * retrieved with dex_channel_select_steal_item(). If the channel is
+ * closed there is no item. For futures, the source itself is ready and
+ * may be inspected by the caller.
+ *
+ * Sources are polled starting after the previous winner so that a busy
+ * source cannot starve the others.
+ *
+ * This may only be called from a fiber. Any item not stolen from the
+ * previous round is released.
+ *
+ * Returns: the index of the source which is ready
+ *
+ * Since: 0.8
+ */
+guint
+dex_channel_select_await (DexChannelSelect *channel_select)
+{
+  GPtrArray *sources;
+  guint n_sources;
+  guint winner;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL_SELECT (channel_select), 0);
+  g_return_val_if_fail (channel_select->sources->len > 0, 0);
+  g_return_val_if_fail (channel_select->wakeup == NULL, 0);
+
+  dex_channel_select_clear_item (channel_select);
+
+  sources = channel_select->sources;
+  n_sources = sources->len;
+
+  for (guint i = 0; i < n_sources; i++)
+    {
+      guint index = (channel_select->next + i) % n_sources;
+      DexChannelSelectSource *source = g_ptr_array_index (sources, index);
+
+      if (source->future != NULL)
+        {
+          if (!dex_future_is_pending (source->future))
+            {
+              winner = index;
+              goto complete;
+            }
+        }
+      else if (dex_channel_poll (source->channel, &channel_select->item) != DEX_CHANNEL_POLL_EMPTY)
+        {
+          channel_select->item_channel = source->channel;
+          winner = index;
+          goto complete;
+        }
+    }
+
+  winner = dex_channel_select_wait (channel_select);
+
+complete:
+  channel_select->next = winner + 1;
+
+  return winner;
+}
+
+/**
+ * dex_channel_select_steal_item:
+ * @channel_select: a #DexChannelSelect
+ *
+ * Steals the item received by the last call to dex_channel_select_await().
+ *
+ * For channels created with dex_channel_new_for_values() this is the
+ * value that was sent, otherwise it is a #DexFuture.
+ *
+ * Returns: (transfer full) (nullable): the received item or %NULL
+ *
+ * Since: 0.8
+ */
+gpointer
+dex_channel_select_steal_item (DexChannelSelect *channel_select)
+{
+  g_return_val_if_fail (DEX_IS_CHANNEL_SELECT (channel_select), NULL);
+
+  channel_select->item_channel = NULL;
+
+  return g_steal_pointer (&channel_select->item);
+}
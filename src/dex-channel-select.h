@@ -0,0 +1,53 @@
+/*
+ * dex-channel-select.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-channel.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_CHANNEL_SELECT    (dex_channel_select_get_type())
+#define DEX_CHANNEL_SELECT(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_CHANNEL_SELECT, DexChannelSelect))
+#define DEX_IS_CHANNEL_SELECT(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_CHANNEL_SELECT))
+
+typedef struct _DexChannelSelect DexChannelSelect;
+
+DEX_AVAILABLE_IN_ALL
+GType             dex_channel_select_get_type    (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexChannelSelect *dex_channel_select_new         (void)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+guint             dex_channel_select_add_channel (DexChannelSelect *channel_select,
+                                                  DexChannel       *channel);
+DEX_AVAILABLE_IN_ALL
+guint             dex_channel_select_add_future  (DexChannelSelect *channel_select,
+                                                  DexFuture        *future);
+DEX_AVAILABLE_IN_ALL
+guint             dex_channel_select_await       (DexChannelSelect *channel_select);
+DEX_AVAILABLE_IN_ALL
+gpointer          dex_channel_select_steal_item  (DexChannelSelect *channel_select)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexChannelSelect, dex_unref)
+
+G_END_DECLS
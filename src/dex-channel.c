@@ -21,13 +21,18 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gio/gio.h>
 
 #include "dex-error.h"
-#include "dex-channel.h"
+#include "dex-channel-private.h"
 #include "dex-future-private.h"
 #include "dex-object-private.h"
+#include "dex-profiler.h"
 #include "dex-promise.h"
+#include "dex-ring-buffer-private.h"
+#include "dex-stats-private.h"
 
 static GError channel_closed_error;
 static GValue success_value;
@@ -42,6 +47,14 @@ typedef struct _DexChannelReceiver
 {
   DexFuture parent_instance;
   GList link;
+
+  /* Item taken from the ring for this receiver, which is delivered
+   * once the channel lock has been released.
+   */
+  gpointer item;
+
+  /* When the receiver started waiting, if collecting statistics */
+  gint64 queued_at;
 } DexChannelReceiver;
 
 typedef struct _DexChannelReceiverClass
@@ -94,12 +107,25 @@ dex_channel_receiver_complete (DexChannelReceiver *channel_receiver,
                        success ? NULL : g_error_copy (&channel_closed_error));
 }
 
+static inline void
+dex_channel_receiver_complete_value (DexChannelReceiver *channel_receiver,
+                                     gpointer            data)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_POINTER);
+  g_value_set_pointer (&value, data);
+  dex_future_complete ((DexFuture *)channel_receiver, &value, NULL);
+}
+
 static inline DexChannelReceiver *
 dex_channel_receiver_new (void)
 {
   return (DexChannelReceiver *)dex_object_create_instance (dex_channel_receiver_type);
 }
 
+typedef struct _DexChannelCounters DexChannelCounters;
+
 struct _DexChannel
 {
   DexObject parent_instance;
@@ -114,6 +140,11 @@ struct _DexChannel
    */
   GQueue recvq;
 
+  /* Queue of DexChannelSelectNode from a #DexChannelSelect waiting for
+   * an item. These are served after @recvq.
+   */
+  GQueue selectq;
+
   /* The actual queue of items in the channel that have been sent and
    * not yet picked up by a receiver.
    */
@@ -124,8 +155,30 @@ struct _DexChannel
    */
   guint capacity;
 
-  /* Flags indicating what sides of the channel are open/closed */
-  DexChannelStateFlags flags : 2;
+  /* Flags indicating what sides of the channel are open/closed. This
+   * is only modified with the lock held but may be read atomically
+   * from the ring fast paths.
+   */
+  guint flags;
+
+  /* When created with %DEX_CHANNEL_FLAGS_RING, items are stored here
+   * instead of @queue. Senders and receivers only take the lock when
+   * the ring is full or empty (or someone is parked because it was)
+   * so @n_parked_send and @n_parked_recv mirror the lengths of @sendq
+   * and @recvq (plus @selectq) for the lock-free paths to check.
+   */
+  DexRingBuffer *ring;
+  int n_parked_send;
+  int n_parked_recv;
+
+  /* Value channels store plain pointers in @ring rather than futures,
+   * releasing any which are never received with @value_free.
+   */
+  GDestroyNotify value_free;
+  guint values : 1;
+
+  /* Only allocated with %DEX_CHANNEL_FLAGS_STATS */
+  DexChannelCounters *counters;
 };
 
 typedef struct _DexChannelClass
@@ -133,6 +186,26 @@ typedef struct _DexChannelClass
   DexObjectClass parent_class;
 } DexChannelClass;
 
+/* Counters are updated atomically as the ring paths do not hold the
+ * channel lock. They are 64-bit, like the scheduler statistics, so that
+ * long running channels do not wrap on 32-bit systems.
+ */
+struct _DexChannelCounters
+{
+  gint64          reset_time;
+  DexStatsCounter n_sent;
+  DexStatsCounter n_received;
+  DexStatsCounter n_send_rejected;
+  DexStatsCounter n_receive_rejected;
+  int             peak_depth;
+  DexStatsCounter send_wait[DEX_CHANNEL_STATS_N_BUCKETS];
+  DexStatsCounter receive_wait[DEX_CHANNEL_STATS_N_BUCKETS];
+
+  /* Sysprof counter ids, or 0 if not profiling */
+  guint           depth_counter;
+  guint           received_counter;
+};
+
 typedef struct _DexChannelItem
 {
   /* Used to insert the item into queues */
@@ -143,6 +216,12 @@ typedef struct _DexChannelItem
 
   /* The future which was sent with dex_channel_send(). */
   DexFuture *future;
+
+  /* The value which was sent with dex_channel_send_value(). */
+  gpointer value;
+
+  /* When the sender started waiting, if collecting statistics */
+  gint64 queued_at;
 } DexChannelItem;
 
 DEX_DEFINE_FINAL_TYPE (DexChannel, dex_channel, DEX_TYPE_OBJECT)
@@ -178,11 +257,154 @@ dex_channel_item_free (DexChannelItem *item)
   g_assert (item->link.prev == NULL);
   g_assert (item->link.next == NULL);
 
+  g_assert (item->value == NULL);
+
   dex_clear (&item->future);
   dex_clear (&item->send);
   g_free (item);
 }
 
+/* Creates an item for a parked sender of a ring channel, where @data is
+ * either a future or a value depending on the kind of channel.
+ */
+static DexChannelItem *
+dex_channel_ring_item_new (DexChannel *channel,
+                           gpointer    data)
+{
+  DexChannelItem *item;
+
+  if (!channel->values)
+    return dex_channel_item_new (data);
+
+  item = g_new0 (DexChannelItem, 1);
+  item->link.data = item;
+  item->value = data;
+  item->send = dex_promise_new ();
+
+  return item;
+}
+
+/* Releases @data which was sent but will never be received */
+static void
+dex_channel_free_data (DexChannel *channel,
+                       gpointer    data)
+{
+  if (data == NULL)
+    return;
+
+  if (!channel->values)
+    dex_unref (data);
+  else if (channel->value_free != NULL)
+    channel->value_free (data);
+}
+
+static inline gint64
+dex_channel_now (DexChannel *channel)
+{
+  return channel->counters != NULL ? g_get_monotonic_time () : 0;
+}
+
+/* Ring channels may be read without the lock, otherwise it must be held */
+static inline guint
+dex_channel_depth (DexChannel *channel)
+{
+  if (channel->ring != NULL)
+    return dex_ring_buffer_length (channel->ring);
+
+  return channel->queue.length;
+}
+
+static inline guint
+dex_channel_wait_bucket (gint64 queued_at)
+{
+  gint64 waited;
+
+  if (queued_at == 0)
+    return 0;
+
+  if ((waited = g_get_monotonic_time () - queued_at) < 1)
+    return 0;
+
+  return MIN (g_bit_storage ((gsize)waited), DEX_CHANNEL_STATS_N_BUCKETS - 1);
+}
+
+static void
+dex_channel_update_depth (DexChannel *channel)
+{
+  DexChannelCounters *counters = channel->counters;
+  int depth = MIN (dex_channel_depth (channel), (guint)G_MAXINT);
+  int peak;
+
+  do
+    peak = g_atomic_int_get (&counters->peak_depth);
+  while (depth > peak &&
+         !g_atomic_int_compare_and_exchange (&counters->peak_depth, peak, depth));
+
+  if (counters->depth_counter != 0 && DEX_PROFILER_ACTIVE)
+    DEX_PROFILER_SET_COUNTER (counters->depth_counter, depth);
+}
+
+/* Records @n_items entering the channel. @queued_at is when the sender
+ * started waiting, or 0 if it did not have to.
+ */
+static inline void
+dex_channel_record_send (DexChannel *channel,
+                         gint64      queued_at,
+                         guint       n_items)
+{
+  DexChannelCounters *counters = channel->counters;
+
+  if G_LIKELY (counters == NULL)
+    return;
+
+  dex_stats_counter_add (&counters->n_sent, n_items);
+  dex_stats_counter_add (&counters->send_wait[dex_channel_wait_bucket (queued_at)], n_items);
+  dex_channel_update_depth (channel);
+}
+
+/* Records @n_items delivered to receivers. @queued_at is when the
+ * receiver started waiting, 0 if it did not have to, or -1 if unknown
+ * as is the case for a #DexChannelSelect.
+ */
+static inline void
+dex_channel_record_receive (DexChannel *channel,
+                            gint64      queued_at,
+                            guint       n_items)
+{
+  DexChannelCounters *counters = channel->counters;
+
+  if G_LIKELY (counters == NULL)
+    return;
+
+  dex_stats_counter_add (&counters->n_received, n_items);
+
+  if (queued_at >= 0)
+    dex_stats_counter_add (&counters->receive_wait[dex_channel_wait_bucket (queued_at)], n_items);
+
+  if (counters->received_counter != 0 && DEX_PROFILER_ACTIVE)
+    {
+      DEX_PROFILER_SET_COUNTER (counters->received_counter,
+                                dex_stats_counter_get (&counters->n_received));
+      DEX_PROFILER_SET_COUNTER (counters->depth_counter, dex_channel_depth (channel));
+    }
+}
+
+static inline void
+dex_channel_record_rejected (DexChannel *channel,
+                             gboolean    send,
+                             guint       n_items)
+{
+  DexChannelCounters *counters = channel->counters;
+
+  if G_LIKELY (counters == NULL || n_items == 0)
+    return;
+
+  if (send)
+    dex_stats_counter_add (&counters->n_send_rejected, n_items);
+  else
+    dex_stats_counter_add (&counters->n_receive_rejected, n_items);
+}
+
 static void
 dex_channel_finalize (DexObject *object)
 {
@@ -195,8 +417,18 @@ dex_channel_finalize (DexObject *object)
   g_assert (channel->queue.length == 0);
   g_assert (channel->sendq.length == 0);
   g_assert (channel->recvq.length == 0);
+  g_assert (channel->selectq.length == 0);
   g_assert (channel->flags == 0);
 
+  if (channel->ring != NULL)
+    {
+      dex_ring_buffer_clear (channel->ring,
+                             channel->values ? channel->value_free : dex_unref);
+      g_clear_pointer (&channel->ring, g_free);
+    }
+
+  g_clear_pointer (&channel->counters, g_free);
+
   DEX_OBJECT_CLASS (dex_channel_parent_class)->finalize (object);
 }
 
@@ -233,23 +465,202 @@ dex_channel_init (DexChannel *channel)
  * from the channel. This is useful in buffering situations so that the
  * producer does not outpace the consumer.
  *
+ * This is equivalent to calling dex_channel_new_full() with
+ * %DEX_CHANNEL_FLAGS_NONE.
+ *
  * Returns: a new #DexChannel
  */
 DexChannel *
 dex_channel_new (guint capacity)
+{
+  return dex_channel_new_full (capacity, DEX_CHANNEL_FLAGS_NONE);
+}
+
+/**
+ * dex_channel_new_full:
+ * @capacity: the channel queue depth or 0 for unlimited
+ * @flags: #DexChannelFlags for the channel
+ *
+ * Creates a new #DexChannel.
+ *
+ * If @flags contains %DEX_CHANNEL_FLAGS_RING then the channel is backed
+ * by a lock-free ring buffer. Sending to a ring channel that is not full,
+ * or receiving from one that is not empty, does not allocate or take the
+ * channel lock. Waiting senders and receivers are only woken when the
+ * ring transitions from full or empty. @capacity must be non-zero and is
+ * rounded up to the next power of two.
+ *
+ * Futures returned from dex_channel_send() on a ring channel resolve to
+ * %TRUE rather than the queue depth.
+ *
+ * If @flags contains %DEX_CHANNEL_FLAGS_STATS then the channel keeps
+ * counters and wait-time histograms which can be read with
+ * dex_channel_get_stats(). When sysprof is recording, the queue depth
+ * and number of items received are also emitted as counters.
+ *
+ * Returns: a new #DexChannel
+ *
+ * Since: 0.8
+ */
+DexChannel *
+dex_channel_new_full (guint           capacity,
+                      DexChannelFlags flags)
 {
   DexChannel *channel;
 
+  g_return_val_if_fail (capacity > 0 || !(flags & DEX_CHANNEL_FLAGS_RING), NULL);
+
+  channel = (DexChannel *)dex_object_create_instance (DEX_TYPE_CHANNEL);
+
+  if (flags & DEX_CHANNEL_FLAGS_RING)
+    {
+      channel->ring = g_new0 (DexRingBuffer, 1);
+      dex_ring_buffer_init (channel->ring, capacity);
+      capacity = dex_ring_buffer_capacity (channel->ring);
+    }
+
   if (capacity == 0)
     capacity = G_MAXUINT;
 
-  channel = (DexChannel *)dex_object_create_instance (DEX_TYPE_CHANNEL);
+  if (flags & DEX_CHANNEL_FLAGS_STATS)
+    {
+      channel->counters = g_new0 (DexChannelCounters, 1);
+      channel->counters->reset_time = g_get_monotonic_time ();
+
+      if (DEX_PROFILER_ACTIVE)
+        {
+          DEX_PROFILER_DEFINE_COUNTER (channel->counters->depth_counter,
+                                       "Channel depth",
+                                       "Items queued in a DexChannel");
+          DEX_PROFILER_DEFINE_COUNTER (channel->counters->received_counter,
+                                       "Channel received",
+                                       "Items received from a DexChannel");
+        }
+    }
+
   channel->capacity = capacity;
   channel->flags = DEX_CHANNEL_STATE_CAN_SEND | DEX_CHANNEL_STATE_CAN_RECEIVE;
 
   return channel;
 }
 
+/**
+ * dex_channel_new_for_values:
+ * @capacity: the channel queue depth, which must be non-zero
+ * @value_free: (nullable): a #GDestroyNotify for values never received
+ *
+ * Creates a new #DexChannel which carries plain pointers instead of
+ * #DexFuture.
+ *
+ * Use dex_channel_send_value() and dex_channel_receive_value() from a
+ * fiber to move values through the channel, or the non-blocking
+ * dex_channel_try_send_value() and dex_channel_try_receive_value().
+ * Passing a value through the channel does not allocate unless the
+ * caller has to wait because the channel is full or empty.
+ *
+ * The channel is always backed by a ring buffer as if created with
+ * %DEX_CHANNEL_FLAGS_RING. dex_channel_receive() may still be used and
+ * resolves to the value as a %G_TYPE_POINTER, but dex_channel_send()
+ * and the other future based functions may not.
+ *
+ * Values which are still queued when the receive side is closed or the
+ * channel is finalized are released with @value_free. For example,
+ * pass g_bytes_unref() to send #GBytes.
+ *
+ * Returns: a new #DexChannel
+ *
+ * Since: 0.8
+ */
+DexChannel *
+dex_channel_new_for_values (guint          capacity,
+                            GDestroyNotify value_free)
+{
+  DexChannel *channel;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+
+  channel = dex_channel_new_full (capacity, DEX_CHANNEL_FLAGS_RING);
+  channel->value_free = value_free;
+  channel->values = TRUE;
+
+  return channel;
+}
+
+static void
+dex_channel_unlink_select_node_locked (DexChannel           *channel,
+                                       DexChannelSelectNode *node)
+{
+  g_assert (node->queued);
+
+  g_queue_unlink (&channel->selectq, &node->link);
+  node->queued = FALSE;
+
+  if (channel->ring != NULL)
+    g_atomic_int_add (&channel->n_parked_recv, -1);
+}
+
+/* Commits the select waiting on @node to this channel. The select must
+ * have been claimed with dex_channel_select_begin_claim().
+ */
+static void
+dex_channel_commit_select_locked (DexChannel            *channel,
+                                  DexChannelSelectNode  *node,
+                                  gpointer               item,
+                                  GPtrArray            **woken)
+{
+  DexChannelSelect *channel_select = node->channel_select;
+
+  dex_channel_unlink_select_node_locked (channel, node);
+
+  if (*woken == NULL)
+    *woken = g_ptr_array_new_with_free_func (dex_unref);
+
+  g_ptr_array_add (*woken,
+                   dex_channel_select_finish_claim (channel_select, channel, node->index, item));
+}
+
+/* Takes the first waiting select which has not already been committed
+ * to another source, dropping any which have.
+ */
+static DexChannelSelectNode *
+dex_channel_claim_select_locked (DexChannel *channel)
+{
+  while (channel->selectq.length > 0)
+    {
+      DexChannelSelectNode *node = g_queue_peek_head (&channel->selectq);
+
+      if (dex_channel_select_begin_claim (node->channel_select))
+        return node;
+
+      dex_channel_unlink_select_node_locked (channel, node);
+    }
+
+  return NULL;
+}
+
+/* Wakes every waiting select with no item so they notice the close */
+static void
+dex_channel_close_selects_locked (DexChannel  *channel,
+                                  GPtrArray  **woken)
+{
+  DexChannelSelectNode *node;
+
+  while ((node = dex_channel_claim_select_locked (channel)))
+    dex_channel_commit_select_locked (channel, node, NULL, woken);
+}
+
+static void
+dex_channel_wake_selects (GPtrArray *woken)
+{
+  if (woken == NULL)
+    return;
+
+  for (guint i = 0; i < woken->len; i++)
+    dex_promise_resolve_boolean (g_ptr_array_index (woken, i), TRUE);
+
+  g_ptr_array_unref (woken);
+}
+
 static inline gboolean
 has_capacity_locked (DexChannel *channel)
 {
@@ -261,7 +672,9 @@ dex_channel_one_receive_and_unlock (DexChannel *channel)
 {
   DexChannelItem *item = NULL;
   DexChannelReceiver *recv = NULL;
+  DexChannelSelectNode *node = NULL;
   DexPromise *to_resolve = NULL;
+  GPtrArray *woken = NULL;
   guint qlen = 0;
 
   g_assert (DEX_IS_CHANNEL (channel));
@@ -273,12 +686,29 @@ dex_channel_one_receive_and_unlock (DexChannel *channel)
    * (which itself still may not be ready, but we must preserve ordering).
    */
 
-  if (channel->queue.length > 0 && channel->recvq.length > 0)
+  if (channel->queue.length > 0 &&
+      (channel->recvq.length > 0 ||
+       (node = dex_channel_claim_select_locked (channel))))
     {
-      recv = g_queue_pop_head_link (&channel->recvq)->data;
-      item = g_queue_pop_head_link (&channel->queue)->data;
+      if (node != NULL)
+        {
+          /* The select gets the sent future, the item itself is freed */
+          item = g_queue_pop_head_link (&channel->queue)->data;
+          dex_channel_commit_select_locked (channel, node,
+                                            g_steal_pointer (&item->future),
+                                            &woken);
+          dex_channel_record_receive (channel, -1, 1);
+        }
+      else
+        {
+          recv = g_queue_pop_head_link (&channel->recvq)->data;
+          item = g_queue_pop_head_link (&channel->queue)->data;
+
+          g_assert (DEX_IS_CHANNEL_RECEIVER (recv));
+
+          dex_channel_record_receive (channel, recv->queued_at, 1);
+        }
 
-      g_assert (DEX_IS_CHANNEL_RECEIVER (recv));
       g_assert (item != NULL);
 
       /* Try to advance a @sendq item into @queue */
@@ -289,20 +719,30 @@ dex_channel_one_receive_and_unlock (DexChannel *channel)
           g_queue_push_tail_link (&channel->queue, &sendq_item->link);
           qlen = channel->queue.length;
           to_resolve = dex_ref (sendq_item->send);
+          dex_channel_record_send (channel, sendq_item->queued_at, 1);
         }
     }
 
-  dex_object_unlock (channel);
+  /* Selects still waiting will never get an item once the send side
+   * has closed and the remaining items belong to receivers.
+   */
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_SEND) == 0 &&
+      channel->queue.length + channel->sendq.length <= channel->recvq.length)
+    dex_channel_close_selects_locked (channel, &woken);
 
-  g_assert (item == NULL || recv != NULL);
+  dex_object_unlock (channel);
 
-  if (item != NULL)
+  if (recv != NULL)
     {
       dex_future_chain (item->future, DEX_FUTURE (recv));
-      dex_channel_item_free (item);
       dex_unref (recv);
     }
 
+  if (item != NULL)
+    dex_channel_item_free (item);
+
+  dex_channel_wake_selects (woken);
+
   if (to_resolve != NULL)
     {
       dex_promise_resolve_uint (to_resolve, qlen);
@@ -310,63 +750,328 @@ dex_channel_one_receive_and_unlock (DexChannel *channel)
     }
 }
 
-/**
- * dex_channel_send:
- * @channel: a #DexChannel
- * @future: (transfer full): a #DexFuture
- *
- * Queues @future into the channel.
- *
- * The other end of the channel can receive the future (or a future that will
- * eventually resolve to @future) using dex_channel_receive().
- *
- * This function returns a #DexFuture that will resolve when the channels
- * capacity is low enough to queue more items.
- *
- * If the send side of the channel is closed, the returned #DexFuture will be
- * rejected with %DEX_ERROR_CHANNEL_CLOSED.
- *
- * Returns: (transfer full): a #DexFuture
- */
-DexFuture *
-dex_channel_send (DexChannel *channel,
-                  DexFuture  *future)
+static void
+dex_channel_ring_flush_and_unlock (DexChannel *channel)
 {
-  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
-  DexChannelItem *item;
-  DexFuture *ret;
+  GQueue ready = G_QUEUE_INIT;
+  GQueue sent = G_QUEUE_INIT;
+  GQueue closed = G_QUEUE_INIT;
+  GPtrArray *woken = NULL;
+  gboolean progress;
 
-  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
-  g_return_val_if_fail (DEX_IS_FUTURE (future), NULL);
+  g_assert (DEX_IS_CHANNEL (channel));
+  g_assert (channel->ring != NULL);
 
-  item = dex_channel_item_new (g_steal_pointer (&future));
+  /* Pair parked receivers with items in the ring and move parked
+   * senders into the ring until neither can make progress. Completing
+   * the futures is deferred until the lock has been released.
+   */
+  do
+    {
+      progress = FALSE;
 
-  dex_object_lock (channel);
+      while (channel->recvq.length > 0)
+        {
+          DexChannelReceiver *recv;
+          gpointer data;
+
+          if (!(data = dex_ring_buffer_pop (channel->ring)))
+            break;
+
+          recv = g_queue_pop_head_link (&channel->recvq)->data;
+          g_atomic_int_add (&channel->n_parked_recv, -1);
+          recv->item = data;
+          g_queue_push_tail_link (&ready, &recv->link);
+          dex_channel_record_receive (channel, recv->queued_at, 1);
+          progress = TRUE;
+        }
 
-  if ((channel->flags & required) != required)
+      if (channel->recvq.length == 0)
+        {
+          DexChannelSelectNode *node;
+
+          while ((node = dex_channel_claim_select_locked (channel)))
+            {
+              gpointer data;
+
+              if (!(data = dex_ring_buffer_pop (channel->ring)))
+                {
+                  dex_channel_select_abort_claim (node->channel_select);
+                  break;
+                }
+
+              dex_channel_commit_select_locked (channel, node, data, &woken);
+              dex_channel_record_receive (channel, -1, 1);
+              progress = TRUE;
+            }
+        }
+
+      while (channel->sendq.length > 0)
+        {
+          DexChannelItem *item = g_queue_peek_head (&channel->sendq);
+          gpointer data = channel->values ? item->value : (gpointer)item->future;
+
+          if (!dex_ring_buffer_push (channel->ring, data))
+            break;
+
+          item->future = NULL;
+          item->value = NULL;
+          g_queue_unlink (&channel->sendq, &item->link);
+          g_atomic_int_add (&channel->n_parked_send, -1);
+          g_queue_push_tail_link (&sent, &item->link);
+          dex_channel_record_send (channel, item->queued_at, 1);
+          progress = TRUE;
+        }
+    }
+  while (progress);
+
+  /* Nothing left to give receivers which are still waiting */
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_SEND) == 0 &&
+      channel->sendq.length == 0)
     {
-      dex_object_unlock (channel);
-      dex_channel_item_free (item);
-      return DEX_FUTURE (dex_future_new_reject (DEX_ERROR,
-                                                DEX_ERROR_CHANNEL_CLOSED,
-                                                "Channel is closed"));
+      g_atomic_int_add (&channel->n_parked_recv, -(int)channel->recvq.length);
+      dex_channel_record_rejected (channel, FALSE, channel->recvq.length);
+      closed = steal_queue (&channel->recvq);
+      dex_channel_close_selects_locked (channel, &woken);
     }
 
-  ret = dex_ref (item->send);
+  dex_object_unlock (channel);
 
-  /* Try to place future directly into @queue. Otherwise, place it in @sendq
-   * and we'll process it when more items have been received.
-   */
-  if (!has_capacity_locked (channel))
+  dex_channel_wake_selects (woken);
+
+  while (ready.length > 0)
     {
-      g_queue_push_tail_link (&channel->sendq, &item->link);
-      dex_object_unlock (channel);
+      DexChannelReceiver *recv = g_queue_pop_head_link (&ready)->data;
+      gpointer data = g_steal_pointer (&recv->item);
+
+      if (channel->values)
+        {
+          dex_channel_receiver_complete_value (recv, data);
+        }
+      else
+        {
+          dex_future_chain (data, DEX_FUTURE (recv));
+          dex_unref (data);
+        }
+
+      dex_unref (recv);
     }
-  else
+
+  while (sent.length > 0)
     {
-      g_queue_push_tail_link (&channel->queue, &item->link);
-      dex_promise_resolve_uint (item->send, channel->queue.length);
-      dex_channel_one_receive_and_unlock (channel);
+      DexChannelItem *item = g_queue_pop_head_link (&sent)->data;
+
+      dex_promise_resolve_boolean (item->send, TRUE);
+      dex_channel_item_free (item);
+    }
+
+  while (closed.length > 0)
+    {
+      DexChannelReceiver *recv = g_queue_pop_head_link (&closed)->data;
+
+      dex_channel_receiver_complete (recv, FALSE);
+      dex_unref (recv);
+    }
+}
+
+/* Wakes parked senders after items were taken from the ring without
+ * the lock held, or parked receivers after items were added to it.
+ */
+static inline void
+dex_channel_ring_wake (DexChannel *channel,
+                       int        *n_parked)
+{
+  if (g_atomic_int_get (n_parked) > 0)
+    {
+      dex_object_lock (channel);
+      dex_channel_ring_flush_and_unlock (channel);
+    }
+}
+
+static DexFuture *
+dex_channel_ring_park_and_unlock (DexChannel *channel,
+                                  gpointer   *data,
+                                  guint       n_data)
+{
+  DexFuture *ret = NULL;
+  gint64 queued_at;
+
+  g_assert (DEX_IS_CHANNEL (channel));
+  g_assert (channel->ring != NULL);
+  g_assert (n_data > 0);
+
+  g_atomic_int_add (&channel->n_parked_send, n_data);
+  queued_at = dex_channel_now (channel);
+
+  for (guint i = 0; i < n_data; i++)
+    {
+      DexChannelItem *item = dex_channel_ring_item_new (channel, data[i]);
+
+      item->queued_at = queued_at;
+
+      if (i + 1 == n_data)
+        ret = dex_ref (item->send);
+
+      g_queue_push_tail_link (&channel->sendq, &item->link);
+    }
+
+  dex_channel_ring_flush_and_unlock (channel);
+
+  return ret;
+}
+
+static DexFuture *
+dex_channel_ring_send (DexChannel *channel,
+                       gpointer    data)
+{
+  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
+
+  g_assert (DEX_IS_CHANNEL (channel));
+  g_assert (data != NULL);
+
+  /* Parked senders get to go first so that ordering is preserved */
+  if (g_atomic_int_get (&channel->n_parked_send) == 0 &&
+      dex_ring_buffer_push (channel->ring, data))
+    {
+      dex_channel_record_send (channel, 0, 1);
+      dex_channel_ring_wake (channel, &channel->n_parked_recv);
+      return dex_future_new_for_boolean (TRUE);
+    }
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & required) != required)
+    {
+      dex_object_unlock (channel);
+      dex_channel_record_rejected (channel, TRUE, 1);
+      dex_channel_free_data (channel, data);
+      return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+    }
+
+  return dex_channel_ring_park_and_unlock (channel, &data, 1);
+}
+
+static DexFuture *
+dex_channel_ring_receive (DexChannel *channel)
+{
+  DexChannelReceiver *recv;
+  gpointer data;
+
+  g_assert (DEX_IS_CHANNEL (channel));
+
+  /* The sent future is handed out directly rather than chained to a
+   * new receiver since it will resolve or reject the same way. Items
+   * left after the receive side is closed belong to the flush, so the
+   * fast path must not pop them.
+   */
+  if ((g_atomic_int_get (&channel->flags) & DEX_CHANNEL_STATE_CAN_RECEIVE) != 0 &&
+      g_atomic_int_get (&channel->n_parked_recv) == 0 &&
+      (data = dex_ring_buffer_pop (channel->ring)))
+    {
+      dex_channel_record_receive (channel, 0, 1);
+      dex_channel_ring_wake (channel, &channel->n_parked_send);
+
+      if (channel->values)
+        return dex_future_new_for_pointer (data);
+
+      return data;
+    }
+
+  recv = dex_channel_receiver_new ();
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+    {
+      dex_object_unlock (channel);
+      dex_channel_record_rejected (channel, FALSE, 1);
+      dex_channel_receiver_complete (recv, FALSE);
+      return DEX_FUTURE (recv);
+    }
+
+  /* Rejection when the send side is closed is handled by the flush */
+  recv->queued_at = dex_channel_now (channel);
+  dex_ref (recv);
+  g_atomic_int_inc (&channel->n_parked_recv);
+  g_queue_push_tail_link (&channel->recvq, &recv->link);
+  dex_channel_ring_flush_and_unlock (channel);
+
+  return DEX_FUTURE (recv);
+}
+
+/**
+ * dex_channel_send:
+ * @channel: a #DexChannel
+ * @future: (transfer full): a #DexFuture
+ *
+ * Queues @future into the channel.
+ *
+ * The other end of the channel can receive the future (or a future that will
+ * eventually resolve to @future) using dex_channel_receive().
+ *
+ * This function returns a #DexFuture that will resolve when the channels
+ * capacity is low enough to queue more items.
+ *
+ * If the send side of the channel is closed, the returned #DexFuture will be
+ * rejected with %DEX_ERROR_CHANNEL_CLOSED.
+ *
+ * Returns: (transfer full): a #DexFuture
+ */
+DexFuture *
+dex_channel_send (DexChannel *channel,
+                  DexFuture  *future)
+{
+  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
+  DexChannelItem *item;
+  DexFuture *ret;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (!channel->values, NULL);
+  g_return_val_if_fail (DEX_IS_FUTURE (future), NULL);
+
+  if (channel->ring != NULL)
+    {
+      if ((g_atomic_int_get (&channel->flags) & required) != required)
+        {
+          dex_channel_record_rejected (channel, TRUE, 1);
+          dex_unref (future);
+          return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+        }
+
+      return dex_channel_ring_send (channel, future);
+    }
+
+  item = dex_channel_item_new (g_steal_pointer (&future));
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & required) != required)
+    {
+      dex_object_unlock (channel);
+      dex_channel_record_rejected (channel, TRUE, 1);
+      dex_channel_item_free (item);
+      return DEX_FUTURE (dex_future_new_reject (DEX_ERROR,
+                                                DEX_ERROR_CHANNEL_CLOSED,
+                                                "Channel is closed"));
+    }
+
+  ret = dex_ref (item->send);
+
+  /* Try to place future directly into @queue. Otherwise, place it in @sendq
+   * and we'll process it when more items have been received.
+   */
+  if (!has_capacity_locked (channel))
+    {
+      item->queued_at = dex_channel_now (channel);
+      g_queue_push_tail_link (&channel->sendq, &item->link);
+      dex_object_unlock (channel);
+    }
+  else
+    {
+      g_queue_push_tail_link (&channel->queue, &item->link);
+      dex_channel_record_send (channel, 0, 1);
+      dex_promise_resolve_uint (item->send, channel->queue.length);
+      dex_channel_one_receive_and_unlock (channel);
     }
 
   return ret;
@@ -390,6 +1095,9 @@ dex_channel_receive (DexChannel *channel)
 
   g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
 
+  if (channel->ring != NULL)
+    return dex_channel_ring_receive (channel);
+
   recv = dex_channel_receiver_new ();
 
   dex_object_lock (channel);
@@ -408,6 +1116,7 @@ dex_channel_receive (DexChannel *channel)
     }
 
   /* Enqueue this receiver and then flush a queued operation if possible */
+  recv->queued_at = dex_channel_now (channel);
   dex_ref (recv);
   g_queue_push_tail_link (&channel->recvq, &recv->link);
   dex_channel_one_receive_and_unlock (channel);
@@ -416,6 +1125,7 @@ dex_channel_receive (DexChannel *channel)
 
 reject_receive:
   dex_object_unlock (channel);
+  dex_channel_record_rejected (channel, FALSE, 1);
   dex_channel_receiver_complete (recv, FALSE);
 
   return DEX_FUTURE (recv);
@@ -446,9 +1156,35 @@ dex_channel_receive_all (DexChannel *channel)
   GQueue stolen = G_QUEUE_INIT;
 
   g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (!channel->values, NULL);
 
   ret = g_ptr_array_new_with_free_func (dex_unref);
 
+  if (channel->ring != NULL)
+    {
+      DexFuture *future;
+
+      if ((g_atomic_int_get (&channel->flags) & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+        {
+          dex_channel_record_rejected (channel, FALSE, 1);
+          return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+        }
+
+      if (g_atomic_int_get (&channel->n_parked_recv) == 0)
+        {
+          while ((future = dex_ring_buffer_pop (channel->ring)))
+            g_ptr_array_add (ret, future);
+        }
+
+      if (ret->len == 0)
+        return dex_future_all (dex_channel_receive (channel), NULL);
+
+      dex_channel_record_receive (channel, 0, ret->len);
+      dex_channel_ring_wake (channel, &channel->n_parked_send);
+
+      return dex_future_allv ((DexFuture **)ret->pdata, ret->len);
+    }
+
   dex_object_lock (channel);
 
   if ((channel->flags & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
@@ -465,6 +1201,8 @@ dex_channel_receive_all (DexChannel *channel)
       g_ptr_array_add (ret, g_steal_pointer (&item->future));
     }
 
+  dex_channel_record_receive (channel, 0, stolen.length);
+
   dex_object_unlock (channel);
 
   while (stolen.length > 0)
@@ -474,6 +1212,7 @@ dex_channel_receive_all (DexChannel *channel)
 
 reject_receive:
   dex_object_unlock (channel);
+  dex_channel_record_rejected (channel, FALSE, 1);
   return dex_future_new_for_error (g_error_copy (&channel_closed_error));
 
 wait_for_result:
@@ -481,6 +1220,412 @@ wait_for_result:
   return dex_future_all (dex_channel_receive (channel), NULL);
 }
 
+/**
+ * dex_channel_send_many:
+ * @channel: a #DexChannel
+ * @futures: (array length=n_futures) (transfer none): an array of #DexFuture
+ * @n_futures: the number of futures in @futures
+ *
+ * Queues each of @futures into the channel in order.
+ *
+ * This is equivalent to calling dex_channel_send() for each future but
+ * on channels created with %DEX_CHANNEL_FLAGS_RING, waiting receivers
+ * are woken at most once for the whole batch.
+ *
+ * The returned #DexFuture resolves once the last of @futures has been
+ * queued, or rejects with %DEX_ERROR_CHANNEL_CLOSED.
+ *
+ * Returns: (transfer full): a #DexFuture
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_channel_send_many (DexChannel  *channel,
+                       DexFuture  **futures,
+                       guint        n_futures)
+{
+  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
+  g_autoptr(GPtrArray) parked = NULL;
+  DexFuture *ret = NULL;
+  guint i = 0;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (!channel->values, NULL);
+  g_return_val_if_fail (futures != NULL || n_futures == 0, NULL);
+
+  if (n_futures == 0)
+    return dex_future_new_for_boolean (TRUE);
+
+  if (channel->ring == NULL)
+    {
+      for (i = 0; i < n_futures; i++)
+        {
+          dex_clear (&ret);
+          ret = dex_channel_send (channel, dex_ref (futures[i]));
+        }
+
+      return ret;
+    }
+
+  if ((g_atomic_int_get (&channel->flags) & required) != required)
+    {
+      dex_channel_record_rejected (channel, TRUE, n_futures);
+      return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+    }
+
+  if (g_atomic_int_get (&channel->n_parked_send) == 0)
+    {
+      for (; i < n_futures; i++)
+        {
+          /* Ref before pushing as a receiver may take it immediately */
+          if (!dex_ring_buffer_push (channel->ring, dex_ref (futures[i])))
+            {
+              dex_unref (futures[i]);
+              break;
+            }
+        }
+
+      if (i > 0)
+        dex_channel_record_send (channel, 0, i);
+    }
+
+  if (i == n_futures)
+    {
+      dex_channel_ring_wake (channel, &channel->n_parked_recv);
+      return dex_future_new_for_boolean (TRUE);
+    }
+
+  parked = g_ptr_array_new_full (n_futures - i, NULL);
+  for (; i < n_futures; i++)
+    g_ptr_array_add (parked, dex_ref (futures[i]));
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & required) != required)
+    {
+      dex_object_unlock (channel);
+      dex_channel_record_rejected (channel, TRUE, parked->len);
+      g_ptr_array_set_free_func (parked, dex_unref);
+      return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+    }
+
+  return dex_channel_ring_park_and_unlock (channel, parked->pdata, parked->len);
+}
+
+/* Takes up to @max_items which can be received without waiting and
+ * appends them to @ret. Returns the number of items taken.
+ */
+static guint
+dex_channel_take_ready (DexChannel *channel,
+                        GPtrArray  *ret,
+                        guint       max_items)
+{
+  g_autoptr(GPtrArray) to_resolve = NULL;
+  GQueue taken = G_QUEUE_INIT;
+  guint qlen = 0;
+  guint n_taken;
+
+  g_assert (DEX_IS_CHANNEL (channel));
+  g_assert (ret != NULL);
+
+  if (channel->ring != NULL)
+    {
+      DexFuture *future;
+
+      /* Parked receivers are ahead of us */
+      if (g_atomic_int_get (&channel->n_parked_recv) > 0)
+        return 0;
+
+      for (n_taken = 0; n_taken < max_items; n_taken++)
+        {
+          if (!(future = dex_ring_buffer_pop (channel->ring)))
+            break;
+
+          g_ptr_array_add (ret, future);
+        }
+
+      if (n_taken > 0)
+        {
+          dex_channel_record_receive (channel, 0, n_taken);
+          dex_channel_ring_wake (channel, &channel->n_parked_send);
+        }
+
+      return n_taken;
+    }
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_RECEIVE) != 0 &&
+      channel->recvq.length == 0)
+    {
+      while (taken.length < max_items && channel->queue.length > 0)
+        {
+          g_queue_push_tail_link (&taken, g_queue_pop_head_link (&channel->queue));
+          dex_channel_record_receive (channel, 0, 1);
+
+          /* Try to advance a @sendq item into @queue */
+          if (channel->sendq.length > 0 && channel->queue.length < channel->capacity)
+            {
+              DexChannelItem *sendq_item = g_queue_pop_head_link (&channel->sendq)->data;
+
+              g_queue_push_tail_link (&channel->queue, &sendq_item->link);
+              dex_channel_record_send (channel, sendq_item->queued_at, 1);
+
+              if (to_resolve == NULL)
+                to_resolve = g_ptr_array_new_with_free_func (dex_unref);
+              g_ptr_array_add (to_resolve, dex_ref (sendq_item->send));
+            }
+        }
+
+      qlen = channel->queue.length;
+    }
+
+  dex_object_unlock (channel);
+
+  n_taken = taken.length;
+
+  while (taken.length > 0)
+    {
+      DexChannelItem *item = g_queue_pop_head_link (&taken)->data;
+
+      g_ptr_array_add (ret, g_steal_pointer (&item->future));
+      dex_channel_item_free (item);
+    }
+
+  if (to_resolve != NULL)
+    {
+      for (guint i = 0; i < to_resolve->len; i++)
+        dex_promise_resolve_uint (g_ptr_array_index (to_resolve, i), qlen);
+    }
+
+  return n_taken;
+}
+
+typedef struct _ReceiveMany
+{
+  DexChannel *channel;
+  guint       max_items;
+} ReceiveMany;
+
+static void
+receive_many_free (ReceiveMany *state)
+{
+  dex_clear (&state->channel);
+  g_free (state);
+}
+
+static DexFuture *
+dex_channel_receive_many_cb (DexFuture *completed,
+                             gpointer   user_data)
+{
+  ReceiveMany *state = user_data;
+  GPtrArray *ret;
+
+  /* Only a closed channel rejects the batch, a rejected item is
+   * delivered like any other.
+   */
+  if (dex_future_is_rejected (completed))
+    {
+      g_autoptr(GError) error = NULL;
+
+      dex_future_get_value (completed, &error);
+
+      if (g_error_matches (error, DEX_ERROR, DEX_ERROR_CHANNEL_CLOSED))
+        return dex_ref (completed);
+    }
+
+  ret = g_ptr_array_new_with_free_func (dex_unref);
+  g_ptr_array_add (ret, dex_ref (completed));
+
+  if (state->max_items > 1)
+    dex_channel_take_ready (state->channel, ret, state->max_items - 1);
+
+  return dex_future_new_take_boxed (G_TYPE_PTR_ARRAY, ret);
+}
+
+/**
+ * dex_channel_receive_many:
+ * @channel: a #DexChannel
+ * @max_items: the maximum number of items to receive
+ *
+ * Receives up to @max_items from the channel.
+ *
+ * If items are available, the returned future resolves immediately with
+ * as many as could be taken without waiting. Otherwise it resolves once
+ * at least one item is available.
+ *
+ * The future resolves to a #GPtrArray of #DexFuture, one for each item
+ * in the order they were sent. If the channel is closed, the future
+ * rejects with %DEX_ERROR_CHANNEL_CLOSED.
+ *
+ * Returns: (transfer full): a #DexFuture
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_channel_receive_many (DexChannel *channel,
+                          guint       max_items)
+{
+  g_autoptr(GPtrArray) ret = NULL;
+  ReceiveMany *state;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (!channel->values, NULL);
+  g_return_val_if_fail (max_items > 0, NULL);
+
+  if ((g_atomic_int_get (&channel->flags) & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+    {
+      dex_channel_record_rejected (channel, FALSE, 1);
+      return dex_future_new_for_error (g_error_copy (&channel_closed_error));
+    }
+
+  ret = g_ptr_array_new_with_free_func (dex_unref);
+
+  if (dex_channel_take_ready (channel, ret, max_items) > 0)
+    return dex_future_new_take_boxed (G_TYPE_PTR_ARRAY, g_steal_pointer (&ret));
+
+  state = g_new0 (ReceiveMany, 1);
+  state->channel = dex_ref (channel);
+  state->max_items = max_items;
+
+  return dex_future_finally (dex_channel_receive (channel),
+                             dex_channel_receive_many_cb,
+                             state,
+                             (GDestroyNotify)receive_many_free);
+}
+
+/**
+ * dex_channel_try_send_value:
+ * @channel: a #DexChannel created with dex_channel_new_for_values()
+ * @value: (transfer full): a non-%NULL value
+ *
+ * Sends @value if it can be queued without waiting.
+ *
+ * Ownership of @value is only transferred to the channel when %TRUE
+ * is returned.
+ *
+ * Returns: %TRUE if @value was queued; %FALSE if the channel is full
+ *   or closed
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_channel_try_send_value (DexChannel *channel,
+                            gpointer    value)
+{
+  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), FALSE);
+  g_return_val_if_fail (channel->values, FALSE);
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  if ((g_atomic_int_get (&channel->flags) & required) != required ||
+      g_atomic_int_get (&channel->n_parked_send) > 0 ||
+      !dex_ring_buffer_push (channel->ring, value))
+    return FALSE;
+
+  dex_channel_record_send (channel, 0, 1);
+  dex_channel_ring_wake (channel, &channel->n_parked_recv);
+
+  return TRUE;
+}
+
+/**
+ * dex_channel_send_value:
+ * @channel: a #DexChannel created with dex_channel_new_for_values()
+ * @value: (transfer full): a non-%NULL value
+ * @error: a location for a #GError, or %NULL
+ *
+ * Sends @value, suspending the calling fiber while the channel is full.
+ *
+ * This may only be called from a fiber. If the channel is closed, @value
+ * is released with the channel's value free function.
+ *
+ * Returns: %TRUE if @value was queued; otherwise %FALSE and @error is set
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_channel_send_value (DexChannel  *channel,
+                        gpointer     value,
+                        GError     **error)
+{
+  const DexChannelStateFlags required = DEX_CHANNEL_STATE_CAN_SEND|DEX_CHANNEL_STATE_CAN_RECEIVE;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), FALSE);
+  g_return_val_if_fail (channel->values, FALSE);
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  if ((g_atomic_int_get (&channel->flags) & required) != required)
+    {
+      dex_channel_record_rejected (channel, TRUE, 1);
+      dex_channel_free_data (channel, value);
+      g_set_error_literal (error, DEX_ERROR, DEX_ERROR_CHANNEL_CLOSED, channel_closed_error.message);
+      return FALSE;
+    }
+
+  return dex_await (dex_channel_ring_send (channel, value), error);
+}
+
+/**
+ * dex_channel_try_receive_value:
+ * @channel: a #DexChannel created with dex_channel_new_for_values()
+ *
+ * Receives the next value if one is available without waiting.
+ *
+ * Returns: (transfer full) (nullable): the next value or %NULL
+ *
+ * Since: 0.8
+ */
+gpointer
+dex_channel_try_receive_value (DexChannel *channel)
+{
+  gpointer value;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (channel->values, NULL);
+
+  if ((g_atomic_int_get (&channel->flags) & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0 ||
+      g_atomic_int_get (&channel->n_parked_recv) > 0 ||
+      !(value = dex_ring_buffer_pop (channel->ring)))
+    return NULL;
+
+  dex_channel_record_receive (channel, 0, 1);
+  dex_channel_ring_wake (channel, &channel->n_parked_send);
+
+  return value;
+}
+
+/**
+ * dex_channel_receive_value:
+ * @channel: a #DexChannel created with dex_channel_new_for_values()
+ * @error: a location for a #GError, or %NULL
+ *
+ * Receives the next value, suspending the calling fiber while the
+ * channel is empty.
+ *
+ * This may only be called from a fiber.
+ *
+ * Returns: (transfer full): the next value, or %NULL with @error set
+ *   if the channel was closed
+ *
+ * Since: 0.8
+ */
+gpointer
+dex_channel_receive_value (DexChannel  *channel,
+                           GError     **error)
+{
+  gpointer value;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), NULL);
+  g_return_val_if_fail (channel->values, NULL);
+
+  if ((value = dex_channel_try_receive_value (channel)))
+    return value;
+
+  return dex_await_pointer (dex_channel_ring_receive (channel), error);
+}
+
 static void
 dex_channel_unset_state_flags (DexChannel           *channel,
                                DexChannelStateFlags  flags)
@@ -489,6 +1634,7 @@ dex_channel_unset_state_flags (DexChannel           *channel,
   GQueue sendq = G_QUEUE_INIT;
   GQueue recvq = G_QUEUE_INIT;
   GQueue trunc = G_QUEUE_INIT;
+  GPtrArray *woken = NULL;
 
   g_assert (DEX_IS_CHANNEL (channel));
 
@@ -499,10 +1645,19 @@ dex_channel_unset_state_flags (DexChannel           *channel,
     {
       guint pending = channel->sendq.length + channel->queue.length;
 
-      channel->flags &= ~DEX_CHANNEL_STATE_CAN_SEND;
+      g_atomic_int_and (&channel->flags, (guint)~DEX_CHANNEL_STATE_CAN_SEND);
+
+      /* Ring channels reject waiting receivers as part of the flush */
+      if (channel->ring == NULL)
+        {
+          while (channel->recvq.length > pending)
+            g_queue_push_head_link (&trunc, g_queue_pop_tail_link (&channel->recvq));
 
-      while (channel->recvq.length > pending)
-        g_queue_push_head_link (&trunc, g_queue_pop_tail_link (&channel->recvq));
+          dex_channel_record_rejected (channel, FALSE, trunc.length);
+
+          if (channel->recvq.length == pending)
+            dex_channel_close_selects_locked (channel, &woken);
+        }
     }
 
   /* If we need to close the receive-side, do so now and steal
@@ -510,14 +1665,36 @@ dex_channel_unset_state_flags (DexChannel           *channel,
    */
   if (flags & DEX_CHANNEL_STATE_CAN_RECEIVE)
     {
-      channel->flags &= ~DEX_CHANNEL_STATE_CAN_RECEIVE;
+      g_atomic_int_and (&channel->flags, (guint)~DEX_CHANNEL_STATE_CAN_RECEIVE);
 
       queue = steal_queue (&channel->queue);
       sendq = steal_queue (&channel->sendq);
       recvq = steal_queue (&channel->recvq);
+
+      dex_channel_record_rejected (channel, TRUE, sendq.length);
+      dex_channel_record_rejected (channel, FALSE, recvq.length);
+
+      dex_channel_close_selects_locked (channel, &woken);
+
+      g_atomic_int_set (&channel->n_parked_send, 0);
+      g_atomic_int_set (&channel->n_parked_recv, 0);
     }
 
-  dex_object_unlock (channel);
+  if (channel->ring != NULL)
+    dex_channel_ring_flush_and_unlock (channel);
+  else
+    dex_object_unlock (channel);
+
+  dex_channel_wake_selects (woken);
+
+  /* Items left in the ring can no longer be received */
+  if (channel->ring != NULL && (flags & DEX_CHANNEL_STATE_CAN_RECEIVE))
+    {
+      gpointer data;
+
+      while ((data = dex_ring_buffer_pop (channel->ring)))
+        dex_channel_free_data (channel, data);
+    }
 
   while (recvq.length > 0)
     {
@@ -543,6 +1720,7 @@ dex_channel_unset_state_flags (DexChannel           *channel,
     {
       DexChannelItem *item = g_queue_pop_head_link (&sendq)->data;
       dex_promise_reject (item->send, g_error_copy (&channel_closed_error));
+      dex_channel_free_data (channel, g_steal_pointer (&item->value));
       dex_channel_item_free (item);
     }
 }
@@ -590,3 +1768,257 @@ dex_channel_can_receive (DexChannel *channel)
 
   return ret;
 }
+
+/**
+ * dex_channel_get_stats:
+ * @channel: a #DexChannel
+ * @stats: (out caller-allocates): a location for #DexChannelStats
+ *
+ * Gets statistics for @channel.
+ *
+ * The queue depth and number of waiting senders and receivers are
+ * always available. The counters and histograms are only collected when
+ * @channel was created with %DEX_CHANNEL_FLAGS_STATS and are otherwise
+ * zero.
+ *
+ * Receives which complete through a #DexChannelSelect are counted in
+ * @n_received but not in the receive wait histogram.
+ *
+ * Since: 0.8
+ */
+void
+dex_channel_get_stats (DexChannel      *channel,
+                       DexChannelStats *stats)
+{
+  DexChannelCounters *counters;
+  gint64 reset_time = 0;
+  double seconds;
+
+  g_return_if_fail (DEX_IS_CHANNEL (channel));
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof *stats);
+
+  dex_object_lock (channel);
+  stats->depth = dex_channel_depth (channel);
+  stats->n_waiting_senders = channel->sendq.length;
+  stats->n_waiting_receivers = channel->recvq.length + channel->selectq.length;
+  if ((counters = channel->counters))
+    reset_time = counters->reset_time;
+  dex_object_unlock (channel);
+
+  if (counters == NULL)
+    return;
+
+  stats->peak_depth = MAX (stats->depth, (guint)g_atomic_int_get (&counters->peak_depth));
+  stats->n_sent = dex_stats_counter_get (&counters->n_sent);
+  stats->n_received = dex_stats_counter_get (&counters->n_received);
+  stats->n_send_rejected = dex_stats_counter_get (&counters->n_send_rejected);
+  stats->n_receive_rejected = dex_stats_counter_get (&counters->n_receive_rejected);
+
+  for (guint i = 0; i < DEX_CHANNEL_STATS_N_BUCKETS; i++)
+    {
+      stats->send_wait[i] = dex_stats_counter_get (&counters->send_wait[i]);
+      stats->receive_wait[i] = dex_stats_counter_get (&counters->receive_wait[i]);
+    }
+
+  seconds = (g_get_monotonic_time () - reset_time) / (double)G_USEC_PER_SEC;
+  if (seconds > 0)
+    stats->items_per_second = stats->n_received / seconds;
+}
+
+/**
+ * dex_channel_reset_stats:
+ * @channel: a #DexChannel
+ *
+ * Resets the counters and histograms of a #DexChannel created with
+ * %DEX_CHANNEL_FLAGS_STATS, starting a new measurement interval.
+ *
+ * Since: 0.8
+ */
+void
+dex_channel_reset_stats (DexChannel *channel)
+{
+  DexChannelCounters *counters;
+
+  g_return_if_fail (DEX_IS_CHANNEL (channel));
+
+  if (!(counters = channel->counters))
+    return;
+
+  dex_object_lock (channel);
+
+  counters->reset_time = g_get_monotonic_time ();
+
+  g_atomic_int_set (&counters->peak_depth, MIN (dex_channel_depth (channel), (guint)G_MAXINT));
+  dex_stats_counter_reset (&counters->n_sent);
+  dex_stats_counter_reset (&counters->n_received);
+  dex_stats_counter_reset (&counters->n_send_rejected);
+  dex_stats_counter_reset (&counters->n_receive_rejected);
+
+  for (guint i = 0; i < DEX_CHANNEL_STATS_N_BUCKETS; i++)
+    {
+      dex_stats_counter_reset (&counters->send_wait[i]);
+      dex_stats_counter_reset (&counters->receive_wait[i]);
+    }
+
+  dex_object_unlock (channel);
+}
+
+/* Releases an item received with dex_channel_poll() or through a
+ * #DexChannelSelect which will not be delivered.
+ */
+void
+dex_channel_free_item (DexChannel *channel,
+                       gpointer    item)
+{
+  g_return_if_fail (DEX_IS_CHANNEL (channel));
+
+  dex_channel_free_data (channel, item);
+}
+
+/* Takes the next item from @channel without waiting. On success @item
+ * is set to a future, or a value for value channels.
+ */
+DexChannelPoll
+dex_channel_poll (DexChannel *channel,
+                  gpointer   *item)
+{
+  DexChannelItem *taken = NULL;
+  DexPromise *to_resolve = NULL;
+  DexChannelPoll ret;
+  guint qlen = 0;
+
+  g_return_val_if_fail (DEX_IS_CHANNEL (channel), DEX_CHANNEL_POLL_CLOSED);
+  g_return_val_if_fail (item != NULL, DEX_CHANNEL_POLL_CLOSED);
+
+  *item = NULL;
+
+  if (channel->ring != NULL)
+    {
+      guint flags = g_atomic_int_get (&channel->flags);
+
+      if ((flags & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+        return DEX_CHANNEL_POLL_CLOSED;
+
+      if (g_atomic_int_get (&channel->n_parked_recv) == 0 &&
+          (*item = dex_ring_buffer_pop (channel->ring)))
+        {
+          dex_channel_record_receive (channel, 0, 1);
+          dex_channel_ring_wake (channel, &channel->n_parked_send);
+          return DEX_CHANNEL_POLL_READY;
+        }
+
+      if ((flags & DEX_CHANNEL_STATE_CAN_SEND) != 0)
+        return DEX_CHANNEL_POLL_EMPTY;
+
+      dex_object_lock (channel);
+      if (channel->sendq.length == 0 &&
+          dex_ring_buffer_length (channel->ring) == 0)
+        ret = DEX_CHANNEL_POLL_CLOSED;
+      else
+        ret = DEX_CHANNEL_POLL_EMPTY;
+      dex_object_unlock (channel);
+
+      return ret;
+    }
+
+  dex_object_lock (channel);
+
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+    {
+      ret = DEX_CHANNEL_POLL_CLOSED;
+    }
+  else if (channel->recvq.length == 0 && channel->queue.length > 0)
+    {
+      taken = g_queue_pop_head_link (&channel->queue)->data;
+      *item = g_steal_pointer (&taken->future);
+      ret = DEX_CHANNEL_POLL_READY;
+      dex_channel_record_receive (channel, 0, 1);
+
+      /* Try to advance a @sendq item into @queue */
+      if (channel->sendq.length > 0 && channel->queue.length < channel->capacity)
+        {
+          DexChannelItem *sendq_item = g_queue_pop_head_link (&channel->sendq)->data;
+          g_queue_push_tail_link (&channel->queue, &sendq_item->link);
+          qlen = channel->queue.length;
+          to_resolve = dex_ref (sendq_item->send);
+          dex_channel_record_send (channel, sendq_item->queued_at, 1);
+        }
+    }
+  else if ((channel->flags & DEX_CHANNEL_STATE_CAN_SEND) == 0 &&
+           channel->queue.length + channel->sendq.length <= channel->recvq.length)
+    {
+      ret = DEX_CHANNEL_POLL_CLOSED;
+    }
+  else
+    {
+      ret = DEX_CHANNEL_POLL_EMPTY;
+    }
+
+  dex_object_unlock (channel);
+
+  if (taken != NULL)
+    dex_channel_item_free (taken);
+
+  if (to_resolve != NULL)
+    {
+      dex_promise_resolve_uint (to_resolve, qlen);
+      dex_unref (to_resolve);
+    }
+
+  return ret;
+}
+
+/* Queues @node so the select it belongs to is committed to @channel
+ * when an item becomes available or the channel is closed. That may
+ * happen before this function returns.
+ */
+void
+dex_channel_add_select_node (DexChannel           *channel,
+                             DexChannelSelectNode *node)
+{
+  GPtrArray *woken = NULL;
+
+  g_return_if_fail (DEX_IS_CHANNEL (channel));
+  g_return_if_fail (node != NULL);
+  g_return_if_fail (!node->queued);
+
+  node->link.data = node;
+
+  dex_object_lock (channel);
+
+  g_queue_push_tail_link (&channel->selectq, &node->link);
+  node->queued = TRUE;
+
+  if (channel->ring != NULL)
+    g_atomic_int_inc (&channel->n_parked_recv);
+
+  if ((channel->flags & DEX_CHANNEL_STATE_CAN_RECEIVE) == 0)
+    {
+      dex_channel_close_selects_locked (channel, &woken);
+      dex_object_unlock (channel);
+      dex_channel_wake_selects (woken);
+    }
+  else if (channel->ring != NULL)
+    {
+      dex_channel_ring_flush_and_unlock (channel);
+    }
+  else
+    {
+      dex_channel_one_receive_and_unlock (channel);
+    }
+}
+
+void
+dex_channel_remove_select_node (DexChannel           *channel,
+                                DexChannelSelectNode *node)
+{
+  g_return_if_fail (DEX_IS_CHANNEL (channel));
+  g_return_if_fail (node != NULL);
+
+  dex_object_lock (channel);
+  if (node->queued)
+    dex_channel_unlink_select_node_locked (channel, node);
+  dex_object_unlock (channel);
+}
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "dex-enums.h"
 #include "dex-future.h"
 
 G_BEGIN_DECLS
@@ -31,29 +32,107 @@ G_BEGIN_DECLS
 
 typedef struct _DexChannel DexChannel;
 
+#define DEX_CHANNEL_STATS_N_BUCKETS 24
+
+/**
+ * DexChannelStats:
+ * @depth: the number of items queued in the channel
+ * @peak_depth: the largest @depth seen since statistics were reset
+ * @n_waiting_senders: the number of sends waiting for capacity
+ * @n_waiting_receivers: the number of receives waiting for an item
+ * @n_sent: the number of items which entered the channel
+ * @n_received: the number of items delivered to receivers
+ * @n_send_rejected: the number of sends rejected because the channel
+ *   was closed
+ * @n_receive_rejected: the number of receives rejected because the
+ *   channel was closed
+ * @items_per_second: @n_received divided by the seconds since statistics
+ *   were reset
+ * @send_wait: histogram of the time sends waited for capacity
+ * @receive_wait: histogram of the time receives waited for an item
+ *
+ * Statistics for a #DexChannel created with %DEX_CHANNEL_FLAGS_STATS.
+ *
+ * Bucket 0 of the histograms counts operations which did not wait. Bucket
+ * `i` counts waits of at least 2^(i-1) and less than 2^i microseconds,
+ * with the last bucket counting everything longer.
+ *
+ * Since: 0.8
+ */
+typedef struct _DexChannelStats
+{
+  guint   depth;
+  guint   peak_depth;
+  guint   n_waiting_senders;
+  guint   n_waiting_receivers;
+  guint64 n_sent;
+  guint64 n_received;
+  guint64 n_send_rejected;
+  guint64 n_receive_rejected;
+  double  items_per_second;
+  guint64 send_wait[DEX_CHANNEL_STATS_N_BUCKETS];
+  guint64 receive_wait[DEX_CHANNEL_STATS_N_BUCKETS];
+} DexChannelStats;
+
 DEX_AVAILABLE_IN_ALL
 GType       dex_channel_get_type          (void) G_GNUC_CONST;
 DEX_AVAILABLE_IN_ALL
-DexChannel *dex_channel_new               (guint       capacity)
+DexChannel *dex_channel_new               (guint             capacity)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexChannel *dex_channel_new_full          (guint             capacity,
+                                           DexChannelFlags   flags)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexChannel *dex_channel_new_for_values    (guint             capacity,
+                                           GDestroyNotify    value_free)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture  *dex_channel_send              (DexChannel       *channel,
+                                           DexFuture        *future)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture  *dex_channel_send_many         (DexChannel       *channel,
+                                           DexFuture       **futures,
+                                           guint             n_futures)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
-DexFuture  *dex_channel_send              (DexChannel *channel,
-                                           DexFuture  *future)
+DexFuture  *dex_channel_receive           (DexChannel       *channel)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
-DexFuture  *dex_channel_receive           (DexChannel *channel)
+DexFuture  *dex_channel_receive_many      (DexChannel       *channel,
+                                           guint             max_items)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
-DexFuture  *dex_channel_receive_all       (DexChannel *channel)
+DexFuture  *dex_channel_receive_all       (DexChannel       *channel)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
-void        dex_channel_close_send        (DexChannel *channel);
+gboolean    dex_channel_try_send_value    (DexChannel       *channel,
+                                           gpointer          value);
+DEX_AVAILABLE_IN_ALL
+gboolean    dex_channel_send_value        (DexChannel       *channel,
+                                           gpointer          value,
+                                           GError          **error);
+DEX_AVAILABLE_IN_ALL
+gpointer    dex_channel_try_receive_value (DexChannel       *channel)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+gpointer    dex_channel_receive_value     (DexChannel       *channel,
+                                           GError          **error)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+void        dex_channel_close_send        (DexChannel       *channel);
+DEX_AVAILABLE_IN_ALL
+void        dex_channel_close_receive     (DexChannel       *channel);
+DEX_AVAILABLE_IN_ALL
+gboolean    dex_channel_can_send          (DexChannel       *channel);
 DEX_AVAILABLE_IN_ALL
-void        dex_channel_close_receive     (DexChannel *channel);
+gboolean    dex_channel_can_receive       (DexChannel       *channel);
 DEX_AVAILABLE_IN_ALL
-gboolean    dex_channel_can_send          (DexChannel *channel);
+void        dex_channel_get_stats         (DexChannel       *channel,
+                                           DexChannelStats  *stats);
 DEX_AVAILABLE_IN_ALL
-gboolean    dex_channel_can_receive       (DexChannel *channel);
+void        dex_channel_reset_stats       (DexChannel       *channel);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexChannel, dex_unref)
 
@@ -60,8 +60,20 @@ _g_source_set_static_name (GSource    *source,
 #endif
 }
 
+static inline gboolean
+_g_spawn_check_wait_status (int      wait_status,
+                            GError **error)
+{
+#if GLIB_CHECK_VERSION(2, 70, 0)
+  return g_spawn_check_wait_status (wait_status, error);
+#else
+  return g_spawn_check_exit_status (wait_status, error);
+#endif
+}
+
 #if !GLIB_CHECK_VERSION(2, 70, 0)
 # define G_DEFINE_FINAL_TYPE_WITH_CODE(TN, t_n, T_P, _C_) _G_DEFINE_TYPE_EXTENDED_BEGIN (TN, t_n, T_P, 0) {_C_;} _G_DEFINE_TYPE_EXTENDED_END()
+# define G_DEFINE_FINAL_TYPE(TN, t_n, T_P) G_DEFINE_TYPE (TN, t_n, T_P)
 # define G_TYPE_FLAG_FINAL 0
 # define G_TYPE_IS_FINAL(type) 1
 #endif
@@ -84,6 +96,21 @@ G_PASTE(type_name, _get_type) (void) \
   } \
   return g_define_type__static; \
 }
+# define G_DEFINE_FLAGS_TYPE(TypeName, type_name, ...) \
+GType \
+G_PASTE(type_name, _get_type) (void) \
+{ \
+  static gsize g_define_type__static = 0; \
+  if (g_once_init_enter (&g_define_type__static)) { \
+    static const GFlagsValue flags_values[] = { \
+      __VA_ARGS__ , \
+      { 0, NULL, NULL }, \
+    }; \
+    GType g_define_type = g_flags_register_static (g_intern_static_string (G_STRINGIFY (TypeName)), flags_values); \
+    g_once_init_leave (&g_define_type__static, g_define_type); \
+  } \
+  return g_define_type__static; \
+}
 #endif
 
 #if !GLIB_CHECK_VERSION(2, 72, 0)
@@ -0,0 +1,214 @@
+/*
+ * dex-cond.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-cond.h"
+#include "dex-lock-waiter-private.h"
+
+/**
+ * DexCond:
+ *
+ * #DexCond is a condition variable for fibers used together with
+ * #DexMutex.
+ *
+ * dex_cond_wait() atomically releases the mutex and returns a future
+ * which resolves once the condition has been signalled and the mutex has
+ * been re-acquired. As with #GCond, spurious wake-ups are possible in the
+ * sense that another fiber may have changed the state before the waiter
+ * re-acquires the mutex, so always re-check the predicate in a loop.
+ *
+ * Waiters are woken in FIFO order. Signalling a condition nobody is
+ * waiting on is a single atomic read.
+ *
+ * Since: 0.8
+ */
+
+struct _DexCond
+{
+  DexObject parent_instance;
+  guint     n_waiters;
+  GQueue    waiters;
+};
+
+typedef struct _DexCondClass
+{
+  DexObjectClass parent_class;
+} DexCondClass;
+
+DEX_DEFINE_FINAL_TYPE (DexCond, dex_cond, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_COND
+#define DEX_TYPE_COND dex_cond_type
+
+static void
+dex_cond_finalize (DexObject *object)
+{
+  DexCond *cond = DEX_COND (object);
+
+  /* Queued waiters hold a reference to the condition */
+  g_assert (cond->waiters.length == 0);
+
+  DEX_OBJECT_CLASS (dex_cond_parent_class)->finalize (object);
+}
+
+static void
+dex_cond_class_init (DexCondClass *cond_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (cond_class);
+
+  object_class->finalize = dex_cond_finalize;
+}
+
+static void
+dex_cond_init (DexCond *cond)
+{
+}
+
+static void
+dex_cond_cancel (DexObject     *owner,
+                 DexLockWaiter *waiter)
+{
+  DexCond *cond = DEX_COND (owner);
+  gboolean unlinked;
+
+  dex_object_lock (cond);
+  if ((unlinked = dex_lock_waiter_unlink (waiter, &cond->waiters)))
+    g_atomic_int_set (&cond->n_waiters, cond->waiters.length);
+  dex_object_unlock (cond);
+
+  if (unlinked)
+    dex_lock_waiter_cancelled (waiter);
+}
+
+static void
+dex_cond_wake (DexCond *cond,
+               guint    max_waiters)
+{
+  GQueue ready = G_QUEUE_INIT;
+  DexLockWaiter *waiter;
+
+  if (g_atomic_int_get (&cond->n_waiters) == 0)
+    return;
+
+  dex_object_lock (cond);
+  while (max_waiters-- > 0 &&
+         (waiter = dex_lock_waiter_dequeue (&cond->waiters)))
+    g_queue_push_tail_link (&ready, &waiter->link);
+  g_atomic_int_set (&cond->n_waiters, cond->waiters.length);
+  dex_object_unlock (cond);
+
+  dex_lock_waiter_wake_all (&ready);
+}
+
+static DexFuture *
+dex_cond_relock (DexFuture *completed,
+                 gpointer   user_data)
+{
+  return dex_mutex_lock (user_data);
+}
+
+/**
+ * dex_cond_new:
+ *
+ * Creates a new #DexCond.
+ *
+ * Returns: (transfer full): a #DexCond
+ *
+ * Since: 0.8
+ */
+DexCond *
+dex_cond_new (void)
+{
+  return (DexCond *)dex_object_create_instance (DEX_TYPE_COND);
+}
+
+/**
+ * dex_cond_wait:
+ * @cond: a #DexCond
+ * @mutex: a #DexMutex owned by the caller
+ *
+ * Releases @mutex and waits for @cond to be signalled.
+ *
+ * The resulting future resolves once @cond has been signalled and
+ * @mutex is owned by the caller again. If the future is discarded
+ * before @cond is signalled, @mutex is not re-acquired.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_cond_wait (DexCond  *cond,
+               DexMutex *mutex)
+{
+  DexLockWaiter *waiter;
+
+  g_return_val_if_fail (DEX_IS_COND (cond), NULL);
+  g_return_val_if_fail (DEX_IS_MUTEX (mutex), NULL);
+
+  waiter = dex_lock_waiter_new (DEX_OBJECT (cond), dex_cond_cancel, FALSE);
+
+  /* Queue before releasing @mutex so a signal cannot be missed */
+  dex_object_lock (cond);
+  dex_lock_waiter_enqueue (waiter, &cond->waiters);
+  g_atomic_int_set (&cond->n_waiters, cond->waiters.length);
+  dex_object_unlock (cond);
+
+  dex_mutex_unlock (mutex);
+
+  return dex_future_then (DEX_FUTURE (waiter),
+                          dex_cond_relock,
+                          dex_ref (mutex),
+                          dex_unref);
+}
+
+/**
+ * dex_cond_signal:
+ * @cond: a #DexCond
+ *
+ * Wakes the longest waiting fiber in dex_cond_wait(), if any.
+ *
+ * Since: 0.8
+ */
+void
+dex_cond_signal (DexCond *cond)
+{
+  g_return_if_fail (DEX_IS_COND (cond));
+
+  dex_cond_wake (cond, 1);
+}
+
+/**
+ * dex_cond_broadcast:
+ * @cond: a #DexCond
+ *
+ * Wakes all fibers waiting in dex_cond_wait().
+ *
+ * Since: 0.8
+ */
+void
+dex_cond_broadcast (DexCond *cond)
+{
+  g_return_if_fail (DEX_IS_COND (cond));
+
+  dex_cond_wake (cond, G_MAXUINT);
+}
@@ -0,0 +1,872 @@
+/*
+ * dex-dir-walker.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+
+#include "dex-dir-walker.h"
+#include "dex-object-private.h"
+#include "dex-promise.h"
+#include "dex-scheduler.h"
+#include "dex-semaphore-private.h"
+#include "dex-thread-pool-scheduler.h"
+
+/**
+ * DexDirWalker:
+ *
+ * #DexDirWalker recursively enumerates a directory tree using multiple
+ * fibers on the default #DexThreadPoolScheduler.
+ *
+ * Each fiber owns a queue of directories still to be read. It processes
+ * its own queue depth-first and, once empty, steals the oldest directory
+ * from another fiber's queue. Since the oldest directories are closest
+ * to the root, stealing tends to move whole subtrees between fibers.
+ *
+ * Directories are read in large batches directly from the kernel (using
+ * `getdents64()` on Linux) and no #GFileInfo is created. Entries are
+ * delivered as #GPtrArray batches of #DexDirEntry through a bounded
+ * #DexChannel, so a slow consumer applies back-pressure to the walk.
+ *
+ * Symbolic links are reported but never followed.
+ *
+ * Since: 0.8
+ */
+
+#define DEFAULT_BUFFER_SIZE (64*1024)
+#define DEFAULT_BATCH_SIZE  1024
+
+/* Layout of the records returned by getdents64() */
+typedef struct _DexDirent64
+{
+  guint64        d_ino;
+  gint64         d_off;
+  unsigned short d_reclen;
+  unsigned char  d_type;
+  char           d_name[];
+} DexDirent64;
+
+struct _DexDirEntry
+{
+  GFileType file_type;
+  guint     has_stat : 1;
+  guint32   mode;
+  guint64   inode;
+  guint64   size;
+  gint64    mtime;
+  gsize     name_offset;
+  char      path[];
+};
+
+typedef struct _DexDirWalkerLane
+{
+  GMutex  mutex;
+  GQueue  pending;
+} DexDirWalkerLane;
+
+typedef struct _DexDirWalkerWorker
+{
+  DexDirWalker *dir_walker;
+  GPtrArray    *batch;
+  gint64        n_entries;
+  guint         lane;
+} DexDirWalkerWorker;
+
+struct _DexDirWalker
+{
+  DexObject         parent_instance;
+
+  char             *path;
+  DexChannel       *channel;
+  DexPromise       *promise;
+
+  /* Posted to wake idle fibers when directories are queued or when
+   * the walk has finished.
+   */
+  DexSemaphore     *wakeup;
+
+  /* One queue of relative directory paths per fiber */
+  DexDirWalkerLane *lanes;
+  guint             n_lanes;
+
+  /* Directories queued or being read. Reaching zero ends the walk. */
+  guint             n_outstanding;
+  guint             n_idle;
+  guint             n_running;
+  guint             cancelled;
+
+  /* Protects error and n_entries */
+  GMutex            mutex;
+  GError           *error;
+  gint64            n_entries;
+
+  guint             query_stat : 1;
+  guint             started : 1;
+};
+
+typedef struct _DexDirWalkerClass
+{
+  DexObjectClass parent_class;
+} DexDirWalkerClass;
+
+DEX_DEFINE_FINAL_TYPE (DexDirWalker, dex_dir_walker, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_DIR_WALKER
+#define DEX_TYPE_DIR_WALKER dex_dir_walker_type
+
+G_DEFINE_BOXED_TYPE (DexDirEntry, dex_dir_entry, dex_dir_entry_copy, dex_dir_entry_free)
+
+static void
+dex_dir_walker_finalize (DexObject *object)
+{
+  DexDirWalker *dir_walker = DEX_DIR_WALKER (object);
+
+  for (guint i = 0; i < dir_walker->n_lanes; i++)
+    {
+      g_queue_clear_full (&dir_walker->lanes[i].pending, g_free);
+      g_mutex_clear (&dir_walker->lanes[i].mutex);
+    }
+
+  g_clear_pointer (&dir_walker->lanes, g_free);
+  g_clear_pointer (&dir_walker->path, g_free);
+  g_clear_error (&dir_walker->error);
+  g_mutex_clear (&dir_walker->mutex);
+
+  dex_clear (&dir_walker->channel);
+  dex_clear (&dir_walker->promise);
+  dex_clear (&dir_walker->wakeup);
+
+  DEX_OBJECT_CLASS (dex_dir_walker_parent_class)->finalize (object);
+}
+
+static void
+dex_dir_walker_class_init (DexDirWalkerClass *dir_walker_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (dir_walker_class);
+
+  object_class->finalize = dex_dir_walker_finalize;
+}
+
+static void
+dex_dir_walker_init (DexDirWalker *dir_walker)
+{
+  g_mutex_init (&dir_walker->mutex);
+}
+
+static void
+dex_dir_walker_take_error (DexDirWalker *dir_walker,
+                           GError       *error)
+{
+  g_mutex_lock (&dir_walker->mutex);
+  if (dir_walker->error == NULL)
+    dir_walker->error = g_steal_pointer (&error);
+  g_mutex_unlock (&dir_walker->mutex);
+
+  g_clear_error (&error);
+}
+
+static void
+dex_dir_walker_set_errno (DexDirWalker *dir_walker,
+                          const char   *path,
+                          int           errsv)
+{
+  dex_dir_walker_take_error (dir_walker,
+                             g_error_new (G_IO_ERROR,
+                                          g_io_error_from_errno (errsv),
+                                          "%s: %s",
+                                          path, g_strerror (errsv)));
+}
+
+static void
+dex_dir_walker_cancel (DexDirWalker *dir_walker)
+{
+  if (g_atomic_int_compare_and_exchange (&dir_walker->cancelled, FALSE, TRUE))
+    dex_semaphore_post_many (dir_walker->wakeup, dir_walker->n_lanes);
+}
+
+static void
+dex_dir_walker_push (DexDirWalker *dir_walker,
+                     guint         lane,
+                     char         *relative_path)
+{
+  DexDirWalkerLane *l = &dir_walker->lanes[lane];
+
+  g_atomic_int_inc (&dir_walker->n_outstanding);
+
+  g_mutex_lock (&l->mutex);
+  g_queue_push_tail (&l->pending, relative_path);
+  g_mutex_unlock (&l->mutex);
+
+  /* Idle fibers increment n_idle before checking the queues again, so
+   * reading it after our push cannot miss one that is about to sleep.
+   */
+  if (g_atomic_int_get (&dir_walker->n_idle) > 0)
+    dex_semaphore_post (dir_walker->wakeup);
+}
+
+static char *
+dex_dir_walker_pop (DexDirWalker *dir_walker,
+                    guint         lane)
+{
+  char *relative_path;
+
+  /* Depth-first from our own queue keeps the working set small */
+  g_mutex_lock (&dir_walker->lanes[lane].mutex);
+  relative_path = g_queue_pop_tail (&dir_walker->lanes[lane].pending);
+  g_mutex_unlock (&dir_walker->lanes[lane].mutex);
+
+  if (relative_path != NULL)
+    return relative_path;
+
+  /* Steal the oldest (closest to the root) directory from another lane */
+  for (guint i = 1; i < dir_walker->n_lanes; i++)
+    {
+      DexDirWalkerLane *victim = &dir_walker->lanes[(lane + i) % dir_walker->n_lanes];
+
+      g_mutex_lock (&victim->mutex);
+      relative_path = g_queue_pop_head (&victim->pending);
+      g_mutex_unlock (&victim->mutex);
+
+      if (relative_path != NULL)
+        return relative_path;
+    }
+
+  return NULL;
+}
+
+static gboolean
+dex_dir_walker_worker_flush (DexDirWalkerWorker *worker)
+{
+  DexDirWalker *dir_walker = worker->dir_walker;
+  GPtrArray *batch;
+
+  if (worker->batch->len == 0)
+    return TRUE;
+
+  batch = g_steal_pointer (&worker->batch);
+  worker->batch = g_ptr_array_new_full (DEFAULT_BATCH_SIZE, (GDestroyNotify)dex_dir_entry_free);
+
+  /* Blocks this fiber until the consumer has room */
+  if (!dex_await (dex_channel_send (dir_walker->channel,
+                                    dex_future_new_take_boxed (G_TYPE_PTR_ARRAY, batch)),
+                  NULL))
+    {
+      dex_dir_walker_cancel (dir_walker);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GFileType
+file_type_from_mode (guint32 mode)
+{
+  if (S_ISDIR (mode))
+    return G_FILE_TYPE_DIRECTORY;
+  else if (S_ISREG (mode))
+    return G_FILE_TYPE_REGULAR;
+  else if (S_ISLNK (mode))
+    return G_FILE_TYPE_SYMBOLIC_LINK;
+  else
+    return G_FILE_TYPE_SPECIAL;
+}
+
+static GFileType
+file_type_from_d_type (guint8 d_type)
+{
+  switch (d_type)
+    {
+    case DT_DIR: return G_FILE_TYPE_DIRECTORY;
+    case DT_REG: return G_FILE_TYPE_REGULAR;
+    case DT_LNK: return G_FILE_TYPE_SYMBOLIC_LINK;
+    case DT_UNKNOWN: return G_FILE_TYPE_UNKNOWN;
+    default: return G_FILE_TYPE_SPECIAL;
+    }
+}
+
+static gboolean
+dex_dir_entry_stat (DexDirEntry *dir_entry,
+                    int          dir_fd)
+{
+  const char *name = &dir_entry->path[dir_entry->name_offset];
+
+#ifdef HAVE_STATX
+  struct statx stx;
+
+  /* Avoid round-trips to the server on network filesystems */
+  if (statx (dir_fd, name,
+             AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+             STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE | STATX_MTIME,
+             &stx) != 0)
+    return FALSE;
+
+  dir_entry->mode = stx.stx_mode;
+  dir_entry->inode = stx.stx_ino;
+  dir_entry->size = stx.stx_size;
+  dir_entry->mtime = stx.stx_mtime.tv_sec;
+#else
+  struct stat stbuf;
+
+  if (fstatat (dir_fd, name, &stbuf, AT_SYMLINK_NOFOLLOW) != 0)
+    return FALSE;
+
+  dir_entry->mode = stbuf.st_mode;
+  dir_entry->inode = stbuf.st_ino;
+  dir_entry->size = stbuf.st_size;
+  dir_entry->mtime = stbuf.st_mtime;
+#endif
+
+  dir_entry->has_stat = TRUE;
+  dir_entry->file_type = file_type_from_mode (dir_entry->mode);
+
+  return TRUE;
+}
+
+static gboolean
+dex_dir_walker_worker_add (DexDirWalkerWorker *worker,
+                           int                 dir_fd,
+                           const char         *relative_dir,
+                           gsize               relative_dir_len,
+                           const char         *name,
+                           guint8              d_type,
+                           guint64             inode)
+{
+  DexDirWalker *dir_walker = worker->dir_walker;
+  DexDirEntry *dir_entry;
+  gsize name_len;
+  gsize prefix_len;
+
+  if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+    return TRUE;
+
+  name_len = strlen (name);
+  prefix_len = relative_dir_len ? relative_dir_len + 1 : 0;
+
+  dir_entry = g_malloc (sizeof *dir_entry + prefix_len + name_len + 1);
+  dir_entry->file_type = file_type_from_d_type (d_type);
+  dir_entry->has_stat = FALSE;
+  dir_entry->mode = 0;
+  dir_entry->inode = inode;
+  dir_entry->size = 0;
+  dir_entry->mtime = 0;
+  dir_entry->name_offset = prefix_len;
+
+  if (prefix_len)
+    {
+      memcpy (dir_entry->path, relative_dir, relative_dir_len);
+      dir_entry->path[relative_dir_len] = G_DIR_SEPARATOR;
+    }
+
+  memcpy (&dir_entry->path[prefix_len], name, name_len + 1);
+
+  /* Some filesystems do not report d_type, so we must stat() to know
+   * if we should descend into the entry.
+   */
+  if (dir_walker->query_stat || dir_entry->file_type == G_FILE_TYPE_UNKNOWN)
+    dex_dir_entry_stat (dir_entry, dir_fd);
+
+  if (dir_entry->file_type == G_FILE_TYPE_DIRECTORY)
+    dex_dir_walker_push (dir_walker, worker->lane, g_strdup (dir_entry->path));
+
+  g_ptr_array_add (worker->batch, dir_entry);
+  worker->n_entries++;
+
+  if (worker->batch->len >= DEFAULT_BATCH_SIZE)
+    return dex_dir_walker_worker_flush (worker);
+
+  return TRUE;
+}
+
+static void
+dex_dir_walker_worker_read (DexDirWalkerWorker *worker,
+                            const char         *relative_dir,
+                            gpointer            buffer)
+{
+  DexDirWalker *dir_walker = worker->dir_walker;
+  g_autofree char *full_path = NULL;
+  gsize relative_dir_len = strlen (relative_dir);
+  int dir_fd;
+
+  if (relative_dir_len == 0)
+    full_path = g_strdup (dir_walker->path);
+  else
+    full_path = g_build_filename (dir_walker->path, relative_dir, NULL);
+
+  if (-1 == (dir_fd = open (full_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)))
+    {
+      dex_dir_walker_set_errno (dir_walker, full_path, errno);
+      return;
+    }
+
+#ifdef __linux__
+  for (;;)
+    {
+      long n_read = syscall (SYS_getdents64, dir_fd, buffer, DEFAULT_BUFFER_SIZE);
+
+      if (n_read == 0)
+        break;
+
+      if (n_read < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          dex_dir_walker_set_errno (dir_walker, full_path, errno);
+          break;
+        }
+
+      for (long pos = 0; pos < n_read; )
+        {
+          const DexDirent64 *dirent = (const DexDirent64 *)((guint8 *)buffer + pos);
+
+          pos += dirent->d_reclen;
+
+          if (!dex_dir_walker_worker_add (worker, dir_fd,
+                                          relative_dir, relative_dir_len,
+                                          dirent->d_name, dirent->d_type, dirent->d_ino))
+            goto cleanup;
+        }
+    }
+
+cleanup:
+  close (dir_fd);
+#else
+  {
+    struct dirent *dirent;
+    DIR *dir;
+
+    if (!(dir = fdopendir (dir_fd)))
+      {
+        dex_dir_walker_set_errno (dir_walker, full_path, errno);
+        close (dir_fd);
+        return;
+      }
+
+    while ((dirent = readdir (dir)))
+      {
+        if (!dex_dir_walker_worker_add (worker, dirfd (dir),
+                                        relative_dir, relative_dir_len,
+                                        dirent->d_name, dirent->d_type, dirent->d_ino))
+          break;
+      }
+
+    closedir (dir);
+  }
+#endif
+}
+
+static void
+dex_dir_walker_worker_free (gpointer data)
+{
+  DexDirWalkerWorker *worker = data;
+
+  g_clear_pointer (&worker->batch, g_ptr_array_unref);
+  dex_clear (&worker->dir_walker);
+  g_free (worker);
+}
+
+static void
+dex_dir_walker_finish (DexDirWalker *dir_walker)
+{
+  GError *error;
+
+  dex_channel_close_send (dir_walker->channel);
+
+  g_mutex_lock (&dir_walker->mutex);
+  error = g_steal_pointer (&dir_walker->error);
+  g_mutex_unlock (&dir_walker->mutex);
+
+  if (error == NULL && g_atomic_int_get (&dir_walker->cancelled))
+    error = g_error_new_literal (G_IO_ERROR,
+                                 G_IO_ERROR_CANCELLED,
+                                 "The channel was closed before the walk completed");
+
+  if (error != NULL)
+    dex_promise_reject (dir_walker->promise, error);
+  else
+    dex_promise_resolve_int64 (dir_walker->promise, dir_walker->n_entries);
+}
+
+static DexFuture *
+dex_dir_walker_fiber (gpointer user_data)
+{
+  DexDirWalkerWorker *worker = user_data;
+  DexDirWalker *dir_walker = worker->dir_walker;
+  g_autofree gpointer buffer = g_malloc (DEFAULT_BUFFER_SIZE);
+
+  while (!g_atomic_int_get (&dir_walker->cancelled))
+    {
+      char *relative_dir;
+
+      if (!(relative_dir = dex_dir_walker_pop (dir_walker, worker->lane)))
+        {
+          if (g_atomic_int_get (&dir_walker->n_outstanding) == 0)
+            break;
+
+          /* Hand what we have to the consumer before going idle */
+          if (!dex_dir_walker_worker_flush (worker))
+            break;
+
+          g_atomic_int_inc (&dir_walker->n_idle);
+          if (!(relative_dir = dex_dir_walker_pop (dir_walker, worker->lane)))
+            dex_await (dex_semaphore_wait (dir_walker->wakeup), NULL);
+          g_atomic_int_add (&dir_walker->n_idle, -1);
+
+          if (relative_dir == NULL)
+            continue;
+        }
+
+      dex_dir_walker_worker_read (worker, relative_dir, buffer);
+      g_free (relative_dir);
+
+      /* That was the last directory, wake everyone so they can exit */
+      if (g_atomic_int_dec_and_test (&dir_walker->n_outstanding))
+        dex_semaphore_post_many (dir_walker->wakeup, dir_walker->n_lanes);
+    }
+
+  if (!g_atomic_int_get (&dir_walker->cancelled))
+    dex_dir_walker_worker_flush (worker);
+
+  g_mutex_lock (&dir_walker->mutex);
+  dir_walker->n_entries += worker->n_entries;
+  g_mutex_unlock (&dir_walker->mutex);
+
+  if (g_atomic_int_dec_and_test (&dir_walker->n_running))
+    dex_dir_walker_finish (dir_walker);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+/**
+ * dex_dir_walker_new:
+ * @path: the directory to walk
+ *
+ * Creates a new #DexDirWalker to enumerate everything below @path.
+ *
+ * The walk does not begin until dex_dir_walker_create_channel() is called.
+ *
+ * Returns: (transfer full): a #DexDirWalker
+ *
+ * Since: 0.8
+ */
+DexDirWalker *
+dex_dir_walker_new (const char *path)
+{
+  DexDirWalker *dir_walker;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  dir_walker = (DexDirWalker *)dex_object_create_instance (DEX_TYPE_DIR_WALKER);
+  dir_walker->path = g_strdup (path);
+  dir_walker->promise = dex_promise_new ();
+  dir_walker->wakeup = dex_semaphore_new ();
+
+  return dir_walker;
+}
+
+/**
+ * dex_dir_walker_set_query_stat:
+ * @dir_walker: a #DexDirWalker
+ * @query_stat: if entries should include file status
+ *
+ * Sets if the mode, inode, size, and modification time should be
+ * retrieved for every entry.
+ *
+ * On Linux this uses `statx()` with `AT_STATX_DONT_SYNC`. It requires
+ * a system call per entry so only enable it when needed.
+ *
+ * This must be called before dex_dir_walker_create_channel().
+ *
+ * Since: 0.8
+ */
+void
+dex_dir_walker_set_query_stat (DexDirWalker *dir_walker,
+                               gboolean      query_stat)
+{
+  g_return_if_fail (DEX_IS_DIR_WALKER (dir_walker));
+  g_return_if_fail (!dir_walker->started);
+
+  dir_walker->query_stat = !!query_stat;
+}
+
+/**
+ * dex_dir_walker_create_channel:
+ * @dir_walker: a #DexDirWalker
+ * @capacity: the channel capacity in batches, or 0 for unlimited
+ *
+ * Starts walking the directory tree and returns a #DexChannel which
+ * will receive a #GPtrArray of #DexDirEntry for each batch of entries.
+ *
+ * Entries within a batch may come from different directories. Since
+ * fibers flush their batches independently, the entries of a directory
+ * may be delivered before the entry for the directory itself.
+ *
+ * The sending side of the channel is closed once the walk completes.
+ * Close the receiving side to stop the walk early.
+ *
+ * Returns: (transfer full): a #DexChannel
+ *
+ * Since: 0.8
+ */
+DexChannel *
+dex_dir_walker_create_channel (DexDirWalker *dir_walker,
+                               guint         capacity)
+{
+  DexScheduler *scheduler;
+
+  g_return_val_if_fail (DEX_IS_DIR_WALKER (dir_walker), NULL);
+  g_return_val_if_fail (!dir_walker->started, NULL);
+
+  dir_walker->started = TRUE;
+  dir_walker->channel = dex_channel_new (capacity);
+
+  /* Match the number of thread pool workers */
+  dir_walker->n_lanes = MAX (1, MIN (32, g_get_num_processors ()) / 2);
+  dir_walker->n_running = dir_walker->n_lanes;
+  dir_walker->lanes = g_new0 (DexDirWalkerLane, dir_walker->n_lanes);
+
+  for (guint i = 0; i < dir_walker->n_lanes; i++)
+    g_mutex_init (&dir_walker->lanes[i].mutex);
+
+  /* The root is the empty relative path */
+  dex_dir_walker_push (dir_walker, 0, g_strdup (""));
+
+  scheduler = dex_thread_pool_scheduler_get_default ();
+
+  for (guint i = 0; i < dir_walker->n_lanes; i++)
+    {
+      DexDirWalkerWorker *worker = g_new0 (DexDirWalkerWorker, 1);
+
+      worker->dir_walker = dex_ref (dir_walker);
+      worker->batch = g_ptr_array_new_full (DEFAULT_BATCH_SIZE, (GDestroyNotify)dex_dir_entry_free);
+      worker->lane = i;
+
+      dex_future_disown (dex_scheduler_spawn (scheduler,
+                                              0,
+                                              dex_dir_walker_fiber,
+                                              worker,
+                                              dex_dir_walker_worker_free));
+    }
+
+  return dex_ref (dir_walker->channel);
+}
+
+/**
+ * dex_dir_walker_wait:
+ * @dir_walker: a #DexDirWalker
+ *
+ * Gets a future which completes when the walk has finished.
+ *
+ * Directories which cannot be read are skipped and the walk continues.
+ * The first such error is reported by rejecting the future once the
+ * walk has finished.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to the number of
+ *   entries found or rejects with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_dir_walker_wait (DexDirWalker *dir_walker)
+{
+  g_return_val_if_fail (DEX_IS_DIR_WALKER (dir_walker), NULL);
+
+  return dex_ref (DEX_FUTURE (dir_walker->promise));
+}
+
+/**
+ * dex_dir_entry_copy:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Returns: (transfer full): a copy of @dir_entry
+ *
+ * Since: 0.8
+ */
+DexDirEntry *
+dex_dir_entry_copy (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, NULL);
+
+  return g_memdup2 (dir_entry, sizeof *dir_entry + strlen (dir_entry->path) + 1);
+}
+
+/**
+ * dex_dir_entry_free:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Since: 0.8
+ */
+void
+dex_dir_entry_free (DexDirEntry *dir_entry)
+{
+  g_free (dir_entry);
+}
+
+/**
+ * dex_dir_entry_get_path:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Gets the path of the entry relative to the directory being walked.
+ *
+ * Returns: a relative path
+ *
+ * Since: 0.8
+ */
+const char *
+dex_dir_entry_get_path (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, NULL);
+
+  return dir_entry->path;
+}
+
+/**
+ * dex_dir_entry_get_name:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Gets the last component of the path of the entry.
+ *
+ * Returns: the file name
+ *
+ * Since: 0.8
+ */
+const char *
+dex_dir_entry_get_name (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, NULL);
+
+  return &dir_entry->path[dir_entry->name_offset];
+}
+
+/**
+ * dex_dir_entry_get_file_type:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Gets the type of file for the entry as reported by the directory
+ * listing, or from the file status if that was queried.
+ *
+ * Returns: a #GFileType
+ *
+ * Since: 0.8
+ */
+GFileType
+dex_dir_entry_get_file_type (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, G_FILE_TYPE_UNKNOWN);
+
+  return dir_entry->file_type;
+}
+
+/**
+ * dex_dir_entry_has_stat:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Checks if the file status was retrieved for the entry.
+ *
+ * See dex_dir_walker_set_query_stat().
+ *
+ * Returns: %TRUE if the mode, size, and modification time are available
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_dir_entry_has_stat (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, FALSE);
+
+  return dir_entry->has_stat;
+}
+
+/**
+ * dex_dir_entry_get_mode:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Returns: the `st_mode` of the entry, or 0 if not available
+ *
+ * Since: 0.8
+ */
+guint32
+dex_dir_entry_get_mode (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, 0);
+
+  return dir_entry->mode;
+}
+
+/**
+ * dex_dir_entry_get_inode:
+ * @dir_entry: a #DexDirEntry
+ *
+ * The inode is always available as it is part of the directory listing.
+ *
+ * Returns: the inode number of the entry
+ *
+ * Since: 0.8
+ */
+guint64
+dex_dir_entry_get_inode (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, 0);
+
+  return dir_entry->inode;
+}
+
+/**
+ * dex_dir_entry_get_size:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Returns: the size of the entry in bytes, or 0 if not available
+ *
+ * Since: 0.8
+ */
+guint64
+dex_dir_entry_get_size (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, 0);
+
+  return dir_entry->size;
+}
+
+/**
+ * dex_dir_entry_get_mtime:
+ * @dir_entry: a #DexDirEntry
+ *
+ * Returns: the modification time of the entry in seconds since the
+ *   UNIX epoch, or 0 if not available
+ *
+ * Since: 0.8
+ */
+gint64
+dex_dir_entry_get_mtime (const DexDirEntry *dir_entry)
+{
+  g_return_val_if_fail (dir_entry != NULL, 0);
+
+  return dir_entry->mtime;
+}
@@ -0,0 +1,81 @@
+/*
+ * dex-dir-walker.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "dex-channel.h"
+#include "dex-object.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_DIR_WALKER    (dex_dir_walker_get_type())
+#define DEX_DIR_WALKER(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_DIR_WALKER, DexDirWalker))
+#define DEX_IS_DIR_WALKER(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_DIR_WALKER))
+#define DEX_TYPE_DIR_ENTRY     (dex_dir_entry_get_type())
+
+typedef struct _DexDirWalker DexDirWalker;
+typedef struct _DexDirEntry  DexDirEntry;
+
+DEX_AVAILABLE_IN_ALL
+GType         dex_dir_walker_get_type       (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexDirWalker *dex_dir_walker_new            (const char        *path)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+void          dex_dir_walker_set_query_stat (DexDirWalker      *dir_walker,
+                                             gboolean           query_stat);
+DEX_AVAILABLE_IN_ALL
+DexChannel   *dex_dir_walker_create_channel (DexDirWalker      *dir_walker,
+                                             guint              capacity)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture    *dex_dir_walker_wait           (DexDirWalker      *dir_walker)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+DEX_AVAILABLE_IN_ALL
+GType         dex_dir_entry_get_type        (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexDirEntry  *dex_dir_entry_copy            (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+void          dex_dir_entry_free            (DexDirEntry       *dir_entry);
+DEX_AVAILABLE_IN_ALL
+const char   *dex_dir_entry_get_path        (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+const char   *dex_dir_entry_get_name        (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+GFileType     dex_dir_entry_get_file_type   (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+gboolean      dex_dir_entry_has_stat        (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+guint32       dex_dir_entry_get_mode        (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+guint64       dex_dir_entry_get_inode       (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+guint64       dex_dir_entry_get_size        (const DexDirEntry *dir_entry);
+DEX_AVAILABLE_IN_ALL
+gint64        dex_dir_entry_get_mtime       (const DexDirEntry *dir_entry);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexDirWalker, dex_unref)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexDirEntry, dex_dir_entry_free)
+
+G_END_DECLS
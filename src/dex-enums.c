@@ -28,3 +28,13 @@ G_DEFINE_ENUM_TYPE (DexFutureStatus, dex_future_status,
                     G_DEFINE_ENUM_VALUE (DEX_FUTURE_STATUS_PENDING, "pending"),
                     G_DEFINE_ENUM_VALUE (DEX_FUTURE_STATUS_RESOLVED, "resolved"),
                     G_DEFINE_ENUM_VALUE (DEX_FUTURE_STATUS_REJECTED, "rejected"))
+
+G_DEFINE_FLAGS_TYPE (DexChannelFlags, dex_channel_flags,
+                     G_DEFINE_ENUM_VALUE (DEX_CHANNEL_FLAGS_NONE, "none"),
+                     G_DEFINE_ENUM_VALUE (DEX_CHANNEL_FLAGS_RING, "ring"),
+                     G_DEFINE_ENUM_VALUE (DEX_CHANNEL_FLAGS_STATS, "stats"))
+
+G_DEFINE_ENUM_TYPE (DexBroadcastPolicy, dex_broadcast_policy,
+                    G_DEFINE_ENUM_VALUE (DEX_BROADCAST_POLICY_BLOCK, "block"),
+                    G_DEFINE_ENUM_VALUE (DEX_BROADCAST_POLICY_DROP_OLDEST, "drop-oldest"),
+                    G_DEFINE_ENUM_VALUE (DEX_BROADCAST_POLICY_DISCONNECT, "disconnect"))
@@ -32,6 +32,8 @@
 G_BEGIN_DECLS
 
 #define DEX_TYPE_FUTURE_STATUS (dex_future_status_get_type())
+#define DEX_TYPE_CHANNEL_FLAGS (dex_channel_flags_get_type())
+#define DEX_TYPE_BROADCAST_POLICY (dex_broadcast_policy_get_type())
 
 typedef enum _DexFutureStatus
 {
@@ -40,7 +42,49 @@ typedef enum _DexFutureStatus
   DEX_FUTURE_STATUS_REJECTED,
 } DexFutureStatus;
 
+/**
+ * DexChannelFlags:
+ * @DEX_CHANNEL_FLAGS_NONE: the default channel implementation
+ * @DEX_CHANNEL_FLAGS_RING: use a fixed-size lock-free ring buffer
+ * @DEX_CHANNEL_FLAGS_STATS: collect throughput and wait-time statistics
+ *   for dex_channel_get_stats()
+ *
+ * Flags which affect how a #DexChannel is implemented.
+ *
+ * Since: 0.8
+ */
+typedef enum _DexChannelFlags
+{
+  DEX_CHANNEL_FLAGS_NONE  = 0,
+  DEX_CHANNEL_FLAGS_RING  = 1 << 0,
+  DEX_CHANNEL_FLAGS_STATS = 1 << 1,
+} DexChannelFlags;
+
+/**
+ * DexBroadcastPolicy:
+ * @DEX_BROADCAST_POLICY_BLOCK: publishing waits for the slowest subscriber
+ * @DEX_BROADCAST_POLICY_DROP_OLDEST: subscribers which fall a full ring
+ *   behind skip the oldest items
+ * @DEX_BROADCAST_POLICY_DISCONNECT: subscribers which fall a full ring
+ *   behind are disconnected
+ *
+ * What a #DexBroadcast does when a subscriber has not read the item
+ * which a new item would overwrite.
+ *
+ * Since: 0.8
+ */
+typedef enum _DexBroadcastPolicy
+{
+  DEX_BROADCAST_POLICY_BLOCK,
+  DEX_BROADCAST_POLICY_DROP_OLDEST,
+  DEX_BROADCAST_POLICY_DISCONNECT,
+} DexBroadcastPolicy;
+
 DEX_AVAILABLE_IN_ALL
 GType dex_future_status_get_type (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+GType dex_channel_flags_get_type (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+GType dex_broadcast_policy_get_type (void) G_GNUC_CONST;
 
 G_END_DECLS
@@ -40,6 +40,7 @@ typedef enum _DexError
   DEX_ERROR_TYPE_MISMATCH,
   DEX_ERROR_TYPE_NOT_SUPPORTED,
   DEX_ERROR_FIBER_CANCELLED,
+  DEX_ERROR_SUBSCRIBER_DISCONNECTED,
 } DexError;
 
 DEX_AVAILABLE_IN_ALL
@@ -35,6 +35,7 @@
 #include "dex-future-private.h"
 #include "dex-scheduler.h"
 #include "dex-stack-private.h"
+#include "dex-stats-private.h"
 
 G_BEGIN_DECLS
 
@@ -96,6 +97,9 @@ struct _DexFiberScheduler
   /* Pooling of unused thread stacks */
   DexStackPool *stack_pool;
 
+  /* Runtime statistics */
+  DexStats stats;
+
   /* The saved context for the thread, which we return to when a
    * fiber yields back to the scheduler.
    */
@@ -27,6 +27,8 @@
 #include "dex-fiber-private.h"
 #include "dex-object-private.h"
 #include "dex-platform.h"
+#include "dex-probes-private.h"
+#include "dex-profiler.h"
 #include "dex-thread-storage-private.h"
 
 /**
@@ -272,6 +274,7 @@ static gboolean
 dex_fiber_scheduler_iteration (DexFiberScheduler *fiber_scheduler)
 {
   DexFiber *fiber;
+  gint64 begin_time = 0;
 
   g_assert (fiber_scheduler != NULL);
 
@@ -292,13 +295,32 @@ dex_fiber_scheduler_iteration (DexFiberScheduler *fiber_scheduler)
   if (fiber == NULL)
     return FALSE;
 
+  dex_stats_counter_add (&fiber_scheduler->stats.fiber_switches, 1);
+
+  if (DEX_PROFILER_ACTIVE)
+    begin_time = DEX_PROFILER_CURRENT_TIME;
+
+  DEX_PROBE2 (fiber_switch, fiber, DEX_FUTURE (fiber)->name);
+
   dex_fiber_context_switch (&fiber_scheduler->context, &fiber->context);
 
+  /* Covers the fiber being switched in until it yields back to us */
+  if (begin_time != 0)
+    {
+      gint64 duration = DEX_PROFILER_CURRENT_TIME - begin_time;
+
+      DEX_PROFILER_MARK (duration,
+                         "DexFiber",
+                         DEX_FUTURE (fiber)->name ? DEX_FUTURE (fiber)->name : "run");
+    }
+
   g_mutex_lock (&fiber_scheduler->mutex);
   fiber->running = FALSE;
   fiber_scheduler->running = NULL;
   if (!fiber->released && fiber->exited)
     {
+      DEX_PROBE2 (fiber_exit, fiber, DEX_FUTURE (fiber)->name);
+
       g_queue_unlink (&fiber_scheduler->runnable, &fiber->link);
 
       if (fiber->stack->size == fiber_scheduler->stack_pool->stack_size)
@@ -348,6 +370,8 @@ dex_fiber_scheduler_finalize (GSource *source)
 {
   DexFiberScheduler *fiber_scheduler = (DexFiberScheduler *)source;
 
+  dex_stats_unregister (&fiber_scheduler->stats);
+
   g_clear_pointer (&fiber_scheduler->stack_pool, dex_stack_pool_free);
   g_mutex_clear (&fiber_scheduler->mutex);
 
@@ -358,6 +382,18 @@ dex_fiber_scheduler_finalize (GSource *source)
     }
 }
 
+static void
+dex_fiber_scheduler_sample_stats (DexStats          *stats,
+                                  DexSchedulerStats *out_stats)
+{
+  DexFiberScheduler *fiber_scheduler = (DexFiberScheduler *)(gpointer)((guint8 *)stats - G_STRUCT_OFFSET (DexFiberScheduler, stats));
+
+  g_mutex_lock (&fiber_scheduler->mutex);
+  out_stats->n_fibers_runnable += fiber_scheduler->runnable.length;
+  out_stats->n_fibers_blocked += fiber_scheduler->blocked.length;
+  g_mutex_unlock (&fiber_scheduler->mutex);
+}
+
 /**
  * dex_fiber_scheduler_new:
  *
@@ -387,6 +423,8 @@ dex_fiber_scheduler_new (void)
   g_mutex_init (&fiber_scheduler->mutex);
   fiber_scheduler->stack_pool = dex_stack_pool_new (0, 0, 0);
 
+  dex_stats_register (&fiber_scheduler->stats, dex_fiber_scheduler_sample_stats);
+
   return fiber_scheduler;
 }
 
@@ -411,6 +449,10 @@ dex_fiber_scheduler_register (DexFiberScheduler *fiber_scheduler,
   g_queue_push_tail_link (&fiber_scheduler->runnable, &fiber->link);
   g_mutex_unlock (&fiber_scheduler->mutex);
 
+  dex_stats_counter_add (&fiber_scheduler->stats.fibers_spawned, 1);
+
+  DEX_PROBE2 (fiber_spawn, fiber, fiber_scheduler);
+
   if (dex_thread_storage_get ()->fiber_scheduler != fiber_scheduler)
     g_main_context_wakeup (g_source_get_context ((GSource *)fiber_scheduler));
 }
@@ -0,0 +1,740 @@
+/*
+ * dex-file-copy-tree.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
+
+#include "dex-aio.h"
+#include "dex-dir-walker.h"
+#include "dex-file-copy-tree.h"
+#include "dex-scheduler.h"
+#include "dex-semaphore-private.h"
+#include "dex-thread-pool-scheduler.h"
+
+#define DEFAULT_MAX_FILES_IN_FLIGHT 64
+#define DEFAULT_MAX_BYTES_IN_FLIGHT (256*1024*1024)
+#define COPY_FILE_RANGE_CHUNK_SIZE  (16*1024*1024)
+#define AIO_CHUNK_SIZE              (1024*1024)
+
+typedef enum _CopyResult
+{
+  COPY_OK,
+  COPY_UNSUPPORTED,
+  COPY_FAILED,
+} CopyResult;
+
+typedef struct _CopyTree
+{
+  char                    *source;
+  char                    *destination;
+
+  DexDirWalker            *dir_walker;
+
+  /* Posted every time a file copy completes */
+  DexSemaphore            *completed;
+
+  DexScheduler            *progress_scheduler;
+  DexFileCopyTreeProgress  progress;
+  gpointer                 progress_data;
+  GDestroyNotify           progress_data_destroy;
+
+  guint                    max_files_in_flight;
+  guint64                  max_bytes_in_flight;
+
+  guint                    n_files_in_flight;
+  guint                    progress_queued;
+
+  /* Protects the fields below */
+  GMutex                   mutex;
+  GError                  *error;
+  guint64                  n_bytes_in_flight;
+  guint64                  n_files;
+  guint64                  n_bytes;
+} CopyTree;
+
+typedef struct _CopyFile
+{
+  CopyTree *copy_tree;
+  char     *path;
+  guint64   size;
+  guint32   mode;
+} CopyFile;
+
+static void
+copy_tree_finalize (gpointer data)
+{
+  CopyTree *copy_tree = data;
+
+  /* Destroy the progress data where the callback would have run */
+  if (copy_tree->progress_data_destroy != NULL)
+    dex_scheduler_push (copy_tree->progress_scheduler,
+                        copy_tree->progress_data_destroy,
+                        copy_tree->progress_data);
+
+  g_clear_pointer (&copy_tree->source, g_free);
+  g_clear_pointer (&copy_tree->destination, g_free);
+  g_clear_error (&copy_tree->error);
+  g_mutex_clear (&copy_tree->mutex);
+
+  dex_clear (&copy_tree->dir_walker);
+  dex_clear (&copy_tree->completed);
+  dex_clear (&copy_tree->progress_scheduler);
+}
+
+static CopyTree *
+copy_tree_ref (CopyTree *copy_tree)
+{
+  return g_atomic_rc_box_acquire (copy_tree);
+}
+
+static void
+copy_tree_unref (CopyTree *copy_tree)
+{
+  g_atomic_rc_box_release_full (copy_tree, copy_tree_finalize);
+}
+
+static void
+copy_tree_take_error (CopyTree *copy_tree,
+                      GError   *error)
+{
+  g_mutex_lock (&copy_tree->mutex);
+  if (copy_tree->error == NULL)
+    copy_tree->error = g_steal_pointer (&error);
+  g_mutex_unlock (&copy_tree->mutex);
+
+  g_clear_error (&error);
+}
+
+static void
+copy_tree_set_errno (CopyTree   *copy_tree,
+                     const char *path,
+                     int         errsv)
+{
+  copy_tree_take_error (copy_tree,
+                        g_error_new (G_IO_ERROR,
+                                     g_io_error_from_errno (errsv),
+                                     "%s: %s",
+                                     path, g_strerror (errsv)));
+}
+
+static gboolean
+copy_tree_has_error (CopyTree *copy_tree)
+{
+  gboolean ret;
+
+  g_mutex_lock (&copy_tree->mutex);
+  ret = copy_tree->error != NULL;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  return ret;
+}
+
+static void
+copy_tree_report_progress (gpointer data)
+{
+  CopyTree *copy_tree = data;
+  guint64 n_files;
+  guint64 n_bytes;
+
+  /* Clear first so that progress made while the callback runs is
+   * reported again afterwards.
+   */
+  g_atomic_int_set (&copy_tree->progress_queued, FALSE);
+
+  g_mutex_lock (&copy_tree->mutex);
+  n_files = copy_tree->n_files;
+  n_bytes = copy_tree->n_bytes;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  copy_tree->progress (n_files, n_bytes, copy_tree->progress_data);
+
+  copy_tree_unref (copy_tree);
+}
+
+static void
+copy_tree_queue_progress (CopyTree *copy_tree)
+{
+  /* Coalesce updates so that at most one report is pending at a time */
+  if (copy_tree->progress != NULL &&
+      g_atomic_int_compare_and_exchange (&copy_tree->progress_queued, FALSE, TRUE))
+    dex_scheduler_push (copy_tree->progress_scheduler,
+                        copy_tree_report_progress,
+                        copy_tree_ref (copy_tree));
+}
+
+static void
+copy_tree_add_bytes (CopyTree *copy_tree,
+                     guint64   n_bytes)
+{
+  g_mutex_lock (&copy_tree->mutex);
+  copy_tree->n_bytes += n_bytes;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  copy_tree_queue_progress (copy_tree);
+}
+
+static CopyResult
+copy_file_clone (CopyFile *copy_file,
+                 int       src_fd,
+                 int       dst_fd)
+{
+#ifdef FICLONE
+  /* Reflink shares the extents on filesystems like Btrfs and XFS so no
+   * data is copied at all.
+   */
+  if (ioctl (dst_fd, FICLONE, src_fd) == 0)
+    {
+      copy_tree_add_bytes (copy_file->copy_tree, copy_file->size);
+      return COPY_OK;
+    }
+#endif
+
+  return COPY_UNSUPPORTED;
+}
+
+static CopyResult
+copy_file_copy_range (CopyFile *copy_file,
+                      int       src_fd,
+                      int       dst_fd)
+{
+#ifdef HAVE_COPY_FILE_RANGE
+  gboolean first = TRUE;
+
+  /* Copied within the kernel, and offloaded to the server or device
+   * when the filesystem supports it.
+   */
+  for (;;)
+    {
+      gssize n_copied = copy_file_range (src_fd, NULL, dst_fd, NULL, COPY_FILE_RANGE_CHUNK_SIZE, 0);
+
+      if (n_copied == 0)
+        return COPY_OK;
+
+      if (n_copied < 0)
+        {
+          int errsv = errno;
+
+          if (errsv == EINTR)
+            continue;
+
+          /* Nothing has been written yet, so we can still fallback */
+          if (first &&
+              (errsv == ENOSYS || errsv == EXDEV || errsv == EINVAL ||
+               errsv == EOPNOTSUPP || errsv == EPERM))
+            return COPY_UNSUPPORTED;
+
+          copy_tree_set_errno (copy_file->copy_tree, copy_file->path, errsv);
+          return COPY_FAILED;
+        }
+
+      first = FALSE;
+      copy_tree_add_bytes (copy_file->copy_tree, n_copied);
+    }
+#else
+  return COPY_UNSUPPORTED;
+#endif
+}
+
+static CopyResult
+copy_file_aio (CopyFile *copy_file,
+               int       src_fd,
+               int       dst_fd)
+{
+  g_autofree guint8 *buffer = g_malloc (AIO_CHUNK_SIZE);
+  goffset offset = 0;
+  GError *error = NULL;
+
+  for (;;)
+    {
+      gssize n_read;
+      gsize n_written = 0;
+
+      n_read = dex_await_int64 (dex_aio_read (NULL, src_fd, buffer, AIO_CHUNK_SIZE, offset), &error);
+
+      if (n_read < 0 || error != NULL)
+        goto failure;
+
+      if (n_read == 0)
+        return COPY_OK;
+
+      while (n_written < (gsize)n_read)
+        {
+          gssize n;
+
+          n = dex_await_int64 (dex_aio_write (NULL, dst_fd,
+                                              buffer + n_written,
+                                              n_read - n_written,
+                                              offset + n_written),
+                               &error);
+
+          if (n <= 0 || error != NULL)
+            goto failure;
+
+          n_written += n;
+        }
+
+      offset += n_read;
+      copy_tree_add_bytes (copy_file->copy_tree, n_read);
+    }
+
+failure:
+  if (error == NULL)
+    error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED, "Short write");
+
+  copy_tree_take_error (copy_file->copy_tree,
+                        g_error_new (error->domain,
+                                     error->code,
+                                     "%s: %s",
+                                     copy_file->path, error->message));
+  g_clear_error (&error);
+
+  return COPY_FAILED;
+}
+
+static void
+copy_file_free (gpointer data)
+{
+  CopyFile *copy_file = data;
+
+  g_clear_pointer (&copy_file->copy_tree, copy_tree_unref);
+  g_clear_pointer (&copy_file->path, g_free);
+  g_free (copy_file);
+}
+
+static DexFuture *
+copy_file_fiber (gpointer user_data)
+{
+  CopyFile *copy_file = user_data;
+  CopyTree *copy_tree = copy_file->copy_tree;
+  g_autofree char *src_path = g_build_filename (copy_tree->source, copy_file->path, NULL);
+  g_autofree char *dst_path = g_build_filename (copy_tree->destination, copy_file->path, NULL);
+  int src_fd = -1;
+  int dst_fd = -1;
+
+  if (-1 == (src_fd = open (src_path, O_RDONLY | O_CLOEXEC)))
+    {
+      copy_tree_set_errno (copy_tree, src_path, errno);
+      goto cleanup;
+    }
+
+  if (-1 == (dst_fd = open (dst_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, copy_file->mode & 0777)))
+    {
+      copy_tree_set_errno (copy_tree, dst_path, errno);
+      goto cleanup;
+    }
+
+  if (copy_file_clone (copy_file, src_fd, dst_fd) == COPY_UNSUPPORTED &&
+      copy_file_copy_range (copy_file, src_fd, dst_fd) == COPY_UNSUPPORTED)
+    copy_file_aio (copy_file, src_fd, dst_fd);
+
+cleanup:
+  if (src_fd != -1)
+    close (src_fd);
+
+  if (dst_fd != -1 && close (dst_fd) != 0)
+    copy_tree_set_errno (copy_tree, dst_path, errno);
+
+  g_mutex_lock (&copy_tree->mutex);
+  copy_tree->n_bytes_in_flight -= copy_file->size;
+  copy_tree->n_files++;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  g_atomic_int_add (&copy_tree->n_files_in_flight, -1);
+  dex_semaphore_post (copy_tree->completed);
+
+  copy_tree_queue_progress (copy_tree);
+
+  return NULL;
+}
+
+static gboolean
+copy_tree_can_start (CopyTree *copy_tree,
+                     guint64   size)
+{
+  guint n_files_in_flight = g_atomic_int_get (&copy_tree->n_files_in_flight);
+  guint64 n_bytes_in_flight;
+
+  /* Always allow a single file, however large it may be */
+  if (n_files_in_flight == 0)
+    return TRUE;
+
+  if (n_files_in_flight >= copy_tree->max_files_in_flight)
+    return FALSE;
+
+  g_mutex_lock (&copy_tree->mutex);
+  n_bytes_in_flight = copy_tree->n_bytes_in_flight;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  return n_bytes_in_flight + size <= copy_tree->max_bytes_in_flight;
+}
+
+static void
+copy_tree_start_file (CopyTree          *copy_tree,
+                      const DexDirEntry *dir_entry)
+{
+  CopyFile *copy_file;
+  guint64 size = dex_dir_entry_get_size (dir_entry);
+
+  /* Only this fiber starts copies, and only the copies decrement the
+   * counters, so nothing can sneak in between the check and start.
+   */
+  while (!copy_tree_can_start (copy_tree, size))
+    dex_await (dex_semaphore_wait (copy_tree->completed), NULL);
+
+  g_mutex_lock (&copy_tree->mutex);
+  copy_tree->n_bytes_in_flight += size;
+  g_mutex_unlock (&copy_tree->mutex);
+
+  g_atomic_int_inc (&copy_tree->n_files_in_flight);
+
+  copy_file = g_new0 (CopyFile, 1);
+  copy_file->copy_tree = copy_tree_ref (copy_tree);
+  copy_file->path = g_strdup (dex_dir_entry_get_path (dir_entry));
+  copy_file->size = size;
+  copy_file->mode = dex_dir_entry_get_mode (dir_entry);
+
+  dex_future_disown (dex_scheduler_spawn (dex_thread_pool_scheduler_get_default (),
+                                          0,
+                                          copy_file_fiber,
+                                          copy_file,
+                                          copy_file_free));
+}
+
+static gboolean
+copy_tree_ensure_directory (CopyTree   *copy_tree,
+                            GHashTable *directories,
+                            const char *path,
+                            guint32     mode)
+{
+  g_autofree char *full_path = NULL;
+  g_autofree char *parent = NULL;
+
+  if (path[0] == 0 || g_str_equal (path, "."))
+    return TRUE;
+
+  /* The walker may report a directory after its children, in which case
+   * it was created with a default mode. Either way the mode of the source
+   * is only applied by copy_tree_restore_modes() once the children have
+   * been copied.
+   */
+  if (g_hash_table_contains (directories, path))
+    {
+      if (mode != 0)
+        g_hash_table_insert (directories, g_strdup (path), GUINT_TO_POINTER (mode));
+
+      return TRUE;
+    }
+
+  full_path = g_build_filename (copy_tree->destination, path, NULL);
+
+  parent = g_path_get_dirname (path);
+
+  if (!copy_tree_ensure_directory (copy_tree, directories, parent, 0))
+    return FALSE;
+
+  /* Keep the directory writable by us so that it can be populated */
+  if (mkdir (full_path, mode != 0 ? ((mode & 07777) | S_IRWXU) : 0755) != 0 &&
+      errno != EEXIST)
+    {
+      copy_tree_set_errno (copy_tree, full_path, errno);
+      return FALSE;
+    }
+
+  g_hash_table_insert (directories, g_strdup (path), GUINT_TO_POINTER (mode));
+
+  return TRUE;
+}
+
+static int
+compare_by_length_descending (gconstpointer a,
+                              gconstpointer b)
+{
+  gsize a_len = strlen (*(const char * const *)a);
+  gsize b_len = strlen (*(const char * const *)b);
+
+  return a_len < b_len ? 1 : a_len > b_len ? -1 : 0;
+}
+
+/* Directories are created writable by us so that they can be populated.
+ * Apply the source modes once everything has been copied, children
+ * before their parents as a parent may lose the search permission.
+ */
+static void
+copy_tree_restore_modes (CopyTree   *copy_tree,
+                         GHashTable *directories,
+                         guint32     root_mode)
+{
+  g_autofree const char **paths = NULL;
+  guint n_paths;
+
+  paths = (const char **)g_hash_table_get_keys_as_array (directories, &n_paths);
+  qsort (paths, n_paths, sizeof (char *), compare_by_length_descending);
+
+  for (guint i = 0; i < n_paths; i++)
+    {
+      guint32 mode = GPOINTER_TO_UINT (g_hash_table_lookup (directories, paths[i]));
+      g_autofree char *full_path = NULL;
+
+      if (mode == 0 || (mode & S_IRWXU) == S_IRWXU)
+        continue;
+
+      full_path = g_build_filename (copy_tree->destination, paths[i], NULL);
+
+      if (chmod (full_path, mode & 07777) != 0)
+        copy_tree_set_errno (copy_tree, full_path, errno);
+    }
+
+  if ((root_mode & S_IRWXU) != S_IRWXU &&
+      chmod (copy_tree->destination, root_mode & 07777) != 0)
+    copy_tree_set_errno (copy_tree, copy_tree->destination, errno);
+}
+
+static void
+copy_tree_symlink (CopyTree          *copy_tree,
+                   const DexDirEntry *dir_entry)
+{
+  g_autofree char *src_path = g_build_filename (copy_tree->source, dex_dir_entry_get_path (dir_entry), NULL);
+  g_autofree char *dst_path = g_build_filename (copy_tree->destination, dex_dir_entry_get_path (dir_entry), NULL);
+  g_autofree char *target = NULL;
+  GError *error = NULL;
+
+  if (!(target = g_file_read_link (src_path, &error)))
+    copy_tree_take_error (copy_tree, error);
+  else if (symlink (target, dst_path) != 0)
+    copy_tree_set_errno (copy_tree, dst_path, errno);
+}
+
+static void
+copy_tree_entry (CopyTree          *copy_tree,
+                 GHashTable        *directories,
+                 const DexDirEntry *dir_entry)
+{
+  const char *path = dex_dir_entry_get_path (dir_entry);
+  g_autofree char *parent = NULL;
+
+  if (dex_dir_entry_get_file_type (dir_entry) == G_FILE_TYPE_DIRECTORY)
+    {
+      copy_tree_ensure_directory (copy_tree, directories, path, dex_dir_entry_get_mode (dir_entry));
+      return;
+    }
+
+  parent = g_path_get_dirname (path);
+
+  if (!copy_tree_ensure_directory (copy_tree, directories, parent, 0))
+    return;
+
+  switch (dex_dir_entry_get_file_type (dir_entry))
+    {
+    case G_FILE_TYPE_REGULAR:
+      copy_tree_start_file (copy_tree, dir_entry);
+      break;
+
+    case G_FILE_TYPE_SYMBOLIC_LINK:
+      copy_tree_symlink (copy_tree, dir_entry);
+      break;
+
+    case G_FILE_TYPE_SPECIAL:
+      /* Fifos, sockets and device nodes are skipped, see dex_file_copy_tree() */
+      break;
+
+    case G_FILE_TYPE_UNKNOWN:
+    case G_FILE_TYPE_DIRECTORY:
+    case G_FILE_TYPE_SHORTCUT:
+    case G_FILE_TYPE_MOUNTABLE:
+    default:
+      copy_tree_take_error (copy_tree,
+                            g_error_new (G_IO_ERROR,
+                                         G_IO_ERROR_NOT_SUPPORTED,
+                                         "%s: Cannot copy special file",
+                                         path));
+      break;
+    }
+}
+
+static DexFuture *
+copy_tree_fiber (gpointer user_data)
+{
+  CopyTree *copy_tree = user_data;
+  g_autoptr(GHashTable) directories = NULL;
+  g_autoptr(DexChannel) channel = NULL;
+  struct stat stbuf;
+  GError *error = NULL;
+
+  if (stat (copy_tree->source, &stbuf) != 0)
+    {
+      int errsv = errno;
+      return dex_future_new_reject (G_IO_ERROR,
+                                    g_io_error_from_errno (errsv),
+                                    "%s: %s",
+                                    copy_tree->source, g_strerror (errsv));
+    }
+
+  if (!S_ISDIR (stbuf.st_mode))
+    return dex_future_new_reject (G_IO_ERROR,
+                                  G_IO_ERROR_NOT_DIRECTORY,
+                                  "%s: Not a directory",
+                                  copy_tree->source);
+
+  if (mkdir (copy_tree->destination, (stbuf.st_mode & 07777) | S_IRWXU) != 0 &&
+      errno != EEXIST)
+    {
+      int errsv = errno;
+      return dex_future_new_reject (G_IO_ERROR,
+                                    g_io_error_from_errno (errsv),
+                                    "%s: %s",
+                                    copy_tree->destination, g_strerror (errsv));
+    }
+
+  directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  copy_tree->dir_walker = dex_dir_walker_new (copy_tree->source);
+  dex_dir_walker_set_query_stat (copy_tree->dir_walker, TRUE);
+  channel = dex_dir_walker_create_channel (copy_tree->dir_walker, 4);
+
+  while (!copy_tree_has_error (copy_tree))
+    {
+      g_autoptr(GPtrArray) batch = dex_await_boxed (dex_channel_receive (channel), NULL);
+
+      if (batch == NULL)
+        break;
+
+      for (guint i = 0; i < batch->len; i++)
+        copy_tree_entry (copy_tree, directories, g_ptr_array_index (batch, i));
+    }
+
+  /* Stops the walk early if we failed */
+  dex_channel_close_receive (channel);
+
+  while (g_atomic_int_get (&copy_tree->n_files_in_flight) > 0)
+    dex_await (dex_semaphore_wait (copy_tree->completed), NULL);
+
+  if (!dex_await (dex_dir_walker_wait (copy_tree->dir_walker), &error))
+    copy_tree_take_error (copy_tree, g_steal_pointer (&error));
+
+  /* A partial copy is left writable so that it can be removed */
+  if (!copy_tree_has_error (copy_tree))
+    copy_tree_restore_modes (copy_tree, directories, stbuf.st_mode);
+
+  copy_tree_queue_progress (copy_tree);
+
+  g_mutex_lock (&copy_tree->mutex);
+  error = g_steal_pointer (&copy_tree->error);
+  g_mutex_unlock (&copy_tree->mutex);
+
+  if (error != NULL)
+    return dex_future_new_for_error (error);
+
+  return dex_future_new_for_uint64 (copy_tree->n_bytes);
+}
+
+/**
+ * dex_file_copy_tree:
+ * @source: a #GFile for a local directory
+ * @destination: a #GFile for the directory to create
+ * @max_files_in_flight: the maximum number of files to copy at once,
+ *   or 0 for the default
+ * @max_bytes_in_flight: the maximum number of bytes in files being
+ *   copied at once, or 0 for the default
+ * @progress: (nullable) (scope notified): a callback for progress
+ * @progress_data: closure data for @progress
+ * @progress_data_destroy: (nullable): destroy notify for @progress_data
+ *
+ * Recursively copies the directory @source to @destination.
+ *
+ * The tree is enumerated with #DexDirWalker and each regular file is
+ * copied by a fiber on the default #DexThreadPoolScheduler. Files are
+ * cloned with `FICLONE` when the filesystem supports reflinks, copied
+ * within the kernel with `copy_file_range()` when possible, and
+ * otherwise copied with dex_aio_read() and dex_aio_write().
+ *
+ * At most @max_files_in_flight files are copied concurrently and new
+ * copies are not started while the combined size of the files in
+ * flight would exceed @max_bytes_in_flight. A single file larger than
+ * @max_bytes_in_flight is still copied, just not alongside others.
+ *
+ * Symbolic links are copied as links. Fifos, sockets and device nodes
+ * are skipped rather than failing the copy, as reading a fifo could block
+ * forever and creating device nodes usually requires privileges.
+ * Ownership, timestamps, and extended attributes are not preserved, just
+ * like `cp -r`.
+ *
+ * Directories are kept writable while their contents are copied and are
+ * given the mode of the source directory once the copy succeeds.
+ *
+ * @progress is called on the scheduler of the calling thread. Updates
+ * are coalesced so it may not be called for every file.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to the number of
+ *   bytes copied as a #guint64 or rejects with the first error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_file_copy_tree (GFile                   *source,
+                    GFile                   *destination,
+                    guint                    max_files_in_flight,
+                    guint64                  max_bytes_in_flight,
+                    DexFileCopyTreeProgress  progress,
+                    gpointer                 progress_data,
+                    GDestroyNotify           progress_data_destroy)
+{
+  CopyTree *copy_tree;
+
+  g_return_val_if_fail (G_IS_FILE (source), NULL);
+  g_return_val_if_fail (G_IS_FILE (destination), NULL);
+
+  if (!g_file_is_native (source) || !g_file_is_native (destination))
+    return dex_future_new_reject (G_IO_ERROR,
+                                  G_IO_ERROR_NOT_SUPPORTED,
+                                  "Only local files may be copied as a tree");
+
+  copy_tree = g_atomic_rc_box_new0 (CopyTree);
+  g_mutex_init (&copy_tree->mutex);
+  copy_tree->source = g_file_get_path (source);
+  copy_tree->destination = g_file_get_path (destination);
+  copy_tree->completed = dex_semaphore_new ();
+  copy_tree->progress_scheduler = dex_scheduler_ref_thread_default ();
+  copy_tree->progress = progress;
+  copy_tree->progress_data = progress_data;
+  copy_tree->progress_data_destroy = progress_data_destroy;
+  copy_tree->max_files_in_flight = max_files_in_flight ? max_files_in_flight : DEFAULT_MAX_FILES_IN_FLIGHT;
+  copy_tree->max_bytes_in_flight = max_bytes_in_flight ? max_bytes_in_flight : DEFAULT_MAX_BYTES_IN_FLIGHT;
+
+  if (copy_tree->progress_scheduler == NULL)
+    copy_tree->progress_scheduler = dex_ref (dex_scheduler_get_default ());
+
+  return dex_scheduler_spawn (dex_thread_pool_scheduler_get_default (),
+                              0,
+                              copy_tree_fiber,
+                              copy_tree,
+                              (GDestroyNotify)copy_tree_unref);
+}
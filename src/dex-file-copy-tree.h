@@ -0,0 +1,54 @@
+/*
+ * dex-file-copy-tree.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "dex-future.h"
+
+G_BEGIN_DECLS
+
+/**
+ * DexFileCopyTreeProgress:
+ * @n_files: the number of files copied so far
+ * @n_bytes: the number of bytes copied so far
+ * @user_data: closure data for the callback
+ *
+ * Reports progress from dex_file_copy_tree().
+ *
+ * Since: 0.8
+ */
+typedef void (*DexFileCopyTreeProgress) (guint64  n_files,
+                                         guint64  n_bytes,
+                                         gpointer user_data);
+
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_file_copy_tree (GFile                   *source,
+                               GFile                   *destination,
+                               guint                    max_files_in_flight,
+                               guint64                  max_bytes_in_flight,
+                               DexFileCopyTreeProgress  progress,
+                               gpointer                 progress_data,
+                               GDestroyNotify           progress_data_destroy)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_END_DECLS
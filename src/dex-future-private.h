@@ -50,6 +50,9 @@ typedef struct _DexFutureClass
   gboolean (*propagate) (DexFuture *future,
                          DexFuture *completed);
   void     (*discard)   (DexFuture *future);
+
+  /* Instances resolved or rejected, for runtime statistics */
+  DexStatsCounter n_completed;
 } DexFutureClass;
 
 void          dex_future_chain         (DexFuture     *future,
@@ -64,4 +67,11 @@ void          dex_future_discard       (DexFuture     *future,
 const GValue *dex_await_borrowed       (DexFuture     *future,
                                         GError       **error);
 
+static inline void
+dex_future_count_completed (DexFuture *future)
+{
+  if (DEX_OBJECT_TYPE_STATS_ENABLED)
+    dex_stats_counter_add (&((DexFutureClass *)((GTypeInstance *)future)->g_class)->n_completed, 1);
+}
+
 G_END_DECLS
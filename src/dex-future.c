@@ -28,6 +28,7 @@
 #include "dex-future-private.h"
 #include "dex-future-set-private.h"
 #include "dex-infinite-private.h"
+#include "dex-probes-private.h"
 #include "dex-promise.h"
 #include "dex-scheduler.h"
 #include "dex-static-future-private.h"
@@ -134,6 +135,10 @@ dex_future_complete (DexFuture    *future,
 
       queue = future->chained;
       future->chained = (GQueue) {NULL, NULL, 0};
+
+      dex_future_count_completed (future);
+
+      DEX_PROBE3 (future_complete, future, future->name, (int)future->status);
     }
   else
     {
@@ -323,6 +328,7 @@ dex_future_class_init (DexFutureClass *klass)
 static void
 dex_future_init (DexFuture *future)
 {
+  DEX_PROBE1 (future_create, future);
 }
 
 static void
@@ -370,6 +376,8 @@ dex_future_chain (DexFuture *future,
   g_return_if_fail (DEX_IS_FUTURE (future));
   g_return_if_fail (DEX_IS_FUTURE (chained));
 
+  DEX_PROBE2 (future_chain, future, chained);
+
   dex_object_lock (future);
   if (future->status == DEX_FUTURE_STATUS_PENDING)
     {
@@ -1751,3 +1759,74 @@ dex_future_disown (DexFuture *future)
                                  (GDestroyNotify)pfuture_unref);
   pfuture_unref (pfuture);
 }
+
+static void
+dex_future_foreach_type_stats_recurse (GType                   type,
+                                       DexFutureTypeStatsFunc  func,
+                                       gpointer                user_data)
+{
+  DexFutureClass *future_class;
+  GType *children;
+  guint n_children;
+
+  /* Types without a class have never been instantiated */
+  if ((future_class = g_type_class_peek (type)))
+    {
+      guint64 n_created = dex_stats_counter_get (&DEX_OBJECT_CLASS (future_class)->n_created);
+      guint64 n_completed = dex_stats_counter_get (&future_class->n_completed);
+
+      if (n_created > 0 || n_completed > 0)
+        func (type, n_created, n_completed, user_data);
+    }
+
+  children = g_type_children (type, &n_children);
+  for (guint i = 0; i < n_children; i++)
+    dex_future_foreach_type_stats_recurse (children[i], func, user_data);
+  g_free (children);
+}
+
+/**
+ * dex_future_foreach_type_stats:
+ * @func: (scope call): a #DexFutureTypeStatsFunc
+ * @user_data: closure data for @func
+ *
+ * Calls @func for every #DexFuture subclass that has been instantiated
+ * with the number of instances created and completed.
+ *
+ * Only instances created and completed while type statistics are enabled
+ * with dex_future_set_type_stats_enabled() are counted.
+ *
+ * Counters are updated atomically but independently of each other and
+ * therefore may be slightly out of date relative to each other.
+ *
+ * Since: 0.8
+ */
+void
+dex_future_foreach_type_stats (DexFutureTypeStatsFunc func,
+                               gpointer               user_data)
+{
+  g_return_if_fail (func != NULL);
+
+  dex_future_foreach_type_stats_recurse (DEX_TYPE_FUTURE, func, user_data);
+}
+
+/**
+ * dex_future_set_type_stats_enabled:
+ * @enabled: if futures should be counted per type
+ *
+ * Enables or disables counting the futures created and completed for
+ * each #DexFuture subclass.
+ *
+ * The counters are shared by every thread, which makes them a point of
+ * contention when creating futures at a high rate from many threads, so
+ * they are disabled by default. Enable them before the work of interest
+ * and read them with dex_future_foreach_type_stats() or
+ * dex_scheduler_get_global_stats().
+ *
+ * Since: 0.8
+ */
+void
+dex_future_set_type_stats_enabled (gboolean enabled)
+{
+  g_atomic_int_set (&dex_object_type_stats_enabled, !!enabled);
+}
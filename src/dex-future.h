@@ -56,6 +56,22 @@ typedef struct _DexFuture DexFuture;
 typedef DexFuture *(*DexFutureCallback) (DexFuture *future,
                                          gpointer   user_data);
 
+/**
+ * DexFutureTypeStatsFunc:
+ * @type: a #GType deriving from #DexFuture
+ * @n_created: the number of instances of @type created
+ * @n_completed: the number of instances of @type that resolved or rejected
+ * @user_data: closure data provided to dex_future_foreach_type_stats()
+ *
+ * Callback for dex_future_foreach_type_stats().
+ *
+ * Since: 0.8
+ */
+typedef void (*DexFutureTypeStatsFunc) (GType    type,
+                                        guint64  n_created,
+                                        guint64  n_completed,
+                                        gpointer user_data);
+
 DEX_AVAILABLE_IN_ALL
 GType            dex_future_get_type        (void) G_GNUC_CONST;
 DEX_AVAILABLE_IN_ALL
@@ -256,6 +272,11 @@ DEX_AVAILABLE_IN_ALL
 gpointer         dex_await_object           (DexFuture          *future,
                                              GError            **error)
   G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+void             dex_future_foreach_type_stats (DexFutureTypeStatsFunc  func,
+                                                gpointer                user_data);
+DEX_AVAILABLE_IN_ALL
+void             dex_future_set_type_stats_enabled (gboolean enabled);
 
 #if G_GNUC_CHECK_VERSION(3,0) && defined(DEX_ENABLE_DEBUG)
 # define _DEX_FUTURE_NEW_(func, counter, ...) \
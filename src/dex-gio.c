@@ -21,11 +21,20 @@
 
 #include "config.h"
 
+#ifdef HAVE_MADVISE
+# include <sys/mman.h>
+#endif
+
+#include "dex-aio.h"
+#include "dex-aio-buffer-pool-private.h"
 #include "dex-async-pair-private.h"
 #include "dex-future-private.h"
 #include "dex-future-set.h"
 #include "dex-gio.h"
 #include "dex-promise.h"
+#include "dex-scheduler.h"
+#include "dex-thread-pool-scheduler.h"
+#include "dex-timeout.h"
 
 typedef struct _DexFileInfoList DexFileInfoList;
 
@@ -66,7 +75,7 @@ create_async_pair (const char *name)
 {
   DexAsyncPair *async_pair;
 
-  async_pair = (DexAsyncPair *)dex_object_create_instance (DEX_TYPE_ASYNC_PAIR);
+  async_pair = dex_async_pair_create ();
   dex_future_set_static_name (DEX_FUTURE (async_pair), name);
 
   return async_pair;
@@ -301,6 +310,45 @@ dex_input_stream_read (GInputStream *self,
   return DEX_FUTURE (async_pair);
 }
 
+/**
+ * dex_input_stream_read_bytes_pooled:
+ * @self: a #GInputStream
+ * @count: the maximum number of bytes to read
+ * @io_priority: the I/O priority of the request
+ *
+ * Like dex_input_stream_read_bytes() but reads into a buffer from the
+ * shared #DexAioBufferPool for that size instead of allocating a new
+ * buffer for each read.
+ *
+ * The buffer is returned to the pool once the resulting #GBytes (and any
+ * views of it) are released. Short reads yield a view of the buffer
+ * which still holds the entire buffer, so copy the data if it is to be
+ * retained for a long time.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to a #GBytes,
+ *   which is empty at the end of the stream, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_input_stream_read_bytes_pooled (GInputStream *self,
+                                    gsize         count,
+                                    int           io_priority)
+{
+  GBytes *buffer;
+  gpointer data;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (self), NULL);
+
+  buffer = dex_aio_buffer_pool_acquire_for_size (count);
+
+  /* We are the only owner of the lease so it is safe to write to */
+  data = (gpointer)g_bytes_get_data (buffer, NULL);
+
+  return dex_aio_buffer_pool_wrap_read (dex_input_stream_read (self, data, count, io_priority),
+                                        buffer);
+}
+
 static void
 dex_input_stream_skip_cb (GObject      *object,
                           GAsyncResult *result,
@@ -395,6 +443,64 @@ dex_output_stream_write (GOutputStream *self,
   return DEX_FUTURE (async_pair);
 }
 
+static void
+dex_output_stream_writev_all_cb (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  DexAsyncPair *async_pair = user_data;
+  GError *error = NULL;
+  gsize len = 0;
+
+  if (g_output_stream_writev_all_finish (G_OUTPUT_STREAM (object), result, &len, &error))
+    dex_async_pair_return_int64 (async_pair, len);
+  else
+    dex_async_pair_return_error (async_pair, error);
+
+  dex_unref (async_pair);
+}
+
+/**
+ * dex_output_stream_writev_all:
+ * @self: a #GOutputStream
+ * @vectors: (array length=n_vectors): the buffers to write
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the I/O priority of the request
+ *
+ * Writes all of @vectors to @self.
+ *
+ * @vectors and the buffers it points to must remain valid until the
+ * future completes.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to the number
+ *   of bytes written as a gint64, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_output_stream_writev_all (GOutputStream *self,
+                              GOutputVector *vectors,
+                              gsize          n_vectors,
+                              int            io_priority)
+{
+  DexAsyncPair *async_pair;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (self), NULL);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, NULL);
+
+  async_pair = create_async_pair (G_STRFUNC);
+
+  g_output_stream_writev_all_async (self,
+                                    vectors,
+                                    n_vectors,
+                                    io_priority,
+                                    async_pair->cancellable,
+                                    dex_output_stream_writev_all_cb,
+                                    dex_ref (async_pair));
+
+  return DEX_FUTURE (async_pair);
+}
+
 static void
 dex_output_stream_close_cb (GObject      *object,
                             GAsyncResult *result,
@@ -1112,6 +1218,269 @@ dex_dbus_connection_call (GDBusConnection    *connection,
   return DEX_FUTURE (async_pair);
 }
 
+typedef struct _DexDBusBatch
+{
+  GMutex           mutex;
+  GDBusConnection *connection;
+  DexPromise      *promise;
+
+  /* Maps the serial of each sent message to its index + 1 */
+  GHashTable      *serials;
+
+  /* Replies in the order the messages were given */
+  GPtrArray       *replies;
+
+  guint            filter_id;
+  guint            n_remaining;
+
+  /* Set once the caller is no longer interested in replies */
+  guint            done : 1;
+} DexDBusBatch;
+
+static void
+dex_dbus_batch_clear (gpointer data)
+{
+  DexDBusBatch *batch = data;
+
+  g_clear_object (&batch->connection);
+  dex_clear (&batch->promise);
+  g_clear_pointer (&batch->serials, g_hash_table_unref);
+  g_clear_pointer (&batch->replies, g_ptr_array_unref);
+  g_mutex_clear (&batch->mutex);
+}
+
+static void
+dex_dbus_batch_unref (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, dex_dbus_batch_clear);
+}
+
+static void
+dex_dbus_batch_clear_reply (gpointer data)
+{
+  if (data != NULL)
+    g_object_unref (data);
+}
+
+/* Stops collecting replies and removes the filter, unless the filter
+ * already removed itself. GDBus allows removing filters from any thread.
+ */
+static void
+dex_dbus_batch_finish (DexDBusBatch *batch)
+{
+  guint filter_id;
+
+  g_mutex_lock (&batch->mutex);
+  batch->done = TRUE;
+  filter_id = batch->filter_id;
+  batch->filter_id = 0;
+  g_mutex_unlock (&batch->mutex);
+
+  if (filter_id != 0)
+    g_dbus_connection_remove_filter (batch->connection, filter_id);
+}
+
+static void
+dex_dbus_batch_finish_and_unref (gpointer data)
+{
+  dex_dbus_batch_finish (data);
+  dex_dbus_batch_unref (data);
+}
+
+/* Filters run on the GDBus worker thread. Taking a reference here is
+ * safe even if the filter is being removed from another thread because
+ * GDBus only releases the reference held by the registration once the
+ * filter is no longer running.
+ */
+static GDBusMessage *
+dex_dbus_batch_filter (GDBusConnection *connection,
+                       GDBusMessage    *message,
+                       gboolean         incoming,
+                       gpointer         user_data)
+{
+  DexDBusBatch *batch;
+  GPtrArray *replies = NULL;
+  GDBusMessageType message_type;
+  guint filter_id = 0;
+
+  if (!incoming)
+    return message;
+
+  batch = g_atomic_rc_box_acquire (user_data);
+  message_type = g_dbus_message_get_message_type (message);
+
+  g_mutex_lock (&batch->mutex);
+
+  if (!batch->done &&
+      (message_type == G_DBUS_MESSAGE_TYPE_METHOD_RETURN ||
+       message_type == G_DBUS_MESSAGE_TYPE_ERROR))
+    {
+      gpointer key = GUINT_TO_POINTER (g_dbus_message_get_reply_serial (message));
+      gpointer index;
+
+      if (g_hash_table_steal_extended (batch->serials, key, NULL, &index))
+        {
+          g_ptr_array_index (batch->replies, GPOINTER_TO_UINT (index) - 1) = g_steal_pointer (&message);
+
+          if (--batch->n_remaining == 0)
+            {
+              batch->done = TRUE;
+              replies = g_steal_pointer (&batch->replies);
+            }
+        }
+    }
+
+  if (batch->done)
+    {
+      filter_id = batch->filter_id;
+      batch->filter_id = 0;
+    }
+
+  g_mutex_unlock (&batch->mutex);
+
+  if (replies != NULL)
+    {
+      GValue value = G_VALUE_INIT;
+
+      g_value_init (&value, G_TYPE_PTR_ARRAY);
+      g_value_take_boxed (&value, replies);
+      dex_promise_resolve (batch->promise, &value);
+      g_value_unset (&value);
+    }
+
+  if (filter_id != 0)
+    g_dbus_connection_remove_filter (connection, filter_id);
+
+  dex_dbus_batch_unref (batch);
+
+  return message;
+}
+
+static DexFuture *
+dex_dbus_batch_done_cb (DexFuture *completed,
+                        gpointer   user_data)
+{
+  /* Any replies still outstanding (such as after a timeout) are left to
+   * GDBus, which drops them once no filter claims them.
+   */
+  dex_dbus_batch_finish (user_data);
+
+  return dex_ref (completed);
+}
+
+/**
+ * dex_dbus_connection_call_batch:
+ * @connection: a #GDBusConnection
+ * @messages: (array length=n_messages): method call messages to send
+ * @n_messages: the number of elements in @messages
+ * @timeout_msec: the timeout in milliseconds for the entire batch, -1 to
+ *   use the default timeout, or %G_MAXINT for no timeout
+ *
+ * Sends all of @messages and waits for every reply.
+ *
+ * Unlike calling dex_dbus_connection_call() in a loop, this does not
+ * create a future or dispatch a completion to the caller's main context
+ * for each message. Replies are collected on the GDBus worker thread and
+ * the returned future completes once when the last reply arrives.
+ *
+ * Error replies are delivered like any other reply so that a failure of
+ * one call does not prevent access to the others. Use
+ * g_dbus_message_to_gerror() to check each reply.
+ *
+ * @messages must be method calls expecting a reply and must not have
+ * been sent before.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to a #GPtrArray
+ *   of #GDBusMessage replies in the same order as @messages, or rejects
+ *   with error if a message could not be sent or the timeout elapsed.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_dbus_connection_call_batch (GDBusConnection     *connection,
+                                GDBusMessage * const *messages,
+                                guint                 n_messages,
+                                int                   timeout_msec)
+{
+  DexDBusBatch *batch;
+  DexFuture *future;
+  GError *error = NULL;
+
+  g_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), NULL);
+  g_return_val_if_fail (messages != NULL || n_messages == 0, NULL);
+
+  for (guint i = 0; i < n_messages; i++)
+    {
+      g_return_val_if_fail (G_IS_DBUS_MESSAGE (messages[i]), NULL);
+      g_return_val_if_fail (g_dbus_message_get_message_type (messages[i]) == G_DBUS_MESSAGE_TYPE_METHOD_CALL, NULL);
+      g_return_val_if_fail (!(g_dbus_message_get_flags (messages[i]) & G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED), NULL);
+    }
+
+  if (n_messages == 0)
+    return dex_future_new_take_boxed (G_TYPE_PTR_ARRAY,
+                                      g_ptr_array_new_with_free_func (g_object_unref));
+
+  batch = g_atomic_rc_box_new0 (DexDBusBatch);
+  g_mutex_init (&batch->mutex);
+  batch->connection = g_object_ref (connection);
+  batch->promise = dex_promise_new ();
+  batch->serials = g_hash_table_new (NULL, NULL);
+  batch->replies = g_ptr_array_new_full (n_messages, dex_dbus_batch_clear_reply);
+  batch->n_remaining = n_messages;
+  g_ptr_array_set_size (batch->replies, n_messages);
+
+  /* Hold the lock while sending so that replies cannot be processed by
+   * the filter before their serial has been recorded.
+   */
+  g_mutex_lock (&batch->mutex);
+
+  batch->filter_id = g_dbus_connection_add_filter (connection,
+                                                   dex_dbus_batch_filter,
+                                                   g_atomic_rc_box_acquire (batch),
+                                                   dex_dbus_batch_unref);
+
+  for (guint i = 0; i < n_messages; i++)
+    {
+      guint32 serial;
+
+      if (!g_dbus_connection_send_message (connection,
+                                           messages[i],
+                                           G_DBUS_SEND_MESSAGE_FLAGS_NONE,
+                                           &serial,
+                                           &error))
+        {
+          batch->done = TRUE;
+          break;
+        }
+
+      g_hash_table_insert (batch->serials,
+                           GUINT_TO_POINTER (serial),
+                           GUINT_TO_POINTER (i + 1));
+    }
+
+  g_mutex_unlock (&batch->mutex);
+
+  if (error != NULL)
+    {
+      dex_dbus_batch_finish_and_unref (batch);
+      return dex_future_new_for_error (error);
+    }
+
+  if (timeout_msec == -1)
+    timeout_msec = 25000;
+
+  future = dex_ref (batch->promise);
+
+  if (timeout_msec != G_MAXINT)
+    future = dex_future_first (future, dex_timeout_new_msec (timeout_msec), NULL);
+
+  /* Also finish if the caller drops the future before it completes */
+  return dex_future_finally (future,
+                             dex_dbus_batch_done_cb,
+                             batch,
+                             dex_dbus_batch_finish_and_unref);
+}
+
 #ifdef G_OS_UNIX
 static void
 dex_dbus_connection_call_with_unix_fd_list_cb (GObject      *object,
@@ -1358,3 +1727,88 @@ dex_file_query_exists (GFile *file)
                            dex_ref (promise));
   return DEX_FUTURE (promise);
 }
+
+typedef struct _FileMap
+{
+  char     *path;
+  gboolean  writable;
+} FileMap;
+
+static void
+file_map_free (FileMap *state)
+{
+  g_free (state->path);
+  g_free (state);
+}
+
+static DexFuture *
+dex_file_map_fiber (gpointer user_data)
+{
+  FileMap *state = user_data;
+  GMappedFile *mapped_file;
+  GError *error = NULL;
+
+  if (!(mapped_file = g_mapped_file_new (state->path, state->writable, &error)))
+    return dex_future_new_for_error (error);
+
+#ifdef HAVE_MADVISE
+  /* Start reading the mapping into the page cache before handing it to
+   * the caller. This is only a hint, so failure is not fatal.
+   */
+  if (g_mapped_file_get_length (mapped_file) > 0)
+    dex_await (dex_aio_madvise (NULL,
+                                g_mapped_file_get_contents (mapped_file),
+                                g_mapped_file_get_length (mapped_file),
+                                MADV_WILLNEED),
+               NULL);
+#endif
+
+  return dex_future_new_take_boxed (G_TYPE_MAPPED_FILE, mapped_file);
+}
+
+/**
+ * dex_file_map:
+ * @file: a #GFile
+ * @writable: if the mapping should be writable
+ *
+ * Maps @file into memory using #GMappedFile.
+ *
+ * Opening and mapping the file happens on a thread pool so that it does
+ * not block the calling thread. Before the future resolves, read-ahead
+ * of the whole mapping is requested with `madvise(MADV_WILLNEED)` so that
+ * scanning the contents is less likely to stall on page faults.
+ *
+ * As with g_mapped_file_new(), modifications to a writable mapping are
+ * private and are not written back to @file.
+ *
+ * @file must have a native path.
+ *
+ * Returns: (transfer full): a #DexFuture that will resolve to a
+ *   #GMappedFile or reject with error.
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_file_map (GFile    *file,
+              gboolean  writable)
+{
+  FileMap *state;
+  const char *path;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  if (!(path = g_file_peek_path (file)))
+    return dex_future_new_reject (G_IO_ERROR,
+                                  G_IO_ERROR_NOT_SUPPORTED,
+                                  "Only native files may be mapped");
+
+  state = g_new0 (FileMap, 1);
+  state->path = g_strdup (path);
+  state->writable = !!writable;
+
+  return dex_scheduler_spawn (dex_thread_pool_scheduler_get_default (),
+                              0,
+                              dex_file_map_fiber,
+                              state,
+                              (GDestroyNotify)file_map_free);
+}
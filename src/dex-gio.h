@@ -100,6 +100,11 @@ DexFuture *dex_input_stream_read_bytes                 (GInputStream
                                                         int                       io_priority)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
+DexFuture *dex_input_stream_read_bytes_pooled          (GInputStream             *self,
+                                                        gsize                     count,
+                                                        int                       io_priority)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
 DexFuture *dex_output_stream_close                     (GOutputStream            *self,
                                                         int                       io_priority)
   G_GNUC_WARN_UNUSED_RESULT;
@@ -121,6 +126,12 @@ DexFuture *dex_output_stream_write_bytes               (GOutputStream
                                                         int                       io_priority)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
+DexFuture *dex_output_stream_writev_all                (GOutputStream            *self,
+                                                        GOutputVector            *vectors,
+                                                        gsize                     n_vectors,
+                                                        int                       io_priority)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
 DexFuture *dex_socket_listener_accept                  (GSocketListener          *listener)
   G_GNUC_WARN_UNUSED_RESULT;
 DEX_AVAILABLE_IN_ALL
@@ -164,6 +175,12 @@ DexFuture *dex_dbus_connection_call_with_unix_fd_list  (GDBusConnection
   G_GNUC_WARN_UNUSED_RESULT;
 #endif
 DEX_AVAILABLE_IN_ALL
+DexFuture *dex_dbus_connection_call_batch              (GDBusConnection          *connection,
+                                                        GDBusMessage * const     *messages,
+                                                        guint                     n_messages,
+                                                        int                       timeout_msec)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
 DexFuture *dex_dbus_connection_send_message_with_reply (GDBusConnection          *connection,
                                                         GDBusMessage             *message,
                                                         GDBusSendMessageFlags     flags,
@@ -176,5 +193,9 @@ DexFuture *dex_subprocess_wait_check                   (GSubprocess
 DEX_AVAILABLE_IN_ALL
 DexFuture *dex_file_query_exists                       (GFile                    *file)
   G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_file_map                                (GFile                    *file,
+                                                        gboolean                  writable)
+  G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
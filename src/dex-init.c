@@ -70,6 +70,8 @@ dex_init_once (void)
 #endif
 
   /* Misc types */
+  g_type_ensure (DEX_TYPE_AIO_BUFFER_POOL);
+  g_type_ensure (DEX_TYPE_AIO_FILE_READER);
   g_type_ensure (DEX_TYPE_ASYNC_RESULT);
   g_type_ensure (DEX_TYPE_CHANNEL);
   g_type_ensure (DEX_TYPE_SEMAPHORE);
@@ -0,0 +1,77 @@
+/*
+ * dex-lock-waiter-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-future-private.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_LOCK_WAITER    (dex_lock_waiter_get_type())
+#define DEX_LOCK_WAITER(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_LOCK_WAITER, DexLockWaiter))
+#define DEX_IS_LOCK_WAITER(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_LOCK_WAITER))
+
+typedef struct _DexLockWaiter DexLockWaiter;
+
+typedef enum _DexLockWaiterHandoff
+{
+  DEX_LOCK_WAITER_HANDOFF_NONE,
+  DEX_LOCK_WAITER_HANDOFF_GRANTED,
+  DEX_LOCK_WAITER_HANDOFF_DELIVERED,
+  DEX_LOCK_WAITER_HANDOFF_REVOKED,
+} DexLockWaiterHandoff;
+
+/* Called with the owner unlocked when a queued waiter is discarded */
+typedef void (*DexLockWaiterCancel) (DexObject     *owner,
+                                     DexLockWaiter *waiter);
+
+struct _DexLockWaiter
+{
+  DexFuture            parent_instance;
+
+  /* Protected by the owner's object lock */
+  GList                link;
+  guint                exclusive : 1;
+  guint                queued : 1;
+
+  /* A DexLockWaiterHandoff, changed atomically */
+  int                  handoff;
+
+  DexObject           *owner;
+  DexLockWaiterCancel  cancel;
+};
+
+GType          dex_lock_waiter_get_type  (void) G_GNUC_CONST;
+DexLockWaiter *dex_lock_waiter_new       (DexObject           *owner,
+                                          DexLockWaiterCancel  cancel,
+                                          gboolean             exclusive);
+void           dex_lock_waiter_enqueue   (DexLockWaiter       *waiter,
+                                          GQueue              *queue);
+DexLockWaiter *dex_lock_waiter_dequeue   (GQueue              *queue);
+gboolean       dex_lock_waiter_unlink    (DexLockWaiter       *waiter,
+                                          GQueue              *queue);
+void           dex_lock_waiter_grant     (DexLockWaiter       *waiter,
+                                          GQueue              *ready);
+gboolean       dex_lock_waiter_revoke    (DexLockWaiter       *waiter);
+void           dex_lock_waiter_wake_all  (GQueue              *ready);
+void           dex_lock_waiter_cancelled (DexLockWaiter       *waiter);
+
+G_END_DECLS
@@ -0,0 +1,228 @@
+/*
+ * dex-lock-waiter.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "dex-lock-waiter-private.h"
+
+/*
+ * DexLockWaiter is the future returned to a fiber which must wait for a
+ * DexMutex, DexRWLock, or DexCond. Waiters are queued in FIFO order on
+ * their owner and completed by whoever releases the lock, which hands the
+ * lock over directly rather than letting the woken fiber race for it.
+ *
+ * Completing the future wakes the awaiting fiber on its own scheduler, so
+ * the releasing thread never runs the waiter's code.
+ *
+ * If the waiter is discarded while still queued, the owner is asked to
+ * remove it so that the lock is not handed to a fiber that is no longer
+ * interested in it.
+ *
+ * A waiter may also be discarded after the owner has granted it the lock
+ * but before dex_lock_waiter_wake_all() completes it. Nobody would observe
+ * that completion, so the owner revokes the grant and releases the lock on
+ * the waiter's behalf. The handoff state decides atomically which of the
+ * two wins, so the lock is either delivered or released, never both.
+ */
+
+typedef struct _DexLockWaiterClass
+{
+  DexFutureClass parent_class;
+} DexLockWaiterClass;
+
+DEX_DEFINE_FINAL_TYPE (DexLockWaiter, dex_lock_waiter, DEX_TYPE_FUTURE)
+
+#undef DEX_TYPE_LOCK_WAITER
+#define DEX_TYPE_LOCK_WAITER dex_lock_waiter_type
+
+static GValue lock_waiter_value;
+
+static void
+dex_lock_waiter_discard (DexFuture *future)
+{
+  DexLockWaiter *waiter = DEX_LOCK_WAITER (future);
+
+  if (dex_future_is_pending (future))
+    waiter->cancel (waiter->owner, waiter);
+}
+
+static void
+dex_lock_waiter_finalize (DexObject *object)
+{
+  DexLockWaiter *waiter = DEX_LOCK_WAITER (object);
+
+  g_assert (!waiter->queued);
+
+  dex_clear (&waiter->owner);
+
+  DEX_OBJECT_CLASS (dex_lock_waiter_parent_class)->finalize (object);
+}
+
+static void
+dex_lock_waiter_class_init (DexLockWaiterClass *lock_waiter_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (lock_waiter_class);
+  DexFutureClass *future_class = DEX_FUTURE_CLASS (lock_waiter_class);
+
+  object_class->finalize = dex_lock_waiter_finalize;
+  future_class->discard = dex_lock_waiter_discard;
+
+  g_value_init (&lock_waiter_value, G_TYPE_BOOLEAN);
+  g_value_set_boolean (&lock_waiter_value, TRUE);
+}
+
+static void
+dex_lock_waiter_init (DexLockWaiter *waiter)
+{
+  waiter->link.data = waiter;
+}
+
+DexLockWaiter *
+dex_lock_waiter_new (DexObject           *owner,
+                     DexLockWaiterCancel  cancel,
+                     gboolean             exclusive)
+{
+  DexLockWaiter *waiter;
+
+  g_assert (DEX_IS_OBJECT (owner));
+  g_assert (cancel != NULL);
+
+  waiter = (DexLockWaiter *)dex_object_create_instance (DEX_TYPE_LOCK_WAITER);
+  waiter->owner = dex_ref (owner);
+  waiter->cancel = cancel;
+  waiter->exclusive = !!exclusive;
+
+  return waiter;
+}
+
+/* Must be called with the owner locked. The queue takes a reference. */
+void
+dex_lock_waiter_enqueue (DexLockWaiter *waiter,
+                         GQueue        *queue)
+{
+  g_assert (DEX_IS_LOCK_WAITER (waiter));
+  g_assert (!waiter->queued);
+
+  dex_ref (waiter);
+  waiter->queued = TRUE;
+  g_queue_push_tail_link (queue, &waiter->link);
+}
+
+/* Must be called with the owner locked. Returns the queue's reference. */
+DexLockWaiter *
+dex_lock_waiter_dequeue (GQueue *queue)
+{
+  GList *link = g_queue_pop_head_link (queue);
+  DexLockWaiter *waiter;
+
+  if (link == NULL)
+    return NULL;
+
+  waiter = link->data;
+  waiter->queued = FALSE;
+
+  return waiter;
+}
+
+/* Must be called with the owner locked. If the waiter was still queued,
+ * the queue's reference is dropped and %TRUE is returned.
+ */
+gboolean
+dex_lock_waiter_unlink (DexLockWaiter *waiter,
+                        GQueue        *queue)
+{
+  g_assert (DEX_IS_LOCK_WAITER (waiter));
+
+  if (!waiter->queued)
+    return FALSE;
+
+  waiter->queued = FALSE;
+  g_queue_unlink (queue, &waiter->link);
+  dex_unref (waiter);
+
+  return TRUE;
+}
+
+/* Must be called with the owner locked after dequeuing @waiter. Marks the
+ * lock as now owned by @waiter and adds it to @ready.
+ */
+void
+dex_lock_waiter_grant (DexLockWaiter *waiter,
+                       GQueue        *ready)
+{
+  g_assert (DEX_IS_LOCK_WAITER (waiter));
+  g_assert (!waiter->queued);
+
+  g_atomic_int_set (&waiter->handoff, DEX_LOCK_WAITER_HANDOFF_GRANTED);
+  g_queue_push_tail_link (ready, &waiter->link);
+}
+
+/* Call without holding the owner lock. If @waiter was granted the lock but
+ * not yet completed, it is rejected instead and %TRUE is returned. The
+ * caller must then release the lock on its behalf.
+ */
+gboolean
+dex_lock_waiter_revoke (DexLockWaiter *waiter)
+{
+  g_assert (DEX_IS_LOCK_WAITER (waiter));
+
+  if (!g_atomic_int_compare_and_exchange (&waiter->handoff,
+                                          DEX_LOCK_WAITER_HANDOFF_GRANTED,
+                                          DEX_LOCK_WAITER_HANDOFF_REVOKED))
+    return FALSE;
+
+  dex_lock_waiter_cancelled (waiter);
+
+  return TRUE;
+}
+
+/* Completes dequeued waiters. Call without holding the owner lock. */
+void
+dex_lock_waiter_wake_all (GQueue *ready)
+{
+  DexLockWaiter *waiter;
+
+  while ((waiter = dex_lock_waiter_dequeue (ready)))
+    {
+      /* Skip grants that were revoked by a discard in the meantime */
+      if (g_atomic_int_get (&waiter->handoff) == DEX_LOCK_WAITER_HANDOFF_NONE ||
+          g_atomic_int_compare_and_exchange (&waiter->handoff,
+                                             DEX_LOCK_WAITER_HANDOFF_GRANTED,
+                                             DEX_LOCK_WAITER_HANDOFF_DELIVERED))
+        dex_future_complete (DEX_FUTURE (waiter), &lock_waiter_value, NULL);
+
+      dex_unref (waiter);
+    }
+}
+
+void
+dex_lock_waiter_cancelled (DexLockWaiter *waiter)
+{
+  g_assert (DEX_IS_LOCK_WAITER (waiter));
+
+  dex_future_complete (DEX_FUTURE (waiter),
+                       NULL,
+                       g_error_new_literal (G_IO_ERROR,
+                                            G_IO_ERROR_CANCELLED,
+                                            "The lock waiter was discarded"));
+}
@@ -25,6 +25,7 @@
 #include "dex-fiber-private.h"
 #include "dex-main-scheduler-private.h"
 #include "dex-scheduler-private.h"
+#include "dex-stats-private.h"
 #include "dex-work-queue-private.h"
 #include "dex-thread-storage-private.h"
 
@@ -61,6 +62,7 @@ typedef struct _DexMainScheduler
   GSource          *fiber_scheduler;
   GSource          *work_queue_source;
   GQueue            work_queue;
+  DexStats          stats;
 } DexMainScheduler;
 
 typedef struct _DexMainSchedulerClass
@@ -107,6 +109,8 @@ dex_main_work_queue_dispatch (GSource     *source,
   *wqs->queue = (GQueue) {NULL, NULL, 0};
   dex_object_unlock (wqs->object);
 
+  dex_stats_counter_add (&((DexMainScheduler *)wqs->object)->stats.work_items_executed, queue.length);
+
   while (queue.length > 0)
     {
       DexMainWorkQueueItem *item = g_queue_pop_head_link (&queue)->data;
@@ -140,6 +144,8 @@ dex_main_scheduler_push (DexScheduler *scheduler,
   g_queue_push_tail_link (&main_scheduler->work_queue, &item->link);
   dex_object_unlock (main_scheduler);
 
+  dex_stats_counter_add (&main_scheduler->stats.work_items_pushed, 1);
+
   if G_UNLIKELY (scheduler != dex_thread_storage_get ()->scheduler)
     g_main_context_wakeup (main_scheduler->main_context);
 }
@@ -175,6 +181,19 @@ dex_main_scheduler_spawn (DexScheduler *scheduler,
   dex_fiber_scheduler_register ((DexFiberScheduler *)main_scheduler->fiber_scheduler, fiber);
 }
 
+static void
+dex_main_scheduler_get_stats (DexScheduler      *scheduler,
+                              DexSchedulerStats *stats)
+{
+  DexMainScheduler *main_scheduler = DEX_MAIN_SCHEDULER (scheduler);
+
+  g_assert (DEX_IS_MAIN_SCHEDULER (main_scheduler));
+
+  dex_stats_collect (&main_scheduler->stats, stats);
+  dex_stats_collect (&((DexFiberScheduler *)main_scheduler->fiber_scheduler)->stats, stats);
+  dex_stats_collect (&((DexAioContext *)main_scheduler->aio_context)->stats, stats);
+}
+
 static void
 dex_main_scheduler_finalize (DexObject *object)
 {
@@ -188,6 +207,8 @@ dex_main_scheduler_finalize (DexObject *object)
       g_free (item);
     }
 
+  dex_stats_unregister (&main_scheduler->stats);
+
   /* Clear DexAioBackend context */
   g_source_destroy (main_scheduler->aio_context);
   g_clear_pointer (&main_scheduler->aio_context, g_source_unref);
@@ -218,11 +239,13 @@ dex_main_scheduler_class_init (DexMainSchedulerClass *main_scheduler_class)
   scheduler_class->get_main_context = dex_main_scheduler_get_main_context;
   scheduler_class->push = dex_main_scheduler_push;
   scheduler_class->spawn = dex_main_scheduler_spawn;
+  scheduler_class->get_stats = dex_main_scheduler_get_stats;
 }
 
 static void
 dex_main_scheduler_init (DexMainScheduler *main_scheduler)
 {
+  dex_stats_register (&main_scheduler->stats, NULL);
 }
 
 DexMainScheduler *
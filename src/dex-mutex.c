@@ -0,0 +1,257 @@
+/*
+ * dex-mutex.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-lock-waiter-private.h"
+#include "dex-mutex.h"
+
+/**
+ * DexMutex:
+ *
+ * #DexMutex provides mutual exclusion between fibers without blocking
+ * the thread they run on.
+ *
+ * dex_mutex_lock() returns a future which resolves once the caller owns
+ * the mutex, so a fiber awaiting it yields to other fibers on the same
+ * scheduler instead of stalling them as a #GMutex would.
+ *
+ * Locking and unlocking an uncontended mutex is a single atomic operation.
+ * When contended, waiters are queued in FIFO order and the mutex is handed
+ * directly to the next waiter on unlock. The woken fiber resumes on its own
+ * scheduler already owning the mutex, so a stream of new lockers cannot
+ * starve it.
+ *
+ * A future from dex_mutex_lock() that is discarded before it resolves
+ * gives up its place in the queue, or releases the mutex again if it was
+ * handed over at that moment. If it is discarded after resolving, the
+ * mutex is still owned and must be unlocked. When racing a lock against a
+ * timeout with dex_future_first(), keep a reference to the lock future so
+ * that you can tell whether it resolved anyway.
+ *
+ * Since: 0.8
+ */
+
+enum {
+  MUTEX_LOCKED  = 1 << 0,
+  MUTEX_WAITING = 1 << 1,
+};
+
+struct _DexMutex
+{
+  DexObject parent_instance;
+
+  /* Once MUTEX_WAITING is set, changes to state happen only while
+   * holding the object lock.
+   */
+  int       state;
+  GQueue    waiters;
+};
+
+typedef struct _DexMutexClass
+{
+  DexObjectClass parent_class;
+} DexMutexClass;
+
+DEX_DEFINE_FINAL_TYPE (DexMutex, dex_mutex, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_MUTEX
+#define DEX_TYPE_MUTEX dex_mutex_type
+
+static void
+dex_mutex_finalize (DexObject *object)
+{
+  DexMutex *mutex = DEX_MUTEX (object);
+
+  /* Queued waiters hold a reference to the mutex */
+  g_assert (mutex->waiters.length == 0);
+
+  DEX_OBJECT_CLASS (dex_mutex_parent_class)->finalize (object);
+}
+
+static void
+dex_mutex_class_init (DexMutexClass *mutex_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (mutex_class);
+
+  object_class->finalize = dex_mutex_finalize;
+}
+
+static void
+dex_mutex_init (DexMutex *mutex)
+{
+}
+
+/* Hands the mutex to the next waiter, must be called locked */
+static void
+dex_mutex_dispatch_locked (DexMutex *mutex,
+                           GQueue   *ready)
+{
+  DexLockWaiter *waiter;
+
+  if ((waiter = dex_lock_waiter_dequeue (&mutex->waiters)))
+    {
+      /* Remains locked, now owned by @waiter */
+      dex_lock_waiter_grant (waiter, ready);
+
+      if (mutex->waiters.length == 0)
+        g_atomic_int_set (&mutex->state, MUTEX_LOCKED);
+    }
+  else
+    {
+      g_atomic_int_set (&mutex->state, 0);
+    }
+}
+
+static void
+dex_mutex_cancel (DexObject     *owner,
+                  DexLockWaiter *waiter)
+{
+  DexMutex *mutex = DEX_MUTEX (owner);
+  gboolean unlinked;
+
+  dex_object_lock (mutex);
+  unlinked = dex_lock_waiter_unlink (waiter, &mutex->waiters);
+  if (unlinked && mutex->waiters.length == 0)
+    g_atomic_int_set (&mutex->state, MUTEX_LOCKED);
+  dex_object_unlock (mutex);
+
+  if (unlinked)
+    dex_lock_waiter_cancelled (waiter);
+  else if (dex_lock_waiter_revoke (waiter))
+    dex_mutex_unlock (mutex);
+}
+
+/**
+ * dex_mutex_new:
+ *
+ * Creates a new #DexMutex.
+ *
+ * Returns: (transfer full): a #DexMutex
+ *
+ * Since: 0.8
+ */
+DexMutex *
+dex_mutex_new (void)
+{
+  return (DexMutex *)dex_object_create_instance (DEX_TYPE_MUTEX);
+}
+
+/**
+ * dex_mutex_trylock:
+ * @mutex: a #DexMutex
+ *
+ * Locks @mutex if it is not currently owned and nobody is waiting
+ * for it.
+ *
+ * Returns: %TRUE if @mutex was locked and must be unlocked with
+ *   dex_mutex_unlock().
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_mutex_trylock (DexMutex *mutex)
+{
+  g_return_val_if_fail (DEX_IS_MUTEX (mutex), FALSE);
+
+  return g_atomic_int_compare_and_exchange (&mutex->state, 0, MUTEX_LOCKED);
+}
+
+/**
+ * dex_mutex_lock:
+ * @mutex: a #DexMutex
+ *
+ * Locks @mutex.
+ *
+ * The resulting future resolves once the caller owns @mutex, which
+ * must then be released with dex_mutex_unlock().
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_mutex_lock (DexMutex *mutex)
+{
+  DexLockWaiter *waiter;
+
+  g_return_val_if_fail (DEX_IS_MUTEX (mutex), NULL);
+
+  if (g_atomic_int_compare_and_exchange (&mutex->state, 0, MUTEX_LOCKED))
+    return dex_future_new_for_boolean (TRUE);
+
+  dex_object_lock (mutex);
+
+  for (;;)
+    {
+      int state = g_atomic_int_get (&mutex->state);
+
+      /* Released while we were taking the object lock */
+      if (state == 0)
+        {
+          if (g_atomic_int_compare_and_exchange (&mutex->state, 0, MUTEX_LOCKED))
+            {
+              dex_object_unlock (mutex);
+              return dex_future_new_for_boolean (TRUE);
+            }
+
+          continue;
+        }
+
+      /* Force the owner into dex_mutex_unlock()'s slow path */
+      if ((state & MUTEX_WAITING) != 0 ||
+          g_atomic_int_compare_and_exchange (&mutex->state, state, state | MUTEX_WAITING))
+        break;
+    }
+
+  waiter = dex_lock_waiter_new (DEX_OBJECT (mutex), dex_mutex_cancel, TRUE);
+  dex_lock_waiter_enqueue (waiter, &mutex->waiters);
+
+  dex_object_unlock (mutex);
+
+  return DEX_FUTURE (waiter);
+}
+
+/**
+ * dex_mutex_unlock:
+ * @mutex: a #DexMutex
+ *
+ * Unlocks @mutex, handing it to the longest waiting fiber if any.
+ *
+ * Since: 0.8
+ */
+void
+dex_mutex_unlock (DexMutex *mutex)
+{
+  GQueue ready = G_QUEUE_INIT;
+
+  g_return_if_fail (DEX_IS_MUTEX (mutex));
+
+  if (g_atomic_int_compare_and_exchange (&mutex->state, MUTEX_LOCKED, 0))
+    return;
+
+  dex_object_lock (mutex);
+  g_warn_if_fail (g_atomic_int_get (&mutex->state) & MUTEX_LOCKED);
+  dex_mutex_dispatch_locked (mutex, &ready);
+  dex_object_unlock (mutex);
+
+  dex_lock_waiter_wake_all (&ready);
+}
@@ -23,6 +23,7 @@
 
 #include "dex-compat-private.h"
 #include "dex-object.h"
+#include "dex-stats-private.h"
 
 G_BEGIN_DECLS
 
@@ -119,8 +120,20 @@ typedef struct _DexObjectClass
   GTypeClass parent_class;
 
   void (*finalize) (DexObject *object);
+
+  /* Instances created, for runtime statistics */
+  DexStatsCounter n_created;
 } DexObjectClass;
 
+/* Per-type counters live in the class and are therefore shared by every
+ * thread, so they are only updated once enabled with
+ * dex_future_set_type_stats_enabled().
+ */
+extern int dex_object_type_stats_enabled;
+
+#define DEX_OBJECT_TYPE_STATS_ENABLED \
+  G_UNLIKELY (g_atomic_int_get (&dex_object_type_stats_enabled))
+
 DexObject *dex_object_create_instance (GType instance_type);
 
 G_END_DECLS
@@ -549,10 +549,17 @@ dex_object_get_type (void)
   return dex_object_type;
 }
 
+int dex_object_type_stats_enabled;
+
 DexObject *
 dex_object_create_instance (GType instance_type)
 {
-  return (DexObject *)(gpointer)g_type_create_instance (instance_type);
+  GTypeInstance *instance = g_type_create_instance (instance_type);
+
+  if (DEX_OBJECT_TYPE_STATS_ENABLED)
+    dex_stats_counter_add (&((DexObjectClass *)instance->g_class)->n_created, 1);
+
+  return (DexObject *)(gpointer)instance;
 }
 
 /**
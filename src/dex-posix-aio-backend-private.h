@@ -37,5 +37,7 @@ GType          dex_posix_aio_backend_get_type (void) G_GNUC_CONST;
 DexAioBackend *dex_posix_aio_backend_new      (void);
 void           dex_posix_aio_context_enqueue  (DexPosixAioContext *posix_aio_context,
                                                DexPosixAioFuture  *posix_aio_future);
+void           dex_posix_aio_context_cancel   (DexPosixAioContext *posix_aio_context,
+                                               DexPosixAioFuture  *posix_aio_future);
 
 G_END_DECLS
@@ -37,9 +37,8 @@
  * that on Linux it doesn't guarantee support for regular files to
  * return EAGAIN properly.
  *
- * If/when we introduce AIO operations for send()/recv() then those would
- * use g_source_add_unix_fd()/g_source_remove_unix_fd() to poll() within
- * the GMainContext.
+ * Readiness futures from dex_fd_wait() use g_source_add_unix_fd() and
+ * g_source_remove_unix_fd() to poll() within the GMainContext.
  *
  * This is primarily meant to be a fallback for cases where we cannot
  * support more specific APIs like io_posix or kqueue.
@@ -60,6 +59,7 @@ typedef struct _DexPosixAioContext
   DexAioContext parent;
   GMutex        mutex;
   GQueue        completed;
+  GQueue        polling;
 } DexPosixAioContext;
 
 DEX_DEFINE_FINAL_TYPE (DexPosixAioBackend, dex_posix_aio_backend, DEX_TYPE_AIO_BACKEND)
@@ -102,8 +102,29 @@ dex_posix_aio_context_dispatch (GSource     *source,
 
   g_mutex_lock (&aio_context->mutex);
   steal_queue (&aio_context->completed, &completed);
+
+  for (GList *iter = aio_context->polling.head; iter; )
+    {
+      DexPosixAioFuture *posix_aio_future = iter->data;
+      gpointer tag = dex_posix_aio_future_get_poll_tag (posix_aio_future);
+      GIOCondition revents = g_source_query_unix_fd (source, tag);
+      GList *next = iter->next;
+
+      if (revents != 0)
+        {
+          g_source_remove_unix_fd (source, tag);
+          dex_posix_aio_future_set_poll_tag (posix_aio_future, NULL);
+          dex_posix_aio_future_set_poll_revents (posix_aio_future, revents);
+          g_queue_delete_link (&aio_context->polling, iter);
+          g_queue_push_tail (&completed, posix_aio_future);
+        }
+
+      iter = next;
+    }
   g_mutex_unlock (&aio_context->mutex);
 
+  dex_stats_counter_add (&aio_context->parent.stats.aio_completed, completed.length);
+
   while (completed.length > 0)
     {
       DexPosixAioFuture *posix_aio_future = g_queue_pop_head (&completed);
@@ -125,6 +146,8 @@ dex_posix_aio_context_check (GSource *source)
 
   g_mutex_lock (&aio_context->mutex);
   ret = aio_context->completed.length > 0;
+  for (const GList *iter = aio_context->polling.head; !ret && iter; iter = iter->next)
+    ret = g_source_query_unix_fd (source, dex_posix_aio_future_get_poll_tag (iter->data)) != 0;
   g_mutex_unlock (&aio_context->mutex);
 
   return ret;
@@ -146,6 +169,9 @@ dex_posix_aio_context_finalize (GSource *source)
   g_assert (aio_context != NULL);
   g_assert (DEX_IS_POSIX_AIO_BACKEND (aio_context->parent.aio_backend));
   g_assert (aio_context->completed.length == 0);
+  g_assert (aio_context->polling.length == 0);
+
+  dex_stats_unregister (&aio_context->parent.stats);
 
   g_mutex_clear (&aio_context->mutex);
 }
@@ -207,6 +233,119 @@ dex_posix_aio_backend_write (DexAioBackend *aio_backend,
   return DEX_FUTURE (posix_aio_future);
 }
 
+static DexFuture *
+dex_posix_aio_backend_writev (DexAioBackend       *aio_backend,
+                              DexAioContext       *aio_context,
+                              int                  fd,
+                              const GOutputVector *vectors,
+                              gsize                n_vectors,
+                              goffset              offset)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new_writev ((DexPosixAioContext *)aio_context, fd, vectors, n_vectors, offset);
+  g_thread_pool_push (io_thread_pool, dex_ref (posix_aio_future), NULL);
+
+  return DEX_FUTURE (posix_aio_future);
+}
+
+static DexFuture *
+dex_posix_aio_backend_send (DexAioBackend *aio_backend,
+                            DexAioContext *aio_context,
+                            int            fd,
+                            gconstpointer  buffer,
+                            gsize          count,
+                            int            flags)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new_send ((DexPosixAioContext *)aio_context, fd, buffer, count, flags);
+  g_thread_pool_push (io_thread_pool, dex_ref (posix_aio_future), NULL);
+
+  return DEX_FUTURE (posix_aio_future);
+}
+
+static DexFuture *
+dex_posix_aio_backend_fadvise (DexAioBackend *aio_backend,
+                               DexAioContext *aio_context,
+                               int            fd,
+                               goffset        offset,
+                               goffset        length,
+                               int            advice)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new_fadvise ((DexPosixAioContext *)aio_context, fd, offset, length, advice);
+  g_thread_pool_push (io_thread_pool, dex_ref (posix_aio_future), NULL);
+
+  return DEX_FUTURE (posix_aio_future);
+}
+
+static DexFuture *
+dex_posix_aio_backend_madvise (DexAioBackend *aio_backend,
+                               DexAioContext *aio_context,
+                               gpointer       address,
+                               gsize          length,
+                               int            advice)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new_madvise ((DexPosixAioContext *)aio_context, address, length, advice);
+  g_thread_pool_push (io_thread_pool, dex_ref (posix_aio_future), NULL);
+
+  return DEX_FUTURE (posix_aio_future);
+}
+
+static DexFuture *
+dex_posix_aio_backend_poll (DexAioBackend *aio_backend,
+                            DexAioContext *aio_context,
+                            int            fd,
+                            GIOCondition   condition)
+{
+  DexPosixAioContext *posix_aio_context = (DexPosixAioContext *)aio_context;
+  DexPosixAioFuture *posix_aio_future;
+  gpointer tag;
+
+  posix_aio_future = dex_posix_aio_future_new_poll (posix_aio_context, fd, condition);
+
+  /* Adding the pollfd wakes up the GMainContext if necessary */
+  g_mutex_lock (&posix_aio_context->mutex);
+  tag = g_source_add_unix_fd ((GSource *)posix_aio_context, fd, condition);
+  dex_posix_aio_future_set_poll_tag (posix_aio_future, tag);
+  g_queue_push_tail (&posix_aio_context->polling, dex_ref (posix_aio_future));
+  g_mutex_unlock (&posix_aio_context->mutex);
+
+  return DEX_FUTURE (posix_aio_future);
+}
+
+void
+dex_posix_aio_context_cancel (DexPosixAioContext *posix_aio_context,
+                              DexPosixAioFuture  *posix_aio_future)
+{
+  GList *link;
+
+  g_return_if_fail (posix_aio_context != NULL);
+  g_return_if_fail (DEX_IS_POSIX_AIO_FUTURE (posix_aio_future));
+
+  g_mutex_lock (&posix_aio_context->mutex);
+  if ((link = g_queue_find (&posix_aio_context->polling, posix_aio_future)))
+    {
+      g_source_remove_unix_fd ((GSource *)posix_aio_context,
+                               dex_posix_aio_future_get_poll_tag (posix_aio_future));
+      dex_posix_aio_future_set_poll_tag (posix_aio_future, NULL);
+      g_queue_delete_link (&posix_aio_context->polling, link);
+    }
+  g_mutex_unlock (&posix_aio_context->mutex);
+
+  /* Completing without any events rejects the future as cancelled */
+  if (link != NULL)
+    {
+      dex_stats_counter_add (&posix_aio_context->parent.stats.aio_completed, 1);
+      dex_posix_aio_future_complete (posix_aio_future);
+      dex_unref (posix_aio_future);
+    }
+}
+
 static void
 dex_posix_aio_backend_worker (gpointer data,
                               gpointer user_data)
@@ -230,6 +369,11 @@ dex_posix_aio_backend_class_init (DexPosixAioBackendClass *posix_aio_backend_cla
   aio_backend_class->create_context = dex_posix_aio_backend_create_context;
   aio_backend_class->read = dex_posix_aio_backend_read;
   aio_backend_class->write = dex_posix_aio_backend_write;
+  aio_backend_class->writev = dex_posix_aio_backend_writev;
+  aio_backend_class->send = dex_posix_aio_backend_send;
+  aio_backend_class->poll = dex_posix_aio_backend_poll;
+  aio_backend_class->fadvise = dex_posix_aio_backend_fadvise;
+  aio_backend_class->madvise = dex_posix_aio_backend_madvise;
 
   io_thread_pool = g_thread_pool_new (dex_posix_aio_backend_worker,
                                       NULL,
@@ -39,6 +39,33 @@ DexPosixAioFuture  *dex_posix_aio_future_new_write        (DexPosixAioContext  *
                                                            gconstpointer        buffer,
                                                            gsize                count,
                                                            goffset              offset);
+DexPosixAioFuture  *dex_posix_aio_future_new_writev       (DexPosixAioContext  *posix_aio_context,
+                                                           int                  fd,
+                                                           const GOutputVector *vectors,
+                                                           gsize                n_vectors,
+                                                           goffset              offset);
+DexPosixAioFuture  *dex_posix_aio_future_new_send         (DexPosixAioContext  *posix_aio_context,
+                                                           int                  fd,
+                                                           gconstpointer        buffer,
+                                                           gsize                count,
+                                                           int                  flags);
+DexPosixAioFuture  *dex_posix_aio_future_new_poll         (DexPosixAioContext  *posix_aio_context,
+                                                           int                  fd,
+                                                           GIOCondition         events);
+DexPosixAioFuture  *dex_posix_aio_future_new_fadvise      (DexPosixAioContext  *posix_aio_context,
+                                                           int                  fd,
+                                                           goffset              offset,
+                                                           goffset              length,
+                                                           int                  advice);
+DexPosixAioFuture  *dex_posix_aio_future_new_madvise      (DexPosixAioContext  *posix_aio_context,
+                                                           gpointer             address,
+                                                           gsize                length,
+                                                           int                  advice);
+gpointer            dex_posix_aio_future_get_poll_tag     (DexPosixAioFuture   *posix_aio_future);
+void                dex_posix_aio_future_set_poll_tag     (DexPosixAioFuture   *posix_aio_future,
+                                                           gpointer             tag);
+void                dex_posix_aio_future_set_poll_revents (DexPosixAioFuture   *posix_aio_future,
+                                                           GIOCondition         revents);
 void                dex_posix_aio_future_run              (DexPosixAioFuture   *posix_aio_future);
 void                dex_posix_aio_future_complete         (DexPosixAioFuture   *posix_aio_future);
 DexPosixAioContext *dex_posix_aio_future_get_aio_context  (DexPosixAioFuture *posix_aio_future);
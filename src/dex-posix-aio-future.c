@@ -21,8 +21,15 @@
 #include "config.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef HAVE_MADVISE
+# include <sys/mman.h>
+#endif
+
 #include <gio/gio.h>
 
 #include "dex-future-private.h"
@@ -33,6 +40,11 @@ typedef enum _DexPosixAioFutureKind
 {
   DEX_POSIX_AIO_FUTURE_READ = 1,
   DEX_POSIX_AIO_FUTURE_WRITE,
+  DEX_POSIX_AIO_FUTURE_WRITEV,
+  DEX_POSIX_AIO_FUTURE_SEND,
+  DEX_POSIX_AIO_FUTURE_POLL,
+  DEX_POSIX_AIO_FUTURE_FADVISE,
+  DEX_POSIX_AIO_FUTURE_MADVISE,
 } DexPosixAioFutureKind;
 
 struct _DexPosixAioFuture
@@ -57,6 +69,39 @@ struct _DexPosixAioFuture
       goffset            offset;
       gssize             res;
     } write;
+    struct {
+      int                fd;
+      const GOutputVector *vectors;
+      gsize              n_vectors;
+      goffset            offset;
+      gssize             res;
+    } writev;
+    struct {
+      int                fd;
+      gconstpointer      buffer;
+      gsize              count;
+      int                flags;
+      gssize             res;
+    } send;
+    struct {
+      int                fd;
+      GIOCondition       events;
+      GIOCondition       revents;
+      gpointer           tag;
+    } poll;
+    struct {
+      int                fd;
+      goffset            offset;
+      goffset            length;
+      int                advice;
+      int                res;
+    } fadvise;
+    struct {
+      gpointer           address;
+      gsize              length;
+      int                advice;
+      int                res;
+    } madvise;
   };
 };
 
@@ -81,12 +126,24 @@ dex_posix_aio_future_finalize (DexObject *object)
   DEX_OBJECT_CLASS (dex_posix_aio_future_parent_class)->finalize (object);
 }
 
+static void
+dex_posix_aio_future_discard (DexFuture *future)
+{
+  DexPosixAioFuture *posix_aio_future = DEX_POSIX_AIO_FUTURE (future);
+
+  /* Readiness may never arrive, so stop polling if nobody is waiting */
+  if (posix_aio_future->kind == DEX_POSIX_AIO_FUTURE_POLL)
+    dex_posix_aio_context_cancel (posix_aio_future->aio_context, posix_aio_future);
+}
+
 static void
 dex_posix_aio_future_class_init (DexPosixAioFutureClass *posix_aio_future_class)
 {
   DexObjectClass *object_class = DEX_OBJECT_CLASS (posix_aio_future_class);
+  DexFutureClass *future_class = DEX_FUTURE_CLASS (posix_aio_future_class);
 
   object_class->finalize = dex_posix_aio_future_finalize;
+  future_class->discard = dex_posix_aio_future_discard;
 }
 
 static void
@@ -150,6 +207,123 @@ dex_posix_aio_future_new_write (DexPosixAioContext *posix_aio_context,
   return posix_aio_future;
 }
 
+DexPosixAioFuture *
+dex_posix_aio_future_new_writev (DexPosixAioContext  *posix_aio_context,
+                                 int                  fd,
+                                 const GOutputVector *vectors,
+                                 gsize                n_vectors,
+                                 goffset              offset)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new (DEX_POSIX_AIO_FUTURE_WRITEV, posix_aio_context);
+  posix_aio_future->writev.fd = fd;
+  posix_aio_future->writev.vectors = vectors;
+  posix_aio_future->writev.n_vectors = n_vectors;
+  posix_aio_future->writev.offset = offset;
+  posix_aio_future->writev.res = -1;
+
+  return posix_aio_future;
+}
+
+DexPosixAioFuture *
+dex_posix_aio_future_new_send (DexPosixAioContext *posix_aio_context,
+                               int                 fd,
+                               gconstpointer       buffer,
+                               gsize               count,
+                               int                 flags)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new (DEX_POSIX_AIO_FUTURE_SEND, posix_aio_context);
+  posix_aio_future->send.fd = fd;
+  posix_aio_future->send.buffer = buffer;
+  posix_aio_future->send.count = count;
+  posix_aio_future->send.flags = flags;
+  posix_aio_future->send.res = -1;
+
+  return posix_aio_future;
+}
+
+DexPosixAioFuture *
+dex_posix_aio_future_new_poll (DexPosixAioContext *posix_aio_context,
+                               int                 fd,
+                               GIOCondition        events)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new (DEX_POSIX_AIO_FUTURE_POLL, posix_aio_context);
+  posix_aio_future->poll.fd = fd;
+  posix_aio_future->poll.events = events;
+
+  return posix_aio_future;
+}
+
+DexPosixAioFuture *
+dex_posix_aio_future_new_fadvise (DexPosixAioContext *posix_aio_context,
+                                  int                 fd,
+                                  goffset             offset,
+                                  goffset             length,
+                                  int                 advice)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new (DEX_POSIX_AIO_FUTURE_FADVISE, posix_aio_context);
+  posix_aio_future->fadvise.fd = fd;
+  posix_aio_future->fadvise.offset = offset;
+  posix_aio_future->fadvise.length = length;
+  posix_aio_future->fadvise.advice = advice;
+  posix_aio_future->fadvise.res = -1;
+
+  return posix_aio_future;
+}
+
+DexPosixAioFuture *
+dex_posix_aio_future_new_madvise (DexPosixAioContext *posix_aio_context,
+                                  gpointer            address,
+                                  gsize               length,
+                                  int                 advice)
+{
+  DexPosixAioFuture *posix_aio_future;
+
+  posix_aio_future = dex_posix_aio_future_new (DEX_POSIX_AIO_FUTURE_MADVISE, posix_aio_context);
+  posix_aio_future->madvise.address = address;
+  posix_aio_future->madvise.length = length;
+  posix_aio_future->madvise.advice = advice;
+  posix_aio_future->madvise.res = -1;
+
+  return posix_aio_future;
+}
+
+gpointer
+dex_posix_aio_future_get_poll_tag (DexPosixAioFuture *posix_aio_future)
+{
+  g_return_val_if_fail (DEX_IS_POSIX_AIO_FUTURE (posix_aio_future), NULL);
+  g_return_val_if_fail (posix_aio_future->kind == DEX_POSIX_AIO_FUTURE_POLL, NULL);
+
+  return posix_aio_future->poll.tag;
+}
+
+void
+dex_posix_aio_future_set_poll_tag (DexPosixAioFuture *posix_aio_future,
+                                   gpointer           tag)
+{
+  g_return_if_fail (DEX_IS_POSIX_AIO_FUTURE (posix_aio_future));
+  g_return_if_fail (posix_aio_future->kind == DEX_POSIX_AIO_FUTURE_POLL);
+
+  posix_aio_future->poll.tag = tag;
+}
+
+void
+dex_posix_aio_future_set_poll_revents (DexPosixAioFuture *posix_aio_future,
+                                       GIOCondition       revents)
+{
+  g_return_if_fail (DEX_IS_POSIX_AIO_FUTURE (posix_aio_future));
+  g_return_if_fail (posix_aio_future->kind == DEX_POSIX_AIO_FUTURE_POLL);
+
+  posix_aio_future->poll.revents = revents;
+}
+
 void
 dex_posix_aio_future_run (DexPosixAioFuture *posix_aio_future)
 {
@@ -193,6 +367,74 @@ dex_posix_aio_future_run (DexPosixAioFuture *posix_aio_future)
       (void)posix_aio_future->write.res;
       break;
 
+    case DEX_POSIX_AIO_FUTURE_WRITEV:
+      {
+        const struct iovec *iov = (const struct iovec *)posix_aio_future->writev.vectors;
+        int iovcnt = MIN (posix_aio_future->writev.n_vectors, G_MAXINT);
+
+        if (posix_aio_future->writev.offset < 0)
+          posix_aio_future->writev.res =
+            writev (posix_aio_future->writev.fd, iov, iovcnt);
+        else
+#ifdef HAVE_PWRITEV
+          posix_aio_future->writev.res =
+            pwritev (posix_aio_future->writev.fd, iov, iovcnt,
+                     posix_aio_future->writev.offset);
+#else
+          /* Positioned writes without pwritev() are limited to the first
+           * buffer, which callers handle like any other short write.
+           */
+          posix_aio_future->writev.res =
+            pwrite (posix_aio_future->writev.fd,
+                    iov[0].iov_base,
+                    iov[0].iov_len,
+                    posix_aio_future->writev.offset);
+#endif
+      }
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_SEND:
+      posix_aio_future->send.res =
+        send (posix_aio_future->send.fd,
+              posix_aio_future->send.buffer,
+              posix_aio_future->send.count,
+              posix_aio_future->send.flags);
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_FADVISE:
+#ifdef HAVE_POSIX_FADVISE
+      {
+        /* posix_fadvise() returns the error rather than setting errno */
+        int res = posix_fadvise (posix_aio_future->fadvise.fd,
+                                 posix_aio_future->fadvise.offset,
+                                 posix_aio_future->fadvise.length,
+                                 posix_aio_future->fadvise.advice);
+
+        if (res != 0)
+          errno = res;
+
+        posix_aio_future->fadvise.res = res == 0 ? 0 : -1;
+      }
+#else
+      errno = ENOSYS;
+      posix_aio_future->fadvise.res = -1;
+#endif
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_MADVISE:
+#ifdef HAVE_MADVISE
+      posix_aio_future->madvise.res =
+        madvise (posix_aio_future->madvise.address,
+                 posix_aio_future->madvise.length,
+                 posix_aio_future->madvise.advice);
+#else
+      errno = ENOSYS;
+      posix_aio_future->madvise.res = -1;
+#endif
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_POLL:
+      /* Polled within the GMainContext rather than a worker thread */
     default:
       g_assert_not_reached ();
     }
@@ -233,6 +475,41 @@ dex_posix_aio_future_complete (DexPosixAioFuture *posix_aio_future)
       dex_posix_aio_future_complete_int64 (posix_aio_future, posix_aio_future->write.res);
       break;
 
+    case DEX_POSIX_AIO_FUTURE_WRITEV:
+      dex_posix_aio_future_complete_int64 (posix_aio_future, posix_aio_future->writev.res);
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_SEND:
+      dex_posix_aio_future_complete_int64 (posix_aio_future, posix_aio_future->send.res);
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_FADVISE:
+      dex_posix_aio_future_complete_int64 (posix_aio_future, posix_aio_future->fadvise.res);
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_MADVISE:
+      dex_posix_aio_future_complete_int64 (posix_aio_future, posix_aio_future->madvise.res);
+      break;
+
+    case DEX_POSIX_AIO_FUTURE_POLL:
+      /* No events means the poll was cancelled before @fd became ready */
+      if (posix_aio_future->poll.revents == 0)
+        dex_future_complete (DEX_FUTURE (posix_aio_future),
+                             NULL,
+                             g_error_new_literal (G_IO_ERROR,
+                                                  G_IO_ERROR_CANCELLED,
+                                                  "Operation was cancelled"));
+      else
+        {
+          GValue value = G_VALUE_INIT;
+
+          g_value_init (&value, G_TYPE_IO_CONDITION);
+          g_value_set_flags (&value, posix_aio_future->poll.revents);
+          dex_future_complete (DEX_FUTURE (posix_aio_future), &value, NULL);
+          g_value_unset (&value);
+        }
+      break;
+
     default:
       g_assert_not_reached ();
     }
@@ -0,0 +1,74 @@
+/*
+ * dex-probes-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#ifndef PACKAGE_VERSION
+# error "config.h was not included before dex-probes-private.h."
+#endif
+
+#include <glib.h>
+
+#ifdef HAVE_USDT
+# include <sys/sdt.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* USDT probes for perf, bpftrace, and SystemTap under the "libdex"
+ * provider. A disabled probe is a single nop in the instruction stream
+ * so arguments must be cheap to compute, which is why names are passed
+ * as the raw (possibly %NULL) pointer from dex_future_set_static_name().
+ *
+ *   future_create      (future)
+ *   future_complete    (future, name, status)
+ *   future_chain       (future, chained)
+ *   block_dispatch     (block, name)
+ *   fiber_spawn        (fiber, fiber_scheduler)
+ *   fiber_switch       (fiber, name)
+ *   fiber_exit         (fiber, name)
+ *   work_item_push     (scheduler, func, func_data)
+ *   work_item_steal    (thief, victim)
+ *   work_item_execute  (func, func_data)
+ *   semaphore_post     (semaphore, count)
+ *   semaphore_wait     (semaphore)
+ *   uring_submit       (future, op)
+ *   uring_complete     (future, op)
+ *
+ * For example, to list them from an installed library:
+ *
+ *   bpftrace -l 'usdt:/usr/lib64/libdex-1.so:libdex:*'
+ */
+
+#ifdef HAVE_USDT
+# define DEX_PROBE1(name, a) \
+  DTRACE_PROBE1 (libdex, name, a)
+# define DEX_PROBE2(name, a, b) \
+  DTRACE_PROBE2 (libdex, name, a, b)
+# define DEX_PROBE3(name, a, b, c) \
+  DTRACE_PROBE3 (libdex, name, a, b, c)
+#else
+# define DEX_PROBE1(name, a) G_STMT_START { } G_STMT_END
+# define DEX_PROBE2(name, a, b) G_STMT_START { } G_STMT_END
+# define DEX_PROBE3(name, a, b, c) G_STMT_START { } G_STMT_END
+#endif
+
+G_END_DECLS
@@ -0,0 +1,512 @@
+/*
+ * dex-process.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+
+#include "dex-aio.h"
+#include "dex-compat-private.h"
+#include "dex-object-private.h"
+#include "dex-process.h"
+#include "dex-promise.h"
+#include "dex-scheduler.h"
+
+#ifndef P_PIDFD
+# define P_PIDFD 3
+#endif
+
+extern char **environ;
+
+/**
+ * DexProcess:
+ *
+ * #DexProcess is a child process spawned with `posix_spawn()`.
+ *
+ * Unlike #GSubprocess, exit of the child is not observed through the
+ * `SIGCHLD` based child watch on the main context. On Linux 5.3 and newer
+ * a pidfd is polled with dex_fd_wait() on the #DexAioContext of the thread
+ * which spawned the process (`IORING_OP_POLL_ADD` with the io_uring
+ * backend) and the child is reaped with `waitid (P_PIDFD)`. That allows
+ * spawning and awaiting many short-lived processes without funneling
+ * every exit through a single main context. Older systems, threads
+ * without a #DexScheduler, or a failure to poll the pidfd fall back to
+ * g_child_watch_add() on the default main context.
+ *
+ * The child is always reaped, even if the #DexProcess is released before
+ * it exits.
+ *
+ * Since: 0.8
+ */
+
+struct _DexProcess
+{
+  DexObject   parent_instance;
+  DexPromise *exited;
+  GPid        pid;
+  int         pidfd;
+  guint       reaped : 1;
+};
+
+typedef struct _DexProcessClass
+{
+  DexObjectClass parent_class;
+} DexProcessClass;
+
+DEX_DEFINE_FINAL_TYPE (DexProcess, dex_process, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_PROCESS
+#define DEX_TYPE_PROCESS dex_process_type
+
+static void
+dex_process_finalize (DexObject *object)
+{
+  DexProcess *process = DEX_PROCESS (object);
+
+  if (process->pidfd != -1)
+    {
+      close (process->pidfd);
+      process->pidfd = -1;
+    }
+
+  dex_clear (&process->exited);
+
+  DEX_OBJECT_CLASS (dex_process_parent_class)->finalize (object);
+}
+
+static void
+dex_process_class_init (DexProcessClass *process_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (process_class);
+
+  object_class->finalize = dex_process_finalize;
+}
+
+static void
+dex_process_init (DexProcess *process)
+{
+  process->pidfd = -1;
+}
+
+static void
+dex_process_exited (DexProcess *process,
+                    int         wait_status)
+{
+  dex_object_lock (process);
+  process->reaped = TRUE;
+  dex_object_unlock (process);
+
+  dex_promise_resolve_int (process->exited, wait_status);
+}
+
+static void
+dex_process_child_watch_cb (GPid     pid,
+                            int      wait_status,
+                            gpointer user_data)
+{
+  dex_process_exited (user_data, wait_status);
+}
+
+static DexFuture *
+dex_process_pidfd_ready_cb (DexFuture *completed,
+                            gpointer   user_data)
+{
+  DexProcess *process = user_data;
+  siginfo_t info = {0};
+  int wait_status;
+  int res;
+
+  /* The child has not been reaped, so it can still be watched for */
+  if (dex_future_get_status (completed) == DEX_FUTURE_STATUS_REJECTED)
+    {
+      g_child_watch_add_full (G_PRIORITY_DEFAULT,
+                              process->pid,
+                              dex_process_child_watch_cb,
+                              dex_ref (process),
+                              dex_unref);
+      return NULL;
+    }
+
+  do
+    res = waitid (P_PIDFD, process->pidfd, &info, WEXITED);
+  while (res != 0 && errno == EINTR);
+
+  /* pidfd_open() arrived in Linux 5.3 but P_PIDFD only in 5.4. The child
+   * has exited since the pidfd is readable, so waitpid() will not block.
+   */
+  if (res != 0 && (errno == EINVAL || errno == ENOSYS))
+    {
+      do
+        res = waitpid (process->pid, &wait_status, 0);
+      while (res == -1 && errno == EINTR);
+
+      if (res == process->pid)
+        {
+          dex_process_exited (process, wait_status);
+          return NULL;
+        }
+    }
+
+  if (res != 0)
+    {
+      int errsv = errno;
+      GError *error = g_error_new_literal (G_IO_ERROR,
+                                           g_io_error_from_errno (errsv),
+                                           g_strerror (errsv));
+      dex_promise_reject (process->exited, g_error_copy (error));
+      return dex_future_new_for_error (error);
+    }
+
+  /* Encode the result the same way waitpid() would so that it may be
+   * used with g_spawn_check_wait_status() and the W*() macros.
+   */
+  if (info.si_code == CLD_EXITED)
+    wait_status = (info.si_status & 0xff) << 8;
+  else
+    wait_status = (info.si_status & 0x7f) | (info.si_code == CLD_DUMPED ? 0x80 : 0);
+
+  dex_process_exited (process, wait_status);
+
+  return NULL;
+}
+
+static void
+dex_process_watch (DexProcess *process)
+{
+#ifdef __NR_pidfd_open
+  /* Waiting on the pidfd requires a scheduler (and therefore an AIO
+   * context) on this thread. Otherwise use a child watch on the default
+   * main context.
+   */
+  if (dex_scheduler_get_thread_default () != NULL)
+    process->pidfd = syscall (__NR_pidfd_open, process->pid, 0);
+
+  if (process->pidfd != -1)
+    {
+      /* The pidfd becomes readable once the child exits. The watch holds
+       * a reference so the child is reaped even if @process is released.
+       */
+      dex_future_disown (dex_future_finally (dex_fd_wait (process->pidfd, G_IO_IN),
+                                             dex_process_pidfd_ready_cb,
+                                             dex_ref (process),
+                                             dex_unref));
+      return;
+    }
+#endif
+
+  g_child_watch_add_full (G_PRIORITY_DEFAULT,
+                          process->pid,
+                          dex_process_child_watch_cb,
+                          dex_ref (process),
+                          dex_unref);
+}
+
+static GSpawnError
+dex_process_spawn_error_from_errno (int errsv)
+{
+  switch (errsv)
+    {
+    case ENOENT: return G_SPAWN_ERROR_NOENT;
+    case EACCES: return G_SPAWN_ERROR_ACCES;
+    case ENOTDIR: return G_SPAWN_ERROR_NOTDIR;
+    case ENOEXEC: return G_SPAWN_ERROR_NOEXEC;
+    case E2BIG: return G_SPAWN_ERROR_TOO_BIG;
+    case ENOMEM: return G_SPAWN_ERROR_NOMEM;
+    case ELOOP: return G_SPAWN_ERROR_LOOP;
+    case ETXTBSY: return G_SPAWN_ERROR_TXTBUSY;
+    default: return G_SPAWN_ERROR_FAILED;
+    }
+}
+
+/**
+ * dex_process_spawn:
+ * @argv: (array zero-terminated=1): the program and arguments to run,
+ *   where the program is looked up in `PATH` if it does not contain a
+ *   directory separator
+ * @envp: (array zero-terminated=1) (nullable): the environment for the
+ *   child or %NULL to inherit the current environment
+ * @cwd: (nullable): the working directory for the child or %NULL to
+ *   inherit the current working directory
+ * @stdin_fd: a file descriptor for the child's stdin or -1 to inherit
+ * @stdout_fd: a file descriptor for the child's stdout or -1 to inherit
+ * @stderr_fd: a file descriptor for the child's stderr or -1 to inherit
+ * @error: a location for a #GError or %NULL
+ *
+ * Spawns a new child process with `posix_spawnp()`.
+ *
+ * On Linux, `posix_spawn()` uses `CLONE_VM` and `CLONE_VFORK` so the cost
+ * of spawning does not grow with the size of the parent process, as it
+ * would with `fork()`.
+ *
+ * The file descriptors are duplicated into the child and may be closed by
+ * the caller once this function returns. All other file descriptors are
+ * only inherited if they do not have `FD_CLOEXEC` set. The child starts
+ * with an empty signal mask and the default disposition for `SIGPIPE`.
+ *
+ * If the program cannot be executed, @error is set to the matching
+ * #GSpawnError such as %G_SPAWN_ERROR_NOENT.
+ *
+ * Returns: (transfer full): a #DexProcess or %NULL and @error is set
+ *
+ * Since: 0.8
+ */
+DexProcess *
+dex_process_spawn (const char * const  *argv,
+                   const char * const  *envp,
+                   const char          *cwd,
+                   int                  stdin_fd,
+                   int                  stdout_fd,
+                   int                  stderr_fd,
+                   GError             **error)
+{
+  posix_spawn_file_actions_t file_actions;
+  posix_spawnattr_t attr;
+  DexProcess *process;
+  sigset_t sigmask;
+  sigset_t sigdefault;
+  pid_t pid;
+  int source_fds[3] = { stdin_fd, stdout_fd, stderr_fd };
+  int duped_fds[3] = { -1, -1, -1 };
+  int res;
+
+  g_return_val_if_fail (argv != NULL, NULL);
+  g_return_val_if_fail (argv[0] != NULL, NULL);
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+  if (cwd != NULL)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_NOT_SUPPORTED,
+                           "Setting the working directory is not supported on this system");
+      return NULL;
+    }
+#endif
+
+  /* The dup2() actions run in order, so a source such as stdout_fd == 0
+   * would be replaced by stdin_fd before it is used. As GLib does, move
+   * such sources above the standard range first.
+   */
+  for (guint i = 0; i < G_N_ELEMENTS (source_fds); i++)
+    {
+      if (source_fds[i] >= 0 && source_fds[i] < 3 && source_fds[i] != (int)i)
+        {
+          duped_fds[i] = fcntl (source_fds[i], F_DUPFD_CLOEXEC, 3);
+
+          if (duped_fds[i] == -1)
+            {
+              int errsv = errno;
+
+              g_set_error (error,
+                           G_SPAWN_ERROR,
+                           G_SPAWN_ERROR_FAILED,
+                           "Failed to duplicate file descriptor for child process: %s",
+                           g_strerror (errsv));
+
+              for (guint j = 0; j < i; j++)
+                {
+                  if (duped_fds[j] != -1)
+                    close (duped_fds[j]);
+                }
+
+              return NULL;
+            }
+
+          source_fds[i] = duped_fds[i];
+        }
+    }
+
+  posix_spawn_file_actions_init (&file_actions);
+  posix_spawnattr_init (&attr);
+
+  for (guint i = 0; i < G_N_ELEMENTS (source_fds); i++)
+    {
+      if (source_fds[i] != -1)
+        posix_spawn_file_actions_adddup2 (&file_actions, source_fds[i], i);
+    }
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+  if (cwd != NULL)
+    posix_spawn_file_actions_addchdir_np (&file_actions, cwd);
+#endif
+
+  /* Threads commonly block signals, and servers commonly ignore SIGPIPE,
+   * neither of which should leak into the child.
+   */
+  sigemptyset (&sigmask);
+  sigemptyset (&sigdefault);
+  sigaddset (&sigdefault, SIGPIPE);
+  posix_spawnattr_setsigmask (&attr, &sigmask);
+  posix_spawnattr_setsigdefault (&attr, &sigdefault);
+  posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+  res = posix_spawnp (&pid,
+                      argv[0],
+                      &file_actions,
+                      &attr,
+                      (char * const *)argv,
+                      envp ? (char * const *)envp : environ);
+
+  posix_spawn_file_actions_destroy (&file_actions);
+  posix_spawnattr_destroy (&attr);
+
+  for (guint i = 0; i < G_N_ELEMENTS (duped_fds); i++)
+    {
+      if (duped_fds[i] != -1)
+        close (duped_fds[i]);
+    }
+
+  if (res != 0)
+    {
+      g_set_error (error,
+                   G_SPAWN_ERROR,
+                   dex_process_spawn_error_from_errno (res),
+                   "Failed to spawn “%s”: %s",
+                   argv[0], g_strerror (res));
+      return NULL;
+    }
+
+  process = (DexProcess *)dex_object_create_instance (DEX_TYPE_PROCESS);
+  process->pid = pid;
+  process->exited = dex_promise_new ();
+
+  dex_process_watch (process);
+
+  return process;
+}
+
+/**
+ * dex_process_get_pid:
+ * @process: a #DexProcess
+ *
+ * Gets the process identifier of the child.
+ *
+ * The identifier may be reused by another process once the child has
+ * been reaped.
+ *
+ * Returns: the process identifier
+ *
+ * Since: 0.8
+ */
+GPid
+dex_process_get_pid (DexProcess *process)
+{
+  g_return_val_if_fail (DEX_IS_PROCESS (process), 0);
+
+  return process->pid;
+}
+
+/**
+ * dex_process_send_signal:
+ * @process: a #DexProcess
+ * @signum: the signal to send
+ *
+ * Sends @signum to the child if it has not yet been reaped.
+ *
+ * When a pidfd is available the signal is delivered with
+ * `pidfd_send_signal()` which cannot reach an unrelated process that
+ * reused the identifier.
+ *
+ * Since: 0.8
+ */
+void
+dex_process_send_signal (DexProcess *process,
+                         int         signum)
+{
+  g_return_if_fail (DEX_IS_PROCESS (process));
+
+  dex_object_lock (process);
+
+  if (!process->reaped)
+    {
+#ifdef __NR_pidfd_send_signal
+      if (process->pidfd != -1)
+        syscall (__NR_pidfd_send_signal, process->pidfd, signum, NULL, 0);
+      else
+#endif
+        kill (process->pid, signum);
+    }
+
+  dex_object_unlock (process);
+}
+
+/**
+ * dex_process_wait:
+ * @process: a #DexProcess
+ *
+ * Gets a future that completes when the child exits.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to the wait
+ *   status of the child as an int (see dex_await_int()) which may be
+ *   checked with g_spawn_check_wait_status(), or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_process_wait (DexProcess *process)
+{
+  g_return_val_if_fail (DEX_IS_PROCESS (process), NULL);
+
+  return dex_ref (process->exited);
+}
+
+static DexFuture *
+dex_process_wait_check_cb (DexFuture *completed,
+                           gpointer   user_data)
+{
+  const GValue *value = dex_future_get_value (completed, NULL);
+  GError *error = NULL;
+
+  if (!_g_spawn_check_wait_status (g_value_get_int (value), &error))
+    return dex_future_new_for_error (error);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+/**
+ * dex_process_wait_check:
+ * @process: a #DexProcess
+ *
+ * Like dex_process_wait() but checks the wait status of the child.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE if the
+ *   child exited successfully, or rejects with error
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_process_wait_check (DexProcess *process)
+{
+  g_return_val_if_fail (DEX_IS_PROCESS (process), NULL);
+
+  return dex_future_then (dex_process_wait (process),
+                          dex_process_wait_check_cb,
+                          NULL, NULL);
+}
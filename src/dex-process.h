@@ -0,0 +1,60 @@
+/*
+ * dex-process.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-future.h"
+#include "dex-object.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_PROCESS    (dex_process_get_type())
+#define DEX_PROCESS(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_PROCESS, DexProcess))
+#define DEX_IS_PROCESS(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_PROCESS))
+
+typedef struct _DexProcess DexProcess;
+
+DEX_AVAILABLE_IN_ALL
+GType       dex_process_get_type    (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexProcess *dex_process_spawn       (const char * const  *argv,
+                                     const char * const  *envp,
+                                     const char          *cwd,
+                                     int                  stdin_fd,
+                                     int                  stdout_fd,
+                                     int                  stderr_fd,
+                                     GError             **error)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+GPid        dex_process_get_pid     (DexProcess          *process);
+DEX_AVAILABLE_IN_ALL
+void        dex_process_send_signal (DexProcess          *process,
+                                     int                  signum);
+DEX_AVAILABLE_IN_ALL
+DexFuture  *dex_process_wait        (DexProcess          *process)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture  *dex_process_wait_check  (DexProcess          *process)
+  G_GNUC_WARN_UNUSED_RESULT;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexProcess, dex_unref)
+
+G_END_DECLS
@@ -55,15 +55,36 @@ G_BEGIN_DECLS
     if (DEX_PROFILER_ACTIVE) \
       sysprof_collector_log_printf(G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN, format, __VA_ARGS__); \
   } G_STMT_END
+# define DEX_PROFILER_DEFINE_COUNTER(id, name, description) \
+  G_STMT_START { \
+    SysprofCaptureCounter __counter = {{0}}; \
+    (id) = sysprof_collector_request_counters (1); \
+    g_strlcpy (__counter.category, "libdex", sizeof __counter.category); \
+    g_strlcpy (__counter.name, name, sizeof __counter.name); \
+    g_strlcpy (__counter.description, description, sizeof __counter.description); \
+    __counter.id = (id); \
+    __counter.type = SYSPROF_CAPTURE_COUNTER_INT64; \
+    sysprof_collector_define_counters (&__counter, 1); \
+  } G_STMT_END
+# define DEX_PROFILER_SET_COUNTER(id, value) \
+  G_STMT_START { \
+    unsigned int __id = (id); \
+    SysprofCaptureCounterValue __value = { .v64 = (value) }; \
+    sysprof_collector_set_counters (&__id, &__value, 1); \
+  } G_STMT_END
 #else
 # undef DEX_PROFILER_ENABLED
 # define DEX_PROFILER_ACTIVE (0)
 # define DEX_PROFILER_CURRENT_TIME 0
 # define DEX_PROFILER_MARK(duration, name, message) \
-  G_STMT_START { } G_STMT_END
+  G_STMT_START { (void)(duration); } G_STMT_END
 # define DEX_PROFILER_BEGIN_MARK G_STMT_START {
 # define DEX_PROFILER_END_MARK(name, message) (void)0; } G_STMT_END
 # define DEX_PROFILER_LOG(format, ...) G_STMT_START { } G_STMT_END
+# define DEX_PROFILER_DEFINE_COUNTER(id, name, description) \
+  G_STMT_START { (id) = 0; } G_STMT_END
+# define DEX_PROFILER_SET_COUNTER(id, value) \
+  G_STMT_START { (void)(id); (void)(value); } G_STMT_END
 #endif
 
 G_END_DECLS
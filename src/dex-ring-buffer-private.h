@@ -0,0 +1,58 @@
+/*
+ * dex-ring-buffer-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DexRingSlot
+{
+  int      sequence;
+  gpointer data;
+} DexRingSlot;
+
+/* Bounded multi-producer/multi-consumer queue of pointers. The producer
+ * and consumer positions live on separate cache lines so that senders
+ * and receivers do not contend with each other.
+ */
+typedef struct _DexRingBuffer
+{
+  int          enqueue_pos;
+  char         _padding1[64 - sizeof (int)];
+  int          dequeue_pos;
+  char         _padding2[64 - sizeof (int)];
+  guint        mask;
+  DexRingSlot *slots;
+} DexRingBuffer;
+
+void     dex_ring_buffer_init     (DexRingBuffer  *ring_buffer,
+                                   guint           capacity);
+void     dex_ring_buffer_clear    (DexRingBuffer  *ring_buffer,
+                                   GDestroyNotify  destroy);
+gboolean dex_ring_buffer_push     (DexRingBuffer  *ring_buffer,
+                                   gpointer        data);
+gpointer dex_ring_buffer_pop      (DexRingBuffer  *ring_buffer);
+guint    dex_ring_buffer_capacity (DexRingBuffer  *ring_buffer);
+guint    dex_ring_buffer_length   (DexRingBuffer  *ring_buffer);
+
+G_END_DECLS
@@ -0,0 +1,162 @@
+/*
+ * dex-ring-buffer.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-ring-buffer-private.h"
+
+/*
+ * This is the bounded MPMC queue described by Dmitry Vyukov. Each slot
+ * carries a sequence number which tells producers and consumers whether
+ * the slot is ready for them in the current lap around the ring, so a
+ * push or pop is a single compare-and-swap on the shared position when
+ * uncontended.
+ *
+ * Positions are 32-bit and allowed to wrap. Comparisons are done on the
+ * signed difference which remains correct as long as the capacity is a
+ * power of two well below 2^31.
+ *
+ * A push may fail while a consumer is still releasing the slot it just
+ * read (and a pop while a producer is still filling its slot). Callers
+ * must treat failure as "try again after being woken" rather than as a
+ * precise full or empty state.
+ */
+
+void
+dex_ring_buffer_init (DexRingBuffer *ring_buffer,
+                      guint          capacity)
+{
+  guint n_slots = 2;
+
+  g_assert (capacity > 0);
+  g_assert (capacity <= G_MAXINT / 2);
+
+  while (n_slots < capacity)
+    n_slots <<= 1;
+
+  ring_buffer->enqueue_pos = 0;
+  ring_buffer->dequeue_pos = 0;
+  ring_buffer->mask = n_slots - 1;
+  ring_buffer->slots = g_new (DexRingSlot, n_slots);
+
+  for (guint i = 0; i < n_slots; i++)
+    {
+      ring_buffer->slots[i].sequence = i;
+      ring_buffer->slots[i].data = NULL;
+    }
+}
+
+void
+dex_ring_buffer_clear (DexRingBuffer  *ring_buffer,
+                       GDestroyNotify  destroy)
+{
+  gpointer data;
+
+  if (ring_buffer->slots == NULL)
+    return;
+
+  while ((data = dex_ring_buffer_pop (ring_buffer)))
+    {
+      if (destroy != NULL)
+        destroy (data);
+    }
+
+  g_clear_pointer (&ring_buffer->slots, g_free);
+}
+
+gboolean
+dex_ring_buffer_push (DexRingBuffer *ring_buffer,
+                      gpointer       data)
+{
+  guint pos = g_atomic_int_get (&ring_buffer->enqueue_pos);
+
+  g_assert (data != NULL);
+
+  for (;;)
+    {
+      DexRingSlot *slot = &ring_buffer->slots[pos & ring_buffer->mask];
+      guint sequence = g_atomic_int_get (&slot->sequence);
+      int diff = (int)(sequence - pos);
+
+      if (diff == 0)
+        {
+          if (g_atomic_int_compare_and_exchange (&ring_buffer->enqueue_pos, (int)pos, (int)(pos + 1)))
+            {
+              slot->data = data;
+              g_atomic_int_set (&slot->sequence, (int)(pos + 1));
+              return TRUE;
+            }
+        }
+      else if (diff < 0)
+        {
+          /* Full, the slot still holds an item from the previous lap */
+          return FALSE;
+        }
+
+      pos = g_atomic_int_get (&ring_buffer->enqueue_pos);
+    }
+}
+
+gpointer
+dex_ring_buffer_pop (DexRingBuffer *ring_buffer)
+{
+  guint pos = g_atomic_int_get (&ring_buffer->dequeue_pos);
+
+  for (;;)
+    {
+      DexRingSlot *slot = &ring_buffer->slots[pos & ring_buffer->mask];
+      guint sequence = g_atomic_int_get (&slot->sequence);
+      int diff = (int)(sequence - (pos + 1));
+
+      if (diff == 0)
+        {
+          if (g_atomic_int_compare_and_exchange (&ring_buffer->dequeue_pos, (int)pos, (int)(pos + 1)))
+            {
+              gpointer data = g_steal_pointer (&slot->data);
+              g_atomic_int_set (&slot->sequence, (int)(pos + ring_buffer->mask + 1));
+              return data;
+            }
+        }
+      else if (diff < 0)
+        {
+          /* Empty, the slot has not been filled for this lap */
+          return NULL;
+        }
+
+      pos = g_atomic_int_get (&ring_buffer->dequeue_pos);
+    }
+}
+
+guint
+dex_ring_buffer_capacity (DexRingBuffer *ring_buffer)
+{
+  return ring_buffer->mask + 1;
+}
+
+/* Only a snapshot, which may be stale by the time it is used */
+guint
+dex_ring_buffer_length (DexRingBuffer *ring_buffer)
+{
+  guint dequeue_pos = g_atomic_int_get (&ring_buffer->dequeue_pos);
+  guint enqueue_pos = g_atomic_int_get (&ring_buffer->enqueue_pos);
+
+  return MIN (enqueue_pos - dequeue_pos, ring_buffer->mask + 1);
+}
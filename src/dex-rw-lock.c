@@ -0,0 +1,372 @@
+/*
+ * dex-rw-lock.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-lock-waiter-private.h"
+#include "dex-rw-lock.h"
+
+/**
+ * DexRWLock:
+ *
+ * #DexRWLock allows many fibers to read shared state concurrently while
+ * giving writers exclusive access, without blocking the threads the
+ * fibers run on.
+ *
+ * Acquiring an uncontended lock, for reading or writing, is a single
+ * atomic operation. Once any fiber has to wait, new readers queue behind
+ * it rather than joining the current readers. Waiters are woken in FIFO
+ * order, with consecutive readers at the head of the queue woken
+ * together, and the lock is handed directly to them on release.
+ *
+ * As with #DexMutex, a discarded lock future gives up its place in the
+ * queue if it has not resolved yet, or releases the lock again if it was
+ * handed over at that moment.
+ *
+ * Since: 0.8
+ */
+
+#define RW_LOCK_WRITER  (1 << 30)
+#define RW_LOCK_WAITING (1 << 29)
+#define RW_LOCK_READERS (RW_LOCK_WAITING - 1)
+
+struct _DexRWLock
+{
+  DexObject parent_instance;
+
+  /* Number of readers, or RW_LOCK_WRITER, along with RW_LOCK_WAITING
+   * when waiters are queued. Once RW_LOCK_WAITING is set, changes to
+   * state happen only while holding the object lock.
+   */
+  int       state;
+  GQueue    waiters;
+};
+
+typedef struct _DexRWLockClass
+{
+  DexObjectClass parent_class;
+} DexRWLockClass;
+
+DEX_DEFINE_FINAL_TYPE (DexRWLock, dex_rw_lock, DEX_TYPE_OBJECT)
+
+#undef DEX_TYPE_RW_LOCK
+#define DEX_TYPE_RW_LOCK dex_rw_lock_type
+
+static void
+dex_rw_lock_finalize (DexObject *object)
+{
+  DexRWLock *rw_lock = DEX_RW_LOCK (object);
+
+  /* Queued waiters hold a reference to the lock */
+  g_assert (rw_lock->waiters.length == 0);
+
+  DEX_OBJECT_CLASS (dex_rw_lock_parent_class)->finalize (object);
+}
+
+static void
+dex_rw_lock_class_init (DexRWLockClass *rw_lock_class)
+{
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (rw_lock_class);
+
+  object_class->finalize = dex_rw_lock_finalize;
+}
+
+static void
+dex_rw_lock_init (DexRWLock *rw_lock)
+{
+}
+
+static inline gboolean
+can_acquire (int      state,
+             gboolean exclusive)
+{
+  if (exclusive)
+    return (state & (RW_LOCK_WRITER | RW_LOCK_READERS)) == 0;
+  else
+    return (state & RW_LOCK_WRITER) == 0;
+}
+
+static inline int
+acquire (int      state,
+         gboolean exclusive)
+{
+  return exclusive ? (state | RW_LOCK_WRITER) : (state + 1);
+}
+
+/* Hands the lock to as many waiters as possible from the head of the
+ * queue, must be called locked.
+ */
+static void
+dex_rw_lock_dispatch_locked (DexRWLock *rw_lock,
+                             GQueue    *ready)
+{
+  int state = g_atomic_int_get (&rw_lock->state);
+
+  while (rw_lock->waiters.length > 0)
+    {
+      DexLockWaiter *waiter = g_queue_peek_head (&rw_lock->waiters);
+
+      if (!can_acquire (state, waiter->exclusive))
+        break;
+
+      state = acquire (state, waiter->exclusive);
+
+      dex_lock_waiter_dequeue (&rw_lock->waiters);
+      dex_lock_waiter_grant (waiter, ready);
+    }
+
+  if (rw_lock->waiters.length == 0)
+    state &= ~RW_LOCK_WAITING;
+
+  g_atomic_int_set (&rw_lock->state, state);
+}
+
+static void dex_rw_lock_unlock (DexRWLock *rw_lock,
+                                gboolean   exclusive);
+
+static void
+dex_rw_lock_cancel (DexObject     *owner,
+                    DexLockWaiter *waiter)
+{
+  DexRWLock *rw_lock = DEX_RW_LOCK (owner);
+  GQueue ready = G_QUEUE_INIT;
+  gboolean unlinked;
+
+  /* Removing a writer from the head may allow the readers behind it */
+  dex_object_lock (rw_lock);
+  if ((unlinked = dex_lock_waiter_unlink (waiter, &rw_lock->waiters)))
+    dex_rw_lock_dispatch_locked (rw_lock, &ready);
+  dex_object_unlock (rw_lock);
+
+  dex_lock_waiter_wake_all (&ready);
+
+  if (unlinked)
+    dex_lock_waiter_cancelled (waiter);
+  else if (dex_lock_waiter_revoke (waiter))
+    dex_rw_lock_unlock (rw_lock, waiter->exclusive);
+}
+
+static gboolean
+dex_rw_lock_trylock (DexRWLock *rw_lock,
+                     gboolean   exclusive)
+{
+  int state;
+
+  while (((state = g_atomic_int_get (&rw_lock->state)) & RW_LOCK_WAITING) == 0 &&
+         can_acquire (state, exclusive))
+    {
+      if (g_atomic_int_compare_and_exchange (&rw_lock->state, state, acquire (state, exclusive)))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static DexFuture *
+dex_rw_lock_lock (DexRWLock *rw_lock,
+                  gboolean   exclusive)
+{
+  DexLockWaiter *waiter;
+
+  if (dex_rw_lock_trylock (rw_lock, exclusive))
+    return dex_future_new_for_boolean (TRUE);
+
+  dex_object_lock (rw_lock);
+
+  for (;;)
+    {
+      int state = g_atomic_int_get (&rw_lock->state);
+
+      if ((state & RW_LOCK_WAITING) != 0)
+        break;
+
+      /* Released while we were taking the object lock */
+      if (can_acquire (state, exclusive))
+        {
+          if (g_atomic_int_compare_and_exchange (&rw_lock->state, state, acquire (state, exclusive)))
+            {
+              dex_object_unlock (rw_lock);
+              return dex_future_new_for_boolean (TRUE);
+            }
+
+          continue;
+        }
+
+      /* Force new lockers and the holders into the slow path */
+      if (g_atomic_int_compare_and_exchange (&rw_lock->state, state, state | RW_LOCK_WAITING))
+        break;
+    }
+
+  waiter = dex_lock_waiter_new (DEX_OBJECT (rw_lock), dex_rw_lock_cancel, exclusive);
+  dex_lock_waiter_enqueue (waiter, &rw_lock->waiters);
+
+  dex_object_unlock (rw_lock);
+
+  return DEX_FUTURE (waiter);
+}
+
+static void
+dex_rw_lock_unlock (DexRWLock *rw_lock,
+                    gboolean   exclusive)
+{
+  GQueue ready = G_QUEUE_INIT;
+  int state;
+
+  while (((state = g_atomic_int_get (&rw_lock->state)) & RW_LOCK_WAITING) == 0)
+    {
+      int new_state = exclusive ? (state & ~RW_LOCK_WRITER) : (state - 1);
+
+      if (g_atomic_int_compare_and_exchange (&rw_lock->state, state, new_state))
+        return;
+    }
+
+  /* RW_LOCK_WAITING keeps everyone else off the fast paths */
+  dex_object_lock (rw_lock);
+  state = g_atomic_int_get (&rw_lock->state);
+  g_atomic_int_set (&rw_lock->state, exclusive ? (state & ~RW_LOCK_WRITER) : (state - 1));
+  dex_rw_lock_dispatch_locked (rw_lock, &ready);
+  dex_object_unlock (rw_lock);
+
+  dex_lock_waiter_wake_all (&ready);
+}
+
+/**
+ * dex_rw_lock_new:
+ *
+ * Creates a new #DexRWLock.
+ *
+ * Returns: (transfer full): a #DexRWLock
+ *
+ * Since: 0.8
+ */
+DexRWLock *
+dex_rw_lock_new (void)
+{
+  return (DexRWLock *)dex_object_create_instance (DEX_TYPE_RW_LOCK);
+}
+
+/**
+ * dex_rw_lock_reader_lock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Acquires @rw_lock for reading.
+ *
+ * Release it with dex_rw_lock_reader_unlock() once the future resolves.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_rw_lock_reader_lock (DexRWLock *rw_lock)
+{
+  g_return_val_if_fail (DEX_IS_RW_LOCK (rw_lock), NULL);
+
+  return dex_rw_lock_lock (rw_lock, FALSE);
+}
+
+/**
+ * dex_rw_lock_reader_trylock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Acquires @rw_lock for reading if that is possible without waiting.
+ *
+ * Returns: %TRUE if @rw_lock was acquired
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_rw_lock_reader_trylock (DexRWLock *rw_lock)
+{
+  g_return_val_if_fail (DEX_IS_RW_LOCK (rw_lock), FALSE);
+
+  return dex_rw_lock_trylock (rw_lock, FALSE);
+}
+
+/**
+ * dex_rw_lock_reader_unlock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Releases a read lock on @rw_lock.
+ *
+ * Since: 0.8
+ */
+void
+dex_rw_lock_reader_unlock (DexRWLock *rw_lock)
+{
+  g_return_if_fail (DEX_IS_RW_LOCK (rw_lock));
+
+  dex_rw_lock_unlock (rw_lock, FALSE);
+}
+
+/**
+ * dex_rw_lock_writer_lock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Acquires @rw_lock for writing.
+ *
+ * Release it with dex_rw_lock_writer_unlock() once the future resolves.
+ *
+ * Returns: (transfer full): a #DexFuture that resolves to %TRUE
+ *
+ * Since: 0.8
+ */
+DexFuture *
+dex_rw_lock_writer_lock (DexRWLock *rw_lock)
+{
+  g_return_val_if_fail (DEX_IS_RW_LOCK (rw_lock), NULL);
+
+  return dex_rw_lock_lock (rw_lock, TRUE);
+}
+
+/**
+ * dex_rw_lock_writer_trylock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Acquires @rw_lock for writing if that is possible without waiting.
+ *
+ * Returns: %TRUE if @rw_lock was acquired
+ *
+ * Since: 0.8
+ */
+gboolean
+dex_rw_lock_writer_trylock (DexRWLock *rw_lock)
+{
+  g_return_val_if_fail (DEX_IS_RW_LOCK (rw_lock), FALSE);
+
+  return dex_rw_lock_trylock (rw_lock, TRUE);
+}
+
+/**
+ * dex_rw_lock_writer_unlock:
+ * @rw_lock: a #DexRWLock
+ *
+ * Releases the write lock on @rw_lock.
+ *
+ * Since: 0.8
+ */
+void
+dex_rw_lock_writer_unlock (DexRWLock *rw_lock)
+{
+  g_return_if_fail (DEX_IS_RW_LOCK (rw_lock));
+
+  dex_rw_lock_unlock (rw_lock, TRUE);
+}
@@ -0,0 +1,56 @@
+/*
+ * dex-rw-lock.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "dex-future.h"
+
+G_BEGIN_DECLS
+
+#define DEX_TYPE_RW_LOCK    (dex_rw_lock_get_type())
+#define DEX_RW_LOCK(obj)    (G_TYPE_CHECK_INSTANCE_CAST(obj, DEX_TYPE_RW_LOCK, DexRWLock))
+#define DEX_IS_RW_LOCK(obj) (G_TYPE_CHECK_INSTANCE_TYPE(obj, DEX_TYPE_RW_LOCK))
+
+typedef struct _DexRWLock DexRWLock;
+
+DEX_AVAILABLE_IN_ALL
+GType      dex_rw_lock_get_type       (void) G_GNUC_CONST;
+DEX_AVAILABLE_IN_ALL
+DexRWLock *dex_rw_lock_new            (void)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_rw_lock_reader_lock    (DexRWLock *rw_lock)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+gboolean   dex_rw_lock_reader_trylock (DexRWLock *rw_lock);
+DEX_AVAILABLE_IN_ALL
+void       dex_rw_lock_reader_unlock  (DexRWLock *rw_lock);
+DEX_AVAILABLE_IN_ALL
+DexFuture *dex_rw_lock_writer_lock    (DexRWLock *rw_lock)
+  G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+gboolean   dex_rw_lock_writer_trylock (DexRWLock *rw_lock);
+DEX_AVAILABLE_IN_ALL
+void       dex_rw_lock_writer_unlock  (DexRWLock *rw_lock);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DexRWLock, dex_unref)
+
+G_END_DECLS
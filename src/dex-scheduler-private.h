@@ -24,6 +24,7 @@
 #include "dex-aio-backend-private.h"
 #include "dex-fiber.h"
 #include "dex-object-private.h"
+#include "dex-probes-private.h"
 #include "dex-scheduler.h"
 
 G_BEGIN_DECLS
@@ -52,6 +53,8 @@ typedef struct _DexSchedulerClass
                                       DexFiber     *fiber);
   GMainContext  *(*get_main_context) (DexScheduler *scheduler);
   DexAioContext *(*get_aio_context)  (DexScheduler *scheduler);
+  void           (*get_stats)        (DexScheduler      *scheduler,
+                                      DexSchedulerStats *stats);
 } DexSchedulerClass;
 
 void           dex_scheduler_set_thread_default (DexScheduler *scheduler);
@@ -61,6 +64,7 @@ DexAioContext *dex_scheduler_get_aio_context    (DexScheduler *scheduler);
 static inline void
 dex_work_item_invoke (const DexWorkItem *work_item)
 {
+  DEX_PROBE2 (work_item_execute, work_item->func, work_item->func_data);
   work_item->func (work_item->func_data);
 }
 
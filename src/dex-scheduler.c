@@ -21,9 +21,13 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "dex-aio-backend-private.h"
 #include "dex-fiber-private.h"
+#include "dex-probes-private.h"
 #include "dex-scheduler-private.h"
+#include "dex-stats-private.h"
 #include "dex-thread-storage-private.h"
 
 /**
@@ -135,6 +139,8 @@ dex_scheduler_push (DexScheduler     *scheduler,
   g_return_if_fail (DEX_IS_SCHEDULER (scheduler));
   g_return_if_fail (func != NULL);
 
+  DEX_PROBE3 (work_item_push, scheduler, func, func_data);
+
   DEX_SCHEDULER_GET_CLASS (scheduler)->push (scheduler, (DexWorkItem) {func, func_data});
 }
 
@@ -215,3 +221,54 @@ dex_scheduler_spawn (DexScheduler   *scheduler,
   DEX_SCHEDULER_GET_CLASS (scheduler)->spawn (scheduler, fiber);
   return DEX_FUTURE (fiber);
 }
+
+/**
+ * dex_scheduler_get_stats:
+ * @scheduler: a #DexScheduler
+ * @stats: (out caller-allocates): location for the stats
+ *
+ * Collects runtime statistics for @scheduler and the sub-schedulers,
+ * work queues, and AIO contexts it owns.
+ *
+ * Futures are not owned by a scheduler, so their counters are only
+ * available from dex_scheduler_get_global_stats().
+ *
+ * Since: 0.8
+ */
+void
+dex_scheduler_get_stats (DexScheduler      *scheduler,
+                         DexSchedulerStats *stats)
+{
+  g_return_if_fail (DEX_IS_SCHEDULER (scheduler));
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof *stats);
+
+  if (DEX_SCHEDULER_GET_CLASS (scheduler)->get_stats)
+    DEX_SCHEDULER_GET_CLASS (scheduler)->get_stats (scheduler, stats);
+}
+
+/**
+ * dex_scheduler_get_global_stats:
+ * @stats: (out caller-allocates): location for the stats
+ *
+ * Collects runtime statistics for the whole process.
+ *
+ * This includes every scheduler, including those which have since been
+ * finalized, as well as the number of futures created and completed.
+ * Use dex_future_foreach_type_stats() for a per-type breakdown of futures.
+ *
+ * This is meant to be cheap enough to be scraped periodically into a
+ * metrics system.
+ *
+ * Since: 0.8
+ */
+void
+dex_scheduler_get_global_stats (DexSchedulerStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof *stats);
+
+  dex_stats_collect_global (stats);
+}
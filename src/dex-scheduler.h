@@ -56,6 +56,54 @@ typedef void (*DexSchedulerFunc) (gpointer user_data);
  */
 typedef DexFuture *(*DexFiberFunc) (gpointer user_data);
 
+/**
+ * DexSchedulerStats:
+ * @n_futures_created: number of futures created, only set for process-wide
+ *   stats and while enabled with dex_future_set_type_stats_enabled()
+ * @n_futures_completed: number of futures resolved or rejected, only set
+ *   for process-wide stats and while enabled with
+ *   dex_future_set_type_stats_enabled()
+ * @n_fibers_spawned: number of fibers spawned
+ * @n_fiber_switches: number of times a fiber was switched into
+ * @n_fibers_runnable: number of fibers currently runnable
+ * @n_fibers_blocked: number of fibers currently blocked
+ * @n_work_items_pushed: number of work items pushed
+ * @n_work_items_executed: number of work items executed
+ * @n_steal_attempts: number of times a worker tried to steal from a peer
+ * @n_steal_successes: number of work items stolen from a peer
+ * @global_queue_depth: number of work items waiting in global work queues
+ * @n_aio_submitted: number of AIO operations submitted
+ * @n_aio_completed: number of AIO operations completed
+ *
+ * Runtime statistics for a #DexScheduler or the whole process.
+ *
+ * Counters are monotonic and updated atomically but independently of each
+ * other, so a snapshot is not guaranteed to be consistent across fields.
+ * On 32-bit platforms they wrap around after %G_MAXSIZE events. The
+ * `n_fibers_runnable`, `n_fibers_blocked` and `global_queue_depth` fields
+ * are gauges sampled at the time of the call.
+ *
+ * Since: 0.8
+ */
+typedef struct _DexSchedulerStats
+{
+  guint64 n_futures_created;
+  guint64 n_futures_completed;
+  guint64 n_fibers_spawned;
+  guint64 n_fiber_switches;
+  guint64 n_fibers_runnable;
+  guint64 n_fibers_blocked;
+  guint64 n_work_items_pushed;
+  guint64 n_work_items_executed;
+  guint64 n_steal_attempts;
+  guint64 n_steal_successes;
+  guint64 global_queue_depth;
+  guint64 n_aio_submitted;
+  guint64 n_aio_completed;
+  /*< private >*/
+  guint64 _reserved[8];
+} DexSchedulerStats;
+
 DEX_AVAILABLE_IN_ALL
 GType         dex_scheduler_get_type           (void) G_GNUC_CONST;
 DEX_AVAILABLE_IN_ALL
@@ -78,6 +126,11 @@ DexFuture    *dex_scheduler_spawn              (DexScheduler     *scheduler,
                                                 gpointer          func_data,
                                                 GDestroyNotify    func_data_destroy)
   G_GNUC_WARN_UNUSED_RESULT;
+DEX_AVAILABLE_IN_ALL
+void          dex_scheduler_get_stats          (DexScheduler      *scheduler,
+                                                DexSchedulerStats *stats);
+DEX_AVAILABLE_IN_ALL
+void          dex_scheduler_get_global_stats   (DexSchedulerStats *stats);
 
 #if G_GNUC_CHECK_VERSION(3,0) && defined(DEX_ENABLE_DEBUG)
 # define _DEX_FIBER_NEW_(counter, ...) \
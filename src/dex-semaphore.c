@@ -39,6 +39,7 @@
 #include "dex-error.h"
 #include "dex-future-private.h"
 #include "dex-object-private.h"
+#include "dex-probes-private.h"
 #include "dex-promise.h"
 #include "dex-semaphore-private.h"
 #include "dex-thread-storage-private.h"
@@ -58,6 +59,14 @@
  * work can be completed in a single io_uring_submit() when running
  * on Linux.
  *
+ * Both of those are only used to park a waiter. The number of available
+ * permits is kept in an atomic counter which goes negative by the number
+ * of parked waiters. Posting when nobody is parked and waiting when a
+ * permit is available only touch that counter, so the uncontended case
+ * requires neither a system call nor an allocation under the lock. Only
+ * when a post finds parked waiters does it write to the eventfd (or
+ * complete waiter futures) and only for as many as it can wake.
+ *
  * We will use the fallback case if we're not on io_uring because
  * otherwise we lock up our thread pool with blocking read().
  *
@@ -119,8 +128,14 @@ struct _DexSemaphore
   int eventfd;
 #endif
 
+  /* Available permits, or negated number of parked waiters */
+  int permits;
+
+  /* Wake-ups posted to parked waiters in the fallback case */
   gint64 counter;
   GQueue waiters;
+
+  int closed;
 };
 
 typedef struct _DexSemaphoreClass
@@ -202,15 +217,46 @@ dex_semaphore_post (DexSemaphore *semaphore)
   return dex_semaphore_post_many (semaphore, 1);
 }
 
+gboolean
+dex_semaphore_try_acquire (DexSemaphore *semaphore)
+{
+  int permits;
+
+  g_return_val_if_fail (DEX_IS_SEMAPHORE (semaphore), FALSE);
+
+  while ((permits = g_atomic_int_get (&semaphore->permits)) > 0)
+    {
+      if (g_atomic_int_compare_and_exchange (&semaphore->permits, permits, permits - 1))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 void
 dex_semaphore_post_many (DexSemaphore *semaphore,
                          guint         count)
 {
+  int old_permits;
+
   g_return_if_fail (DEX_IS_SEMAPHORE (semaphore));
+  g_return_if_fail (count <= G_MAXINT);
 
   if (count == 0)
     return;
 
+  DEX_PROBE2 (semaphore_post, semaphore, count);
+
+  /* Only wake as many parked waiters as there are, the rest of the
+   * permits remain in the counter for the fast path.
+   */
+  old_permits = g_atomic_int_add (&semaphore->permits, (int)count);
+
+  if (old_permits >= 0)
+    return;
+
+  count = MIN (count, (guint)-old_permits);
+
 #ifdef HAVE_EVENTFD
   if (semaphore->eventfd != -1)
     {
@@ -266,6 +312,25 @@ dex_semaphore_wait (DexSemaphore *semaphore)
 {
   g_return_val_if_fail (DEX_IS_SEMAPHORE (semaphore), NULL);
 
+  DEX_PROBE1 (semaphore_wait, semaphore);
+
+  if (g_atomic_int_get (&semaphore->closed))
+    return dex_future_new_for_error (g_error_copy (&semaphore_closed_error));
+
+  if (dex_semaphore_try_acquire (semaphore))
+    return dex_future_new_for_boolean (TRUE);
+
+  /* Register as a parked waiter, unless a permit was posted since */
+  if (g_atomic_int_add (&semaphore->permits, -1) > 0)
+    return dex_future_new_for_boolean (TRUE);
+
+  /* Closed while registering, nobody will wake us so give it back */
+  if (g_atomic_int_get (&semaphore->closed))
+    {
+      g_atomic_int_inc (&semaphore->permits);
+      return dex_future_new_for_error (g_error_copy (&semaphore_closed_error));
+    }
+
 #ifdef HAVE_EVENTFD
   if (semaphore->eventfd != -1)
     {
@@ -325,6 +390,8 @@ dex_semaphore_close (DexSemaphore *semaphore)
 
   dex_object_lock (semaphore);
 
+  g_atomic_int_set (&semaphore->closed, TRUE);
+
 #ifdef HAVE_EVENTFD
   if (semaphore->eventfd != -1)
     {
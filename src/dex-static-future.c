@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include "dex-future-private.h"
+#include "dex-probes-private.h"
 #include "dex-static-future-private.h"
 
 /**
@@ -71,6 +72,9 @@ dex_static_future_new_rejected (GError *error)
   ret = (DexFuture *)dex_object_create_instance (DEX_TYPE_STATIC_FUTURE);
   ret->rejected = error;
   ret->status = DEX_FUTURE_STATUS_REJECTED;
+  dex_future_count_completed (ret);
+
+  DEX_PROBE3 (future_complete, ret, ret->name, (int)ret->status);
 
   return DEX_FUTURE (ret);
 }
@@ -86,6 +90,9 @@ dex_static_future_new_resolved (const GValue *value)
   g_value_init (&ret->resolved, G_VALUE_TYPE (value));
   g_value_copy (value, &ret->resolved);
   ret->status = DEX_FUTURE_STATUS_RESOLVED;
+  dex_future_count_completed (ret);
+
+  DEX_PROBE3 (future_complete, ret, ret->name, (int)ret->status);
 
   return DEX_FUTURE (ret);
 }
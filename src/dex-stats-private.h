@@ -0,0 +1,86 @@
+/*
+ * dex-stats-private.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "dex-scheduler.h"
+
+G_BEGIN_DECLS
+
+/* Pointer sized so that 64-bit hosts get 64-bit counters while 32-bit
+ * targets can still update them without libatomic.
+ */
+typedef gsize DexStatsCounter;
+
+typedef struct _DexStats DexStats;
+
+typedef void (*DexStatsSampleFunc) (DexStats          *stats,
+                                    DexSchedulerStats *out_stats);
+
+/* Counters embedded in the schedulers, fiber schedulers, work queues and
+ * AIO contexts. Each owner only bumps the counters it cares about from the
+ * hot path, each with a single atomic add. Gauges such as queue depth are
+ * read through @sample when collecting so the hot path does not pay for
+ * them at all.
+ */
+struct _DexStats
+{
+  GList              link;
+  DexStatsSampleFunc sample;
+  DexStatsCounter    fibers_spawned;
+  DexStatsCounter    fiber_switches;
+  DexStatsCounter    work_items_pushed;
+  DexStatsCounter    work_items_executed;
+  DexStatsCounter    steal_attempts;
+  DexStatsCounter    steal_successes;
+  DexStatsCounter    aio_submitted;
+  DexStatsCounter    aio_completed;
+};
+
+void dex_stats_register       (DexStats           *stats,
+                               DexStatsSampleFunc  sample);
+void dex_stats_unregister     (DexStats           *stats);
+void dex_stats_collect        (DexStats           *stats,
+                               DexSchedulerStats  *out_stats);
+void dex_stats_collect_global (DexSchedulerStats  *out_stats);
+
+static inline void
+dex_stats_counter_add (DexStatsCounter *counter,
+                       guint64          value)
+{
+  g_atomic_pointer_add (counter, (gssize)value);
+}
+
+static inline guint64
+dex_stats_counter_get (DexStatsCounter *counter)
+{
+  return (gsize)g_atomic_pointer_get (counter);
+}
+
+static inline void
+dex_stats_counter_reset (DexStatsCounter *counter)
+{
+  g_atomic_pointer_set (counter, 0);
+}
+
+G_END_DECLS
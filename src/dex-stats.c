@@ -0,0 +1,133 @@
+/*
+ * dex-stats.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include "dex-future-private.h"
+#include "dex-stats-private.h"
+
+/* All live counter blocks are linked here so that process-wide stats can
+ * be collected without a shared (and therefore contended) counter in the
+ * hot paths. Blocks that go away are folded into @retired so the totals
+ * remain monotonic.
+ */
+static GMutex   stats_mutex;
+static GQueue   stats_live;
+static DexStats stats_retired;
+
+static void
+dex_stats_collect_counters (DexStats          *stats,
+                            DexSchedulerStats *out_stats)
+{
+  out_stats->n_fibers_spawned += dex_stats_counter_get (&stats->fibers_spawned);
+  out_stats->n_fiber_switches += dex_stats_counter_get (&stats->fiber_switches);
+  out_stats->n_work_items_pushed += dex_stats_counter_get (&stats->work_items_pushed);
+  out_stats->n_work_items_executed += dex_stats_counter_get (&stats->work_items_executed);
+  out_stats->n_steal_attempts += dex_stats_counter_get (&stats->steal_attempts);
+  out_stats->n_steal_successes += dex_stats_counter_get (&stats->steal_successes);
+  out_stats->n_aio_submitted += dex_stats_counter_get (&stats->aio_submitted);
+  out_stats->n_aio_completed += dex_stats_counter_get (&stats->aio_completed);
+}
+
+void
+dex_stats_register (DexStats           *stats,
+                    DexStatsSampleFunc  sample)
+{
+  g_return_if_fail (stats != NULL);
+  g_return_if_fail (stats->link.data == NULL);
+
+  stats->link.data = stats;
+  stats->sample = sample;
+
+  g_mutex_lock (&stats_mutex);
+  g_queue_push_tail_link (&stats_live, &stats->link);
+  g_mutex_unlock (&stats_mutex);
+}
+
+void
+dex_stats_unregister (DexStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  /* Owners may be torn down after failing to initialize */
+  if (stats->link.data == NULL)
+    return;
+
+  g_mutex_lock (&stats_mutex);
+  g_queue_unlink (&stats_live, &stats->link);
+  dex_stats_counter_add (&stats_retired.fibers_spawned, dex_stats_counter_get (&stats->fibers_spawned));
+  dex_stats_counter_add (&stats_retired.fiber_switches, dex_stats_counter_get (&stats->fiber_switches));
+  dex_stats_counter_add (&stats_retired.work_items_pushed, dex_stats_counter_get (&stats->work_items_pushed));
+  dex_stats_counter_add (&stats_retired.work_items_executed, dex_stats_counter_get (&stats->work_items_executed));
+  dex_stats_counter_add (&stats_retired.steal_attempts, dex_stats_counter_get (&stats->steal_attempts));
+  dex_stats_counter_add (&stats_retired.steal_successes, dex_stats_counter_get (&stats->steal_successes));
+  dex_stats_counter_add (&stats_retired.aio_submitted, dex_stats_counter_get (&stats->aio_submitted));
+  dex_stats_counter_add (&stats_retired.aio_completed, dex_stats_counter_get (&stats->aio_completed));
+  g_mutex_unlock (&stats_mutex);
+
+  stats->link.data = NULL;
+  stats->sample = NULL;
+}
+
+/*
+ * dex_stats_collect:
+ *
+ * Adds the counters of @stats to @out_stats. Gauges are sampled from the
+ * owner of @stats which may require taking its lock.
+ */
+void
+dex_stats_collect (DexStats          *stats,
+                   DexSchedulerStats *out_stats)
+{
+  g_return_if_fail (stats != NULL);
+  g_return_if_fail (out_stats != NULL);
+
+  dex_stats_collect_counters (stats, out_stats);
+
+  if (stats->sample != NULL)
+    stats->sample (stats, out_stats);
+}
+
+static void
+dex_stats_collect_futures (GType     type,
+                           guint64   n_created,
+                           guint64   n_completed,
+                           gpointer  user_data)
+{
+  DexSchedulerStats *out_stats = user_data;
+
+  out_stats->n_futures_created += n_created;
+  out_stats->n_futures_completed += n_completed;
+}
+
+void
+dex_stats_collect_global (DexSchedulerStats *out_stats)
+{
+  g_return_if_fail (out_stats != NULL);
+
+  g_mutex_lock (&stats_mutex);
+  dex_stats_collect_counters (&stats_retired, out_stats);
+  for (const GList *iter = stats_live.head; iter; iter = iter->next)
+    dex_stats_collect (iter->data, out_stats);
+  g_mutex_unlock (&stats_mutex);
+
+  dex_future_foreach_type_stats (dex_stats_collect_futures, out_stats);
+}
@@ -122,6 +122,22 @@ dex_thread_pool_scheduler_spawn (DexScheduler *scheduler,
   DEX_SCHEDULER_GET_CLASS (worker)->spawn (DEX_SCHEDULER (worker), fiber);
 }
 
+static void
+dex_thread_pool_scheduler_get_stats (DexScheduler      *scheduler,
+                                     DexSchedulerStats *stats)
+{
+  DexThreadPoolScheduler *thread_pool_scheduler = (DexThreadPoolScheduler *)scheduler;
+
+  dex_work_queue_collect_stats (thread_pool_scheduler->global_work_queue, stats);
+
+  for (guint i = 0; i < thread_pool_scheduler->workers->len; i++)
+    {
+      DexScheduler *worker = g_ptr_array_index (thread_pool_scheduler->workers, i);
+
+      DEX_SCHEDULER_GET_CLASS (worker)->get_stats (worker, stats);
+    }
+}
+
 static void
 dex_thread_pool_scheduler_finalize (DexObject *object)
 {
@@ -147,6 +163,7 @@ dex_thread_pool_scheduler_class_init (DexThreadPoolSchedulerClass *thread_pool_s
   scheduler_class->get_aio_context = dex_thread_pool_scheduler_get_aio_context;
   scheduler_class->push = dex_thread_pool_scheduler_push;
   scheduler_class->spawn = dex_thread_pool_scheduler_spawn;
+  scheduler_class->get_stats = dex_thread_pool_scheduler_get_stats;
 }
 
 static void
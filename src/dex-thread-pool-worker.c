@@ -26,6 +26,8 @@
 #include "dex-aio-backend-private.h"
 #include "dex-compat-private.h"
 #include "dex-fiber-private.h"
+#include "dex-probes-private.h"
+#include "dex-stats-private.h"
 #include "dex-thread-pool-worker-private.h"
 #include "dex-thread-storage-private.h"
 #include "dex-work-stealing-queue-private.h"
@@ -59,6 +61,8 @@ struct _DexThreadPoolWorker
   GMutex                     setup_mutex;
   GCond                      setup_cond;
 
+  DexStats                   stats;
+
   DexThreadPoolWorkerStatus  status : 2;
 };
 
@@ -83,7 +87,13 @@ static gboolean
 dex_thread_pool_worker_work_item_cb (gpointer user_data)
 {
   DexWorkItem *work_item = user_data;
+  DexThreadPoolWorker *thread_pool_worker = DEX_THREAD_POOL_WORKER_CURRENT;
+
   dex_work_item_invoke (work_item);
+
+  if (thread_pool_worker != NULL)
+    dex_stats_counter_add (&thread_pool_worker->stats.work_items_executed, 1);
+
   return G_SOURCE_REMOVE;
 }
 
@@ -95,6 +105,8 @@ dex_thread_pool_worker_push (DexScheduler *scheduler,
 
   g_assert (DEX_IS_THREAD_POOL_WORKER (thread_pool_worker));
 
+  dex_stats_counter_add (&thread_pool_worker->stats.work_items_pushed, 1);
+
   if G_LIKELY (g_thread_self () == thread_pool_worker->thread &&
                thread_pool_worker->status == DEX_THREAD_POOL_WORKER_RUNNING)
     dex_work_stealing_queue_push (thread_pool_worker->work_stealing_queue, work_item);
@@ -139,7 +151,10 @@ dex_thread_pool_worker_finalize_cb (gpointer data)
 
   /* Now flush out the rest of the work items if there are any */
   while (dex_work_stealing_queue_pop (thread_pool_worker->work_stealing_queue, &work_item))
-    dex_work_item_invoke (&work_item);
+    {
+      dex_work_item_invoke (&work_item);
+      dex_stats_counter_add (&thread_pool_worker->stats.work_items_executed, 1);
+    }
 
   return G_SOURCE_REMOVE;
 }
@@ -182,6 +197,8 @@ dex_thread_pool_worker_finalize (DexObject *object)
   g_clear_pointer (&thread_pool_worker->local_source, g_source_unref);
   g_clear_pointer (&thread_pool_worker->fiber_scheduler, g_source_unref);
 
+  dex_stats_unregister (&thread_pool_worker->stats);
+
   g_clear_pointer (&thread_pool_worker->thread, g_thread_unref);
   g_clear_pointer (&thread_pool_worker->main_context, g_main_context_unref);
   g_clear_pointer (&thread_pool_worker->main_loop, g_main_loop_unref);
@@ -229,6 +246,23 @@ dex_thread_pool_worker_spawn (DexScheduler *scheduler,
   dex_fiber_scheduler_register ((DexFiberScheduler *)thread_pool_worker->fiber_scheduler, fiber);
 }
 
+static void
+dex_thread_pool_worker_get_stats (DexScheduler      *scheduler,
+                                  DexSchedulerStats *stats)
+{
+  DexThreadPoolWorker *thread_pool_worker = DEX_THREAD_POOL_WORKER (scheduler);
+
+  g_assert (DEX_IS_THREAD_POOL_WORKER (thread_pool_worker));
+
+  dex_stats_collect (&thread_pool_worker->stats, stats);
+
+  if (thread_pool_worker->fiber_scheduler != NULL)
+    dex_stats_collect (&((DexFiberScheduler *)thread_pool_worker->fiber_scheduler)->stats, stats);
+
+  if (thread_pool_worker->aio_context != NULL)
+    dex_stats_collect (&thread_pool_worker->aio_context->stats, stats);
+}
+
 static void
 dex_thread_pool_worker_class_init (DexThreadPoolWorkerClass *thread_pool_worker_class)
 {
@@ -241,6 +275,7 @@ dex_thread_pool_worker_class_init (DexThreadPoolWorkerClass *thread_pool_worker_
   scheduler_class->get_main_context = dex_thread_pool_worker_get_main_context;
   scheduler_class->spawn = dex_thread_pool_worker_spawn;
   scheduler_class->get_aio_context = dex_thread_pool_worker_get_aio_context;
+  scheduler_class->get_stats = dex_thread_pool_worker_get_stats;
 }
 
 static void
@@ -250,6 +285,8 @@ dex_thread_pool_worker_init (DexThreadPoolWorker *thread_pool_worker)
 
   g_mutex_init (&thread_pool_worker->setup_mutex);
   g_cond_init (&thread_pool_worker->setup_cond);
+
+  dex_stats_register (&thread_pool_worker->stats, NULL);
 }
 
 static gpointer
@@ -288,7 +325,8 @@ dex_thread_pool_worker_thread_func (gpointer data)
   /* Attach a GSource that will process items from the worker threads
    * work queue.
    */
-  source = dex_work_stealing_queue_create_source (thread_pool_worker->work_stealing_queue);
+  source = dex_work_stealing_queue_create_source (thread_pool_worker->work_stealing_queue,
+                                                  &thread_pool_worker->stats);
   g_source_set_priority (source, G_PRIORITY_DEFAULT);
   g_source_attach (source, thread_pool_worker->main_context);
   thread_pool_worker->local_source = g_steal_pointer (&source);
@@ -361,9 +399,14 @@ dex_thread_pool_worker_maybe_steal (DexThreadPoolWorker *thread_pool_worker,
   g_assert (DEX_IS_THREAD_POOL_WORKER (thread_pool_worker));
   g_assert (DEX_IS_THREAD_POOL_WORKER (neighbor));
 
+  dex_stats_counter_add (&thread_pool_worker->stats.steal_attempts, 1);
+
   if (dex_work_stealing_queue_steal (neighbor->work_stealing_queue, &work_item))
     {
+      DEX_PROBE2 (work_item_steal, thread_pool_worker, neighbor);
+      dex_stats_counter_add (&thread_pool_worker->stats.steal_successes, 1);
       dex_work_item_invoke (&work_item);
+      dex_stats_counter_add (&thread_pool_worker->stats.work_items_executed, 1);
       return TRUE;
     }
 
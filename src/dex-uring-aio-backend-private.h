@@ -30,8 +30,11 @@ G_BEGIN_DECLS
 
 typedef struct _DexUringAioBackend      DexUringAioBackend;
 typedef struct _DexUringAioBackendClass DexUringAioBackendClass;
+typedef struct _DexUringFuture          DexUringFuture;
 
 GType          dex_uring_aio_backend_get_type (void) G_GNUC_CONST;
 DexAioBackend *dex_uring_aio_backend_new      (void);
+void           dex_uring_aio_context_cancel   (DexAioContext  *aio_context,
+                                               DexUringFuture *future);
 
 G_END_DECLS
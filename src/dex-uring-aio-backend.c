@@ -53,7 +53,13 @@ typedef struct _DexUringAioContext
   gpointer         eventfdtag;
   GMutex           mutex;
   GQueue           queued;
+  struct io_uring  iopoll_ring;
+  guint            iopoll_inflight;
+  guint            iopoll_idle;
   guint            ring_initialized : 1;
+  guint            iopoll_initialized : 1;
+  guint            iopoll_failed : 1;
+  guint            send_zc_supported : 1;
 } DexUringAioContext;
 
 DEX_DEFINE_FINAL_TYPE (DexUringAioBackend, dex_uring_aio_backend, DEX_TYPE_AIO_BACKEND)
@@ -91,6 +97,66 @@ dex_uring_check_kernel_version (int major,
          (kernel_major == major && kernel_minor >= minor);
 }
 
+/* Empty polls of the IOPOLL ring before backing off, see prepare() */
+#define IOPOLL_SPIN_LIMIT 64
+
+static inline void
+dex_uring_aio_context_iopoll_submitted (DexUringAioContext *aio_context)
+{
+  aio_context->iopoll_inflight++;
+  aio_context->iopoll_idle = 0;
+}
+
+static inline struct io_uring *
+dex_uring_aio_context_get_ring (DexUringAioContext *aio_context,
+                                DexUringFuture     *future)
+{
+  if (dex_uring_future_get_iopoll (future))
+    return &aio_context->iopoll_ring;
+
+  return &aio_context->ring;
+}
+
+static void
+dex_uring_aio_context_reap (DexUringAioContext  *aio_context,
+                            struct io_uring     *ring,
+                            DexUringFuture     **handled,
+                            guint               *n_handled,
+                            guint                max_handled)
+{
+  struct io_uring_cqe *cqe;
+
+  while (*n_handled < max_handled &&
+         io_uring_peek_cqe (ring, &cqe) == 0)
+    {
+      DexUringFuture *future = io_uring_cqe_get_data (cqe);
+      DexUringCqeStatus status = dex_uring_future_cqe (future, cqe);
+
+      io_uring_cqe_seen (ring, cqe);
+
+      /* Requests on the IOPOLL ring only ever produce a single CQE */
+      if (ring == &aio_context->iopoll_ring)
+        aio_context->iopoll_inflight--;
+
+      /* Keep our reference until the final CQE arrives */
+      if (status == DEX_URING_CQE_PENDING)
+        continue;
+
+      /* Give our reference back to the queue to be submitted again
+       * during the next prepare().
+       */
+      if (status == DEX_URING_CQE_RESUBMIT)
+        {
+          g_mutex_lock (&aio_context->mutex);
+          g_queue_push_tail (&aio_context->queued, future);
+          g_mutex_unlock (&aio_context->mutex);
+          continue;
+        }
+
+      handled[(*n_handled)++] = future;
+    }
+}
+
 static gboolean
 dex_uring_aio_context_dispatch (GSource     *source,
                                 GSourceFunc  callback,
@@ -98,7 +164,6 @@ dex_uring_aio_context_dispatch (GSource     *source,
 {
   DexUringAioContext *aio_context = (DexUringAioContext *)source;
   DexUringFuture *handledstack[32];
-  struct io_uring_cqe *cqe;
   gint64 counter;
   guint n_handled;
 
@@ -112,15 +177,30 @@ dex_uring_aio_context_dispatch (GSource     *source,
 
 again:
   n_handled = 0;
-  while (io_uring_peek_cqe (&aio_context->ring, &cqe) == 0)
-    {
-      DexUringFuture *future = io_uring_cqe_get_data (cqe);
-      dex_uring_future_cqe (future, cqe);
-      io_uring_cqe_seen (&aio_context->ring, cqe);
-      handledstack[n_handled++] = future;
 
-      if G_UNLIKELY (n_handled == G_N_ELEMENTS (handledstack))
-        break;
+  dex_uring_aio_context_reap (aio_context,
+                              &aio_context->ring,
+                              handledstack,
+                              &n_handled,
+                              G_N_ELEMENTS (handledstack));
+
+  /* Peeking an IOPOLL ring enters the kernel to poll for completions,
+   * so only do that while we have requests outstanding.
+   */
+  if (aio_context->iopoll_inflight > 0)
+    {
+      guint iopoll_inflight = aio_context->iopoll_inflight;
+
+      dex_uring_aio_context_reap (aio_context,
+                                  &aio_context->iopoll_ring,
+                                  handledstack,
+                                  &n_handled,
+                                  G_N_ELEMENTS (handledstack));
+
+      if (aio_context->iopoll_inflight < iopoll_inflight)
+        aio_context->iopoll_idle = 0;
+      else
+        aio_context->iopoll_idle++;
     }
 
   for (guint i = 0; i < n_handled; i++)
@@ -130,6 +210,8 @@ again:
       dex_unref (future);
     }
 
+  dex_stats_counter_add (&aio_context->parent.stats.aio_completed, n_handled);
+
   if G_UNLIKELY (n_handled == G_N_ELEMENTS (handledstack))
     goto again;
 
@@ -155,28 +237,49 @@ dex_uring_aio_context_prepare (GSource *source,
   while (aio_context->queued.length)
     {
       struct io_uring_sqe *sqe;
+      struct io_uring *ring;
       DexUringFuture *future;
 
+      future = g_queue_peek_head (&aio_context->queued);
+      ring = dex_uring_aio_context_get_ring (aio_context, future);
+
       /* Try to get the next sqe, and submit if we can't get
        * one right away. If we still fail to get an sqe, then
        * we'll wait for completions to come in to advance this.
        */
-      if G_UNLIKELY (!(sqe = io_uring_get_sqe (&aio_context->ring)))
+      if G_UNLIKELY (!(sqe = io_uring_get_sqe (ring)))
         {
-          io_uring_submit (&aio_context->ring);
+          io_uring_submit (ring);
 
-          if (!(sqe = io_uring_get_sqe (&aio_context->ring)))
+          if (!(sqe = io_uring_get_sqe (ring)))
             break;
         }
 
-      future = g_queue_pop_head (&aio_context->queued);
+      /* Reference owned by the queue is transferred to the sqe */
+      g_queue_pop_head (&aio_context->queued);
       dex_uring_future_sqe (future, sqe);
-      io_uring_sqe_set_data (sqe, dex_ref (future));
+      io_uring_sqe_set_data (sqe, future);
+
+      if (ring == &aio_context->iopoll_ring)
+        dex_uring_aio_context_iopoll_submitted (aio_context);
     }
 
   if (do_submit || io_uring_sq_ready (&aio_context->ring) > 0)
     io_uring_submit (&aio_context->ring);
 
+  if (aio_context->iopoll_initialized &&
+      io_uring_sq_ready (&aio_context->iopoll_ring) > 0)
+    io_uring_submit (&aio_context->iopoll_ring);
+
+  /* Completions on the IOPOLL ring are not signaled to our eventfd and
+   * must be reaped by polling. Spin while they keep arriving, which is
+   * what IOPOLL is for with fast devices, but once IOPOLL_SPIN_LIMIT polls
+   * in a row found nothing, only poll every millisecond (the finest GLib
+   * timeout) so that a slow or stalled device cannot keep the thread busy.
+   */
+  if (aio_context->iopoll_inflight > 0)
+    *timeout = aio_context->iopoll_idle < IOPOLL_SPIN_LIMIT ? 0 : 1;
+
   g_mutex_unlock (&aio_context->mutex);
 
   return io_uring_cq_ready (&aio_context->ring) > 0;
@@ -190,7 +293,8 @@ dex_uring_aio_context_check (GSource *source)
   g_assert (aio_context != NULL);
   g_assert (DEX_IS_URING_AIO_BACKEND (aio_context->parent.aio_backend));
 
-  return io_uring_cq_ready (&aio_context->ring) > 0;
+  return io_uring_cq_ready (&aio_context->ring) > 0 ||
+         aio_context->iopoll_inflight > 0;
 }
 
 static void
@@ -204,6 +308,11 @@ dex_uring_aio_context_finalize (GSource *source)
   if (aio_context->queued.length > 0)
     g_critical ("Destroying DexAioContext with queued items!");
 
+  dex_stats_unregister (&aio_context->parent.stats);
+
+  if (aio_context->iopoll_initialized)
+    io_uring_queue_exit (&aio_context->iopoll_ring);
+
   if (aio_context->ring_initialized)
     io_uring_queue_exit (&aio_context->ring);
 
@@ -230,20 +339,25 @@ dex_uring_aio_context_queue (DexUringAioContext *aio_context,
 {
   gboolean is_same_thread;
   struct io_uring_sqe *sqe;
+  struct io_uring *ring;
 
   g_assert (aio_context != NULL);
   g_assert (DEX_IS_URING_AIO_BACKEND (aio_context->parent.aio_backend));
   g_assert (DEX_IS_URING_FUTURE (future));
 
   is_same_thread = dex_thread_storage_get ()->aio_context == (DexAioContext *)aio_context;
+  ring = dex_uring_aio_context_get_ring (aio_context, future);
 
   g_mutex_lock (&aio_context->mutex);
   if G_LIKELY (is_same_thread &&
                aio_context->queued.length == 0 &&
-               (sqe = io_uring_get_sqe (&aio_context->ring)))
+               (sqe = io_uring_get_sqe (ring)))
     {
       dex_uring_future_sqe (future, sqe);
       io_uring_sqe_set_data (sqe, dex_ref (future));
+
+      if (ring == &aio_context->iopoll_ring)
+        dex_uring_aio_context_iopoll_submitted (aio_context);
     }
   else
     {
@@ -257,11 +371,40 @@ dex_uring_aio_context_queue (DexUringAioContext *aio_context,
   return DEX_FUTURE (future);
 }
 
+/* Lazily creates a ring with IORING_SETUP_IOPOLL for O_DIRECT requests.
+ * This is separate from our primary ring because polled rings may only
+ * be used with files opened for direct I/O.
+ */
+static gboolean
+dex_uring_aio_context_ensure_iopoll (DexUringAioContext *aio_context)
+{
+  gboolean ret;
+
+  g_mutex_lock (&aio_context->mutex);
+
+  if (!aio_context->iopoll_initialized && !aio_context->iopoll_failed)
+    {
+      if (io_uring_queue_init (DEFAULT_URING_SIZE, &aio_context->iopoll_ring, IORING_SETUP_IOPOLL) == 0)
+        aio_context->iopoll_initialized = TRUE;
+      else
+        aio_context->iopoll_failed = TRUE;
+    }
+
+  ret = aio_context->iopoll_initialized;
+
+  g_mutex_unlock (&aio_context->mutex);
+
+  return ret;
+}
+
 static DexAioContext *
 dex_uring_aio_backend_create_context (DexAioBackend *aio_backend)
 {
   DexUringAioContext *aio_context;
   guint uring_flags = 0;
+#if DEX_URING_CHECK_VERSION(2, 3)
+  struct io_uring_probe *probe;
+#endif
 
   g_assert (DEX_IS_URING_AIO_BACKEND (aio_backend));
 
@@ -290,6 +433,15 @@ dex_uring_aio_backend_create_context (DexAioBackend *aio_backend)
 
   aio_context->ring_initialized = TRUE;
 
+#if DEX_URING_CHECK_VERSION(2, 3)
+  /* Zero-copy send requires Linux 6.0, so probe rather than guess */
+  if ((probe = io_uring_get_probe_ring (&aio_context->ring)))
+    {
+      aio_context->send_zc_supported = !!io_uring_opcode_supported (probe, IORING_OP_SEND_ZC);
+      io_uring_free_probe (probe);
+    }
+#endif
+
 #if DEX_URING_CHECK_VERSION(2, 2)
   /* Register the ring FD so we don't have to on every io_ring_enter() */
   if (io_uring_register_ring_fd (&aio_context->ring) < 0)
@@ -342,6 +494,127 @@ dex_uring_aio_backend_write (DexAioBackend *aio_backend,
                                       dex_uring_future_new_write (fd, buffer, count, offset));
 }
 
+static DexFuture *
+dex_uring_aio_backend_read_direct (DexAioBackend *aio_backend,
+                                   DexAioContext *aio_context,
+                                   int            fd,
+                                   gpointer       buffer,
+                                   gsize          count,
+                                   goffset        offset)
+{
+  DexUringAioContext *uring_aio_context = (DexUringAioContext *)aio_context;
+  DexUringFuture *future = dex_uring_future_new_read (fd, buffer, count, offset);
+
+  if (dex_uring_aio_context_ensure_iopoll (uring_aio_context))
+    dex_uring_future_set_iopoll (future, TRUE);
+
+  return dex_uring_aio_context_queue (uring_aio_context, future);
+}
+
+static DexFuture *
+dex_uring_aio_backend_write_direct (DexAioBackend *aio_backend,
+                                    DexAioContext *aio_context,
+                                    int            fd,
+                                    gconstpointer  buffer,
+                                    gsize          count,
+                                    goffset        offset)
+{
+  DexUringAioContext *uring_aio_context = (DexUringAioContext *)aio_context;
+  DexUringFuture *future = dex_uring_future_new_write (fd, buffer, count, offset);
+
+  if (dex_uring_aio_context_ensure_iopoll (uring_aio_context))
+    dex_uring_future_set_iopoll (future, TRUE);
+
+  return dex_uring_aio_context_queue (uring_aio_context, future);
+}
+
+static DexFuture *
+dex_uring_aio_backend_writev (DexAioBackend       *aio_backend,
+                              DexAioContext       *aio_context,
+                              int                  fd,
+                              const GOutputVector *vectors,
+                              gsize                n_vectors,
+                              goffset              offset)
+{
+  return dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                      dex_uring_future_new_writev (fd, vectors, n_vectors, offset));
+}
+
+static DexFuture *
+dex_uring_aio_backend_send (DexAioBackend *aio_backend,
+                            DexAioContext *aio_context,
+                            int            fd,
+                            gconstpointer  buffer,
+                            gsize          count,
+                            int            flags)
+{
+  return dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                      dex_uring_future_new_send (fd, buffer, count, flags));
+}
+
+static DexFuture *
+dex_uring_aio_backend_send_zc (DexAioBackend *aio_backend,
+                               DexAioContext *aio_context,
+                               int            fd,
+                               gconstpointer  buffer,
+                               gsize          count,
+                               int            flags)
+{
+  DexUringAioContext *uring_aio_context = (DexUringAioContext *)aio_context;
+  DexUringFuture *future;
+
+  if (uring_aio_context->send_zc_supported)
+    future = dex_uring_future_new_send_zc (fd, buffer, count, flags);
+  else
+    future = dex_uring_future_new_send (fd, buffer, count, flags);
+
+  return dex_uring_aio_context_queue (uring_aio_context, future);
+}
+
+static DexFuture *
+dex_uring_aio_backend_poll (DexAioBackend *aio_backend,
+                            DexAioContext *aio_context,
+                            int            fd,
+                            GIOCondition   condition)
+{
+  return dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                      dex_uring_future_new_poll (aio_context, fd, condition));
+}
+
+static DexFuture *
+dex_uring_aio_backend_fadvise (DexAioBackend *aio_backend,
+                               DexAioContext *aio_context,
+                               int            fd,
+                               goffset        offset,
+                               goffset        length,
+                               int            advice)
+{
+  return dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                      dex_uring_future_new_fadvise (fd, offset, length, advice));
+}
+
+static DexFuture *
+dex_uring_aio_backend_madvise (DexAioBackend *aio_backend,
+                               DexAioContext *aio_context,
+                               gpointer       address,
+                               gsize          length,
+                               int            advice)
+{
+  return dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                      dex_uring_future_new_madvise (address, length, advice));
+}
+
+void
+dex_uring_aio_context_cancel (DexAioContext  *aio_context,
+                              DexUringFuture *future)
+{
+  g_return_if_fail (aio_context != NULL);
+  g_return_if_fail (DEX_IS_URING_FUTURE (future));
+
+  dex_unref (dex_uring_aio_context_queue ((DexUringAioContext *)aio_context,
+                                          dex_uring_future_new_cancel (future)));
+}
+
 static void
 dex_uring_aio_backend_class_init (DexUringAioBackendClass *uring_aio_backend_class)
 {
@@ -350,6 +623,14 @@ dex_uring_aio_backend_class_init (DexUringAioBackendClass *uring_aio_backend_cla
   aio_backend_class->create_context = dex_uring_aio_backend_create_context;
   aio_backend_class->read = dex_uring_aio_backend_read;
   aio_backend_class->write = dex_uring_aio_backend_write;
+  aio_backend_class->read_direct = dex_uring_aio_backend_read_direct;
+  aio_backend_class->write_direct = dex_uring_aio_backend_write_direct;
+  aio_backend_class->writev = dex_uring_aio_backend_writev;
+  aio_backend_class->send = dex_uring_aio_backend_send;
+  aio_backend_class->send_zc = dex_uring_aio_backend_send_zc;
+  aio_backend_class->poll = dex_uring_aio_backend_poll;
+  aio_backend_class->fadvise = dex_uring_aio_backend_fadvise;
+  aio_backend_class->madvise = dex_uring_aio_backend_madvise;
 }
 
 static void
@@ -22,6 +22,7 @@
 
 #include <liburing.h>
 
+#include "dex-aio-backend-private.h"
 #include "dex-future.h"
 
 G_BEGIN_DECLS
@@ -32,19 +33,55 @@ G_BEGIN_DECLS
 
 typedef struct _DexUringFuture DexUringFuture;
 
-GType           dex_uring_future_get_type  (void) G_GNUC_CONST;
-DexUringFuture *dex_uring_future_new_read  (int                  fd,
-                                            gpointer             buffer,
-                                            gsize                count,
-                                            goffset              offset);
-DexUringFuture *dex_uring_future_new_write (int                  fd,
-                                            gconstpointer        buffer,
-                                            gsize                count,
-                                            goffset              offset);
-void            dex_uring_future_sqe       (DexUringFuture      *uring_future,
-                                            struct io_uring_sqe *sqe);
-void            dex_uring_future_cqe       (DexUringFuture      *uring_future,
-                                            struct io_uring_cqe *cqe);
-void            dex_uring_future_complete  (DexUringFuture      *uring_future);
+typedef enum _DexUringCqeStatus
+{
+  /* The future has received its final CQE and may be completed */
+  DEX_URING_CQE_COMPLETE,
+  /* More CQEs are expected for the future (such as a notification) */
+  DEX_URING_CQE_PENDING,
+  /* The future must be submitted again (such as a fallback operation) */
+  DEX_URING_CQE_RESUBMIT,
+} DexUringCqeStatus;
+
+GType              dex_uring_future_get_type    (void) G_GNUC_CONST;
+DexUringFuture    *dex_uring_future_new_read    (int                  fd,
+                                                 gpointer             buffer,
+                                                 gsize                count,
+                                                 goffset              offset);
+DexUringFuture    *dex_uring_future_new_write   (int                  fd,
+                                                 gconstpointer        buffer,
+                                                 gsize                count,
+                                                 goffset              offset);
+DexUringFuture    *dex_uring_future_new_writev  (int                  fd,
+                                                 const GOutputVector *vectors,
+                                                 gsize                n_vectors,
+                                                 goffset              offset);
+DexUringFuture    *dex_uring_future_new_send    (int                  fd,
+                                                 gconstpointer        buffer,
+                                                 gsize                count,
+                                                 int                  flags);
+DexUringFuture    *dex_uring_future_new_send_zc (int                  fd,
+                                                 gconstpointer        buffer,
+                                                 gsize                count,
+                                                 int                  flags);
+DexUringFuture    *dex_uring_future_new_poll    (DexAioContext       *aio_context,
+                                                 int                  fd,
+                                                 GIOCondition         events);
+DexUringFuture    *dex_uring_future_new_cancel  (DexUringFuture      *target);
+DexUringFuture    *dex_uring_future_new_fadvise (int                  fd,
+                                                 goffset              offset,
+                                                 goffset              length,
+                                                 int                  advice);
+DexUringFuture    *dex_uring_future_new_madvise (gpointer             address,
+                                                 gsize                length,
+                                                 int                  advice);
+void               dex_uring_future_sqe         (DexUringFuture      *uring_future,
+                                                 struct io_uring_sqe *sqe);
+DexUringCqeStatus  dex_uring_future_cqe         (DexUringFuture      *uring_future,
+                                                 struct io_uring_cqe *cqe);
+void               dex_uring_future_complete    (DexUringFuture      *uring_future);
+gboolean           dex_uring_future_get_iopoll  (DexUringFuture      *uring_future);
+void               dex_uring_future_set_iopoll  (DexUringFuture      *uring_future,
+                                                 gboolean             iopoll);
 
 G_END_DECLS
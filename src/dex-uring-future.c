@@ -20,23 +20,39 @@
 
 #include "config.h"
 
+#include <errno.h>
+
 #include <liburing.h>
 
 #include <gio/gio.h>
 
 #include "dex-future-private.h"
+#include "dex-probes-private.h"
+#include "dex-profiler.h"
+#include "dex-uring-aio-backend-private.h"
 #include "dex-uring-future-private.h"
+#include "dex-uring-version.h"
 
 typedef enum _DexUringType
 {
   DEX_URING_TYPE_READ = 1,
   DEX_URING_TYPE_WRITE,
+  DEX_URING_TYPE_WRITEV,
+  DEX_URING_TYPE_SEND,
+  DEX_URING_TYPE_SEND_ZC,
+  DEX_URING_TYPE_POLL,
+  DEX_URING_TYPE_CANCEL,
+  DEX_URING_TYPE_FADVISE,
+  DEX_URING_TYPE_MADVISE,
 } DexUringType;
 
 struct _DexUringFuture
 {
   DexFuture parent_instance;
   DexUringType type;
+  GSource *aio_context;
+  gint64 submit_time;
+  guint iopoll : 1;
   union {
     struct {
       int fd;
@@ -52,6 +68,42 @@ struct _DexUringFuture
       goffset offset;
       gssize result;
     } write;
+    struct {
+      int fd;
+      const GOutputVector *vectors;
+      gsize n_vectors;
+      goffset offset;
+      gssize result;
+    } writev;
+    struct {
+      int fd;
+      gconstpointer buffer;
+      gsize count;
+      int flags;
+      gssize result;
+    } send;
+    struct {
+      int fd;
+      GIOCondition events;
+      int result;
+    } poll;
+    struct {
+      DexUringFuture *target;
+      int result;
+    } cancel;
+    struct {
+      int fd;
+      goffset offset;
+      goffset length;
+      int advice;
+      int result;
+    } fadvise;
+    struct {
+      gpointer address;
+      gsize length;
+      int advice;
+      int result;
+    } madvise;
   };
 };
 
@@ -65,9 +117,39 @@ DEX_DEFINE_FINAL_TYPE (DexUringFuture, dex_uring_future, DEX_TYPE_FUTURE)
 #undef DEX_TYPE_URING_FUTURE
 #define DEX_TYPE_URING_FUTURE dex_uring_future_type
 
+static void
+dex_uring_future_discard (DexFuture *future)
+{
+  DexUringFuture *uring_future = DEX_URING_FUTURE (future);
+
+  /* Readiness may never arrive, so cancel polls nobody is waiting on */
+  if (uring_future->type == DEX_URING_TYPE_POLL &&
+      uring_future->aio_context != NULL &&
+      dex_future_is_pending (future))
+    dex_uring_aio_context_cancel ((DexAioContext *)uring_future->aio_context, uring_future);
+}
+
+static void
+dex_uring_future_finalize (DexObject *object)
+{
+  DexUringFuture *uring_future = DEX_URING_FUTURE (object);
+
+  if (uring_future->type == DEX_URING_TYPE_CANCEL)
+    dex_clear (&uring_future->cancel.target);
+
+  g_clear_pointer (&uring_future->aio_context, g_source_unref);
+
+  DEX_OBJECT_CLASS (dex_uring_future_parent_class)->finalize (object);
+}
+
 static void
 dex_uring_future_class_init (DexUringFutureClass *uring_future_class)
 {
+  DexObjectClass *object_class = DEX_OBJECT_CLASS (uring_future_class);
+  DexFutureClass *future_class = DEX_FUTURE_CLASS (uring_future_class);
+
+  object_class->finalize = dex_uring_future_finalize;
+  future_class->discard = dex_uring_future_discard;
 }
 
 static void
@@ -97,9 +179,41 @@ complete_ssize (DexUringFuture *uring_future,
                          NULL);
 }
 
+#if defined(DEX_PROFILER_ENABLED) || defined(HAVE_USDT)
+static const char *
+dex_uring_type_name (DexUringType type)
+{
+  switch (type)
+    {
+    case DEX_URING_TYPE_READ: return "read";
+    case DEX_URING_TYPE_WRITE: return "write";
+    case DEX_URING_TYPE_WRITEV: return "writev";
+    case DEX_URING_TYPE_SEND: return "send";
+    case DEX_URING_TYPE_SEND_ZC: return "send_zc";
+    case DEX_URING_TYPE_POLL: return "poll";
+    case DEX_URING_TYPE_CANCEL: return "cancel";
+    case DEX_URING_TYPE_FADVISE: return "fadvise";
+    case DEX_URING_TYPE_MADVISE: return "madvise";
+    default: return "unknown";
+    }
+}
+#endif
+
 void
 dex_uring_future_complete (DexUringFuture *uring_future)
 {
+  DEX_PROBE2 (uring_complete, uring_future, dex_uring_type_name (uring_future->type));
+
+  /* Latency from the first SQE until the final CQE was reaped */
+  if (uring_future->submit_time != 0 && DEX_PROFILER_ACTIVE)
+    {
+      gint64 duration = DEX_PROFILER_CURRENT_TIME - uring_future->submit_time;
+
+      DEX_PROFILER_MARK (duration,
+                         "DexUringFuture",
+                         dex_uring_type_name (uring_future->type));
+    }
+
   switch (uring_future->type)
     {
     case DEX_URING_TYPE_READ:
@@ -110,15 +224,69 @@ dex_uring_future_complete (DexUringFuture *uring_future)
       complete_ssize (uring_future, uring_future->write.result);
       break;
 
+    case DEX_URING_TYPE_WRITEV:
+      complete_ssize (uring_future, uring_future->writev.result);
+      break;
+
+    case DEX_URING_TYPE_SEND:
+    case DEX_URING_TYPE_SEND_ZC:
+      complete_ssize (uring_future, uring_future->send.result);
+      break;
+
+    case DEX_URING_TYPE_POLL:
+      if (uring_future->poll.result == -ECANCELED)
+        dex_future_complete (DEX_FUTURE (uring_future),
+                             NULL,
+                             g_error_new_literal (G_IO_ERROR,
+                                                  G_IO_ERROR_CANCELLED,
+                                                  "Operation was cancelled"));
+      else if (uring_future->poll.result < 0)
+        dex_future_complete (DEX_FUTURE (uring_future),
+                             NULL,
+                             create_error (uring_future->poll.result));
+      else
+        {
+          GValue value = G_VALUE_INIT;
+
+          g_value_init (&value, G_TYPE_IO_CONDITION);
+          g_value_set_flags (&value, uring_future->poll.result);
+          dex_future_complete (DEX_FUTURE (uring_future), &value, NULL);
+          g_value_unset (&value);
+        }
+      break;
+
+    case DEX_URING_TYPE_FADVISE:
+      complete_ssize (uring_future, uring_future->fadvise.result);
+      break;
+
+    case DEX_URING_TYPE_MADVISE:
+      complete_ssize (uring_future, uring_future->madvise.result);
+      break;
+
+    case DEX_URING_TYPE_CANCEL:
+      dex_future_complete (DEX_FUTURE (uring_future),
+                           &(GValue) { G_TYPE_BOOLEAN, {{.v_int = uring_future->cancel.result == 0}}},
+                           NULL);
+      break;
+
     default:
       g_assert_not_reached ();
     }
 }
 
-void
+DexUringCqeStatus
 dex_uring_future_cqe (DexUringFuture      *uring_future,
                       struct io_uring_cqe *cqe)
 {
+  /* Not every file or filesystem supports polled I/O even when opened
+   * with O_DIRECT. Retry those on the interrupt driven ring.
+   */
+  if G_UNLIKELY (uring_future->iopoll && cqe->res == -EOPNOTSUPP)
+    {
+      uring_future->iopoll = FALSE;
+      return DEX_URING_CQE_RESUBMIT;
+    }
+
   switch (uring_future->type)
     {
     case DEX_URING_TYPE_READ:
@@ -129,15 +297,73 @@ dex_uring_future_cqe (DexUringFuture      *uring_future,
       uring_future->write.result = cqe->res;
       break;
 
+    case DEX_URING_TYPE_WRITEV:
+      uring_future->writev.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_SEND:
+      uring_future->send.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_POLL:
+      uring_future->poll.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_CANCEL:
+      uring_future->cancel.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_FADVISE:
+      uring_future->fadvise.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_MADVISE:
+      uring_future->madvise.result = cqe->res;
+      break;
+
+    case DEX_URING_TYPE_SEND_ZC:
+#if DEX_URING_CHECK_VERSION(2, 3)
+      /* Zero-copy sends post two CQEs. The first contains the result
+       * of the send and has IORING_CQE_F_MORE set. The second is the
+       * notification that the kernel is done with our buffer, which is
+       * what we must wait for before the caller may reuse it.
+       */
+      if ((cqe->flags & IORING_CQE_F_NOTIF) == 0)
+        {
+          uring_future->send.result = cqe->res;
+
+          if (cqe->flags & IORING_CQE_F_MORE)
+            return DEX_URING_CQE_PENDING;
+        }
+
+      /* Some socket types (such as AF_UNIX) do not support zero-copy,
+       * so retry those as a regular send().
+       */
+      if (uring_future->send.result == -EOPNOTSUPP)
+        {
+          uring_future->type = DEX_URING_TYPE_SEND;
+          return DEX_URING_CQE_RESUBMIT;
+        }
+      break;
+#endif
+
     default:
       g_assert_not_reached ();
     }
+
+  return DEX_URING_CQE_COMPLETE;
 }
 
 void
 dex_uring_future_sqe (DexUringFuture      *uring_future,
                       struct io_uring_sqe *sqe)
 {
+  /* Keep the original time when resubmitting */
+  if (uring_future->submit_time == 0 && DEX_PROFILER_ACTIVE)
+    uring_future->submit_time = DEX_PROFILER_CURRENT_TIME;
+
+  DEX_PROBE2 (uring_submit, uring_future, dex_uring_type_name (uring_future->type));
+
   switch (uring_future->type)
     {
     case DEX_URING_TYPE_READ:
@@ -156,6 +382,77 @@ dex_uring_future_sqe (DexUringFuture      *uring_future,
                            uring_future->write.offset);
       break;
 
+    case DEX_URING_TYPE_WRITEV:
+      io_uring_prep_writev (sqe,
+                            uring_future->writev.fd,
+                            (const struct iovec *)uring_future->writev.vectors,
+                            MIN (uring_future->writev.n_vectors, G_MAXUINT),
+                            uring_future->writev.offset);
+      break;
+
+    case DEX_URING_TYPE_SEND:
+      io_uring_prep_send (sqe,
+                          uring_future->send.fd,
+                          uring_future->send.buffer,
+                          uring_future->send.count,
+                          uring_future->send.flags);
+      break;
+
+    case DEX_URING_TYPE_POLL:
+      /* GIOCondition values match the poll() event bits */
+      io_uring_prep_poll_add (sqe,
+                              uring_future->poll.fd,
+                              uring_future->poll.events);
+      break;
+
+    case DEX_URING_TYPE_CANCEL:
+      io_uring_prep_cancel (sqe, uring_future->cancel.target, 0);
+      break;
+
+    /* liburing 2.7 narrowed the length of the original helpers to 32-bit
+     * and added 64-bit variants.
+     */
+    case DEX_URING_TYPE_FADVISE:
+#if DEX_URING_CHECK_VERSION(2, 7)
+      io_uring_prep_fadvise64 (sqe,
+                               uring_future->fadvise.fd,
+                               uring_future->fadvise.offset,
+                               uring_future->fadvise.length,
+                               uring_future->fadvise.advice);
+#else
+      io_uring_prep_fadvise (sqe,
+                             uring_future->fadvise.fd,
+                             uring_future->fadvise.offset,
+                             uring_future->fadvise.length,
+                             uring_future->fadvise.advice);
+#endif
+      break;
+
+    case DEX_URING_TYPE_MADVISE:
+#if DEX_URING_CHECK_VERSION(2, 7)
+      io_uring_prep_madvise64 (sqe,
+                               uring_future->madvise.address,
+                               uring_future->madvise.length,
+                               uring_future->madvise.advice);
+#else
+      io_uring_prep_madvise (sqe,
+                             uring_future->madvise.address,
+                             uring_future->madvise.length,
+                             uring_future->madvise.advice);
+#endif
+      break;
+
+    case DEX_URING_TYPE_SEND_ZC:
+#if DEX_URING_CHECK_VERSION(2, 3)
+      io_uring_prep_send_zc (sqe,
+                             uring_future->send.fd,
+                             uring_future->send.buffer,
+                             uring_future->send.count,
+                             uring_future->send.flags,
+                             0);
+      break;
+#endif
+
     default:
       g_assert_not_reached ();
     }
@@ -196,3 +493,133 @@ dex_uring_future_new_write (int           fd,
 
   return future;
 }
+
+DexUringFuture *
+dex_uring_future_new_writev (int                  fd,
+                             const GOutputVector *vectors,
+                             gsize                n_vectors,
+                             goffset              offset)
+{
+  DexUringFuture *future;
+
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_WRITEV;
+  future->writev.fd = fd;
+  future->writev.vectors = vectors;
+  future->writev.n_vectors = n_vectors;
+  future->writev.offset = offset;
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_send (int           fd,
+                           gconstpointer buffer,
+                           gsize         count,
+                           int           flags)
+{
+  DexUringFuture *future;
+
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_SEND;
+  future->send.fd = fd;
+  future->send.buffer = buffer;
+  future->send.count = count;
+  future->send.flags = flags;
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_send_zc (int           fd,
+                              gconstpointer buffer,
+                              gsize         count,
+                              int           flags)
+{
+  DexUringFuture *future;
+
+  future = dex_uring_future_new_send (fd, buffer, count, flags);
+#if DEX_URING_CHECK_VERSION(2, 3)
+  future->type = DEX_URING_TYPE_SEND_ZC;
+#endif
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_poll (DexAioContext *aio_context,
+                           int            fd,
+                           GIOCondition   events)
+{
+  DexUringFuture *future;
+
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_POLL;
+  future->aio_context = g_source_ref ((GSource *)aio_context);
+  future->poll.fd = fd;
+  future->poll.events = events;
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_fadvise (int     fd,
+                              goffset offset,
+                              goffset length,
+                              int     advice)
+{
+  DexUringFuture *future;
+
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_FADVISE;
+  future->fadvise.fd = fd;
+  future->fadvise.offset = offset;
+  future->fadvise.length = length;
+  future->fadvise.advice = advice;
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_madvise (gpointer address,
+                              gsize    length,
+                              int      advice)
+{
+  DexUringFuture *future;
+
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_MADVISE;
+  future->madvise.address = address;
+  future->madvise.length = length;
+  future->madvise.advice = advice;
+
+  return future;
+}
+
+DexUringFuture *
+dex_uring_future_new_cancel (DexUringFuture *target)
+{
+  DexUringFuture *future;
+
+  /* Hold @target so its address cannot be reused by another request
+   * before the kernel has processed the cancellation.
+   */
+  future = (DexUringFuture *)dex_object_create_instance (DEX_TYPE_URING_FUTURE);
+  future->type = DEX_URING_TYPE_CANCEL;
+  future->cancel.target = dex_ref (target);
+
+  return future;
+}
+
+gboolean
+dex_uring_future_get_iopoll (DexUringFuture *uring_future)
+{
+  return uring_future->iopoll;
+}
+
+void
+dex_uring_future_set_iopoll (DexUringFuture *uring_future,
+                             gboolean        iopoll)
+{
+  uring_future->iopoll = !!iopoll;
+}
@@ -31,12 +31,14 @@ G_BEGIN_DECLS
 
 typedef struct _DexWorkQueue DexWorkQueue;
 
-GType         dex_work_queue_get_type (void) G_GNUC_CONST;
-DexWorkQueue *dex_work_queue_new      (void);
-void          dex_work_queue_push     (DexWorkQueue *work_queue,
-                                       DexWorkItem   work_item);
-gboolean      dex_work_queue_try_pop  (DexWorkQueue *work_queue,
-                                       DexWorkItem  *out_work_item);
-DexFuture    *dex_work_queue_run      (DexWorkQueue *work_queue);
+GType         dex_work_queue_get_type      (void) G_GNUC_CONST;
+DexWorkQueue *dex_work_queue_new           (void);
+void          dex_work_queue_push          (DexWorkQueue      *work_queue,
+                                            DexWorkItem        work_item);
+gboolean      dex_work_queue_try_pop       (DexWorkQueue      *work_queue,
+                                            DexWorkItem       *out_work_item);
+DexFuture    *dex_work_queue_run           (DexWorkQueue      *work_queue);
+void          dex_work_queue_collect_stats (DexWorkQueue      *work_queue,
+                                            DexSchedulerStats *stats);
 
 G_END_DECLS
@@ -22,7 +22,9 @@
 #include "config.h"
 
 #include "dex-object-private.h"
+#include "dex-profiler.h"
 #include "dex-semaphore-private.h"
+#include "dex-stats-private.h"
 #include "dex-work-queue-private.h"
 
 struct _DexWorkQueue
@@ -31,6 +33,8 @@ struct _DexWorkQueue
   DexSemaphore *semaphore;
   GMutex mutex;
   GQueue queue;
+  DexStats stats;
+  guint backlog_counter;
 };
 
 typedef struct _DexWorkQueueClass
@@ -55,6 +59,8 @@ dex_work_queue_finalize (DexObject *object)
     g_critical ("Work queue %p freed with %u items still in it!",
                 work_queue, work_queue->queue.length);
 
+  dex_stats_unregister (&work_queue->stats);
+
   g_mutex_clear (&work_queue->mutex);
   dex_clear (&work_queue->semaphore);
 
@@ -69,11 +75,38 @@ dex_work_queue_class_init (DexWorkQueueClass *work_queue_class)
   object_class->finalize = dex_work_queue_finalize;
 }
 
+static void
+dex_work_queue_sample_stats (DexStats          *stats,
+                             DexSchedulerStats *out_stats)
+{
+  DexWorkQueue *work_queue = (DexWorkQueue *)(gpointer)((guint8 *)stats - G_STRUCT_OFFSET (DexWorkQueue, stats));
+
+  g_mutex_lock (&work_queue->mutex);
+  out_stats->global_queue_depth += work_queue->queue.length;
+  g_mutex_unlock (&work_queue->mutex);
+}
+
 static void
 dex_work_queue_init (DexWorkQueue *work_queue)
 {
   work_queue->semaphore = dex_semaphore_new ();
   g_mutex_init (&work_queue->mutex);
+  dex_stats_register (&work_queue->stats, dex_work_queue_sample_stats);
+
+  if (DEX_PROFILER_ACTIVE)
+    DEX_PROFILER_DEFINE_COUNTER (work_queue->backlog_counter,
+                                 "Work queue backlog",
+                                 "Work items waiting in a global DexWorkQueue");
+}
+
+void
+dex_work_queue_collect_stats (DexWorkQueue      *work_queue,
+                              DexSchedulerStats *stats)
+{
+  g_return_if_fail (DEX_IS_WORK_QUEUE (work_queue));
+  g_return_if_fail (stats != NULL);
+
+  dex_stats_collect (&work_queue->stats, stats);
 }
 
 DexWorkQueue *
@@ -87,6 +120,7 @@ dex_work_queue_push (DexWorkQueue *work_queue,
                      DexWorkItem   work_item)
 {
   DexWorkQueueItem *work_queue_item;
+  guint backlog;
 
   g_return_if_fail (DEX_IS_WORK_QUEUE (work_queue));
   g_return_if_fail (work_item.func != NULL);
@@ -97,8 +131,14 @@ dex_work_queue_push (DexWorkQueue *work_queue,
 
   g_mutex_lock (&work_queue->mutex);
   g_queue_push_tail_link (&work_queue->queue, &work_queue_item->link);
+  backlog = work_queue->queue.length;
   g_mutex_unlock (&work_queue->mutex);
 
+  dex_stats_counter_add (&work_queue->stats.work_items_pushed, 1);
+
+  if (work_queue->backlog_counter != 0 && DEX_PROFILER_ACTIVE)
+    DEX_PROFILER_SET_COUNTER (work_queue->backlog_counter, backlog);
+
   dex_semaphore_post (work_queue->semaphore);
 }
 
@@ -107,14 +147,19 @@ dex_work_queue_try_pop (DexWorkQueue *work_queue,
                         DexWorkItem  *out_work_item)
 {
   GList *link;
+  guint backlog;
 
   g_return_val_if_fail (DEX_IS_WORK_QUEUE (work_queue), FALSE);
   g_return_val_if_fail (out_work_item != NULL, FALSE);
 
   g_mutex_lock (&work_queue->mutex);
   link = g_queue_pop_head_link (&work_queue->queue);
+  backlog = work_queue->queue.length;
   g_mutex_unlock (&work_queue->mutex);
 
+  if (work_queue->backlog_counter != 0 && DEX_PROFILER_ACTIVE)
+    DEX_PROFILER_SET_COUNTER (work_queue->backlog_counter, backlog);
+
   if (link != NULL)
     {
       DexWorkQueueItem *item = link->data;
@@ -135,7 +180,10 @@ dex_work_queue_run_cb (DexFuture *future,
   g_assert (DEX_IS_WORK_QUEUE (work_queue));
 
   if (dex_work_queue_try_pop (work_queue, &work_item))
-    dex_work_item_invoke (&work_item);
+    {
+      dex_work_item_invoke (&work_item);
+      dex_stats_counter_add (&work_queue->stats.work_items_executed, 1);
+    }
 
   return dex_semaphore_wait (work_queue->semaphore);
 }
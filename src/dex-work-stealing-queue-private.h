@@ -56,6 +56,7 @@
 #include <glib.h>
 
 #include "dex-scheduler-private.h"
+#include "dex-stats-private.h"
 
 /**
  * SECTION:dex-work-stealing-queue
@@ -95,7 +96,8 @@ typedef struct _DexWorkStealingQueue
 DexWorkStealingQueue *dex_work_stealing_queue_new           (gint64                capacity);
 DexWorkStealingQueue *dex_work_stealing_queue_ref           (DexWorkStealingQueue *work_stealing_queue);
 void                  dex_work_stealing_queue_unref         (DexWorkStealingQueue *work_stealing_queue);
-GSource              *dex_work_stealing_queue_create_source (DexWorkStealingQueue *work_stealing_queue);
+GSource              *dex_work_stealing_queue_create_source (DexWorkStealingQueue *work_stealing_queue,
+                                                             DexStats             *stats);
 
 static inline DexWorkStealingArray *
 dex_work_stealing_array_new (gint64 c)
@@ -76,6 +76,7 @@ typedef struct _DexWorkStealingQueueSource
 {
   GSource               parent_instance;
   DexWorkStealingQueue *work_stealing_queue;
+  DexStats             *stats;
   guint                 batch_size;
 } DexWorkStealingQueueSource;
 
@@ -105,8 +106,9 @@ dex_work_stealing_queue_source_dispatch (GSource     *source,
 {
   DexWorkStealingQueueSource *real_source = (DexWorkStealingQueueSource *)source;
   DexWorkStealingQueue *work_stealing_queue = real_source->work_stealing_queue;
+  guint i;
 
-  for (guint i = 0; i < real_source->batch_size; i++)
+  for (i = 0; i < real_source->batch_size; i++)
     {
       DexWorkItem work_item;
 
@@ -116,6 +118,9 @@ dex_work_stealing_queue_source_dispatch (GSource     *source,
       dex_work_item_invoke (&work_item);
     }
 
+  if (real_source->stats != NULL)
+    dex_stats_counter_add (&real_source->stats->work_items_executed, i);
+
   return G_SOURCE_CONTINUE;
 }
 
@@ -126,7 +131,8 @@ static GSourceFuncs dex_work_stealing_queue_source_funcs = {
 };
 
 GSource *
-dex_work_stealing_queue_create_source (DexWorkStealingQueue *work_stealing_queue)
+dex_work_stealing_queue_create_source (DexWorkStealingQueue *work_stealing_queue,
+                                       DexStats             *stats)
 {
   DexWorkStealingQueueSource *real_source;
   GSource *source;
@@ -138,6 +144,7 @@ dex_work_stealing_queue_create_source (DexWorkStealingQueue *work_stealing_queue
 
   _g_source_set_static_name (source, "[dex-work-stealing-queue]");
   real_source->work_stealing_queue = dex_work_stealing_queue_ref (work_stealing_queue);
+  real_source->stats = stats;
   real_source->batch_size = DEFAULT_BATCH_SIZE;
 
   return source;
@@ -28,11 +28,19 @@ G_BEGIN_DECLS
 
 #define DEX_INSIDE
 # include "dex-aio.h"
+# include "dex-aio-buffer-pool.h"
+# include "dex-aio-file-reader.h"
+# include "dex-aio-input-stream.h"
+# include "dex-aio-output-stream.h"
 # include "dex-async-pair.h"
 # include "dex-async-result.h"
 # include "dex-block.h"
+# include "dex-broadcast.h"
+# include "dex-buffered-writer.h"
 # include "dex-cancellable.h"
 # include "dex-channel.h"
+# include "dex-channel-select.h"
+# include "dex-cond.h"
 # include "dex-delayed.h"
 # include "dex-enums.h"
 # include "dex-error.h"
@@ -42,14 +50,19 @@ G_BEGIN_DECLS
 # include "dex-gio.h"
 # include "dex-init.h"
 # include "dex-main-scheduler.h"
+# include "dex-mutex.h"
 # include "dex-object.h"
 # include "dex-platform.h"
 # include "dex-promise.h"
+# include "dex-rw-lock.h"
 # include "dex-scheduler.h"
 # include "dex-static-future.h"
 # include "dex-thread-pool-scheduler.h"
 # include "dex-timeout.h"
 #ifdef G_OS_UNIX
+# include "dex-dir-walker.h"
+# include "dex-file-copy-tree.h"
+# include "dex-process.h"
 # include "dex-unix-signal.h"
 #endif
 # include "dex-version.h"
@@ -0,0 +1,186 @@
+/* test-aio-send.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+/* Small enough to fit in the socket buffer so it can be sent in full
+ * before reading it back from the same fiber.
+ */
+#define SEND_PAYLOAD_SIZE (32*1024)
+
+static void
+send_round_trip (DexAioContext *aio_context,
+                 int            send_fd,
+                 int            recv_fd,
+                 gboolean       zero_copy)
+{
+  guint8 *payload = g_malloc (SEND_PAYLOAD_SIZE);
+  guint8 *received = g_malloc0 (SEND_PAYLOAD_SIZE);
+  GError *error = NULL;
+  gsize n_sent = 0;
+  gsize n_received = 0;
+
+  for (guint i = 0; i < SEND_PAYLOAD_SIZE; i++)
+    payload[i] = i % 251;
+
+  while (n_sent < SEND_PAYLOAD_SIZE)
+    {
+      DexFuture *future;
+      gssize n;
+
+      if (zero_copy)
+        future = dex_aio_send_zc (aio_context, send_fd, &payload[n_sent], SEND_PAYLOAD_SIZE - n_sent, MSG_NOSIGNAL);
+      else
+        future = dex_aio_send (aio_context, send_fd, &payload[n_sent], SEND_PAYLOAD_SIZE - n_sent, MSG_NOSIGNAL);
+
+      n = dex_await_int64 (future, &error);
+      g_assert_no_error (error);
+      g_assert_cmpint (n, >, 0);
+
+      n_sent += n;
+    }
+
+  while (n_received < SEND_PAYLOAD_SIZE)
+    {
+      gssize n;
+
+      n = dex_await_int64 (dex_aio_read (aio_context, recv_fd, &received[n_received], SEND_PAYLOAD_SIZE - n_received, -1), &error);
+      g_assert_no_error (error);
+      g_assert_cmpint (n, >, 0);
+
+      n_received += n;
+    }
+
+  g_assert_cmpmem (received, SEND_PAYLOAD_SIZE, payload, SEND_PAYLOAD_SIZE);
+
+  g_free (payload);
+  g_free (received);
+}
+
+static gboolean
+tcp_loopback_pair (int fds[2])
+{
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl (INADDR_LOOPBACK) };
+  socklen_t len = sizeof addr;
+  int listener;
+
+  if (-1 == (listener = socket (AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)))
+    return FALSE;
+
+  if (bind (listener, (struct sockaddr *)&addr, sizeof addr) != 0 ||
+      listen (listener, 1) != 0 ||
+      getsockname (listener, (struct sockaddr *)&addr, &len) != 0 ||
+      -1 == (fds[0] = socket (AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)))
+    {
+      close (listener);
+      return FALSE;
+    }
+
+  /* The connection completes against the listen backlog */
+  if (connect (fds[0], (struct sockaddr *)&addr, sizeof addr) != 0 ||
+      -1 == (fds[1] = accept4 (listener, NULL, NULL, SOCK_CLOEXEC)))
+    {
+      close (fds[0]);
+      close (listener);
+      return FALSE;
+    }
+
+  close (listener);
+
+  return TRUE;
+}
+
+static DexFuture *
+send_fiber (gpointer user_data)
+{
+  DexAioContext *aio_context = user_data;
+  int fds[2];
+
+  g_assert_no_errno (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds));
+
+  send_round_trip (aio_context, fds[0], fds[1], FALSE);
+  send_round_trip (aio_context, fds[1], fds[0], FALSE);
+
+  close (fds[0]);
+  close (fds[1]);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+send_zc_fiber (gpointer user_data)
+{
+  DexAioContext *aio_context = user_data;
+  int fds[2];
+
+  /* AF_UNIX does not support zero-copy so this exercises the fallback */
+  g_assert_no_errno (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds));
+
+  send_round_trip (aio_context, fds[0], fds[1], TRUE);
+  send_round_trip (aio_context, fds[1], fds[0], TRUE);
+
+  close (fds[0]);
+  close (fds[1]);
+
+  /* TCP takes the zero-copy path itself where the backend supports it */
+  if (!tcp_loopback_pair (fds))
+    {
+      g_test_message ("TCP loopback is unavailable, only tested AF_UNIX");
+      return dex_future_new_for_boolean (TRUE);
+    }
+
+  send_round_trip (aio_context, fds[0], fds[1], TRUE);
+
+  close (fds[0]);
+  close (fds[1]);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_send (void)
+{
+  test_run_fiber_with_backends (send_fiber);
+}
+
+static void
+test_send_zc (void)
+{
+  test_run_fiber_with_backends (send_zc_fiber);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Aio/send", test_send);
+  g_test_add_func ("/Dex/TestSuite/Aio/send_zc", test_send_zc);
+  return g_test_run ();
+}
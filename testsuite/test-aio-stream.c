@@ -0,0 +1,245 @@
+/* test-aio-stream.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+#define TEST_FILE_SIZE (1024*1024 + 123)
+
+typedef struct
+{
+  char       *path;
+  GBytes     *contents;
+  GByteArray *result;
+  int         fd;
+} StreamTest;
+
+static void
+stream_test_init (StreamTest *test)
+{
+  GError *error = NULL;
+  guint8 *data;
+  gsize to_write;
+
+  data = g_malloc (TEST_FILE_SIZE);
+  for (guint i = 0; i < TEST_FILE_SIZE; i++)
+    data[i] = i % 251;
+
+  test->contents = g_bytes_new_take (data, TEST_FILE_SIZE);
+  test->fd = g_file_open_tmp ("test-aio-stream-XXXXXX", &test->path, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (test->fd, >, -1);
+
+  for (to_write = TEST_FILE_SIZE; to_write > 0; )
+    {
+      gssize len = write (test->fd, &data[TEST_FILE_SIZE - to_write], to_write);
+      g_assert_cmpint (len, >, 0);
+      to_write -= len;
+    }
+
+  test->result = g_byte_array_new ();
+}
+
+static void
+stream_test_clear (StreamTest *test)
+{
+  GBytes *result = g_byte_array_free_to_bytes (g_steal_pointer (&test->result));
+
+  g_assert_true (g_bytes_equal (result, test->contents));
+
+  g_bytes_unref (result);
+  g_bytes_unref (test->contents);
+  close (test->fd);
+  g_unlink (test->path);
+  g_free (test->path);
+}
+
+static DexFuture *
+input_stream_fiber (gpointer user_data)
+{
+  StreamTest *test = user_data;
+  GInputStream *stream;
+  GError *error = NULL;
+  guint8 buffer[4096*5];
+  gssize len;
+
+  g_assert_cmpint (lseek (test->fd, 0, SEEK_SET), ==, 0);
+
+  stream = dex_aio_input_stream_new (test->fd, FALSE);
+  g_assert_true (DEX_IS_AIO_INPUT_STREAM (stream));
+  g_assert_cmpint (dex_aio_input_stream_get_fd (DEX_AIO_INPUT_STREAM (stream)), ==, test->fd);
+
+  while ((len = dex_await_int64 (dex_input_stream_read (stream, buffer, sizeof buffer, G_PRIORITY_DEFAULT), &error)) > 0)
+    g_byte_array_append (test->result, buffer, len);
+
+  g_assert_no_error (error);
+  g_assert_cmpint (len, ==, 0);
+
+  g_object_unref (stream);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static int
+output_stream_open_tmp (char **path)
+{
+  GError *error = NULL;
+  int fd;
+
+  fd = g_file_open_tmp ("test-aio-out-XXXXXX", path, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (fd, >, -1);
+
+  return fd;
+}
+
+static void
+output_stream_read_back (StreamTest *test,
+                         const char *path)
+{
+  GError *error = NULL;
+  char *contents;
+  gsize len;
+
+  g_file_get_contents (path, &contents, &len, &error);
+  g_assert_no_error (error);
+
+  g_byte_array_append (test->result, (const guint8 *)contents, len);
+
+  g_unlink (path);
+  g_free (contents);
+}
+
+static DexFuture *
+output_stream_write_fiber (gpointer user_data)
+{
+  StreamTest *test = user_data;
+  GOutputStream *stream;
+  GError *error = NULL;
+  const guint8 *data;
+  char *path = NULL;
+  gsize to_write;
+  gsize len;
+  int fd;
+
+  fd = output_stream_open_tmp (&path);
+  data = g_bytes_get_data (test->contents, &len);
+
+  stream = dex_aio_output_stream_new (fd, TRUE);
+  g_assert_true (DEX_IS_AIO_OUTPUT_STREAM (stream));
+  g_assert_cmpint (dex_aio_output_stream_get_fd (DEX_AIO_OUTPUT_STREAM (stream)), ==, fd);
+
+  for (to_write = len; to_write > 0; )
+    {
+      gssize n_written;
+
+      n_written = dex_await_int64 (dex_output_stream_write (stream,
+                                                            &data[len - to_write],
+                                                            MIN (to_write, 4096*5),
+                                                            G_PRIORITY_DEFAULT),
+                                   &error);
+      g_assert_no_error (error);
+      g_assert_cmpint (n_written, >, 0);
+
+      to_write -= n_written;
+    }
+
+  dex_await (dex_output_stream_close (stream, G_PRIORITY_DEFAULT), &error);
+  g_assert_no_error (error);
+
+  g_object_unref (stream);
+
+  output_stream_read_back (test, path);
+  g_free (path);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+output_stream_splice_fiber (gpointer user_data)
+{
+  StreamTest *test = user_data;
+  GOutputStream *output;
+  GInputStream *input;
+  GError *error = NULL;
+  char *path = NULL;
+  gssize len;
+  int fd;
+
+  g_assert_cmpint (lseek (test->fd, 0, SEEK_SET), ==, 0);
+
+  fd = output_stream_open_tmp (&path);
+
+  /* Both ends being #DexAio streams keeps GIO on the asynchronous
+   * read/write loop instead of splicing in a worker thread.
+   */
+  input = dex_aio_input_stream_new (test->fd, FALSE);
+  output = dex_aio_output_stream_new (fd, TRUE);
+
+  len = dex_await_int64 (dex_output_stream_splice (output,
+                                                   input,
+                                                   G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                                   G_PRIORITY_DEFAULT),
+                         &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (len, ==, g_bytes_get_size (test->contents));
+  g_assert_true (g_output_stream_is_closed (output));
+
+  g_object_unref (output);
+  g_object_unref (input);
+
+  output_stream_read_back (test, path);
+  g_free (path);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+/* Runs the fiber in @data with a file containing known contents and
+ * checks that the fiber collected exactly those contents.
+ */
+static void
+test_stream (gconstpointer data)
+{
+  DexFiberFunc fiber_func = data;
+  StreamTest test;
+
+  stream_test_init (&test);
+  test_run_fiber (fiber_func, &test);
+  stream_test_clear (&test);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_data_func ("/Dex/TestSuite/AioInputStream/read", input_stream_fiber, test_stream);
+  g_test_add_data_func ("/Dex/TestSuite/AioOutputStream/write", output_stream_write_fiber, test_stream);
+  g_test_add_data_func ("/Dex/TestSuite/AioOutputStream/splice", output_stream_splice_fiber, test_stream);
+  return g_test_run ();
+}
@@ -0,0 +1,420 @@
+/* test-aio.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <glib/gstdio.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+#define TEST_FILE_SIZE (1024*1024 + 123)
+
+typedef struct
+{
+  char       *path;
+  GBytes     *contents;
+  GByteArray *result;
+  GMainLoop  *main_loop;
+  int         fd;
+} FileTest;
+
+static void
+file_test_init (FileTest *test)
+{
+  GError *error = NULL;
+  guint8 *data;
+  gsize to_write;
+
+  data = g_malloc (TEST_FILE_SIZE);
+  for (guint i = 0; i < TEST_FILE_SIZE; i++)
+    data[i] = i % 251;
+
+  test->contents = g_bytes_new_take (data, TEST_FILE_SIZE);
+  test->fd = g_file_open_tmp ("test-aio-XXXXXX", &test->path, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (test->fd, >, -1);
+
+  for (to_write = TEST_FILE_SIZE; to_write > 0; )
+    {
+      gssize len = write (test->fd, &data[TEST_FILE_SIZE - to_write], to_write);
+      g_assert_cmpint (len, >, 0);
+      to_write -= len;
+    }
+
+  test->result = g_byte_array_new ();
+  test->main_loop = g_main_loop_new (NULL, FALSE);
+}
+
+static void
+file_test_clear (FileTest *test)
+{
+  GBytes *result = g_byte_array_free_to_bytes (g_steal_pointer (&test->result));
+
+  g_assert_true (g_bytes_equal (result, test->contents));
+
+  g_bytes_unref (result);
+  g_bytes_unref (test->contents);
+  g_main_loop_unref (test->main_loop);
+  close (test->fd);
+  g_unlink (test->path);
+  g_free (test->path);
+}
+
+static DexFuture *
+quit_cb (DexFuture *future,
+         gpointer   user_data)
+{
+  FileTest *test = user_data;
+  GError *error = NULL;
+
+  dex_future_get_value (future, &error);
+  g_assert_no_error (error);
+
+  g_main_loop_quit (test->main_loop);
+
+  return NULL;
+}
+
+static DexFuture *
+file_reader_next_fiber (gpointer user_data)
+{
+  FileTest *test = user_data;
+  DexAioFileReader *file_reader = dex_aio_file_reader_new (NULL, test->fd, 64*1024, 4);
+  GError *error = NULL;
+
+  for (;;)
+    {
+      GBytes *bytes = dex_await_boxed (dex_aio_file_reader_next (file_reader), &error);
+
+      g_assert_no_error (error);
+      g_assert_nonnull (bytes);
+
+      if (g_bytes_get_size (bytes) == 0)
+        {
+          g_bytes_unref (bytes);
+          break;
+        }
+
+      g_byte_array_append (test->result,
+                           g_bytes_get_data (bytes, NULL),
+                           g_bytes_get_size (bytes));
+      g_bytes_unref (bytes);
+    }
+
+  dex_unref (file_reader);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+file_reader_channel_fiber (gpointer user_data)
+{
+  FileTest *test = user_data;
+  DexAioFileReader *file_reader = dex_aio_file_reader_new (NULL, test->fd, 4096*3, 3);
+  DexChannel *channel = dex_aio_file_reader_create_channel (file_reader, 2);
+  GBytes *bytes;
+
+  while ((bytes = dex_await_boxed (dex_channel_receive (channel), NULL)))
+    {
+      g_byte_array_append (test->result,
+                           g_bytes_get_data (bytes, NULL),
+                           g_bytes_get_size (bytes));
+      g_bytes_unref (bytes);
+    }
+
+  g_assert_false (dex_channel_can_send (channel));
+
+  dex_unref (channel);
+  dex_unref (file_reader);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+file_map_fiber (gpointer user_data)
+{
+  FileTest *test = user_data;
+  GMappedFile *mapped_file;
+  GError *error = NULL;
+  GFile *file;
+
+  dex_await (dex_aio_fadvise (NULL, test->fd, 0, 0, POSIX_FADV_WILLNEED), &error);
+  g_assert_no_error (error);
+
+  file = g_file_new_for_path (test->path);
+  mapped_file = dex_await_boxed (dex_file_map (file, FALSE), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (mapped_file);
+
+  g_byte_array_append (test->result,
+                       (const guint8 *)g_mapped_file_get_contents (mapped_file),
+                       g_mapped_file_get_length (mapped_file));
+
+  g_mapped_file_unref (mapped_file);
+  g_object_unref (file);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_file_reader (gconstpointer data)
+{
+  DexFiberFunc fiber_func = data;
+  DexFuture *future;
+  FileTest test;
+
+  file_test_init (&test);
+
+  future = dex_scheduler_spawn (NULL, 0, fiber_func, &test, NULL);
+  future = dex_future_finally (future, quit_cb, &test, NULL);
+
+  g_main_loop_run (test.main_loop);
+
+  dex_unref (future);
+
+  file_test_clear (&test);
+}
+
+static DexFuture *
+direct_io_fiber (gpointer user_data)
+{
+  DexAioContext *aio_context = user_data;
+  g_autofree char *path = NULL;
+  gpointer write_buffer = NULL;
+  gpointer read_buffer = NULL;
+  GError *error = NULL;
+  gsize memory_alignment = 0;
+  gsize offset_alignment = 0;
+  gsize size;
+  gssize n;
+  int fd;
+
+  fd = g_file_open_tmp ("test-aio-direct-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  /* tmpfs and some other filesystems do not support O_DIRECT */
+  if (-1 == (fd = open (path, O_RDWR | O_DIRECT | O_CLOEXEC)))
+    {
+      g_test_skip ("O_DIRECT is not supported in the temporary directory");
+      goto cleanup;
+    }
+
+  if (!dex_aio_query_direct_alignment (fd, &memory_alignment, &offset_alignment, &error))
+    {
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+      g_clear_error (&error);
+      g_test_skip ("O_DIRECT is not supported in the temporary directory");
+      goto cleanup;
+    }
+
+  g_assert_cmpuint (memory_alignment, >, 0);
+  g_assert_cmpuint (offset_alignment, >, 0);
+  g_assert_cmpuint (memory_alignment & (memory_alignment - 1), ==, 0);
+  g_assert_cmpuint (offset_alignment & (offset_alignment - 1), ==, 0);
+
+  /* Both are powers of two, so the larger satisfies either */
+  size = MAX (memory_alignment, offset_alignment) * 4;
+  g_assert_no_errno (posix_memalign (&write_buffer, MAX (memory_alignment, sizeof (gpointer)), size));
+  g_assert_no_errno (posix_memalign (&read_buffer, MAX (memory_alignment, sizeof (gpointer)), size));
+
+  for (gsize i = 0; i < size; i++)
+    ((guint8 *)write_buffer)[i] = i % 251;
+  memset (read_buffer, 0, size);
+
+  /* With io_uring these go through the IOPOLL ring when it is available,
+   * falling back to the regular ring if the device does not support it.
+   */
+  n = dex_await_int64 (dex_aio_write_direct (aio_context, fd, write_buffer, size, offset_alignment), &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, size);
+
+  n = dex_await_int64 (dex_aio_read_direct (aio_context, fd, read_buffer, size, offset_alignment), &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, size);
+  g_assert_cmpmem (read_buffer, size, write_buffer, size);
+
+  /* Reads past the end of the file are short */
+  n = dex_await_int64 (dex_aio_read_direct (aio_context, fd, read_buffer, size, offset_alignment * 2), &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, size - offset_alignment);
+
+cleanup:
+  if (fd != -1)
+    close (fd);
+  g_unlink (path);
+  free (write_buffer);
+  free (read_buffer);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_direct_io (void)
+{
+  test_run_fiber_with_backends (direct_io_fiber);
+}
+
+static void
+test_buffer_pool_shared (void)
+{
+  DexAioBufferPool *buffer_pool;
+  gconstpointer data;
+  GBytes *bytes;
+
+  g_assert_null (dex_aio_buffer_pool_get_shared (2 * 1024 * 1024));
+
+  buffer_pool = dex_aio_buffer_pool_get_shared (4096);
+  g_assert_nonnull (buffer_pool);
+  g_assert_cmpuint (dex_aio_buffer_pool_get_buffer_size (buffer_pool), ==, 4096);
+
+  buffer_pool = dex_aio_buffer_pool_get_shared (5000);
+  g_assert_nonnull (buffer_pool);
+  g_assert_cmpuint (dex_aio_buffer_pool_get_buffer_size (buffer_pool), ==, 8192);
+  g_assert_true (buffer_pool == dex_aio_buffer_pool_get_shared (8192));
+
+  /* Released buffers are reused by the same thread */
+  bytes = dex_aio_buffer_pool_acquire (buffer_pool);
+  data = g_bytes_get_data (bytes, NULL);
+  g_bytes_unref (bytes);
+
+  bytes = dex_aio_buffer_pool_acquire (buffer_pool);
+  g_assert_true (data == g_bytes_get_data (bytes, NULL));
+  g_bytes_unref (bytes);
+}
+
+static DexFuture *
+read_bytes_fiber (gpointer user_data)
+{
+  GError *error = NULL;
+  GBytes *bytes;
+  int fds[2];
+
+  g_assert_no_errno (pipe (fds));
+  g_assert_cmpint (write (fds[1], "hello", 5), ==, 5);
+  close (fds[1]);
+
+  bytes = dex_await_boxed (dex_aio_read_bytes (NULL, fds[0], 4096, -1), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (bytes);
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), "hello", 5);
+  g_bytes_unref (bytes);
+
+  bytes = dex_await_boxed (dex_aio_read_bytes (NULL, fds[0], 4096, -1), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (bytes);
+  g_assert_cmpuint (g_bytes_get_size (bytes), ==, 0);
+  g_bytes_unref (bytes);
+
+  close (fds[0]);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_read_bytes (void)
+{
+  test_run_fiber (read_bytes_fiber, NULL);
+}
+
+static DexFuture *
+read_bytes_pooled_fiber (gpointer user_data)
+{
+  GSocketConnection *connection;
+  GInputStream *stream;
+  DexFuture *future;
+  GSocket *socket;
+  GError *error = NULL;
+  GBytes *bytes;
+  int fds[2];
+
+  g_assert_no_errno (socketpair (AF_UNIX, SOCK_STREAM, 0, fds));
+
+  socket = g_socket_new_from_fd (fds[0], &error);
+  g_assert_no_error (error);
+  connection = g_socket_connection_factory_create_connection (socket);
+  stream = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+
+  /* Short reads are a view of the pooled buffer */
+  g_assert_cmpint (write (fds[1], "hello", 5), ==, 5);
+  bytes = dex_await_boxed (dex_input_stream_read_bytes_pooled (stream, 4096, G_PRIORITY_DEFAULT), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (bytes);
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), "hello", 5);
+  g_bytes_unref (bytes);
+
+  /* Discarding the pooled read cancels the underlying read */
+  future = dex_input_stream_read_bytes_pooled (stream, 4096, G_PRIORITY_DEFAULT);
+  g_assert_false (dex_await (dex_future_first (dex_ref (future),
+                                               dex_timeout_new_msec (10),
+                                               NULL),
+                             &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_TIMED_OUT);
+  g_clear_error (&error);
+  g_assert_null (dex_await_boxed (future, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+
+  /* ... which leaves the stream usable for the next read */
+  g_assert_false (g_input_stream_has_pending (stream));
+  g_assert_cmpint (write (fds[1], "world", 5), ==, 5);
+  bytes = dex_await_boxed (dex_input_stream_read_bytes_pooled (stream, 4096, G_PRIORITY_DEFAULT), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (bytes);
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), "world", 5);
+  g_bytes_unref (bytes);
+
+  close (fds[1]);
+
+  g_object_unref (connection);
+  g_object_unref (socket);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_read_bytes_pooled (void)
+{
+  test_run_fiber (read_bytes_pooled_fiber, NULL);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_data_func ("/Dex/TestSuite/AioFileReader/next", file_reader_next_fiber, test_file_reader);
+  g_test_add_data_func ("/Dex/TestSuite/AioFileReader/channel", file_reader_channel_fiber, test_file_reader);
+  g_test_add_data_func ("/Dex/TestSuite/Aio/file_map", file_map_fiber, test_file_reader);
+  g_test_add_func ("/Dex/TestSuite/Aio/read_bytes", test_read_bytes);
+  g_test_add_func ("/Dex/TestSuite/Aio/read_bytes_pooled", test_read_bytes_pooled);
+  g_test_add_func ("/Dex/TestSuite/Aio/direct_io", test_direct_io);
+  g_test_add_func ("/Dex/TestSuite/AioBufferPool/shared", test_buffer_pool_shared);
+  return g_test_run ();
+}
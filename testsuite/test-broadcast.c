@@ -0,0 +1,209 @@
+/*
+ * test-broadcast.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <libdex.h>
+
+#define ASSERT_STATUS(f,status) g_assert_cmpint(status, ==, dex_future_get_status(DEX_FUTURE(f)))
+
+#define ASSERT_CMPINT(future, op, v) \
+  G_STMT_START { \
+    GError *error = NULL; \
+    const GValue *value = dex_future_get_value (DEX_FUTURE (future), &error); \
+    g_assert_no_error (error); \
+    g_assert_nonnull (value); \
+    g_assert_cmpint (g_value_get_int (value), op, v); \
+  } G_STMT_END
+
+static void
+iterate_pending (void)
+{
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+}
+
+static void
+test_broadcast_basic (void)
+{
+  DexBroadcast *broadcast = dex_broadcast_new (4, DEX_BROADCAST_POLICY_BLOCK);
+  DexBroadcastSubscriber *sub1 = dex_broadcast_subscribe (broadcast);
+  DexBroadcastSubscriber *sub2 = dex_broadcast_subscribe (broadcast);
+  DexFuture *publish;
+  DexFuture *next1;
+  DexFuture *next2;
+
+  /* Waiting subscribers are woken by the next publish */
+  next1 = dex_broadcast_subscriber_next (sub1);
+  ASSERT_STATUS (next1, DEX_FUTURE_STATUS_PENDING);
+
+  publish = dex_broadcast_publish (broadcast, dex_future_new_for_int (1));
+  ASSERT_STATUS (publish, DEX_FUTURE_STATUS_RESOLVED);
+  dex_clear (&publish);
+  iterate_pending ();
+  ASSERT_CMPINT (next1, ==, 1);
+  dex_clear (&next1);
+
+  publish = dex_broadcast_publish (broadcast, dex_future_new_for_int (2));
+  ASSERT_STATUS (publish, DEX_FUTURE_STATUS_RESOLVED);
+  dex_clear (&publish);
+
+  /* Every subscriber sees every item */
+  next2 = dex_broadcast_subscriber_next (sub2);
+  ASSERT_CMPINT (next2, ==, 1);
+  dex_clear (&next2);
+  next2 = dex_broadcast_subscriber_next (sub2);
+  ASSERT_CMPINT (next2, ==, 2);
+  dex_clear (&next2);
+  next1 = dex_broadcast_subscriber_next (sub1);
+  ASSERT_CMPINT (next1, ==, 2);
+  dex_clear (&next1);
+
+  /* Closing leaves a waiting subscriber rejected */
+  next1 = dex_broadcast_subscriber_next (sub1);
+  ASSERT_STATUS (next1, DEX_FUTURE_STATUS_PENDING);
+  dex_broadcast_close (broadcast);
+  iterate_pending ();
+  ASSERT_STATUS (next1, DEX_FUTURE_STATUS_REJECTED);
+  dex_clear (&next1);
+
+  publish = dex_broadcast_publish (broadcast, dex_future_new_for_int (3));
+  ASSERT_STATUS (publish, DEX_FUTURE_STATUS_REJECTED);
+  dex_clear (&publish);
+
+  g_assert_cmpuint (dex_broadcast_subscriber_get_n_dropped (sub1), ==, 0);
+
+  dex_clear (&sub1);
+  dex_clear (&sub2);
+  dex_clear (&broadcast);
+}
+
+static void
+test_broadcast_block (void)
+{
+  DexBroadcast *broadcast = dex_broadcast_new (2, DEX_BROADCAST_POLICY_BLOCK);
+  DexBroadcastSubscriber *sub = dex_broadcast_subscribe (broadcast);
+  DexFuture *publish[3];
+  DexFuture *next;
+
+  for (guint i = 0; i < G_N_ELEMENTS (publish); i++)
+    publish[i] = dex_broadcast_publish (broadcast, dex_future_new_for_int (i));
+
+  ASSERT_STATUS (publish[0], DEX_FUTURE_STATUS_RESOLVED);
+  ASSERT_STATUS (publish[1], DEX_FUTURE_STATUS_RESOLVED);
+  ASSERT_STATUS (publish[2], DEX_FUTURE_STATUS_PENDING);
+
+  /* Reading the oldest item makes room for the pending publish */
+  next = dex_broadcast_subscriber_next (sub);
+  ASSERT_CMPINT (next, ==, 0);
+  dex_clear (&next);
+  iterate_pending ();
+  ASSERT_STATUS (publish[2], DEX_FUTURE_STATUS_RESOLVED);
+
+  for (int i = 1; i < 3; i++)
+    {
+      next = dex_broadcast_subscriber_next (sub);
+      ASSERT_CMPINT (next, ==, i);
+      dex_clear (&next);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (publish); i++)
+    dex_clear (&publish[i]);
+
+  dex_clear (&sub);
+  dex_clear (&broadcast);
+}
+
+static void
+test_broadcast_drop_oldest (void)
+{
+  DexBroadcast *broadcast = dex_broadcast_new (4, DEX_BROADCAST_POLICY_DROP_OLDEST);
+  DexBroadcastSubscriber *sub = dex_broadcast_subscribe (broadcast);
+  DexFuture *next;
+
+  for (int i = 0; i < 10; i++)
+    {
+      DexFuture *publish = dex_broadcast_publish (broadcast, dex_future_new_for_int (i));
+      ASSERT_STATUS (publish, DEX_FUTURE_STATUS_RESOLVED);
+      dex_clear (&publish);
+    }
+
+  /* Only the newest items are kept */
+  g_assert_cmpuint (dex_broadcast_subscriber_get_n_dropped (sub), ==, 6);
+
+  for (int i = 6; i < 10; i++)
+    {
+      next = dex_broadcast_subscriber_next (sub);
+      ASSERT_CMPINT (next, ==, i);
+      dex_clear (&next);
+    }
+
+  next = dex_broadcast_subscriber_next (sub);
+  ASSERT_STATUS (next, DEX_FUTURE_STATUS_PENDING);
+  dex_clear (&next);
+
+  dex_clear (&sub);
+  dex_clear (&broadcast);
+}
+
+static void
+test_broadcast_disconnect (void)
+{
+  DexBroadcast *broadcast = dex_broadcast_new (2, DEX_BROADCAST_POLICY_DISCONNECT);
+  DexBroadcastSubscriber *slow = dex_broadcast_subscribe (broadcast);
+  DexBroadcastSubscriber *fast = dex_broadcast_subscribe (broadcast);
+  GError *error = NULL;
+  DexFuture *next;
+
+  for (int i = 0; i < 3; i++)
+    {
+      DexFuture *publish = dex_broadcast_publish (broadcast, dex_future_new_for_int (i));
+      ASSERT_STATUS (publish, DEX_FUTURE_STATUS_RESOLVED);
+      dex_clear (&publish);
+
+      next = dex_broadcast_subscriber_next (fast);
+      ASSERT_CMPINT (next, ==, i);
+      dex_clear (&next);
+    }
+
+  next = dex_broadcast_subscriber_next (slow);
+  g_assert_null (dex_future_get_value (next, &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_SUBSCRIBER_DISCONNECTED);
+  g_clear_error (&error);
+  dex_clear (&next);
+
+  dex_clear (&slow);
+  dex_clear (&fast);
+  dex_clear (&broadcast);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Broadcast/basic", test_broadcast_basic);
+  g_test_add_func ("/Dex/TestSuite/Broadcast/block", test_broadcast_block);
+  g_test_add_func ("/Dex/TestSuite/Broadcast/drop_oldest", test_broadcast_drop_oldest);
+  g_test_add_func ("/Dex/TestSuite/Broadcast/disconnect", test_broadcast_disconnect);
+  return g_test_run ();
+}
@@ -0,0 +1,213 @@
+/* test-buffered-writer.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+/* Forwards to a memory stream while counting the vectored writes it
+ * receives so tests can check how writes were coalesced.
+ */
+typedef struct
+{
+  GFilterOutputStream parent_instance;
+  guint               n_writev;
+} TestCountingStream;
+
+typedef GFilterOutputStreamClass TestCountingStreamClass;
+
+GType test_counting_stream_get_type (void);
+
+G_DEFINE_TYPE (TestCountingStream, test_counting_stream, G_TYPE_FILTER_OUTPUT_STREAM)
+
+static gboolean
+test_counting_stream_writev (GOutputStream        *stream,
+                             const GOutputVector  *vectors,
+                             gsize                 n_vectors,
+                             gsize                *bytes_written,
+                             GCancellable         *cancellable,
+                             GError              **error)
+{
+  g_atomic_int_inc (&((TestCountingStream *)stream)->n_writev);
+
+  return G_OUTPUT_STREAM_CLASS (test_counting_stream_parent_class)->writev_fn (stream, vectors, n_vectors,
+                                                                                 bytes_written, cancellable, error);
+}
+
+static void
+test_counting_stream_class_init (TestCountingStreamClass *klass)
+{
+  GOutputStreamClass *output_stream_class = G_OUTPUT_STREAM_CLASS (klass);
+
+  output_stream_class->writev_fn = test_counting_stream_writev;
+}
+
+static void
+test_counting_stream_init (TestCountingStream *self)
+{
+}
+
+static DexFuture *
+buffered_writer_fd_fiber (gpointer user_data)
+{
+  DexBufferedWriter *buffered_writer;
+  GString *expected = g_string_new (NULL);
+  GByteArray *received = g_byte_array_new ();
+  GPtrArray *futures = g_ptr_array_new_with_free_func (dex_unref);
+  GBytes *large;
+  GError *error = NULL;
+  guint8 buffer[4096];
+  int fds[2];
+
+  g_assert_no_errno (pipe (fds));
+
+  buffered_writer = dex_buffered_writer_new_for_fd (fds[1], TRUE);
+  dex_buffered_writer_set_max_delay (buffered_writer, G_USEC_PER_SEC);
+
+  /* Small writes join the same batch while waiting for the delay */
+  for (guint i = 0; i < 100; i++)
+    {
+      g_autofree char *line = g_strdup_printf ("line %u\n", i);
+
+      g_string_append (expected, line);
+      g_ptr_array_add (futures, dex_buffered_writer_write (buffered_writer, line, strlen (line)));
+    }
+
+  memset (buffer, 'x', sizeof buffer);
+  large = g_bytes_new (buffer, sizeof buffer);
+  g_string_append_len (expected, (const char *)buffer, sizeof buffer);
+  g_ptr_array_add (futures, dex_buffered_writer_write_bytes (buffered_writer, large));
+  g_bytes_unref (large);
+
+  for (guint i = 1; i < futures->len; i++)
+    g_assert_true (g_ptr_array_index (futures, 0) == g_ptr_array_index (futures, i));
+
+  /* Flushing must not wait for the delay to elapse */
+  g_assert_true (dex_await (dex_buffered_writer_flush (buffered_writer), &error));
+  g_assert_no_error (error);
+  g_assert_true (dex_future_is_resolved (g_ptr_array_index (futures, 0)));
+
+  g_assert_true (dex_await (dex_buffered_writer_close (buffered_writer), &error));
+  g_assert_no_error (error);
+
+  g_assert_false (dex_await (dex_buffered_writer_write (buffered_writer, "x", 1), &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED);
+  g_clear_error (&error);
+
+  for (;;)
+    {
+      gint64 len = dex_await_int64 (dex_aio_read (NULL, fds[0], buffer, sizeof buffer, -1), &error);
+
+      g_assert_no_error (error);
+
+      if (len == 0)
+        break;
+
+      g_byte_array_append (received, buffer, len);
+    }
+
+  g_assert_cmpmem (received->data, received->len, expected->str, expected->len);
+
+  close (fds[0]);
+
+  g_ptr_array_unref (futures);
+  g_byte_array_unref (received);
+  g_string_free (expected, TRUE);
+  dex_unref (buffered_writer);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+buffered_writer_coalesce_fiber (gpointer user_data)
+{
+  DexBufferedWriter *buffered_writer;
+  TestCountingStream *stream;
+  GOutputStream *memory;
+  GString *expected = g_string_new (NULL);
+  GBytes *received;
+  GError *error = NULL;
+
+  memory = g_memory_output_stream_new_resizable ();
+  stream = g_object_new (test_counting_stream_get_type (),
+                         "base-stream", memory,
+                         NULL);
+
+  buffered_writer = dex_buffered_writer_new (G_OUTPUT_STREAM (stream));
+  dex_buffered_writer_set_max_delay (buffered_writer, G_USEC_PER_SEC);
+
+  for (guint i = 0; i < 100; i++)
+    {
+      g_autofree char *line = g_strdup_printf ("line %u\n", i);
+
+      g_string_append (expected, line);
+      dex_unref (dex_buffered_writer_write (buffered_writer, line, strlen (line)));
+    }
+
+  g_assert_true (dex_await (dex_buffered_writer_flush (buffered_writer), &error));
+  g_assert_no_error (error);
+
+  /* All of them were coalesced into a single writev() */
+  g_assert_cmpuint (g_atomic_int_get (&stream->n_writev), ==, 1);
+
+  g_assert_true (dex_await (dex_buffered_writer_close (buffered_writer), &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (g_atomic_int_get (&stream->n_writev), ==, 1);
+
+  received = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (memory));
+  g_assert_cmpmem (g_bytes_get_data (received, NULL), g_bytes_get_size (received),
+                   expected->str, expected->len);
+
+  g_bytes_unref (received);
+  g_string_free (expected, TRUE);
+  dex_unref (buffered_writer);
+  g_object_unref (stream);
+  g_object_unref (memory);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_buffered_writer_fd (void)
+{
+  test_run_fiber (buffered_writer_fd_fiber, NULL);
+}
+
+static void
+test_buffered_writer_coalesce (void)
+{
+  test_run_fiber (buffered_writer_coalesce_fiber, NULL);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/BufferedWriter/write", test_buffered_writer_fd);
+  g_test_add_func ("/Dex/TestSuite/BufferedWriter/coalesce", test_buffered_writer_coalesce);
+  return g_test_run ();
+}
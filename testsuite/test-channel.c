@@ -23,6 +23,8 @@
 
 #include <libdex.h>
 
+#include "test-util.h"
+
 #define ASSERT_STATUS(f,status) g_assert_cmpint(status, ==, dex_future_get_status(DEX_FUTURE(f)))
 
 #define ASSERT_CMP(future, kind, get, op, v) \
@@ -148,6 +150,486 @@ test_channel_recv_first (void)
   dex_clear (&send1);
 }
 
+static void
+test_channel_ring_basic (void)
+{
+  DexChannel *channel = dex_channel_new_full (3, DEX_CHANNEL_FLAGS_RING);
+  DexFuture *sends[5];
+  DexFuture *recvs[5];
+
+  /* Capacity is rounded up to 4 */
+  for (guint i = 0; i < G_N_ELEMENTS (sends); i++)
+    sends[i] = dex_channel_send (channel, dex_future_new_for_int (i));
+
+  for (guint i = 0; i < 4; i++)
+    ASSERT_STATUS (sends[i], DEX_FUTURE_STATUS_RESOLVED);
+  ASSERT_STATUS (sends[4], DEX_FUTURE_STATUS_PENDING);
+
+  recvs[0] = dex_channel_receive (channel);
+  ASSERT_CMPINT (recvs[0], ==, 0);
+  ASSERT_STATUS (sends[4], DEX_FUTURE_STATUS_RESOLVED);
+
+  for (guint i = 1; i < G_N_ELEMENTS (recvs); i++)
+    {
+      recvs[i] = dex_channel_receive (channel);
+      ASSERT_CMPINT (recvs[i], ==, i);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (sends); i++)
+    {
+      dex_clear (&sends[i]);
+      dex_clear (&recvs[i]);
+    }
+
+  dex_clear (&channel);
+}
+
+static void
+test_channel_ring_recv_first (void)
+{
+  DexChannel *channel = dex_channel_new_full (2, DEX_CHANNEL_FLAGS_RING);
+  DexFuture *recv1 = dex_channel_receive (channel);
+  DexFuture *recv2 = dex_channel_receive (channel);
+  DexFuture *recv3 = dex_channel_receive (channel);
+  DexFuture *send1;
+
+  ASSERT_STATUS (recv1, DEX_FUTURE_STATUS_PENDING);
+  ASSERT_STATUS (recv2, DEX_FUTURE_STATUS_PENDING);
+
+  send1 = dex_channel_send (channel, dex_future_new_for_int (123));
+  ASSERT_STATUS (send1, DEX_FUTURE_STATUS_RESOLVED);
+  ASSERT_CMPINT (recv1, ==, 123);
+  ASSERT_STATUS (recv2, DEX_FUTURE_STATUS_PENDING);
+
+  dex_channel_close_send (channel);
+  ASSERT_STATUS (recv2, DEX_FUTURE_STATUS_REJECTED);
+  ASSERT_STATUS (recv3, DEX_FUTURE_STATUS_REJECTED);
+
+  dex_clear (&channel);
+  dex_clear (&recv1);
+  dex_clear (&recv2);
+  dex_clear (&recv3);
+  dex_clear (&send1);
+}
+
+static void
+test_channel_many (void)
+{
+  const DexChannelFlags flags[] = { DEX_CHANNEL_FLAGS_NONE, DEX_CHANNEL_FLAGS_RING };
+
+  for (guint f = 0; f < G_N_ELEMENTS (flags); f++)
+    {
+      DexChannel *channel = dex_channel_new_full (4, flags[f]);
+      DexFuture *values[6];
+      DexFuture *send;
+      DexFuture *recv;
+      const GValue *value;
+      GPtrArray *ar;
+
+      for (guint i = 0; i < G_N_ELEMENTS (values); i++)
+        values[i] = dex_future_new_for_int (i);
+
+      send = dex_channel_send_many (channel, values, G_N_ELEMENTS (values));
+      ASSERT_STATUS (send, DEX_FUTURE_STATUS_PENDING);
+
+      recv = dex_channel_receive_many (channel, 3);
+      ASSERT_STATUS (recv, DEX_FUTURE_STATUS_RESOLVED);
+      value = dex_future_get_value (recv, NULL);
+      ar = g_value_get_boxed (value);
+      g_assert_cmpint (ar->len, ==, 3);
+      for (guint i = 0; i < ar->len; i++)
+        ASSERT_CMPINT (g_ptr_array_index (ar, i), ==, i);
+      dex_clear (&recv);
+
+      ASSERT_STATUS (send, DEX_FUTURE_STATUS_RESOLVED);
+      dex_clear (&send);
+
+      recv = dex_channel_receive_many (channel, 10);
+      value = dex_future_get_value (recv, NULL);
+      ar = g_value_get_boxed (value);
+      g_assert_cmpint (ar->len, ==, 3);
+      for (guint i = 0; i < ar->len; i++)
+        ASSERT_CMPINT (g_ptr_array_index (ar, i), ==, 3 + i);
+      dex_clear (&recv);
+
+      recv = dex_channel_receive_many (channel, 10);
+      ASSERT_STATUS (recv, DEX_FUTURE_STATUS_PENDING);
+
+      send = dex_channel_send (channel, dex_future_new_for_int (42));
+      ASSERT_STATUS (recv, DEX_FUTURE_STATUS_RESOLVED);
+      value = dex_future_get_value (recv, NULL);
+      ar = g_value_get_boxed (value);
+      g_assert_cmpint (ar->len, ==, 1);
+      ASSERT_CMPINT (g_ptr_array_index (ar, 0), ==, 42);
+      dex_clear (&recv);
+      dex_clear (&send);
+
+      dex_channel_close_send (channel);
+      recv = dex_channel_receive_many (channel, 10);
+      ASSERT_STATUS (recv, DEX_FUTURE_STATUS_REJECTED);
+      dex_clear (&recv);
+
+      for (guint i = 0; i < G_N_ELEMENTS (values); i++)
+        dex_clear (&values[i]);
+      dex_clear (&channel);
+    }
+}
+
+static guint n_values_freed;
+
+static void
+value_free (gpointer data)
+{
+  n_values_freed++;
+}
+
+static void
+test_channel_values (void)
+{
+  DexChannel *channel = dex_channel_new_for_values (2, value_free);
+  DexFuture *recv;
+  const GValue *value;
+
+  g_assert_null (dex_channel_try_receive_value (channel));
+
+  recv = dex_channel_receive (channel);
+  ASSERT_STATUS (recv, DEX_FUTURE_STATUS_PENDING);
+
+  g_assert_true (dex_channel_try_send_value (channel, GUINT_TO_POINTER (1)));
+  ASSERT_STATUS (recv, DEX_FUTURE_STATUS_RESOLVED);
+  value = dex_future_get_value (recv, NULL);
+  g_assert_true (G_VALUE_HOLDS_POINTER (value));
+  g_assert_true (g_value_get_pointer (value) == GUINT_TO_POINTER (1));
+  dex_clear (&recv);
+
+  g_assert_true (dex_channel_try_send_value (channel, GUINT_TO_POINTER (2)));
+  g_assert_true (dex_channel_try_send_value (channel, GUINT_TO_POINTER (3)));
+  g_assert_false (dex_channel_try_send_value (channel, GUINT_TO_POINTER (4)));
+
+  g_assert_true (dex_channel_try_receive_value (channel) == GUINT_TO_POINTER (2));
+  g_assert_true (dex_channel_try_send_value (channel, GUINT_TO_POINTER (4)));
+
+  /* Values left in the channel are released when it is closed */
+  g_assert_cmpint (n_values_freed, ==, 0);
+  dex_channel_close_receive (channel);
+  g_assert_cmpint (n_values_freed, ==, 2);
+  g_assert_false (dex_channel_try_send_value (channel, GUINT_TO_POINTER (5)));
+  g_assert_null (dex_channel_try_receive_value (channel));
+
+  dex_clear (&channel);
+}
+
+#define N_FIBER_VALUES 16
+
+typedef struct
+{
+  DexChannel *channel;
+  guint       n_sent;
+  gboolean    producer_started;
+} ValuesFiberState;
+
+static DexFuture *
+values_producer_fiber (gpointer user_data)
+{
+  ValuesFiberState *state = user_data;
+  GError *error = NULL;
+
+  state->producer_started = TRUE;
+
+  for (guint i = 1; i <= N_FIBER_VALUES; i++)
+    {
+      g_assert_true (dex_channel_send_value (state->channel, GUINT_TO_POINTER (i), &error));
+      g_assert_no_error (error);
+      state->n_sent = i;
+    }
+
+  dex_channel_close_send (state->channel);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+values_consumer_fiber (gpointer user_data)
+{
+  ValuesFiberState *state = user_data;
+  DexFuture *producer;
+  GError *error = NULL;
+  guint n_freed;
+
+  producer = dex_scheduler_spawn (NULL, 0, values_producer_fiber, state, NULL);
+
+  /* The channel is empty so this suspends, letting the producer run
+   * until it fills the channel and suspends in turn.
+   */
+  g_assert_false (state->producer_started);
+  g_assert_true (dex_channel_receive_value (state->channel, &error) == GUINT_TO_POINTER (1));
+  g_assert_no_error (error);
+  g_assert_true (state->producer_started);
+  g_assert_cmpuint (state->n_sent, >=, 2);
+  g_assert_cmpuint (state->n_sent, <, N_FIBER_VALUES);
+
+  for (guint i = 2; i <= N_FIBER_VALUES; i++)
+    {
+      g_assert_true (dex_channel_receive_value (state->channel, &error) == GUINT_TO_POINTER (i));
+      g_assert_no_error (error);
+    }
+
+  /* Once drained, the closed send side rejects the next receive */
+  g_assert_null (dex_channel_receive_value (state->channel, &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_CHANNEL_CLOSED);
+  g_clear_error (&error);
+
+  g_assert_true (dex_await (producer, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (state->n_sent, ==, N_FIBER_VALUES);
+
+  /* Sending into a closed channel releases the value */
+  n_freed = n_values_freed;
+  g_assert_false (dex_channel_send_value (state->channel, GUINT_TO_POINTER (1), &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_CHANNEL_CLOSED);
+  g_clear_error (&error);
+  g_assert_cmpuint (n_values_freed, ==, n_freed + 1);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_channel_values_fiber (void)
+{
+  ValuesFiberState state = {0};
+
+  state.channel = dex_channel_new_for_values (2, value_free);
+  test_run_fiber (values_consumer_fiber, &state);
+  dex_clear (&state.channel);
+}
+
+typedef struct
+{
+  DexChannelSelect *select;
+  GArray           *received;
+  guint             shutdown_index;
+} SelectState;
+
+static DexFuture *
+select_fiber (gpointer user_data)
+{
+  SelectState *state = user_data;
+
+  for (;;)
+    {
+      guint index = dex_channel_select_await (state->select);
+      g_autoptr(DexFuture) item = dex_channel_select_steal_item (state->select);
+      int value;
+
+      /* Stop on shutdown or when a channel is closed */
+      if (index == state->shutdown_index || item == NULL)
+        return dex_future_new_for_uint (index);
+
+      value = dex_await_int (g_steal_pointer (&item), NULL);
+      g_array_append_val (state->received, value);
+    }
+}
+
+static void
+test_channel_select (void)
+{
+  DexChannel *a = dex_channel_new (0);
+  DexChannel *b = dex_channel_new_full (4, DEX_CHANNEL_FLAGS_RING);
+  DexPromise *shutdown = dex_promise_new ();
+  SelectState state;
+  DexFuture *fiber;
+  DexFuture *send;
+  DexFuture *recv;
+
+  state.select = dex_channel_select_new ();
+  state.received = g_array_new (FALSE, FALSE, sizeof (int));
+  g_assert_cmpint (dex_channel_select_add_channel (state.select, a), ==, 0);
+  g_assert_cmpint (dex_channel_select_add_channel (state.select, b), ==, 1);
+  state.shutdown_index = dex_channel_select_add_future (state.select, DEX_FUTURE (shutdown));
+  g_assert_cmpint (state.shutdown_index, ==, 2);
+
+  /* Items which are already available are taken in turn */
+  dex_unref (dex_channel_send (a, dex_future_new_for_int (1)));
+  dex_unref (dex_channel_send (b, dex_future_new_for_int (2)));
+
+  fiber = dex_scheduler_spawn (NULL, 0, select_fiber, &state, NULL);
+  while (state.received->len < 2)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpint (g_array_index (state.received, int, 0), ==, 1);
+  g_assert_cmpint (g_array_index (state.received, int, 1), ==, 2);
+
+  /* The fiber is now waiting on all of the sources */
+  dex_unref (dex_channel_send (b, dex_future_new_for_int (3)));
+  while (state.received->len < 3)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpint (g_array_index (state.received, int, 2), ==, 3);
+
+  /* Receivers are served before a waiting select */
+  recv = dex_channel_receive (a);
+  send = dex_channel_send (a, dex_future_new_for_int (4));
+  ASSERT_CMPINT (recv, ==, 4);
+  g_assert_cmpint (state.received->len, ==, 3);
+  dex_clear (&recv);
+  dex_clear (&send);
+
+  /* Closing a channel makes it ready with no item */
+  dex_channel_close_send (b);
+  test_run_until_complete (fiber);
+  ASSERT_CMPUINT (fiber, ==, 1);
+  dex_clear (&fiber);
+  dex_clear (&state.select);
+
+  /* Futures are sources too */
+  state.select = dex_channel_select_new ();
+  dex_channel_select_add_channel (state.select, a);
+  state.shutdown_index = dex_channel_select_add_future (state.select, DEX_FUTURE (shutdown));
+  fiber = dex_scheduler_spawn (NULL, 0, select_fiber, &state, NULL);
+  g_main_context_iteration (NULL, FALSE);
+  g_assert_true (dex_future_is_pending (fiber));
+  dex_promise_resolve_boolean (shutdown, TRUE);
+  test_run_until_complete (fiber);
+  ASSERT_CMPUINT (fiber, ==, 1);
+  g_assert_cmpint (state.received->len, ==, 3);
+  dex_clear (&fiber);
+
+  dex_clear (&shutdown);
+  dex_clear (&state.select);
+  g_array_unref (state.received);
+  dex_clear (&a);
+  dex_clear (&b);
+}
+
+static void
+test_channel_select_timeout (void)
+{
+  DexChannel *channel = dex_channel_new (0);
+  DexFuture *timeout = dex_timeout_new_msec (500);
+  GError *error = NULL;
+  SelectState state;
+  DexFuture *fiber;
+
+  state.select = dex_channel_select_new ();
+  state.received = g_array_new (FALSE, FALSE, sizeof (int));
+  dex_channel_select_add_channel (state.select, channel);
+  state.shutdown_index = dex_channel_select_add_future (state.select, timeout);
+
+  /* Rounds won by the channel must leave the timeout running */
+  fiber = dex_scheduler_spawn (NULL, 0, select_fiber, &state, NULL);
+  for (int i = 0; i < 4; i++)
+    {
+      g_main_context_iteration (NULL, FALSE);
+      g_assert_true (dex_future_is_pending (fiber));
+      dex_unref (dex_channel_send (channel, dex_future_new_for_int (i)));
+      while (state.received->len < i + 1)
+        g_main_context_iteration (NULL, TRUE);
+      g_assert_true (dex_future_is_pending (timeout));
+    }
+
+  test_run_until_complete (fiber);
+  ASSERT_CMPUINT (fiber, ==, state.shutdown_index);
+  g_assert_cmpint (state.received->len, ==, 4);
+  g_assert_null (dex_future_get_value (timeout, &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_TIMED_OUT);
+  g_clear_error (&error);
+
+  dex_clear (&fiber);
+  dex_clear (&timeout);
+  dex_clear (&state.select);
+  g_array_unref (state.received);
+  dex_channel_close_send (channel);
+  dex_clear (&channel);
+}
+
+static guint64
+sum_buckets (const guint64 *buckets)
+{
+  guint64 ret = 0;
+
+  for (guint i = 0; i < DEX_CHANNEL_STATS_N_BUCKETS; i++)
+    ret += buckets[i];
+
+  return ret;
+}
+
+static void
+test_channel_stats (void)
+{
+  DexChannel *channel = dex_channel_new_full (1, DEX_CHANNEL_FLAGS_STATS);
+  DexChannel *ring = dex_channel_new_full (2, DEX_CHANNEL_FLAGS_RING | DEX_CHANNEL_FLAGS_STATS);
+  DexChannelStats stats;
+  DexFuture *send1;
+  DexFuture *send2;
+  DexFuture *recv;
+
+  send1 = dex_channel_send (channel, dex_future_new_for_int (1));
+  send2 = dex_channel_send (channel, dex_future_new_for_int (2));
+  ASSERT_STATUS (send2, DEX_FUTURE_STATUS_PENDING);
+
+  dex_channel_get_stats (channel, &stats);
+  g_assert_cmpuint (stats.depth, ==, 1);
+  g_assert_cmpuint (stats.n_waiting_senders, ==, 1);
+  g_assert_cmpuint (stats.n_sent, ==, 1);
+  g_assert_cmpuint (stats.send_wait[0], ==, 1);
+
+  recv = dex_channel_receive (channel);
+  ASSERT_CMPINT (recv, ==, 1);
+  ASSERT_STATUS (send2, DEX_FUTURE_STATUS_RESOLVED);
+  dex_clear (&recv);
+
+  dex_channel_get_stats (channel, &stats);
+  g_assert_cmpuint (stats.depth, ==, 1);
+  g_assert_cmpuint (stats.peak_depth, ==, 1);
+  g_assert_cmpuint (stats.n_waiting_senders, ==, 0);
+  g_assert_cmpuint (stats.n_sent, ==, 2);
+  g_assert_cmpuint (stats.n_received, ==, 1);
+  g_assert_cmpuint (sum_buckets (stats.send_wait), ==, 2);
+  g_assert_cmpuint (sum_buckets (stats.receive_wait), ==, 1);
+
+  dex_channel_close_receive (channel);
+  dex_clear (&send1);
+  send1 = dex_channel_send (channel, dex_future_new_for_int (3));
+  ASSERT_STATUS (send1, DEX_FUTURE_STATUS_REJECTED);
+
+  dex_channel_get_stats (channel, &stats);
+  g_assert_cmpuint (stats.depth, ==, 0);
+  g_assert_cmpuint (stats.n_send_rejected, ==, 1);
+
+  dex_channel_reset_stats (channel);
+  dex_channel_get_stats (channel, &stats);
+  g_assert_cmpuint (stats.n_sent, ==, 0);
+  g_assert_cmpuint (stats.n_send_rejected, ==, 0);
+  g_assert_cmpuint (sum_buckets (stats.send_wait), ==, 0);
+
+  /* A receiver waiting on a ring is counted when an item arrives */
+  recv = dex_channel_receive (ring);
+  dex_channel_get_stats (ring, &stats);
+  g_assert_cmpuint (stats.n_waiting_receivers, ==, 1);
+  dex_clear (&send2);
+  send2 = dex_channel_send (ring, dex_future_new_for_int (4));
+  ASSERT_CMPINT (recv, ==, 4);
+  dex_channel_get_stats (ring, &stats);
+  g_assert_cmpuint (stats.n_waiting_receivers, ==, 0);
+  g_assert_cmpuint (stats.n_sent, ==, 1);
+  g_assert_cmpuint (stats.n_received, ==, 1);
+  g_assert_cmpuint (sum_buckets (stats.receive_wait), ==, 1);
+
+  /* Channels without the flag still report their depth */
+  dex_clear (&channel);
+  channel = dex_channel_new (0);
+  dex_clear (&send1);
+  send1 = dex_channel_send (channel, dex_future_new_for_int (5));
+  dex_channel_get_stats (channel, &stats);
+  g_assert_cmpuint (stats.depth, ==, 1);
+  g_assert_cmpuint (stats.n_sent, ==, 0);
+
+  dex_clear (&send1);
+  dex_clear (&send2);
+  dex_clear (&recv);
+  dex_channel_close_receive (channel);
+  dex_clear (&channel);
+  dex_clear (&ring);
+}
+
 int
 main (int argc,
       char *argv[])
@@ -156,5 +638,13 @@ main (int argc,
   g_test_init (&argc, &argv, NULL);
   g_test_add_func ("/Dex/TestSuite/Channel/basic", test_channel_basic);
   g_test_add_func ("/Dex/TestSuite/Channel/recv_first", test_channel_recv_first);
+  g_test_add_func ("/Dex/TestSuite/Channel/ring_basic", test_channel_ring_basic);
+  g_test_add_func ("/Dex/TestSuite/Channel/ring_recv_first", test_channel_ring_recv_first);
+  g_test_add_func ("/Dex/TestSuite/Channel/many", test_channel_many);
+  g_test_add_func ("/Dex/TestSuite/Channel/values", test_channel_values);
+  g_test_add_func ("/Dex/TestSuite/Channel/values_fiber", test_channel_values_fiber);
+  g_test_add_func ("/Dex/TestSuite/Channel/select", test_channel_select);
+  g_test_add_func ("/Dex/TestSuite/Channel/select_timeout", test_channel_select_timeout);
+  g_test_add_func ("/Dex/TestSuite/Channel/stats", test_channel_stats);
   return g_test_run ();
 }
@@ -0,0 +1,356 @@
+/* test-dbus.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <sys/socket.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+/* The peer runs in its own thread and main context on the other end of
+ * a socketpair, so no message bus is required.
+ */
+
+#define OBJECT_PATH    "/org/gnome/Dex/Test"
+#define INTERFACE_NAME "org.gnome.Dex.Test"
+
+static const char introspection_xml[] =
+  "<node>"
+  "  <interface name='" INTERFACE_NAME "'>"
+  "    <method name='Ping'>"
+  "      <arg type='u' name='value' direction='in'/>"
+  "      <arg type='u' name='value' direction='out'/>"
+  "    </method>"
+  "    <method name='Fail'/>"
+  "    <method name='Hang'/>"
+  "  </interface>"
+  "</node>";
+
+typedef struct
+{
+  GDBusConnection *connection;
+  GThread         *thread;
+} Peer;
+
+static void
+peer_method_call (GDBusConnection       *connection,
+                  const char            *sender,
+                  const char            *object_path,
+                  const char            *interface_name,
+                  const char            *method_name,
+                  GVariant              *parameters,
+                  GDBusMethodInvocation *invocation,
+                  gpointer               user_data)
+{
+  GPtrArray *hanging = user_data;
+
+  if (g_str_equal (method_name, "Ping"))
+    {
+      guint32 value;
+
+      g_variant_get (parameters, "(u)", &value);
+      g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", value));
+    }
+  else if (g_str_equal (method_name, "Fail"))
+    {
+      g_dbus_method_invocation_return_error_literal (invocation,
+                                                     G_DBUS_ERROR,
+                                                     G_DBUS_ERROR_FAILED,
+                                                     "Failed on purpose");
+    }
+  else
+    {
+      /* Never reply, the invocation is released with the peer */
+      g_ptr_array_add (hanging, g_object_ref (invocation));
+    }
+}
+
+static const GDBusInterfaceVTable peer_vtable = { peer_method_call };
+
+static void
+peer_closed_cb (GDBusConnection *connection,
+                gboolean         remote_peer_vanished,
+                GError          *error,
+                GMainLoop       *main_loop)
+{
+  g_main_loop_quit (main_loop);
+}
+
+static gpointer
+peer_thread (gpointer data)
+{
+  GIOStream *stream = data;
+  GMainContext *main_context = g_main_context_new ();
+  GMainLoop *main_loop = g_main_loop_new (main_context, FALSE);
+  GPtrArray *hanging = g_ptr_array_new_with_free_func (g_object_unref);
+  GDBusConnection *connection;
+  GDBusNodeInfo *node_info;
+  GError *error = NULL;
+  char *guid = g_dbus_generate_guid ();
+
+  g_main_context_push_thread_default (main_context);
+
+  connection = g_dbus_connection_new_sync (stream,
+                                           guid,
+                                           (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER |
+                                            G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING),
+                                           NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  node_info = g_dbus_node_info_new_for_xml (introspection_xml, &error);
+  g_assert_no_error (error);
+
+  g_dbus_connection_register_object (connection,
+                                     OBJECT_PATH,
+                                     node_info->interfaces[0],
+                                     &peer_vtable,
+                                     hanging, NULL, &error);
+  g_assert_no_error (error);
+
+  g_signal_connect (connection, "closed", G_CALLBACK (peer_closed_cb), main_loop);
+  g_dbus_connection_start_message_processing (connection);
+
+  g_main_loop_run (main_loop);
+
+  g_main_context_pop_thread_default (main_context);
+
+  g_ptr_array_unref (hanging);
+  g_dbus_node_info_unref (node_info);
+  g_object_unref (connection);
+  g_object_unref (stream);
+  g_main_loop_unref (main_loop);
+  g_main_context_unref (main_context);
+  g_free (guid);
+
+  return NULL;
+}
+
+static GIOStream *
+stream_new_for_fd (int fd)
+{
+  GSocketConnection *connection;
+  GSocket *socket;
+  GError *error = NULL;
+
+  socket = g_socket_new_from_fd (fd, &error);
+  g_assert_no_error (error);
+
+  connection = g_socket_connection_factory_create_connection (socket);
+  g_object_unref (socket);
+
+  return G_IO_STREAM (connection);
+}
+
+static void
+peer_init (Peer *peer)
+{
+  GIOStream *stream;
+  GError *error = NULL;
+  int fds[2];
+
+  g_assert_no_errno (socketpair (AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, fds));
+
+  peer->thread = g_thread_new ("dbus-peer", peer_thread, stream_new_for_fd (fds[1]));
+
+  stream = stream_new_for_fd (fds[0]);
+  peer->connection = g_dbus_connection_new_sync (stream,
+                                                 NULL,
+                                                 G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                                                 NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (stream);
+}
+
+static void
+peer_clear (Peer *peer)
+{
+  g_dbus_connection_close_sync (peer->connection, NULL, NULL);
+  g_thread_join (peer->thread);
+  g_clear_object (&peer->connection);
+}
+
+static GDBusMessage *
+message_new (const char *method_name,
+             GVariant   *body)
+{
+  GDBusMessage *message = g_dbus_message_new_method_call (NULL, OBJECT_PATH, INTERFACE_NAME, method_name);
+
+  if (body != NULL)
+    g_dbus_message_set_body (message, body);
+
+  return message;
+}
+
+static void
+messages_free (GDBusMessage **messages,
+               guint          n_messages)
+{
+  for (guint i = 0; i < n_messages; i++)
+    g_object_unref (messages[i]);
+}
+
+static DexFuture *
+batch_in_order_fiber (gpointer user_data)
+{
+  Peer *peer = user_data;
+  GDBusMessage *messages[32];
+  GPtrArray *replies;
+  GError *error = NULL;
+
+  for (guint i = 0; i < G_N_ELEMENTS (messages); i++)
+    messages[i] = message_new ("Ping", g_variant_new ("(u)", i));
+
+  replies = dex_await_boxed (dex_dbus_connection_call_batch (peer->connection,
+                                                             messages,
+                                                             G_N_ELEMENTS (messages),
+                                                             -1),
+                             &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (replies);
+  g_assert_cmpuint (replies->len, ==, G_N_ELEMENTS (messages));
+
+  for (guint i = 0; i < replies->len; i++)
+    {
+      GDBusMessage *reply = g_ptr_array_index (replies, i);
+      guint32 value;
+
+      g_assert_cmpint (g_dbus_message_get_reply_serial (reply), ==, g_dbus_message_get_serial (messages[i]));
+      g_variant_get (g_dbus_message_get_body (reply), "(u)", &value);
+      g_assert_cmpuint (value, ==, i);
+    }
+
+  g_ptr_array_unref (replies);
+  messages_free (messages, G_N_ELEMENTS (messages));
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+batch_errors_fiber (gpointer user_data)
+{
+  Peer *peer = user_data;
+  GDBusMessage *messages[3];
+  GPtrArray *replies;
+  GError *error = NULL;
+
+  messages[0] = message_new ("Ping", g_variant_new ("(u)", 1));
+  messages[1] = message_new ("Fail", NULL);
+  messages[2] = message_new ("Ping", g_variant_new ("(u)", 2));
+
+  /* A failed call does not fail the batch */
+  replies = dex_await_boxed (dex_dbus_connection_call_batch (peer->connection,
+                                                             messages,
+                                                             G_N_ELEMENTS (messages),
+                                                             -1),
+                             &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (replies->len, ==, 3);
+
+  g_assert_false (g_dbus_message_to_gerror (g_ptr_array_index (replies, 0), &error));
+  g_assert_no_error (error);
+
+  g_assert_cmpint (g_dbus_message_get_message_type (g_ptr_array_index (replies, 1)), ==, G_DBUS_MESSAGE_TYPE_ERROR);
+  g_assert_true (g_dbus_message_to_gerror (g_ptr_array_index (replies, 1), &error));
+  g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED);
+  g_clear_error (&error);
+
+  g_assert_false (g_dbus_message_to_gerror (g_ptr_array_index (replies, 2), &error));
+  g_assert_no_error (error);
+
+  g_ptr_array_unref (replies);
+  messages_free (messages, G_N_ELEMENTS (messages));
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+batch_timeout_fiber (gpointer user_data)
+{
+  Peer *peer = user_data;
+  GDBusMessage *messages[2];
+  GDBusMessage *ping;
+  GPtrArray *replies;
+  GError *error = NULL;
+
+  messages[0] = message_new ("Ping", g_variant_new ("(u)", 1));
+  messages[1] = message_new ("Hang", NULL);
+
+  g_assert_null (dex_await_boxed (dex_dbus_connection_call_batch (peer->connection,
+                                                                  messages,
+                                                                  G_N_ELEMENTS (messages),
+                                                                  50),
+                                  &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_TIMED_OUT);
+  g_clear_error (&error);
+
+  /* The connection remains usable for the next batch */
+  ping = message_new ("Ping", g_variant_new ("(u)", 2));
+  replies = dex_await_boxed (dex_dbus_connection_call_batch (peer->connection, &ping, 1, -1), &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (replies->len, ==, 1);
+  g_ptr_array_unref (replies);
+
+  g_object_unref (ping);
+  messages_free (messages, G_N_ELEMENTS (messages));
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+batch_empty_fiber (gpointer user_data)
+{
+  Peer *peer = user_data;
+  GPtrArray *replies;
+  GError *error = NULL;
+
+  replies = dex_await_boxed (dex_dbus_connection_call_batch (peer->connection, NULL, 0, -1), &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (replies);
+  g_assert_cmpuint (replies->len, ==, 0);
+  g_ptr_array_unref (replies);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_dbus_batch (gconstpointer data)
+{
+  DexFiberFunc fiber_func = data;
+  Peer peer;
+
+  peer_init (&peer);
+  test_run_fiber (fiber_func, &peer);
+  peer_clear (&peer);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_data_func ("/Dex/TestSuite/DBus/batch_in_order", batch_in_order_fiber, test_dbus_batch);
+  g_test_add_data_func ("/Dex/TestSuite/DBus/batch_errors", batch_errors_fiber, test_dbus_batch);
+  g_test_add_data_func ("/Dex/TestSuite/DBus/batch_timeout", batch_timeout_fiber, test_dbus_batch);
+  g_test_add_data_func ("/Dex/TestSuite/DBus/batch_empty", batch_empty_fiber, test_dbus_batch);
+  return g_test_run ();
+}
@@ -0,0 +1,169 @@
+/* test-dir-walker.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+static const char *tree_files[] = { "a/1", "a/b/2", "c" };
+static const char *tree_contents[] = { "x", "hello", "a somewhat longer file" };
+static const char *tree_dirs[] = { "a/b", "a", "d" };
+
+static gsize
+tree_file_size (const char *path)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      if (g_str_equal (path, tree_files[i]))
+        return strlen (tree_contents[i]);
+    }
+
+  g_assert_not_reached ();
+}
+
+static char *
+create_tree (void)
+{
+  char *root = g_build_filename (g_get_tmp_dir (), "test-dir-walker-XXXXXX", NULL);
+  GError *error = NULL;
+
+  g_assert_nonnull (g_mkdtemp (root));
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_dirs); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_dirs[i], NULL);
+      g_assert_no_errno (g_mkdir_with_parents (path, 0750));
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_files[i], NULL);
+      g_file_set_contents (path, tree_contents[i], -1, &error);
+      g_assert_no_error (error);
+    }
+
+  return root;
+}
+
+static void
+remove_tree (const char *root)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_files[i], NULL);
+      g_unlink (path);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_dirs); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_dirs[i], NULL);
+      g_rmdir (path);
+    }
+
+  g_rmdir (root);
+}
+
+static DexFuture *
+dir_walker_fiber (gpointer user_data)
+{
+  const char *root = user_data;
+  DexDirWalker *dir_walker;
+  DexChannel *channel;
+  GHashTable *seen;
+  GError *error = NULL;
+  gint64 n_entries;
+
+  seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  dir_walker = dex_dir_walker_new (root);
+  dex_dir_walker_set_query_stat (dir_walker, TRUE);
+  channel = dex_dir_walker_create_channel (dir_walker, 1);
+
+  for (;;)
+    {
+      GPtrArray *batch = dex_await_boxed (dex_channel_receive (channel), &error);
+
+      if (batch == NULL)
+        break;
+
+      for (guint i = 0; i < batch->len; i++)
+        {
+          const DexDirEntry *dir_entry = g_ptr_array_index (batch, i);
+
+          g_assert_true (dex_dir_entry_has_stat (dir_entry));
+          g_assert_true (g_str_has_suffix (dex_dir_entry_get_path (dir_entry),
+                                           dex_dir_entry_get_name (dir_entry)));
+
+          if (dex_dir_entry_get_file_type (dir_entry) == G_FILE_TYPE_REGULAR)
+            g_assert_cmpint (dex_dir_entry_get_size (dir_entry), ==, tree_file_size (dex_dir_entry_get_path (dir_entry)));
+
+          g_hash_table_add (seen, g_strdup (dex_dir_entry_get_path (dir_entry)));
+        }
+
+      g_ptr_array_unref (batch);
+    }
+
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_CHANNEL_CLOSED);
+  g_clear_error (&error);
+
+  n_entries = dex_await_int64 (dex_dir_walker_wait (dir_walker), &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n_entries, ==, 6);
+  g_assert_cmpint (g_hash_table_size (seen), ==, 6);
+
+  g_assert_true (g_hash_table_contains (seen, "a"));
+  g_assert_true (g_hash_table_contains (seen, "a/1"));
+  g_assert_true (g_hash_table_contains (seen, "a/b"));
+  g_assert_true (g_hash_table_contains (seen, "a/b/2"));
+  g_assert_true (g_hash_table_contains (seen, "c"));
+  g_assert_true (g_hash_table_contains (seen, "d"));
+
+  g_hash_table_unref (seen);
+  dex_unref (channel);
+  dex_unref (dir_walker);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_dir_walker (void)
+{
+  g_autofree char *root = create_tree ();
+
+  test_run_fiber (dir_walker_fiber, root);
+
+  remove_tree (root);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/DirWalker/walk", test_dir_walker);
+  return g_test_run ();
+}
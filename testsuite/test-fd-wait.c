@@ -0,0 +1,80 @@
+/* test-fd-wait.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+static DexFuture *
+fd_wait_fiber (gpointer user_data)
+{
+  DexFuture *future;
+  GError *error = NULL;
+  guint revents;
+  int fds[2];
+
+  g_assert_no_errno (pipe (fds));
+
+  /* Resolves once data is available */
+  future = dex_fd_wait (fds[0], G_IO_IN);
+  g_assert_true (dex_future_is_pending (future));
+  g_assert_cmpint (write (fds[1], "x", 1), ==, 1);
+  revents = dex_await_flags (future, &error);
+  g_assert_no_error (error);
+  g_assert_true (revents & G_IO_IN);
+
+  /* Discarding the wait cancels it */
+  g_assert_cmpint (read (fds[0], &(char) {0}, 1), ==, 1);
+  future = dex_fd_wait (fds[0], G_IO_IN);
+  g_assert_false (dex_await (dex_future_first (dex_ref (future),
+                                               dex_timeout_new_msec (10),
+                                               NULL),
+                             &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_TIMED_OUT);
+  g_clear_error (&error);
+  g_assert_false (dex_await (future, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+
+  close (fds[0]);
+  close (fds[1]);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_fd_wait (void)
+{
+  test_run_fiber (fd_wait_fiber, NULL);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Aio/fd_wait", test_fd_wait);
+  return g_test_run ();
+}
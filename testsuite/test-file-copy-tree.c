@@ -0,0 +1,168 @@
+/* test-file-copy-tree.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+static const char *tree_files[] = { "a/1", "a/b/2", "c" };
+static const char *tree_contents[] = { "x", "hello", "a somewhat longer file" };
+static const char *tree_dirs[] = { "a/b", "a", "d" };
+
+static char *
+create_tree (void)
+{
+  char *root = g_build_filename (g_get_tmp_dir (), "test-file-copy-tree-XXXXXX", NULL);
+  GError *error = NULL;
+
+  g_assert_nonnull (g_mkdtemp (root));
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_dirs); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_dirs[i], NULL);
+      g_assert_no_errno (g_mkdir_with_parents (path, 0750));
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_files[i], NULL);
+      g_file_set_contents (path, tree_contents[i], -1, &error);
+      g_assert_no_error (error);
+    }
+
+  return root;
+}
+
+static void
+remove_tree (const char *root)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_files[i], NULL);
+      g_unlink (path);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_dirs); i++)
+    {
+      g_autofree char *path = g_build_filename (root, tree_dirs[i], NULL);
+      g_rmdir (path);
+    }
+
+  g_rmdir (root);
+}
+
+static void
+copy_tree_progress_cb (guint64  n_files,
+                       guint64  n_bytes,
+                       gpointer user_data)
+{
+  guint64 *last_n_files = user_data;
+
+  g_assert_cmpint (n_files, >=, *last_n_files);
+  g_assert_cmpint (n_files, <=, G_N_ELEMENTS (tree_files));
+
+  *last_n_files = n_files;
+}
+
+static void
+test_file_copy_tree (void)
+{
+  g_autofree char *source = create_tree ();
+  g_autofree char *destination = g_strconcat (source, "-copy", NULL);
+  g_autoptr(GFile) source_file = g_file_new_for_path (source);
+  g_autoptr(GFile) destination_file = g_file_new_for_path (destination);
+  g_autofree char *fifo = g_build_filename (source, "e", NULL);
+  g_autofree char *source_ab = g_build_filename (source, "a", "b", NULL);
+  g_autofree char *destination_ab = g_build_filename (destination, "a", "b", NULL);
+  g_autofree char *destination_fifo = g_build_filename (destination, "e", NULL);
+  const GValue *value;
+  DexFuture *future;
+  GError *error = NULL;
+  guint64 n_files = 0;
+  guint64 n_bytes = 0;
+  struct stat stbuf;
+
+  /* Special files are skipped rather than failing the copy */
+  g_assert_no_errno (mkfifo (fifo, 0600));
+
+  /* Directory modes are restored once their children are copied */
+  g_assert_no_errno (chmod (source_ab, 0555));
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_contents); i++)
+    n_bytes += strlen (tree_contents[i]);
+
+  future = dex_file_copy_tree (source_file, destination_file, 2, 0,
+                               copy_tree_progress_cb, &n_files, NULL);
+  test_run_until_complete (future);
+
+  value = dex_future_get_value (future, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (value);
+  g_assert_cmpint (g_value_get_uint64 (value), ==, n_bytes);
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_files); i++)
+    {
+      g_autofree char *path = g_build_filename (destination, tree_files[i], NULL);
+      g_autofree char *contents = NULL;
+
+      g_file_get_contents (path, &contents, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (contents, ==, tree_contents[i]);
+    }
+
+  g_assert_no_errno (stat (destination_ab, &stbuf));
+  g_assert_cmpint (stbuf.st_mode & 07777, ==, 0555);
+  g_assert_false (g_file_test (destination_fifo, G_FILE_TEST_EXISTS));
+
+  for (guint i = 0; i < G_N_ELEMENTS (tree_dirs); i++)
+    {
+      g_autofree char *path = g_build_filename (destination, tree_dirs[i], NULL);
+      g_assert_true (g_file_test (path, G_FILE_TEST_IS_DIR));
+    }
+
+  /* Drain the final progress report */
+  while (g_main_context_iteration (NULL, FALSE)) { }
+  g_assert_cmpint (n_files, ==, G_N_ELEMENTS (tree_files));
+
+  dex_unref (future);
+
+  g_unlink (fifo);
+  chmod (source_ab, 0750);
+  chmod (destination_ab, 0750);
+  remove_tree (source);
+  remove_tree (destination);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/FileCopyTree/copy", test_file_copy_tree);
+  return g_test_run ();
+}
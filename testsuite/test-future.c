@@ -843,6 +843,65 @@ test_future_discard (void)
   dex_clear (&any);
 }
 
+static void
+test_async_pair_recycle (void)
+{
+  DexAsyncPair *async_pair;
+  GCancellable *cancelled;
+  GCancellable *exposed;
+  GCancellable *cached;
+  GCancellable *held;
+
+  /* A cancelled cancellable must never be handed to another operation */
+  async_pair = dex_async_pair_create ();
+  cancelled = g_object_ref (async_pair->cancellable);
+  g_cancellable_cancel (cancelled);
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  async_pair = dex_async_pair_create ();
+  g_assert_true (async_pair->cancellable != cancelled);
+  g_assert_false (g_cancellable_is_cancelled (async_pair->cancellable));
+  cached = async_pair->cancellable;
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  /* One that was never exposed is reused and still clean */
+  async_pair = dex_async_pair_create ();
+  g_assert_true (async_pair->cancellable == cached);
+  g_assert_false (g_cancellable_is_cancelled (async_pair->cancellable));
+  g_assert_false (g_signal_has_handler_pending (async_pair->cancellable,
+                                                g_signal_lookup ("cancelled", G_TYPE_CANCELLABLE),
+                                                0, TRUE));
+
+  /* Once exposed, callers may attach state to it so it is not recycled */
+  exposed = g_object_ref (dex_async_pair_get_cancellable (async_pair));
+  g_object_set_data (G_OBJECT (exposed), "test-async-pair-recycle", exposed);
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  async_pair = dex_async_pair_create ();
+  g_assert_true (async_pair->cancellable != exposed);
+  g_assert_null (g_object_get_data (G_OBJECT (async_pair->cancellable), "test-async-pair-recycle"));
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  /* One still referenced elsewhere, such as by a GTask, is not reused */
+  async_pair = dex_async_pair_create ();
+  held = g_object_ref (async_pair->cancellable);
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  async_pair = dex_async_pair_create ();
+  g_assert_true (async_pair->cancellable != held);
+  dex_async_pair_return_boolean (async_pair, TRUE);
+  dex_clear (&async_pair);
+
+  g_object_unref (cancelled);
+  g_object_unref (exposed);
+  g_object_unref (held);
+}
+
 #ifdef G_OS_UNIX
 static void
 test_unix_signal_sigusr2 (void)
@@ -928,6 +987,7 @@ main (int   argc,
   g_test_add_func ("/Dex/TestSuite/AsyncPair/flags", test_async_pair_GSubprocessFlags);
   g_test_add_func ("/Dex/TestSuite/AsyncPair/enums", test_async_pair_DexFutureStatus);
   g_test_add_func ("/Dex/TestSuite/AsyncPair/GError", test_async_pair_ErrorTest);
+  g_test_add_func ("/Dex/TestSuite/AsyncPair/recycle", test_async_pair_recycle);
   g_test_add_func ("/Dex/TestSuite/Future/first_preresolved", test_future_set_first_preresolved);
   g_test_add_func ("/Dex/TestSuite/Future/all_race_preresolved", test_future_set_all_race_preresolved);
   g_test_add_func ("/Dex/TestSuite/Future/any_preresolved", test_future_set_any_preresolved);
@@ -0,0 +1,307 @@
+/*
+ * test-mutex.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+#define N_FIBERS     8
+#define N_ITERATIONS 1000
+
+typedef struct
+{
+  DexMutex *mutex;
+  DexCond  *cond;
+  guint     counter;
+  gboolean  ready;
+} Shared;
+
+static void
+test_mutex_basic (void)
+{
+  DexMutex *mutex = dex_mutex_new ();
+  DexFuture *future;
+
+  g_assert_true (dex_mutex_trylock (mutex));
+  g_assert_false (dex_mutex_trylock (mutex));
+
+  future = dex_mutex_lock (mutex);
+  g_assert_true (dex_future_is_pending (future));
+
+  /* Ownership is handed directly to the waiter */
+  dex_mutex_unlock (mutex);
+  g_assert_true (dex_future_is_resolved (future));
+  g_assert_false (dex_mutex_trylock (mutex));
+  dex_unref (future);
+
+  dex_mutex_unlock (mutex);
+  g_assert_true (dex_mutex_trylock (mutex));
+  dex_mutex_unlock (mutex);
+
+  dex_unref (mutex);
+}
+
+static DexFuture *
+mutex_discard_fiber (gpointer user_data)
+{
+  DexMutex *mutex = user_data;
+  GError *error = NULL;
+
+  g_assert_true (dex_mutex_trylock (mutex));
+
+  /* Timing out gives up our place in the queue */
+  g_assert_false (dex_await (dex_future_first (dex_mutex_lock (mutex),
+                                               dex_timeout_new_msec (10),
+                                               NULL),
+                             &error));
+  g_assert_error (error, DEX_ERROR, DEX_ERROR_TIMED_OUT);
+  g_clear_error (&error);
+
+  /* So unlocking leaves the mutex unowned */
+  dex_mutex_unlock (mutex);
+  g_assert_true (dex_mutex_trylock (mutex));
+  dex_mutex_unlock (mutex);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_mutex_discard (void)
+{
+  DexMutex *mutex = dex_mutex_new ();
+
+  test_run_fiber (mutex_discard_fiber, mutex);
+
+  dex_unref (mutex);
+}
+
+static gpointer
+mutex_unlock_thread (gpointer user_data)
+{
+  dex_mutex_unlock (user_data);
+  return NULL;
+}
+
+static DexFuture *
+mutex_discard_race_fiber (gpointer user_data)
+{
+  DexMutex *mutex = user_data;
+
+  for (guint i = 0; i < N_ITERATIONS; i++)
+    {
+      DexFuture *lock;
+      GThread *thread;
+
+      g_assert_true (dex_mutex_trylock (mutex));
+
+      /* Hand the mutex over from another thread while the timeout
+       * discards the waiter on this one.
+       */
+      lock = dex_mutex_lock (mutex);
+      thread = g_thread_new ("[test-mutex-unlock]", mutex_unlock_thread, mutex);
+      dex_await (dex_future_first (dex_ref (lock), dex_timeout_new_msec (0), NULL), NULL);
+      g_thread_join (thread);
+
+      /* Either we own it, or it was released on our behalf */
+      g_assert_false (dex_future_is_pending (lock));
+      if (dex_future_is_resolved (lock))
+        dex_mutex_unlock (mutex);
+      dex_unref (lock);
+
+      g_assert_true (dex_mutex_trylock (mutex));
+      dex_mutex_unlock (mutex);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_mutex_discard_race (void)
+{
+  DexMutex *mutex = dex_mutex_new ();
+
+  test_run_fiber (mutex_discard_race_fiber, mutex);
+
+  dex_unref (mutex);
+}
+
+static DexFuture *
+mutex_contended_fiber (gpointer user_data)
+{
+  Shared *shared = user_data;
+
+  for (guint i = 0; i < N_ITERATIONS; i++)
+    {
+      guint counter;
+
+      dex_await (dex_mutex_lock (shared->mutex), NULL);
+
+      /* Not atomic on purpose, the mutex must protect it */
+      counter = shared->counter;
+      if (i % 100 == 0)
+        dex_await (dex_timeout_new_usec (1), NULL);
+      shared->counter = counter + 1;
+
+      dex_mutex_unlock (shared->mutex);
+    }
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_mutex_contended (void)
+{
+  DexScheduler *thread_pool = dex_thread_pool_scheduler_get_default ();
+  DexFuture *fibers[N_FIBERS];
+  DexFuture *future;
+  Shared shared = {0};
+
+  shared.mutex = dex_mutex_new ();
+
+  for (guint i = 0; i < N_FIBERS; i++)
+    fibers[i] = dex_scheduler_spawn (thread_pool, 0, mutex_contended_fiber, &shared, NULL);
+
+  future = dex_future_allv (fibers, N_FIBERS);
+  for (guint i = 0; i < N_FIBERS; i++)
+    dex_unref (fibers[i]);
+  test_run_until_complete (future);
+  g_assert_true (dex_future_is_resolved (future));
+  dex_unref (future);
+
+  g_assert_cmpuint (shared.counter, ==, N_FIBERS * N_ITERATIONS);
+
+  dex_unref (shared.mutex);
+}
+
+static void
+test_rw_lock_basic (void)
+{
+  DexRWLock *rw_lock = dex_rw_lock_new ();
+  DexFuture *writer;
+  DexFuture *reader;
+
+  g_assert_true (dex_rw_lock_reader_trylock (rw_lock));
+  g_assert_true (dex_rw_lock_reader_trylock (rw_lock));
+  g_assert_false (dex_rw_lock_writer_trylock (rw_lock));
+
+  writer = dex_rw_lock_writer_lock (rw_lock);
+  g_assert_true (dex_future_is_pending (writer));
+
+  /* New readers queue behind the waiting writer */
+  g_assert_false (dex_rw_lock_reader_trylock (rw_lock));
+  reader = dex_rw_lock_reader_lock (rw_lock);
+  g_assert_true (dex_future_is_pending (reader));
+
+  dex_rw_lock_reader_unlock (rw_lock);
+  g_assert_true (dex_future_is_pending (writer));
+  dex_rw_lock_reader_unlock (rw_lock);
+  g_assert_true (dex_future_is_resolved (writer));
+  g_assert_true (dex_future_is_pending (reader));
+
+  dex_rw_lock_writer_unlock (rw_lock);
+  g_assert_true (dex_future_is_resolved (reader));
+
+  dex_rw_lock_reader_unlock (rw_lock);
+  g_assert_true (dex_rw_lock_writer_trylock (rw_lock));
+  dex_rw_lock_writer_unlock (rw_lock);
+
+  dex_unref (writer);
+  dex_unref (reader);
+  dex_unref (rw_lock);
+}
+
+static DexFuture *
+cond_consumer_fiber (gpointer user_data)
+{
+  Shared *shared = user_data;
+
+  dex_await (dex_mutex_lock (shared->mutex), NULL);
+  while (!shared->ready)
+    dex_await (dex_cond_wait (shared->cond, shared->mutex), NULL);
+  shared->counter++;
+  dex_mutex_unlock (shared->mutex);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+cond_producer_fiber (gpointer user_data)
+{
+  Shared *shared = user_data;
+
+  dex_await (dex_mutex_lock (shared->mutex), NULL);
+  shared->ready = TRUE;
+  dex_cond_broadcast (shared->cond);
+  dex_mutex_unlock (shared->mutex);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_cond_basic (void)
+{
+  DexFuture *fibers[N_FIBERS + 1];
+  DexFuture *future;
+  Shared shared = {0};
+
+  shared.mutex = dex_mutex_new ();
+  shared.cond = dex_cond_new ();
+
+  /* Signalling without waiters is a no-op */
+  dex_cond_signal (shared.cond);
+
+  for (guint i = 0; i < N_FIBERS; i++)
+    fibers[i] = dex_scheduler_spawn (NULL, 0, cond_consumer_fiber, &shared, NULL);
+
+  /* Let the consumers start waiting */
+  while (g_main_context_iteration (NULL, FALSE)) { }
+
+  fibers[N_FIBERS] = dex_scheduler_spawn (NULL, 0, cond_producer_fiber, &shared, NULL);
+
+  future = dex_future_allv (fibers, G_N_ELEMENTS (fibers));
+  for (guint i = 0; i < G_N_ELEMENTS (fibers); i++)
+    dex_unref (fibers[i]);
+  test_run_until_complete (future);
+  g_assert_true (dex_future_is_resolved (future));
+  dex_unref (future);
+
+  g_assert_cmpuint (shared.counter, ==, N_FIBERS);
+
+  dex_unref (shared.cond);
+  dex_unref (shared.mutex);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Mutex/basic", test_mutex_basic);
+  g_test_add_func ("/Dex/TestSuite/Mutex/discard", test_mutex_discard);
+  g_test_add_func ("/Dex/TestSuite/Mutex/discard-race", test_mutex_discard_race);
+  g_test_add_func ("/Dex/TestSuite/Mutex/contended", test_mutex_contended);
+  g_test_add_func ("/Dex/TestSuite/RWLock/basic", test_rw_lock_basic);
+  g_test_add_func ("/Dex/TestSuite/Cond/basic", test_cond_basic);
+  return g_test_run ();
+}
@@ -0,0 +1,255 @@
+/* test-process.c
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <libdex.h>
+
+#include "test-util.h"
+
+static DexFuture *
+wait_fiber (gpointer user_data)
+{
+  const char *argv[] = { "/bin/sh", "-c", "exit 3", NULL };
+  DexProcess *process;
+  GError *error = NULL;
+  int wait_status;
+
+  process = dex_process_spawn (argv, NULL, NULL, -1, -1, -1, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (process);
+  g_assert_cmpint (dex_process_get_pid (process), >, 0);
+
+  wait_status = dex_await_int (dex_process_wait (process), &error);
+  g_assert_no_error (error);
+  g_assert_true (WIFEXITED (wait_status));
+  g_assert_cmpint (WEXITSTATUS (wait_status), ==, 3);
+
+  g_assert_false (dex_await (dex_process_wait_check (process), &error));
+  g_assert_error (error, G_SPAWN_EXIT_ERROR, 3);
+  g_clear_error (&error);
+
+  dex_unref (process);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+signal_fiber (gpointer user_data)
+{
+  const char *argv[] = { "sleep", "30", NULL };
+  DexProcess *process;
+  GError *error = NULL;
+  int wait_status;
+
+  process = dex_process_spawn (argv, NULL, NULL, -1, -1, -1, &error);
+  g_assert_no_error (error);
+
+  dex_process_send_signal (process, SIGTERM);
+
+  wait_status = dex_await_int (dex_process_wait (process), &error);
+  g_assert_no_error (error);
+  g_assert_true (WIFSIGNALED (wait_status));
+  g_assert_cmpint (WTERMSIG (wait_status), ==, SIGTERM);
+
+  dex_unref (process);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+stdout_fiber (gpointer user_data)
+{
+  const char *argv[] = { "/bin/sh", "-c", "pwd; echo $DEX_TEST", NULL };
+  const char *envp[] = { "DEX_TEST=hello", NULL };
+  DexProcess *process;
+  GError *error = NULL;
+  GBytes *bytes;
+  int fds[2];
+
+  g_assert_no_errno (pipe (fds));
+
+  process = dex_process_spawn (argv, envp, "/", -1, fds[1], -1, &error);
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+  if (process == NULL)
+    {
+      g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+      g_clear_error (&error);
+      close (fds[0]);
+      close (fds[1]);
+      return dex_future_new_for_boolean (TRUE);
+    }
+#endif
+
+  g_assert_no_error (error);
+  close (fds[1]);
+
+  g_assert_true (dex_await (dex_process_wait_check (process), &error));
+  g_assert_no_error (error);
+
+  bytes = dex_await_boxed (dex_aio_read_bytes (NULL, fds[0], 4096, -1), &error);
+  g_assert_no_error (error);
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), "/\nhello\n", 8);
+  g_bytes_unref (bytes);
+
+  close (fds[0]);
+  dex_unref (process);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static DexFuture *
+swapped_fds_fiber (gpointer user_data)
+{
+  const char *argv[] = { "/bin/sh", "-c", "echo hello", NULL };
+  DexProcess *process;
+  GError *error = NULL;
+  GBytes *bytes;
+  int saved_stdin;
+  int devnull;
+  int fds[2];
+
+  g_assert_no_errno (pipe (fds));
+  devnull = open ("/dev/null", O_RDONLY | O_CLOEXEC);
+  g_assert_cmpint (devnull, >, -1);
+
+  /* stdout_fd is the slot that stdin_fd is duplicated into first */
+  saved_stdin = dup (STDIN_FILENO);
+  g_assert_cmpint (saved_stdin, >, -1);
+  g_assert_no_errno (dup2 (fds[1], STDIN_FILENO));
+  close (fds[1]);
+
+  process = dex_process_spawn (argv, NULL, NULL, devnull, STDIN_FILENO, -1, &error);
+  g_assert_no_error (error);
+
+  g_assert_no_errno (dup2 (saved_stdin, STDIN_FILENO));
+  close (saved_stdin);
+  close (devnull);
+
+  g_assert_true (dex_await (dex_process_wait_check (process), &error));
+  g_assert_no_error (error);
+
+  bytes = dex_await_boxed (dex_aio_read_bytes (NULL, fds[0], 4096, -1), &error);
+  g_assert_no_error (error);
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), "hello\n", 6);
+  g_bytes_unref (bytes);
+
+  close (fds[0]);
+  dex_unref (process);
+
+  return dex_future_new_for_boolean (TRUE);
+}
+
+static void
+test_process_noent (void)
+{
+  const char *argv[] = { "/nonexistent/dex-test-program", NULL };
+  DexProcess *process;
+  GError *error = NULL;
+
+  process = dex_process_spawn (argv, NULL, NULL, -1, -1, -1, &error);
+  g_assert_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_NOENT);
+  g_assert_null (process);
+  g_clear_error (&error);
+}
+
+static gpointer
+spawn_thread_func (gpointer data)
+{
+  const char *argv[] = { "/bin/sh", "-c", "exit 5", NULL };
+  GError *error = NULL;
+  DexProcess *process;
+
+  /* No scheduler on this thread, so the child watch must be used */
+  g_assert_null (dex_scheduler_get_thread_default ());
+
+  process = dex_process_spawn (argv, NULL, NULL, -1, -1, -1, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (process);
+
+  return process;
+}
+
+static void
+test_process_thread (void)
+{
+  const GValue *value;
+  DexProcess *process;
+  DexFuture *future;
+  GError *error = NULL;
+
+  process = g_thread_join (g_thread_new ("test-process-spawn", spawn_thread_func, NULL));
+  future = dex_process_wait (process);
+
+  test_run_until_complete (future);
+
+  value = dex_future_get_value (future, &error);
+  g_assert_no_error (error);
+  g_assert_true (WIFEXITED (g_value_get_int (value)));
+  g_assert_cmpint (WEXITSTATUS (g_value_get_int (value)), ==, 5);
+
+  dex_unref (future);
+  dex_unref (process);
+}
+
+static void
+test_process_wait (void)
+{
+  test_run_fiber (wait_fiber, NULL);
+}
+
+static void
+test_process_signal (void)
+{
+  test_run_fiber (signal_fiber, NULL);
+}
+
+static void
+test_process_stdout (void)
+{
+  test_run_fiber (stdout_fiber, NULL);
+}
+
+static void
+test_process_swapped_fds (void)
+{
+  test_run_fiber (swapped_fds_fiber, NULL);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  dex_init ();
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Process/wait", test_process_wait);
+  g_test_add_func ("/Dex/TestSuite/Process/signal", test_process_signal);
+  g_test_add_func ("/Dex/TestSuite/Process/stdout", test_process_stdout);
+  g_test_add_func ("/Dex/TestSuite/Process/swapped_fds", test_process_swapped_fds);
+  g_test_add_func ("/Dex/TestSuite/Process/noent", test_process_noent);
+  g_test_add_func ("/Dex/TestSuite/Process/thread", test_process_thread);
+  return g_test_run ();
+}
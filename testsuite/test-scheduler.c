@@ -160,6 +160,59 @@ test_thread_pool_scheduler_push (void)
   g_cond_clear (&syncobj.cond);
 }
 
+static void
+test_stats_type_cb (GType    type,
+                    guint64  n_created,
+                    guint64  n_completed,
+                    gpointer user_data)
+{
+  guint64 *n_fibers = user_data;
+
+  g_assert_true (g_type_is_a (type, DEX_TYPE_FUTURE));
+  g_assert_cmpuint (n_completed, <=, n_created);
+
+  if (type == DEX_TYPE_FIBER)
+    *n_fibers = n_created;
+}
+
+static void
+test_scheduler_stats (void)
+{
+  DexScheduler *scheduler = dex_scheduler_get_default ();
+  DexSchedulerStats before;
+  DexSchedulerStats after;
+  DexSchedulerStats global;
+  DexFuture *future;
+  guint64 n_fibers = 0;
+  guint count = 0;
+
+  dex_future_set_type_stats_enabled (TRUE);
+
+  dex_scheduler_get_stats (scheduler, &before);
+  g_assert_cmpuint (before.n_futures_created, ==, 0);
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+  future = dex_scheduler_spawn (scheduler, 0, test_fiber_func, &count, NULL);
+  future = dex_future_finally (future, quit_cb, NULL, NULL);
+  g_main_loop_run (main_loop);
+  g_clear_pointer (&main_loop, g_main_loop_unref);
+  dex_unref (future);
+
+  g_assert_cmpint (count, ==, 10);
+
+  dex_scheduler_get_stats (scheduler, &after);
+  g_assert_cmpuint (after.n_fibers_spawned, >=, before.n_fibers_spawned + 11);
+  g_assert_cmpuint (after.n_fiber_switches, >, before.n_fiber_switches);
+
+  dex_scheduler_get_global_stats (&global);
+  g_assert_cmpuint (global.n_fibers_spawned, >=, after.n_fibers_spawned);
+  g_assert_cmpuint (global.n_futures_created, >, 0);
+  g_assert_cmpuint (global.n_futures_completed, >, 0);
+
+  dex_future_foreach_type_stats (test_stats_type_cb, &n_fibers);
+  g_assert_cmpuint (n_fibers, >=, 11);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -169,5 +222,6 @@ main (int   argc,
   g_test_add_func ("/Dex/TestSuite/MainScheduler/simple", test_main_scheduler_simple);
   g_test_add_func ("/Dex/TestSuite/ThreadPoolScheduler/10_000_fibers", test_thread_pool_scheduler_spawn);
   g_test_add_func ("/Dex/TestSuite/ThreadPoolScheduler/push", test_thread_pool_scheduler_push);
+  g_test_add_func ("/Dex/TestSuite/Scheduler/stats", test_scheduler_stats);
   return g_test_run ();
 }
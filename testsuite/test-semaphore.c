@@ -25,6 +25,8 @@
 #include "dex-semaphore-private.h"
 #include "dex-thread-storage-private.h"
 
+#include "test-util.h"
+
 #define N_THREADS 32
 
 static guint total_count;
@@ -126,12 +128,75 @@ test_semaphore_threaded (void)
     }
 }
 
+static void
+test_semaphore_fast_path (void)
+{
+  DexSemaphore *semaphore = dex_semaphore_new ();
+  DexFuture *future;
+
+  g_assert_false (dex_semaphore_try_acquire (semaphore));
+
+  dex_semaphore_post_many (semaphore, 2);
+  g_assert_true (dex_semaphore_try_acquire (semaphore));
+
+  /* Permits are available so waiting completes without parking */
+  future = dex_semaphore_wait (semaphore);
+  g_assert_true (dex_future_is_resolved (future));
+  dex_unref (future);
+
+  g_assert_false (dex_semaphore_try_acquire (semaphore));
+
+  /* A parked waiter is woken by the next post */
+  future = dex_semaphore_wait (semaphore);
+  g_assert_true (dex_future_is_pending (future));
+  dex_semaphore_post (semaphore);
+  test_run_until_complete (future);
+
+  g_assert_true (dex_future_is_resolved (future));
+  g_assert_false (dex_semaphore_try_acquire (semaphore));
+  dex_unref (future);
+
+  dex_semaphore_close (semaphore);
+  dex_unref (semaphore);
+}
+
+static void
+test_semaphore_closed (void)
+{
+  DexSemaphore *semaphore = dex_semaphore_new ();
+  GError *error = NULL;
+
+  dex_semaphore_close (semaphore);
+
+  /* Waiting on a closed semaphore must not leave a parked waiter
+   * behind, or the next post would try to wake it.
+   */
+  for (guint i = 0; i < 3; i++)
+    {
+      DexFuture *future = dex_semaphore_wait (semaphore);
+
+      g_assert_true (dex_future_is_rejected (future));
+      g_assert_false (dex_future_get_value (future, &error));
+      g_assert_error (error, DEX_ERROR, DEX_ERROR_SEMAPHORE_CLOSED);
+      g_clear_error (&error);
+      dex_unref (future);
+    }
+
+  dex_semaphore_post (semaphore);
+  g_assert_true (dex_semaphore_try_acquire (semaphore));
+  g_assert_false (dex_semaphore_try_acquire (semaphore));
+
+  dex_unref (semaphore);
+}
+
 int
 main (int argc,
       char *argv[])
 {
   dex_init ();
   g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Dex/TestSuite/Semaphore/fast_path", test_semaphore_fast_path);
+  g_test_add_func ("/Dex/TestSuite/Semaphore/closed", test_semaphore_closed);
   g_test_add_func ("/Dex/TestSuite/Semaphore/threaded", test_semaphore_threaded);
   return g_test_run ();
 }
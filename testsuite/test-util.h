@@ -0,0 +1,90 @@
+/* test-util.h
+ *
+ * Copyright 2024 Christian Hergert <chergert@redhat.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <libdex.h>
+
+#include "dex-posix-aio-backend-private.h"
+#ifdef HAVE_LIBURING
+# include "dex-uring-aio-backend-private.h"
+#endif
+
+G_BEGIN_DECLS
+
+/* Iterates the default main context until @future completes */
+static inline void
+test_run_until_complete (DexFuture *future)
+{
+  while (dex_future_is_pending (future))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/* Runs @fiber_func on the default scheduler and asserts it resolved */
+static inline void
+test_run_fiber (DexFiberFunc fiber_func,
+                gpointer     user_data)
+{
+  DexFuture *future = dex_scheduler_spawn (NULL, 0, fiber_func, user_data, NULL);
+  GError *error = NULL;
+
+  test_run_until_complete (future);
+
+  g_assert_nonnull (dex_future_get_value (future, &error));
+  g_assert_no_error (error);
+
+  dex_unref (future);
+}
+
+/* Runs @fiber_func once for each AIO backend available, passing a
+ * #DexAioContext for that backend which is attached to the default
+ * main context.
+ */
+static inline void
+test_run_fiber_with_backends (DexFiberFunc fiber_func)
+{
+  DexAioBackend *backends[2] = { dex_posix_aio_backend_new (), NULL };
+
+#ifdef HAVE_LIBURING
+  backends[1] = dex_uring_aio_backend_new ();
+#endif
+
+  for (guint i = 0; i < G_N_ELEMENTS (backends); i++)
+    {
+      DexAioContext *aio_context;
+
+      if (backends[i] == NULL)
+        continue;
+
+      g_test_message ("Using AIO backend %s", DEX_OBJECT_TYPE_NAME (backends[i]));
+
+      aio_context = dex_aio_backend_create_context (backends[i]);
+      g_assert_nonnull (aio_context);
+      g_source_attach ((GSource *)aio_context, NULL);
+
+      test_run_fiber (fiber_func, aio_context);
+
+      g_source_destroy ((GSource *)aio_context);
+      g_source_unref ((GSource *)aio_context);
+      dex_unref (backends[i]);
+    }
+}
+
+G_END_DECLS